@@ -7,6 +7,7 @@
 #include "adc.h"
 #include "logging.h"
 #include "esp_adc/adc_oneshot.h"
+#include "esp_rom_sys.h"
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
@@ -20,6 +21,12 @@
 /// Invalid ADC channel sentinel (no ADC_CHANNEL_MAX in ESP-IDF enum)
 #define ADC_CHANNEL_INVALID  ((adc_channel_t) -1)
 
+/// Attempts of a conversion while the unit is busy with a conversion of another task (ripple sampler on Core 0)
+#define ADC_BUSY_RETRIES     8
+
+/// Wait between attempts in microseconds (about one conversion)
+#define ADC_BUSY_WAIT_US     10
+
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -100,8 +107,27 @@ esp_err_t adc_init(void)
 /// \param[in] pin        GPIO pin to read
 /// \param[out] raw_value  Pointer to receive the raw ADC value (0–4095)
 /// \return ESP_OK on success, ESP_ERR_INVALID_STATE if not initialized,
-///         ESP_ERR_INVALID_ARG on bad pin or NULL pointer
+///         ESP_ERR_INVALID_ARG on bad pin or NULL pointer, ESP_ERR_TIMEOUT if the unit stayed busy
 esp_err_t adc_read(adc_pin_t pin, int *raw_value)
+{
+    // The driver does not wait for a conversion of another task on the same unit, it returns ESP_ERR_TIMEOUT
+    esp_err_t ret = adc_read_once(pin, raw_value);
+    for (int i = 0; i < ADC_BUSY_RETRIES && ret == ESP_ERR_TIMEOUT; ++i) {
+        esp_rom_delay_us(ADC_BUSY_WAIT_US);
+        ret = adc_read_once(pin, raw_value);
+    }
+
+    return ret;
+}
+
+/// This function performs a single ADC conversion attempt on the specified analog pin without waiting for a busy
+/// unit. For callers with a fixed sample period, which repeat their previous sample instead of waiting.
+///
+/// \param[in] pin        GPIO pin to read
+/// \param[out] raw_value  Pointer to receive the raw ADC value (0–4095)
+/// \return ESP_OK on success, ESP_ERR_INVALID_STATE if not initialized,
+///         ESP_ERR_INVALID_ARG on bad pin or NULL pointer, ESP_ERR_TIMEOUT if the unit is busy
+esp_err_t adc_read_once(adc_pin_t pin, int *raw_value)
 {
     if (!raw_value) {
         return ESP_ERR_INVALID_ARG;
@@ -39,6 +39,7 @@ typedef enum {
 /*==============================================================================================================*/
 esp_err_t adc_init(void);
 esp_err_t adc_read(adc_pin_t pin, int *raw_value);
+esp_err_t adc_read_once(adc_pin_t pin, int *raw_value);
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
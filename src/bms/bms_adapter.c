@@ -5,34 +5,26 @@
 /*==============================================================================================================*/
 #include "bms_adapter.h"
 #include "ltc6804.h"
+#include "ltc6804_calib.h"
 #include "configuration.h"
 #include "logging.h"
 #include "adc.h"
+#include "pt1000.h"
+#include "bms_sim.h"
+#include "bms_trace.h"
+#include "ripple.h"
+#include "stage_timing.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_mac.h"
 #include "esp_random.h"
 #include <stdlib.h>
-#include <math.h>
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
 /*==============================================================================================================*/
 /// Log module tag used by logging module
 #define LOG_MODULE_TAG "BMS_ADAPTER"
-/// PT1000 reference resistance at 0 deg C (Ohms)
-#define PT1000_R0      1000.0f
-/// Callendar-Van Dusen coefficient A (IEC 60751)
-#define PT1000_A       3.9083e-3f
-/// Callendar-Van Dusen coefficient B (IEC 60751)
-#define PT1000_B      -5.775e-7f
-/// Callendar-Van Dusen coefficient C (IEC 60751, used below 0 deg C only)
-#define PT1000_C      -4.183e-12f
-/// Assumed voltage reference for PT1000 divider calculations (V)
-#define PT1000_V_REF   3.3f
-/// Reference resistor in voltage divider circuit (Ohms)
-#define PT1000_R_REF   1000.0f
-
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -46,6 +38,8 @@ static esp_err_t demo_init(void);
 static esp_err_t demo_read_sample(bms_sample_t *out);
 static esp_err_t ltc6804_adapter_init(void);
 static esp_err_t ltc6804_adapter_read_sample(bms_sample_t *out);
+static esp_err_t sim_init(void);
+static esp_err_t replay_init(void);
 static float read_current(adc_pin_t pin, float i_min, float i_max);
 static float read_pt1000(adc_pin_t pin);
 static float read_temperature(adc_pin_t pin);
@@ -53,7 +47,7 @@ static float read_temperature(adc_pin_t pin);
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
 /*==============================================================================================================*/
-/// Selected adapter instance. Used to switch between demo and LTC6804 adapter.
+/// Selected adapter instance. Used to switch between demo, LTC6804, simulator and trace replay adapter.
 static const bms_adapter_t *s_current_adapter = NULL;
 
 /// Demo adapter instance
@@ -68,6 +62,18 @@ static const bms_adapter_t s_ltc6804_adapter = {
     .read_sample = ltc6804_adapter_read_sample,
 };
 
+/// Simulator adapter instance
+static const bms_adapter_t s_sim_adapter = {
+    .init        = sim_init,
+    .read_sample = bms_sim_read_sample,
+};
+
+/// Trace replay adapter instance
+static const bms_adapter_t s_replay_adapter = {
+    .init        = replay_init,
+    .read_sample = bms_trace_replay_read,
+};
+
 /*==============================================================================================================*/
 /*                                            Private Variables                                                 */
 /*==============================================================================================================*/
@@ -105,6 +111,24 @@ esp_err_t bms_ltc6804_adapter_select(void)
     return s_current_adapter->init();
 }
 
+/// This function selects and initializes the pack simulator BMS adapter.
+/// \param None
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t bms_sim_adapter_select(void)
+{
+    s_current_adapter = &s_sim_adapter;
+    return s_current_adapter->init();
+}
+
+/// This function selects and initializes the trace replay BMS adapter.
+/// \param None
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t bms_replay_adapter_select(void)
+{
+    s_current_adapter = &s_replay_adapter;
+    return s_current_adapter->init();
+}
+
 /*==============================================================================================================*/
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
@@ -204,7 +228,47 @@ static esp_err_t demo_read_sample(bms_sample_t *out)
     return ESP_OK;
 }
 
-/// This function initializes the LTC6804 hardware adapter by calling function ltc6804_init().
+/// This function initializes the simulator adapter with default simulator configuration (seed and run mode from
+/// Kconfig).
+///
+/// \param None
+/// \return ESP_OK on success, otherwise an error code
+static esp_err_t sim_init(void)
+{
+    esp_err_t ret = bms_sim_init(NULL);
+    if (ret != ESP_OK) {
+        BMS_LOGE("Simulator adapter init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    BMS_LOGI("Simulator BMS adapter initialized");
+    return ESP_OK;
+}
+
+/// This function initializes the trace replay adapter. Opens the trace at ::CONFIG_BMS_TRACE_PATH without pacing,
+/// records are returned at the Fast Core period. The trace must contain at least the configured number of cells.
+///
+/// \param None
+/// \return ESP_OK on success, ESP_ERR_INVALID_SIZE if the trace has fewer cells than configured, otherwise an
+///         error code of bms_trace_replay_open()
+static esp_err_t replay_init(void)
+{
+    esp_err_t ret = bms_trace_replay_open(CONFIG_BMS_TRACE_PATH, BMS_TRACE_PACE_NONE, CONFIG_BMS_TRACE_REPLAY_LOOP);
+    if (ret != ESP_OK) {
+        BMS_LOGE("Replay adapter init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (bms_trace_replay_cells() < g_cfg.battery.num_cells) {
+        BMS_LOGE("Trace has %u cells, %u configured", (unsigned)bms_trace_replay_cells(),
+                 (unsigned)g_cfg.battery.num_cells);
+        bms_trace_replay_close();
+        return ESP_ERR_INVALID_SIZE;
+    }
+    BMS_LOGI("Trace replay BMS adapter initialized");
+    return ESP_OK;
+}
+
+/// This function initializes the LTC6804 hardware adapter by calling function ltc6804_init() and applies cell
+/// calibration stored in NVS.
 ///
 /// \param None
 /// \return ESP_OK on success, otherwise an error code
@@ -215,6 +279,14 @@ static esp_err_t ltc6804_adapter_init(void)
         BMS_LOGE("LTC6804 adapter init failed: %s", esp_err_to_name(ret));
         return ret;
     }
+    if (g_cfg.battery.num_cells > ltc6804_num_cells()) {
+        BMS_LOGE("Configured %u cells, LTC6804 chains provide %u", g_cfg.battery.num_cells, ltc6804_num_cells());
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Missing calibration is not an error, cells are then converted with the nominal factor
+    if (ltc6804_calib_load() != ESP_OK) {
+        BMS_LOGW("Failed to load cell calibration, using nominal conversion");
+    }
     BMS_LOGI("LTC6804 hardware BMS adapter initialized");
     return ESP_OK;
 }
@@ -246,10 +318,21 @@ static esp_err_t ltc6804_adapter_read_sample(bms_sample_t *out)
 
 
     // Read pack current from current sensor. Range 0-50A corresponds to 50 amp LEM HTB 50-P/SP5 sensor
-    out->pack_i = read_current(ADC_PIN_GPIO34, 0, 50);
+    uint32_t t_adc = stage_timing_now_us();
+#if CONFIG_BMS_RIPPLE
+    // Mean of the ripple sampler since the previous cycle, single conversion while the sampler is stopped
+    if (!bms_ripple_take_mean(&out->pack_i)) {
+        out->pack_i = read_current(BMS_CURRENT_ADC_PIN, BMS_CURRENT_I_MIN, BMS_CURRENT_I_MAX);
+    }
+#else
+    out->pack_i = read_current(BMS_CURRENT_ADC_PIN, BMS_CURRENT_I_MIN, BMS_CURRENT_I_MAX);
+#endif
+    uint32_t t_temp = stage_timing_now_us();
+    stage_timing_record(FC_STAGE_CURRENT_ADC, t_temp - t_adc);
 
     // Read temperature from sensor
     out->temperature = read_temperature(ADC_PIN_GPIO35);
+    stage_timing_record(FC_STAGE_TEMP_ADC, stage_timing_now_us() - t_temp);
 
     // Set timestamp
     out->timestamp = xTaskGetTickCount();
@@ -281,8 +364,7 @@ static float read_current(adc_pin_t pin, float i_min, float i_max)
 }
 
 /// This function reads the resistance of a PT1000 sensor connected via a voltage divider
-/// to the specified ADC pin and converts it to temperature in degrees Celsius.
-/// Uses the Callendar-Van Dusen equation (IEC 60751) to convert resistance to temperature.
+/// to the specified ADC pin and converts it to temperature in degrees Celsius (see `pt1000.c`).
 ///
 /// \param[in] pin ADC pin connected to the PT1000 voltage divider output
 /// \return Temperature in degrees Celsius, or 0 if reading fails
@@ -295,62 +377,7 @@ static float read_pt1000(adc_pin_t pin)
         return 0;
     }
 
-    // Convert raw ADC value to voltage
-    float voltage = (float)raw_value * PT1000_V_REF / (float)ADC_RANGE;
-
-    // Calculate PT1000 resistance from voltage divider: R_pt1000 = R_ref * V / (V_ref - V)
-    float denom = PT1000_V_REF - voltage; // (V_ref - V)
-    if (denom <= 0.0f) {
-        BMS_LOGE("PT1000 voltage divider error: voltage too high");
-        return 0;
-    }
-    float resistance = PT1000_R_REF * voltage / denom;
-
-    // Convert resistance to temperature using Callendar-Van Dusen equation (IEC 60751)
-    // For T >= 0: R(T) = R0*(1 + A*T + B*T^2)                 - solve quadratic
-    // For T <  0: R(T) = R0*(1 + A*T + B*T^2 + C*(T-100)*T^3) - Newton-Raphson
-    float ratio = resistance / PT1000_R0;
-    float discriminant = PT1000_A * PT1000_A - 4.0f * PT1000_B * (1.0f - ratio);
-    if (discriminant < 0.0f) {
-        BMS_LOGE("PT1000 conversion error: resistance out of range");
-        return 0;
-    }
-    // Only positive root is valid. Check by assuming ratio as 0 (0 deg C). Calculation will be simplified to T1 = (A-A) / (2*B)
-    // and T2 = (-A-A) / (2*B). Since B is negative, T1 will be 0 deg C and T2 will be outside of PT1000 range.
-    float temperature = (-PT1000_A + sqrtf(discriminant)) / (2.0f * PT1000_B);
-
-    // If quadratic yields T < 0, refine with full equation including C coefficient
-    // using Newton-Raphson to calculate formula: f(T) = R0*(1 + A*T + B*T^2 + C*(T-100)*T^3)
-    if (temperature < 0.0f) {
-        float t = temperature; // initial guess from quadratic
-        // Perform Newton-Raphson iterations according to formula x_{n+1} = x_n - f(x_n) / f'(x_n). Max number of iterations is 5.
-        for (int iter = 0; iter < 5; ++iter) {
-            float t2 = t * t;
-            float t3 = t2 * t;
-            // f(T) = R0*(1 + A*T + B*T^2 + C*(T-100)*T^3)
-            float f  = PT1000_R0 * (1.0f + PT1000_A * t + PT1000_B * t2
-                       + PT1000_C * (t - 100.0f) * t3) - resistance;
-            // f'(T) = R0*(A + 2*B*T + C*(4*T^3 - 300*T^2))
-            float df = PT1000_R0 * (PT1000_A + 2.0f * PT1000_B * t
-                       + PT1000_C * (4.0f * t3 - 300.0f * t2));
-            // Accuracy threshold for Newton-Raphson. For thermal degree of freedom is standard engineering value 1e-6.
-            // Prevents to division by zero and limits iterations when close enough to solution.
-            if (fabsf(df) < 1e-6f) {
-                break;
-            }
-            // f(x_n) / f'(x_n)
-            float dt = f / df;
-            // x_n - f(x_n) / f'(x_n)
-            t -= dt;
-            // Stop iterations if change of temperature is below 0.01 deg C.
-            if (fabsf(dt) < 0.01f) {
-                break;
-            }
-        }
-        temperature = t;
-    }
-
-    return temperature;
+    return pt1000_raw_to_celsius(raw_value);
 }
 
 /// This function reads the temperature from the PT1000 sensor connected to GPIO35.
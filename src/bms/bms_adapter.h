@@ -6,11 +6,20 @@
 #pragma once
 
 #include "bms_data.h"
+#include "adc.h"
 #include "esp_err.h"
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
 /*==============================================================================================================*/
+/// ADC pin of the pack current sensor
+#define BMS_CURRENT_ADC_PIN     ADC_PIN_GPIO34
+
+/// Pack current at raw ADC value 0 (A)
+#define BMS_CURRENT_I_MIN       0.0f
+
+/// Pack current at raw ADC value ::ADC_RANGE (A), 50 A LEM HTB 50-P/SP5 sensor
+#define BMS_CURRENT_I_MAX       50.0f
 
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
@@ -34,6 +43,8 @@ typedef struct {
 /*==============================================================================================================*/
 esp_err_t bms_demo_adapter_select(void);
 esp_err_t bms_ltc6804_adapter_select(void);
+esp_err_t bms_sim_adapter_select(void);
+esp_err_t bms_replay_adapter_select(void);
 const bms_adapter_t *bms_get_adapter(void);
 
 /*==============================================================================================================*/
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
@@ -19,11 +20,13 @@
 typedef enum {
     BMS_ADAPTER_LTC6804 = 0,  ///< LTC6804 hardware adapter (default)
     BMS_ADAPTER_DEMO    = 1,  ///< Demo adapter with random data
+    BMS_ADAPTER_SIM     = 2,  ///< Simulator adapter with pack model (bms_sim.c)
+    BMS_ADAPTER_REPLAY  = 3,  ///< Replay of a recorded sample trace (bms_trace.c)
 } bms_adapter_mode_t;
 
 /// Structure defining BMS configuration parameters for measured battery pack
 typedef struct {
-    bms_adapter_mode_t adapter_mode;    ///< Selected BMS adapter (ltc6804 or demo)
+    bms_adapter_mode_t adapter_mode;    ///< Selected BMS adapter (ltc6804, demo, sim or replay)
     uint8_t num_cells;                  ///< Number of cells in the battery pack (runtime configurable)
     bool    current_enable;             ///< Enable current measurement (true = measure, false = skip)
     bool    temperature_enable;         ///< Enable temperature measurement (true = measure, false = skip)
@@ -49,4 +52,36 @@ typedef struct {
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
-/*==============================================================================================================*/
\ No newline at end of file
+/*==============================================================================================================*/
+/// This function returns configuration name of an adapter mode.
+///
+/// \param[in] mode Adapter mode
+/// \return Adapter name ("ltc6804", "demo", "sim" or "replay")
+static inline const char *bms_adapter_mode_name(bms_adapter_mode_t mode)
+{
+    switch (mode) {
+        case BMS_ADAPTER_DEMO:   return "demo";
+        case BMS_ADAPTER_SIM:    return "sim";
+        case BMS_ADAPTER_REPLAY: return "replay";
+        default:                 return "ltc6804";
+    }
+}
+
+/// This function parses configuration name of an adapter mode. Unknown names select the LTC6804 hardware adapter.
+///
+/// \param[in] name Adapter name
+/// \return Adapter mode
+static inline bms_adapter_mode_t bms_adapter_mode_from_name(const char *name)
+{
+    if (strcmp(name, "demo") == 0) {
+        return BMS_ADAPTER_DEMO;
+    }
+    if (strcmp(name, "sim") == 0) {
+        return BMS_ADAPTER_SIM;
+    }
+    if (strcmp(name, "replay") == 0) {
+        return BMS_ADAPTER_REPLAY;
+    }
+
+    return BMS_ADAPTER_LTC6804;
+}
@@ -6,17 +6,63 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "freertos/FreeRTOS.h"
+#include "latency_probe.h"
+#include "timesync.h"
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
 /*==============================================================================================================*/
-/// Maximum number of cells supported by the battery pack. Limited by LTC6804 hardware.
-#define BMS_MAX_CELLS 12
+/// Chain layout from Kconfig: number of chains, and devices and cells per device of each chain. Cells of chain 0
+/// come first in the sample, cells of one chain are ordered by device address.
+#ifndef CONFIG_BMS_LTC_CHAINS
+#define CONFIG_BMS_LTC_CHAINS              1
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN0_ICS
+#define CONFIG_BMS_LTC_CHAIN0_ICS          1
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN0_CELLS_PER_IC
+#define CONFIG_BMS_LTC_CHAIN0_CELLS_PER_IC 12
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN1_ICS
+#define CONFIG_BMS_LTC_CHAIN1_ICS          1
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN1_CELLS_PER_IC
+#define CONFIG_BMS_LTC_CHAIN1_CELLS_PER_IC 12
+#endif
+
+/// Number of cells of the LTC6804 chain layout from Kconfig
+#define BMS_LTC_LAYOUT_CELLS  (CONFIG_BMS_LTC_CHAIN0_ICS * CONFIG_BMS_LTC_CHAIN0_CELLS_PER_IC +    \
+                               (CONFIG_BMS_LTC_CHAINS > 1                                           \
+                                ? CONFIG_BMS_LTC_CHAIN1_ICS * CONFIG_BMS_LTC_CHAIN1_CELLS_PER_IC : 0))
+
+/// Maximum number of cells supported by the battery pack: all cells of the LTC6804 chain layout, at least the 12
+/// cells of one device (other adapters)
+#define BMS_MAX_CELLS  (BMS_LTC_LAYOUT_CELLS > 12 ? BMS_LTC_LAYOUT_CELLS : 12)
+
+// Cell counts and indices are 8-bit; Kconfig ranges keep the layout at 240 cells at most
+#if BMS_MAX_CELLS > 240
+#error "LTC6804 chain layout exceeds 240 cells"
+#endif
+
+/// Number of 32-bit words of a per-cell bitmap
+#define BMS_CELL_MASK_WORDS  ((BMS_MAX_CELLS + 31) / 32)
+
+/// Per-cycle read of LTC6804 cell UV/OV comparator flags (see Kconfig BMS_LTC_HW_FLAGS)
+#ifndef CONFIG_BMS_LTC_HW_FLAGS
+#define CONFIG_BMS_LTC_HW_FLAGS  0
+#endif
 
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
 /*==============================================================================================================*/
+/// Per-cell bitmap sized by ::BMS_MAX_CELLS, bit (c % 32) of word c / 32 stands for cell c.
+typedef struct {
+    uint32_t w[BMS_CELL_MASK_WORDS];  ///< bitmap words
+} bms_cell_mask_t;
+
 /// Structure defining one measured BMS sample.
 typedef struct {
     float      cell_v[BMS_MAX_CELLS];  ///< per-cell voltages
@@ -24,6 +70,17 @@ typedef struct {
     float      pack_i;                 ///< pack current
     float      temperature;            ///< temperature in degrees Celsius
     TickType_t timestamp;              ///< RTOS ticks
+#if CONFIG_BMS_TIMESYNC
+    uint64_t   epoch_ms;               ///< UTC of the Fast Core cycle (ms since the Unix epoch), 0 if not synchronized
+#endif
+#if CONFIG_BMS_LTC_HW_FLAGS
+    bms_cell_mask_t hw_uv;             ///< LTC6804 cell UV flags of the same conversion
+    bms_cell_mask_t hw_ov;             ///< LTC6804 cell OV flags of the same conversion
+#endif
+#if CONFIG_BMS_LATENCY_PROBE
+    uint32_t   acq_us;                 ///< Time when adapter returned the sample (us since boot)
+    uint32_t   enq_us;                 ///< Time when sample was pushed into inter-core queue (us since boot)
+#endif
 } bms_sample_t;
 
 /// Structure defining ring buffer for storing measured BMS samples.
@@ -58,4 +115,48 @@ typedef struct {
 static inline size_t bms_buf_index(const bms_sample_buffer_t *buf, size_t offset)
 {
     return (buf->head + offset) % buf->capacity;
-}
\ No newline at end of file
+}
+
+/// This function sets the bit of one cell in a per-cell bitmap.
+///
+/// \param[in,out] mask Bitmap to update
+/// \param[in] cell Cell index (below ::BMS_MAX_CELLS)
+/// \return None
+static inline void bms_cell_mask_set(bms_cell_mask_t *mask, unsigned cell)
+{
+    mask->w[cell / 32u] |= 1u << (cell % 32u);
+}
+
+/// This function tests the bit of one cell in a per-cell bitmap.
+///
+/// \param[in] mask Bitmap to test
+/// \param[in] cell Cell index (below ::BMS_MAX_CELLS)
+/// \return True if the bit of the cell is set
+static inline bool bms_cell_mask_test(const bms_cell_mask_t *mask, unsigned cell)
+{
+    return (mask->w[cell / 32u] >> (cell % 32u)) & 1u;
+}
+
+/// This function clears the bit of one cell in a per-cell bitmap.
+///
+/// \param[in,out] mask Bitmap to update
+/// \param[in] cell Cell index (below ::BMS_MAX_CELLS)
+/// \return None
+static inline void bms_cell_mask_clear(bms_cell_mask_t *mask, unsigned cell)
+{
+    mask->w[cell / 32u] &= ~(1u << (cell % 32u));
+}
+
+/// This function checks whether any cell bit is set in a per-cell bitmap.
+///
+/// \param[in] mask Bitmap to check
+/// \return True if at least one bit is set
+static inline bool bms_cell_mask_any(const bms_cell_mask_t *mask)
+{
+    for (size_t i = 0; i < BMS_CELL_MASK_WORDS; ++i) {
+        if (mask->w[i]) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,454 @@
+/// Deterministic battery pack simulator used by the simulator BMS adapter and by host soak tests. Every cell is
+/// an equivalent circuit (open circuit voltage over state of charge, series resistance and one RC pair) driven by
+/// a scripted, repeating current profile. Pack temperature follows a lumped thermal model heated by the cells'
+/// resistive losses and cooled towards a slowly drifting ambient temperature. Cells differ slightly in capacity,
+/// resistance and initial state of charge, configurable faults change a cell's parameters or its measurement at
+/// a given time, and Gaussian noise is added to measured values.
+///
+/// All randomness comes from a seeded xorshift32 generator. In deterministic mode the simulated time advances by a
+/// fixed step per sample and sample timestamps are derived from it, so a given seed and configuration always
+/// produce the same sample stream, independently of scheduling. The model is scaled to the configured cell voltage
+/// and current limits, so it produces plausible values (and occasional limit violations) for any configuration.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "bms_sim.h"
+#include "configuration.h"
+#include "logging.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "BMS_SIM"
+
+/// Number of points of the normalized open circuit voltage table
+#define SIM_OCV_POINTS         11
+
+/// Part of the configured cell voltage span kept between open circuit voltage and the limits
+#define SIM_OCV_MARGIN         0.04f
+
+/// Series resistance voltage drop at maximum current, relative to the cell voltage span
+#define SIM_R0_DROP            0.03f
+
+/// RC pair resistance relative to series resistance
+#define SIM_R1_RATIO           0.6f
+
+/// RC pair time constant in seconds
+#define SIM_RC_TAU_S           30.0f
+
+/// Steady-state pack temperature rise at maximum current in degrees Celsius
+#define SIM_T_RISE_C           15.0f
+
+/// Thermal time constant of the pack in seconds
+#define SIM_THERMAL_TAU_S      1800.0f
+
+/// Period of ambient temperature drift in seconds
+#define SIM_AMBIENT_PERIOD_S   21600.0f
+
+/// Self-discharge fault leakage in C
+#define SIM_LEAK_C             0.05f
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void advance(bms_sim_t *sim, float dt_s);
+static float profile_current(const bms_sim_t *sim);
+static void apply_faults(bms_sim_t *sim);
+static float cell_ocv(float soc);
+static uint32_t sim_rand32(bms_sim_t *sim);
+static float sim_rand_uniform(bms_sim_t *sim);
+static float sim_rand_gauss(bms_sim_t *sim);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Open circuit voltage over state of charge in 10 % steps, normalized to the open circuit voltage range
+static const float s_ocv_table[SIM_OCV_POINTS] = {
+    0.00f, 0.18f, 0.30f, 0.38f, 0.45f, 0.52f, 0.60f, 0.69f, 0.79f, 0.89f, 1.00f
+};
+
+/// Default current profile: light load, discharge, peak load pulse, heavy discharge, charge, light load. All steps
+/// stay inside the configured current limits with margin for measurement noise, so limits are only violated by
+/// injected faults.
+static const bms_sim_step_t s_default_profile[] = {
+    {   60.0f,  0.1f  },
+    {  900.0f,  0.5f  },
+    {   10.0f,  0.95f },
+    {  600.0f,  0.8f  },
+    { 1600.0f, -0.6f  },
+    {  120.0f,  0.1f  },
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Built-in simulator instance used by bms_sim_init() and bms_sim_read_sample()
+static bms_sim_t s_sim;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function fills simulator configuration with defaults: seed and run mode from Kconfig, 50 ms step, 90 %
+/// initial charge, 25 deg C ambient with 3 deg C drift, small measurement noise, default profile and no faults.
+///
+/// \param[out] cfg Pointer to configuration to fill
+/// \return None
+void bms_sim_default_config(bms_sim_config_t *cfg)
+{
+    if (!cfg) {
+        return;
+    }
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->seed            = CONFIG_BMS_SIM_SEED;
+    cfg->deterministic   = CONFIG_BMS_SIM_DETERMINISTIC;
+    cfg->dt_ms           = 50;
+    cfg->capacity_ah     = 0.0f;
+    cfg->initial_soc     = 0.9f;
+    cfg->ambient_c       = 25.0f;
+    cfg->ambient_drift_c = 3.0f;
+    cfg->noise_v         = 0.001f;
+    cfg->noise_i         = 0.02f;
+    cfg->noise_t         = 0.1f;
+    memcpy(cfg->profile, s_default_profile, sizeof(s_default_profile));
+    cfg->profile_len     = (uint8_t)(sizeof(s_default_profile) / sizeof(s_default_profile[0]));
+
+    return;
+}
+
+/// This function initializes the built-in simulator instance used by the simulator adapter. Cell parameters are
+/// derived from the configured battery limits and varied per cell by the seeded random generator, so it has to be
+/// called after configuration is loaded.
+///
+/// \param[in] cfg Pointer to simulator configuration (NULL = defaults of bms_sim_default_config())
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid configuration
+esp_err_t bms_sim_init(const bms_sim_config_t *cfg)
+{
+    return bms_sim_inst_init(&s_sim, cfg);
+}
+
+/// This function advances the built-in simulator instance and produces one measured sample.
+///
+/// \param[out] out Pointer to output sample structure
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL output
+esp_err_t bms_sim_read_sample(bms_sample_t *out)
+{
+    return bms_sim_inst_read_sample(&s_sim, out);
+}
+
+/// This function returns simulated time of the built-in simulator instance since bms_sim_init().
+///
+/// \param None
+/// \return Simulated time in seconds
+float bms_sim_time_s(void)
+{
+    return (float)s_sim.time_s;
+}
+
+/// This function initializes an independent simulator instance (see bms_sim_init()). Instances share the battery
+/// configuration but have their own pack state and random generator, e.g. to emulate a fleet of devices.
+///
+/// \param[out] sim Pointer to simulator instance
+/// \param[in] cfg Pointer to simulator configuration (NULL = defaults of bms_sim_default_config())
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid configuration or NULL instance
+esp_err_t bms_sim_inst_init(bms_sim_t *sim, const bms_sim_config_t *cfg)
+{
+    if (!sim) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (cfg) {
+        if (cfg->profile_len == 0 || cfg->profile_len > BMS_SIM_MAX_STEPS ||
+            cfg->fault_count > BMS_SIM_MAX_FAULTS || (cfg->deterministic && cfg->dt_ms == 0)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint8_t i = 0; i < cfg->profile_len; ++i) {
+            if (cfg->profile[i].duration_s <= 0.0f) {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        sim->cfg = *cfg;
+    } else {
+        bms_sim_default_config(&sim->cfg);
+    }
+
+    sim->rng = sim->cfg.seed;
+    if (sim->rng == 0) {
+        esp_fill_random(&sim->rng, sizeof(sim->rng));
+        if (sim->rng == 0) {
+            sim->rng = 0x12345678u;
+        }
+    }
+
+    const float i_max = (g_cfg.battery.series_pack_i_max > 0.0f) ? g_cfg.battery.series_pack_i_max : 1.0f;
+    const float v_span = g_cfg.battery.cell_v_max - g_cfg.battery.cell_v_min;
+    const float capacity_ah = (sim->cfg.capacity_ah > 0.0f) ? sim->cfg.capacity_ah : 0.5f * i_max;
+    const float r0 = SIM_R0_DROP * v_span / i_max;
+
+    // Cells differ by up to +-3 % in capacity, +-10 % in resistance and +-2 % in initial state of charge
+    for (int i = 0; i < BMS_MAX_CELLS; ++i) {
+        bms_sim_cell_t *c = &sim->cells[i];
+        memset(c, 0, sizeof(*c));
+        c->capacity_as = capacity_ah * 3600.0f * (1.0f + 0.06f * (sim_rand_uniform(sim) - 0.5f));
+        c->r0          = r0 * (1.0f + 0.2f * (sim_rand_uniform(sim) - 0.5f));
+        c->r1          = c->r0 * SIM_R1_RATIO;
+        c->soc         = sim->cfg.initial_soc + 0.04f * (sim_rand_uniform(sim) - 0.5f);
+        if (c->soc < 0.0f) c->soc = 0.0f;
+        if (c->soc > 1.0f) c->soc = 1.0f;
+    }
+
+    sim->temp_c = sim->cfg.ambient_c;
+    sim->current_a = 0.0f;
+    sim->time_s = 0.0;
+    sim->step = 0;
+    sim->step_time_s = 0.0f;
+    sim->faults_applied = 0;
+    sim->samples = 0;
+    sim->last_tick = xTaskGetTickCount();
+
+    BMS_LOGI("Simulator initialized (seed %lu, %s, %.2f Ah, %u profile steps, %u faults)",
+             (unsigned long)sim->cfg.seed, sim->cfg.deterministic ? "deterministic" : "real-time",
+             capacity_ah, (unsigned)sim->cfg.profile_len, (unsigned)sim->cfg.fault_count);
+
+    return ESP_OK;
+}
+
+/// This function advances a simulator instance and produces one measured sample. In deterministic mode the
+/// simulated time advances by the configured step and the timestamp is the simulated time in ticks, otherwise the
+/// simulation follows the tick count.
+///
+/// \param[in, out] sim Pointer to simulator instance
+/// \param[out] out Pointer to output sample structure
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL instance or output
+esp_err_t bms_sim_inst_read_sample(bms_sim_t *sim, bms_sample_t *out)
+{
+    if (!sim || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TickType_t tick = xTaskGetTickCount();
+    float dt_s;
+    if (sim->cfg.deterministic) {
+        dt_s = (sim->samples == 0) ? 0.0f : (float)sim->cfg.dt_ms * 0.001f;
+    } else {
+        dt_s = (float)(TickType_t)(tick - sim->last_tick) / (float)configTICK_RATE_HZ;
+    }
+    sim->last_tick = tick;
+    advance(sim, dt_s);
+    sim->samples++;
+
+    float pack_v = 0.0f;
+    for (int i = 0; i < g_cfg.battery.num_cells; ++i) {
+        bms_sim_cell_t *c = &sim->cells[i];
+        float v = cell_ocv(c->soc) - sim->current_a * c->r0 - c->v_rc + sim->cfg.noise_v * sim_rand_gauss(sim);
+        if (c->open_wire) {
+            v = 0.0f;
+        } else if (c->stuck) {
+            v = c->stuck_v;
+        }
+        c->stuck_v = c->stuck ? c->stuck_v : v;
+        // Measured with the 100 uV resolution of the LTC6804 cell voltage codes
+        v = (v > 0.0f) ? (float)lroundf(v * 10000.0f) * 0.0001f : 0.0f;
+        out->cell_v[i] = v;
+        pack_v += v;
+    }
+    out->pack_v = pack_v;
+
+    // Current is measured as magnitude, as by the unidirectional current sensor of the hardware adapter
+    if (g_cfg.battery.current_enable) {
+        out->pack_i = fabsf(sim->current_a) + sim->cfg.noise_i * sim_rand_gauss(sim);
+    } else {
+        out->pack_i = 0.0f;
+    }
+
+    if (g_cfg.battery.temperature_enable) {
+        out->temperature = sim->temp_c + sim->cfg.noise_t * sim_rand_gauss(sim);
+    } else {
+        out->temperature = 0.0f;
+    }
+
+    if (sim->cfg.deterministic) {
+        out->timestamp = (TickType_t)(sim->time_s * (double)configTICK_RATE_HZ + 0.5);
+    } else {
+        out->timestamp = tick;
+    }
+
+    return ESP_OK;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function advances cells, profile and thermal model by the given time. RC pair and thermal model use
+/// exact exponential discretization, so any step size is stable.
+///
+/// \param[in, out] sim Pointer to simulator instance
+/// \param[in] dt_s Time step in seconds
+/// \return None
+static void advance(bms_sim_t *sim, float dt_s)
+{
+    if (dt_s <= 0.0f) {
+        sim->current_a = profile_current(sim);
+        return;
+    }
+
+    sim->time_s += dt_s;
+    apply_faults(sim);
+
+    // Profile step sequencing, profile repeats after last step
+    sim->step_time_s += dt_s;
+    while (sim->step_time_s >= sim->cfg.profile[sim->step].duration_s) {
+        sim->step_time_s -= sim->cfg.profile[sim->step].duration_s;
+        sim->step = (uint8_t)((sim->step + 1u) % sim->cfg.profile_len);
+    }
+    sim->current_a = profile_current(sim);
+
+    // Resistance rises by 1 %/deg C below 25 deg C and falls above it (limited to half of nominal)
+    float r_scale = 1.0f + 0.01f * (25.0f - sim->temp_c);
+    if (r_scale < 0.5f) {
+        r_scale = 0.5f;
+    }
+
+    const float rc_decay = expf(-dt_s / SIM_RC_TAU_S);
+    float heat_w = 0.0f;
+    for (int i = 0; i < BMS_MAX_CELLS; ++i) {
+        bms_sim_cell_t *c = &sim->cells[i];
+        float i_cell = sim->current_a + c->leak_a;
+        c->soc -= i_cell * dt_s / c->capacity_as;
+        if (c->soc < 0.0f) c->soc = 0.0f;
+        if (c->soc > 1.0f) c->soc = 1.0f;
+        c->v_rc = c->v_rc * rc_decay + sim->current_a * c->r1 * r_scale * (1.0f - rc_decay);
+        if (i < g_cfg.battery.num_cells) {
+            heat_w += sim->current_a * sim->current_a * (c->r0 + c->r1) * r_scale;
+        }
+    }
+
+    // Lumped thermal model, thermal resistance gives SIM_T_RISE_C at maximum current with nominal resistance
+    const float i_max = (g_cfg.battery.series_pack_i_max > 0.0f) ? g_cfg.battery.series_pack_i_max : 1.0f;
+    const float p_max = i_max * i_max * (sim->cells[0].r0 + sim->cells[0].r1) *
+                        (float)(g_cfg.battery.num_cells ? g_cfg.battery.num_cells : 1);
+    const float r_th = (p_max > 0.0f) ? SIM_T_RISE_C / p_max : 0.0f;
+    const float ambient = sim->cfg.ambient_c +
+                          sim->cfg.ambient_drift_c * sinf((float)(6.2831853 * fmod(sim->time_s, SIM_AMBIENT_PERIOD_S) /
+                                                               SIM_AMBIENT_PERIOD_S));
+    const float t_eq = ambient + heat_w * r_th;
+    sim->temp_c = t_eq + (sim->temp_c - t_eq) * expf(-dt_s / SIM_THERMAL_TAU_S);
+
+    return;
+}
+
+/// This function returns pack current of the active profile step.
+///
+/// \param[in] sim Pointer to simulator instance
+/// \return Pack current in amps (positive = discharge)
+static float profile_current(const bms_sim_t *sim)
+{
+    float level = sim->cfg.profile[sim->step].level;
+    float span = g_cfg.battery.series_pack_i_max - g_cfg.battery.series_pack_i_min;
+    float magnitude = g_cfg.battery.series_pack_i_min + fabsf(level) * span;
+
+    return (level < 0.0f) ? -magnitude : magnitude;
+}
+
+/// This function applies faults whose start time was reached. Each fault is applied once.
+///
+/// \param[in, out] sim Pointer to simulator instance
+/// \return None
+static void apply_faults(bms_sim_t *sim)
+{
+    for (uint8_t f = 0; f < sim->cfg.fault_count; ++f) {
+        const bms_sim_fault_t *fault = &sim->cfg.faults[f];
+        if ((sim->faults_applied & (1u << f)) || sim->time_s < fault->start_s || fault->cell >= BMS_MAX_CELLS) {
+            continue;
+        }
+        sim->faults_applied |= (1u << f);
+
+        bms_sim_cell_t *c = &sim->cells[fault->cell];
+        switch (fault->kind) {
+            case BMS_SIM_FAULT_HIGH_RESISTANCE: c->r0 *= 4.0f; c->r1 *= 4.0f;                    break;
+            case BMS_SIM_FAULT_LOW_CAPACITY:    c->capacity_as *= 0.5f;                           break;
+            case BMS_SIM_FAULT_SELF_DISCHARGE:  c->leak_a = SIM_LEAK_C * c->capacity_as / 3600.0f; break;
+            case BMS_SIM_FAULT_OPEN_WIRE:       c->open_wire = true;                              break;
+            case BMS_SIM_FAULT_STUCK:           c->stuck = true;                                  break;
+            default:                                                                              break;
+        }
+        BMS_LOGW("Simulated fault %d on cell %u at %.1f s", (int)fault->kind, (unsigned)fault->cell + 1u,
+                 (double)sim->time_s);
+    }
+
+    return;
+}
+
+/// This function returns open circuit voltage of a cell. The normalized table is mapped into the configured cell
+/// voltage limits, leaving ::SIM_OCV_MARGIN of the span on both sides for resistive drops.
+///
+/// \param[in] soc State of charge (0 to 1)
+/// \return Open circuit voltage in volts
+static float cell_ocv(float soc)
+{
+    const float v_span = g_cfg.battery.cell_v_max - g_cfg.battery.cell_v_min;
+    const float v_lo = g_cfg.battery.cell_v_min + SIM_OCV_MARGIN * v_span;
+    const float v_hi = g_cfg.battery.cell_v_max - SIM_OCV_MARGIN * v_span;
+
+    float x = soc * (float)(SIM_OCV_POINTS - 1);
+    int idx = (int)x;
+    if (idx >= SIM_OCV_POINTS - 1) {
+        idx = SIM_OCV_POINTS - 2;
+    }
+    float frac = x - (float)idx;
+    float norm = s_ocv_table[idx] + frac * (s_ocv_table[idx + 1] - s_ocv_table[idx]);
+
+    return v_lo + norm * (v_hi - v_lo);
+}
+
+/// This function returns next value of the xorshift32 random generator.
+///
+/// \param[in, out] sim Pointer to simulator instance
+/// \return Pseudo-random 32-bit unsigned integer
+static uint32_t sim_rand32(bms_sim_t *sim)
+{
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+
+    return x;
+}
+
+/// This function returns a pseudo-random float in the range [0, 1).
+///
+/// \param[in, out] sim Pointer to simulator instance
+/// \return Pseudo-random float
+static float sim_rand_uniform(bms_sim_t *sim)
+{
+    return (sim_rand32(sim) & 0xFFFFFFu) / (float)0x1000000u;
+}
+
+/// This function returns a standard normal pseudo-random value (Box-Muller transform).
+///
+/// \param[in, out] sim Pointer to simulator instance
+/// \return Pseudo-random value with zero mean and unit variance
+static float sim_rand_gauss(bms_sim_t *sim)
+{
+    float u1 = ((float)(sim_rand32(sim) & 0xFFFFFFu) + 1.0f) / 16777217.0f;
+    float u2 = sim_rand_uniform(sim);
+
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
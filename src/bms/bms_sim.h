@@ -0,0 +1,126 @@
+/// Header file for `bms_sim.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "bms_data.h"
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Maximum number of steps of a current profile
+#define BMS_SIM_MAX_STEPS       16
+
+/// Maximum number of injected cell faults
+#define BMS_SIM_MAX_FAULTS      4
+
+/// Seed of simulator random generator (0 = seed from hardware random number generator)
+#ifndef CONFIG_BMS_SIM_SEED
+#define CONFIG_BMS_SIM_SEED     1
+#endif
+
+/// Deterministic run mode of simulator adapter (simulated time instead of wall clock)
+#ifndef CONFIG_BMS_SIM_DETERMINISTIC
+#define CONFIG_BMS_SIM_DETERMINISTIC  0
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of one step of the scripted current profile. Pack current of the step is
+/// i_min + |level| * (i_max - i_min) of the configured series current limits, negative level charges the pack.
+typedef struct {
+    float duration_s;           ///< Step duration in seconds
+    float level;                ///< Current level relative to configured current limits (see above)
+} bms_sim_step_t;
+
+/// Kind of injected cell fault
+typedef enum {
+    BMS_SIM_FAULT_NONE = 0,             ///< No fault
+    BMS_SIM_FAULT_HIGH_RESISTANCE,      ///< Internal resistance four times nominal (degraded connection)
+    BMS_SIM_FAULT_LOW_CAPACITY,         ///< Remaining capacity halved (aged cell)
+    BMS_SIM_FAULT_SELF_DISCHARGE,       ///< Internal leakage of 0.05 C (soft short)
+    BMS_SIM_FAULT_OPEN_WIRE,            ///< Open sense wire, cell measured as 0 V
+    BMS_SIM_FAULT_STUCK,                ///< Cell measurement frozen at the value of fault start
+} bms_sim_fault_kind_t;
+
+/// Structure of one injected cell fault
+typedef struct {
+    bms_sim_fault_kind_t kind;  ///< Kind of fault
+    uint8_t cell;               ///< Cell index (0 = cell 1)
+    float   start_s;            ///< Simulated time of fault start in seconds
+} bms_sim_fault_t;
+
+/// Structure of simulator configuration
+typedef struct {
+    uint32_t seed;                              ///< Random generator seed (0 = hardware random seed)
+    bool     deterministic;                     ///< Advance simulated time by dt_ms per sample, not by wall clock
+    uint32_t dt_ms;                             ///< Simulated time per sample in deterministic mode
+    float    capacity_ah;                       ///< Nominal cell capacity (0 = half an hour at maximum current)
+    float    initial_soc;                       ///< Initial state of charge (0 to 1)
+    float    ambient_c;                         ///< Mean ambient temperature in degrees Celsius
+    float    ambient_drift_c;                   ///< Amplitude of slow (6 h period) ambient temperature drift
+    float    noise_v;                           ///< Standard deviation of cell voltage measurement noise (V)
+    float    noise_i;                           ///< Standard deviation of current measurement noise (A)
+    float    noise_t;                           ///< Standard deviation of temperature measurement noise (deg C)
+    bms_sim_step_t  profile[BMS_SIM_MAX_STEPS]; ///< Current profile, repeated when it ends
+    uint8_t         profile_len;                ///< Number of profile steps
+    bms_sim_fault_t faults[BMS_SIM_MAX_FAULTS]; ///< Injected cell faults
+    uint8_t         fault_count;                ///< Number of injected faults
+} bms_sim_config_t;
+
+/// Structure of simulated cell state
+typedef struct {
+    float soc;                  ///< State of charge (0 to 1)
+    float v_rc;                 ///< Voltage across RC pair
+    float capacity_as;          ///< Capacity in ampere-seconds
+    float r0;                   ///< Series resistance in ohms
+    float r1;                   ///< RC pair resistance in ohms
+    float leak_a;               ///< Internal leakage current in amps
+    float stuck_v;              ///< Frozen measurement (valid when stuck)
+    bool  stuck;                ///< Measurement frozen
+    bool  open_wire;            ///< Sense wire open
+} bms_sim_cell_t;
+
+/// Structure of simulator instance state (private to bms_sim.c, exposed for allocation by the caller)
+typedef struct {
+    bms_sim_config_t cfg;                       ///< Active configuration
+    bms_sim_cell_t   cells[BMS_MAX_CELLS];      ///< Simulated cells
+    float            temp_c;                    ///< Pack temperature in degrees Celsius
+    float            current_a;                 ///< Pack current in amps (positive = discharge)
+    double           time_s;                    ///< Simulated time in seconds
+    uint8_t          step;                      ///< Current profile step
+    float            step_time_s;               ///< Time spent in current profile step in seconds
+    uint32_t         faults_applied;            ///< Bit mask of faults already applied
+    TickType_t       last_tick;                 ///< Tick count of the previous sample (real-time mode)
+    uint32_t         samples;                   ///< Number of produced samples
+    uint32_t         rng;                       ///< Random generator state
+} bms_sim_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void bms_sim_default_config(bms_sim_config_t *cfg);
+esp_err_t bms_sim_init(const bms_sim_config_t *cfg);
+esp_err_t bms_sim_read_sample(bms_sample_t *out);
+float bms_sim_time_s(void);
+esp_err_t bms_sim_inst_init(bms_sim_t *sim, const bms_sim_config_t *cfg);
+esp_err_t bms_sim_inst_read_sample(bms_sim_t *sim, bms_sample_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -0,0 +1,556 @@
+/// Recording and replay of raw BMS sample streams. A trace is a compact binary file: a 16 byte header followed by
+/// fixed size records, one per adapter sample, all little-endian.
+///
+///   header: magic "BMST" (4), version (1), number of cells (1), tick rate in Hz (2), tick count at recording
+///           start (4), reserved (4)
+///   record: ticks since previous record (2), cell voltage codes in 100 uV steps (2 per cell), pack current (float,
+///           4), temperature (float, 4)
+///
+/// Cell voltages use the LTC6804 code resolution, so samples read from hardware are stored without loss. Pack
+/// voltage is not stored, it is the sum of cell voltages as in every adapter.
+///
+/// The recorder is split between cores. The Fast Core only encodes a record into a RAM ring buffer (bounded time,
+/// never blocks, records are dropped when the buffer is full) and the Slow Core writes the buffered records to the
+/// file once per processing cycle. The replay side reads records back from a file on host or on SPIFFS and
+/// returns them with their recorded timestamps, either immediately or paced in real time.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "bms_trace.h"
+#include "logging.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "BMS_TRACE"
+
+/// Maximum size of one record in bytes
+#define TRACE_RECORD_MAX        BMS_TRACE_RECORD_SIZE(BMS_MAX_CELLS)
+
+/// Size of stdio buffer of replayed trace file (fewer, larger flash reads on SPIFFS)
+#define TRACE_READ_BUF_SIZE     512
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void put_u16(uint8_t *p, uint16_t v);
+static void put_u32(uint8_t *p, uint32_t v);
+static uint16_t get_u16(const uint8_t *p);
+static uint32_t get_u32(const uint8_t *p);
+static void put_f32(uint8_t *p, float v);
+static float get_f32(const uint8_t *p);
+static esp_err_t write_header(void);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Recorder RAM ring buffer (written by Fast Core, drained by Slow Core)
+static uint8_t s_ring[CONFIG_BMS_TRACE_BUFFER_SIZE];
+/// Free-running write position in ring buffer (advanced by producer only)
+static uint32_t s_ring_head = 0;
+/// Free-running read position in ring buffer (advanced by consumer only)
+static uint32_t s_ring_tail = 0;
+/// Spinlock protecting ring positions and recorder counters
+static portMUX_TYPE s_rec_lock = portMUX_INITIALIZER_UNLOCKED;
+/// Recorder running
+static volatile bool s_rec_active = false;
+/// Recorded trace file
+static FILE *s_rec_file = NULL;
+/// Number of recorded cells
+static uint8_t s_rec_cells = 0;
+/// Maximum trace file size in bytes
+static uint32_t s_rec_max_bytes = 0;
+/// Number of bytes accepted for the file (header and records in file or ring buffer)
+static uint32_t s_rec_accepted_bytes = 0;
+/// Timestamp of last accepted record
+static TickType_t s_rec_last_tick = 0;
+/// Recording start written to file header (timestamp of first record)
+static TickType_t s_rec_start_tick = 0;
+/// No record accepted yet (first record defines recording start tick)
+static bool s_rec_first = true;
+/// File header not written yet
+static bool s_rec_header_pending = false;
+/// Recorder counters
+static bms_trace_rec_stats_t s_rec_stats;
+
+/// Replayed trace file
+static FILE *s_rp_file = NULL;
+/// stdio buffer of replayed trace file
+static char s_rp_iobuf[TRACE_READ_BUF_SIZE];
+/// Number of cells in replayed trace
+static uint8_t s_rp_cells = 0;
+/// Replay pacing
+static bms_trace_pace_t s_rp_pace = BMS_TRACE_PACE_NONE;
+/// Restart at end of trace
+static bool s_rp_loop = false;
+/// Recorded tick count of the last returned record (continues across loops)
+static TickType_t s_rp_tick = 0;
+/// Recorded tick count at recording start
+static TickType_t s_rp_start_tick = 0;
+/// Tick count at replay start (real-time pacing)
+static TickType_t s_rp_wall_start = 0;
+/// Number of records returned since the trace was opened or restarted
+static uint32_t s_rp_records = 0;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function starts trace recording. Creates the trace file and resets the RAM buffer. The file header is
+/// written by the first flush, with the timestamp of the first record as recording start. Must not be called while
+/// recording is active; samples are accepted once this function returns.
+///
+/// \param[in] path Path of trace file (overwritten)
+/// \param[in] num_cells Number of cells stored per record (1 to ::BMS_MAX_CELLS)
+/// \param[in] max_bytes Maximum trace file size in bytes, further records are dropped
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid arguments, ESP_ERR_INVALID_STATE if already
+///         recording, ESP_FAIL if the file cannot be created
+esp_err_t bms_trace_rec_start(const char *path, uint8_t num_cells, uint32_t max_bytes)
+{
+    if (!path || num_cells == 0 || num_cells > BMS_MAX_CELLS || max_bytes < BMS_TRACE_HEADER_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_rec_active || s_rec_file) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        BMS_LOGE("Failed to create trace file %s", path);
+        return ESP_FAIL;
+    }
+
+    taskENTER_CRITICAL(&s_rec_lock);
+    s_rec_file           = f;
+    s_rec_cells          = num_cells;
+    s_rec_max_bytes      = max_bytes;
+    s_rec_accepted_bytes = BMS_TRACE_HEADER_SIZE;
+    s_rec_last_tick      = xTaskGetTickCount();
+    s_rec_start_tick     = s_rec_last_tick;
+    s_rec_first          = true;
+    s_rec_header_pending = true;
+    s_ring_head          = 0;
+    s_ring_tail          = 0;
+    memset(&s_rec_stats, 0, sizeof(s_rec_stats));
+    s_rec_stats.active        = true;
+    s_rec_active              = true;
+    taskEXIT_CRITICAL(&s_rec_lock);
+
+    BMS_LOGI("Trace recording to %s (%u cells, %u byte records, max %lu bytes)", path, (unsigned)num_cells,
+             (unsigned)BMS_TRACE_RECORD_SIZE(num_cells), (unsigned long)max_bytes);
+
+    return ESP_OK;
+}
+
+/// This function appends one raw sample to the trace. Called from the Fast Core right after the adapter read:
+/// encodes the record and copies it into the RAM buffer, file access is left to ::bms_trace_rec_flush. When the
+/// buffer is full or the file size limit is reached the record is dropped and counted. Does nothing when the
+/// recorder is not running.
+///
+/// \param[in] sample Pointer to sample to record
+/// \return None
+void bms_trace_rec_push(const bms_sample_t *sample)
+{
+    if (!s_rec_active || !sample) {
+        return;
+    }
+
+    uint8_t rec[TRACE_RECORD_MAX];
+    const size_t size = BMS_TRACE_RECORD_SIZE(s_rec_cells);
+
+    // Reserve space in buffer and file (consumer only ever frees space, so the check stays valid after unlock)
+    taskENTER_CRITICAL(&s_rec_lock);
+    bool fits = ((s_ring_head - s_ring_tail) + size <= CONFIG_BMS_TRACE_BUFFER_SIZE) &&
+                (s_rec_accepted_bytes + size <= s_rec_max_bytes);
+    if (!fits) {
+        s_rec_stats.dropped++;
+    }
+    TickType_t dt = s_rec_first ? 0 : (TickType_t)(sample->timestamp - s_rec_last_tick);
+    uint32_t head = s_ring_head;
+    taskEXIT_CRITICAL(&s_rec_lock);
+    if (!fits) {
+        return;
+    }
+
+    // Encode record. Gaps longer than 65535 ticks are shortened, the trace has no such gaps in normal operation.
+    put_u16(&rec[0], (dt > 0xFFFFu) ? 0xFFFFu : (uint16_t)dt);
+    size_t pos = 2;
+    for (uint8_t c = 0; c < s_rec_cells; ++c) {
+        long code = lroundf(sample->cell_v[c] * 10000.0f);
+        code = (code < 0) ? 0 : (code > 0xFFFF) ? 0xFFFF : code;
+        put_u16(&rec[pos], (uint16_t)code);
+        pos += 2;
+    }
+    put_f32(&rec[pos], sample->pack_i);
+    put_f32(&rec[pos + 4], sample->temperature);
+
+    // Copy into ring buffer outside of critical section (region is owned by producer until head is advanced)
+    size_t offset = head % CONFIG_BMS_TRACE_BUFFER_SIZE;
+    size_t first = CONFIG_BMS_TRACE_BUFFER_SIZE - offset;
+    if (first >= size) {
+        memcpy(&s_ring[offset], rec, size);
+    } else {
+        memcpy(&s_ring[offset], rec, first);
+        memcpy(&s_ring[0], &rec[first], size - first);
+    }
+
+    taskENTER_CRITICAL(&s_rec_lock);
+    s_ring_head          += (uint32_t)size;
+    s_rec_accepted_bytes += (uint32_t)size;
+    s_rec_last_tick       = sample->timestamp;
+    if (s_rec_first) {
+        s_rec_start_tick = sample->timestamp;
+        s_rec_first      = false;
+    }
+    s_rec_stats.records++;
+    uint32_t used = s_ring_head - s_ring_tail;
+    if (used > s_rec_stats.buffer_peak) {
+        s_rec_stats.buffer_peak = used;
+    }
+    taskEXIT_CRITICAL(&s_rec_lock);
+
+    return;
+}
+
+/// This function writes all buffered records to the trace file and flushes it. Called periodically from the Slow
+/// Core (once per processing cycle); the RAM buffer must be able to hold the records of one cycle. On write error
+/// recording stops.
+///
+/// \param None
+/// \return ESP_OK on success or when not recording, ESP_FAIL on write error
+esp_err_t bms_trace_rec_flush(void)
+{
+    if (!s_rec_file) {
+        return ESP_OK;
+    }
+
+    taskENTER_CRITICAL(&s_rec_lock);
+    uint32_t head = s_ring_head;
+    uint32_t tail = s_ring_tail;
+    taskEXIT_CRITICAL(&s_rec_lock);
+
+    if (s_rec_header_pending && write_header() != ESP_OK) {
+        BMS_LOGE("Trace header write failed, recording stopped");
+        s_rec_active = false;
+        s_rec_stats.active = false;
+        fclose(s_rec_file);
+        s_rec_file = NULL;
+        return ESP_FAIL;
+    }
+
+    while (tail != head) {
+        size_t offset = tail % CONFIG_BMS_TRACE_BUFFER_SIZE;
+        size_t chunk = head - tail;
+        if (chunk > CONFIG_BMS_TRACE_BUFFER_SIZE - offset) {
+            chunk = CONFIG_BMS_TRACE_BUFFER_SIZE - offset;
+        }
+        if (fwrite(&s_ring[offset], 1, chunk, s_rec_file) != chunk) {
+            BMS_LOGE("Trace write failed, recording stopped");
+            s_rec_active = false;
+            s_rec_stats.active = false;
+            fclose(s_rec_file);
+            s_rec_file = NULL;
+            return ESP_FAIL;
+        }
+        tail += (uint32_t)chunk;
+
+        taskENTER_CRITICAL(&s_rec_lock);
+        s_ring_tail = tail;
+        s_rec_stats.bytes_written += (uint32_t)chunk;
+        taskEXIT_CRITICAL(&s_rec_lock);
+    }
+    fflush(s_rec_file);
+
+    return ESP_OK;
+}
+
+/// This function stops trace recording, writes remaining buffered records and closes the trace file.
+///
+/// \param None
+/// \return ESP_OK on success, ESP_ERR_INVALID_STATE if not recording, ESP_FAIL on write error
+esp_err_t bms_trace_rec_stop(void)
+{
+    if (!s_rec_file) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_rec_active = false;
+    esp_err_t err = bms_trace_rec_flush();
+    if (s_rec_file) {
+        fclose(s_rec_file);
+        s_rec_file = NULL;
+    }
+    s_rec_stats.active = false;
+
+    BMS_LOGI("Trace recording stopped: %lu records, %lu dropped, %lu bytes, buffer peak %lu bytes",
+             (unsigned long)s_rec_stats.records, (unsigned long)s_rec_stats.dropped,
+             (unsigned long)s_rec_stats.bytes_written, (unsigned long)s_rec_stats.buffer_peak);
+
+    return err;
+}
+
+/// This function returns a snapshot of trace recorder counters.
+///
+/// \param[out] out Pointer to counters
+/// \return None
+void bms_trace_rec_get_stats(bms_trace_rec_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_rec_lock);
+    *out = s_rec_stats;
+    taskEXIT_CRITICAL(&s_rec_lock);
+
+    return;
+}
+
+/// This function opens a trace for replay and validates its header. A previously opened trace is closed.
+///
+/// \param[in] path Path of trace file
+/// \param[in] pace Replay pacing
+/// \param[in] loop Restart from the first record at the end of the trace
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid arguments, ESP_ERR_NOT_FOUND if the file cannot be
+///         opened, ESP_ERR_INVALID_VERSION on invalid header
+esp_err_t bms_trace_replay_open(const char *path, bms_trace_pace_t pace, bool loop)
+{
+    if (!path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bms_trace_replay_close();
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        BMS_LOGE("Failed to open trace file %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+    setvbuf(f, s_rp_iobuf, _IOFBF, sizeof(s_rp_iobuf));
+
+    uint8_t hdr[BMS_TRACE_HEADER_SIZE];
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) || get_u32(&hdr[0]) != BMS_TRACE_MAGIC ||
+        hdr[4] != BMS_TRACE_VERSION || hdr[5] == 0 || hdr[5] > BMS_MAX_CELLS) {
+        BMS_LOGE("Invalid trace header in %s", path);
+        fclose(f);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (get_u16(&hdr[6]) != configTICK_RATE_HZ) {
+        BMS_LOGW("Trace recorded at %u Hz tick rate, replaying at %u Hz", (unsigned)get_u16(&hdr[6]),
+                 (unsigned)configTICK_RATE_HZ);
+    }
+
+    s_rp_file       = f;
+    s_rp_cells      = hdr[5];
+    s_rp_pace       = pace;
+    s_rp_loop       = loop;
+    s_rp_start_tick = (TickType_t)get_u32(&hdr[8]);
+    s_rp_tick       = s_rp_start_tick;
+    s_rp_wall_start = xTaskGetTickCount();
+    s_rp_records    = 0;
+
+    BMS_LOGI("Replaying trace %s (%u cells, %s%s)", path, (unsigned)s_rp_cells,
+             (pace == BMS_TRACE_PACE_REALTIME) ? "real time" : "unpaced", loop ? ", looped" : "");
+
+    return ESP_OK;
+}
+
+/// This function returns the next sample of the replayed trace. Timestamps are the recorded ones, continued
+/// monotonically when the trace is looped. Cells not stored in the trace read as 0 V. A truncated last record
+/// (recording interrupted by reset) is treated as the end of the trace.
+///
+/// \param[out] out Pointer to output sample
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG if out is NULL, ESP_ERR_INVALID_STATE if no trace is open,
+///         ESP_ERR_NOT_FOUND at the end of a trace which is not looped or has no records
+esp_err_t bms_trace_replay_read(bms_sample_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_rp_file) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t rec[TRACE_RECORD_MAX];
+    const size_t size = BMS_TRACE_RECORD_SIZE(s_rp_cells);
+    if (fread(rec, 1, size, s_rp_file) != size) {
+        if (!s_rp_loop || s_rp_records == 0 || fseek(s_rp_file, BMS_TRACE_HEADER_SIZE, SEEK_SET) != 0 ||
+            fread(rec, 1, size, s_rp_file) != size) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        s_rp_records = 0;
+    }
+    s_rp_records++;
+    s_rp_tick += (TickType_t)get_u16(&rec[0]);
+
+    float pack_v = 0.0f;
+    size_t pos = 2;
+    for (uint8_t c = 0; c < BMS_MAX_CELLS; ++c) {
+        if (c < s_rp_cells) {
+            out->cell_v[c] = (float)get_u16(&rec[pos]) * 0.0001f;
+            pack_v += out->cell_v[c];
+            pos += 2;
+        } else {
+            out->cell_v[c] = 0.0f;
+        }
+    }
+    out->pack_v      = pack_v;
+    out->pack_i      = get_f32(&rec[pos]);
+    out->temperature = get_f32(&rec[pos + 4]);
+    out->timestamp   = s_rp_tick;
+
+    if (s_rp_pace == BMS_TRACE_PACE_REALTIME) {
+        TickType_t due = s_rp_wall_start + (s_rp_tick - s_rp_start_tick);
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(due - now) > 0) {
+            vTaskDelay(due - now);
+        }
+    }
+
+    return ESP_OK;
+}
+
+/// This function closes the replayed trace.
+///
+/// \param None
+/// \return None
+void bms_trace_replay_close(void)
+{
+    if (s_rp_file) {
+        fclose(s_rp_file);
+        s_rp_file = NULL;
+    }
+    s_rp_cells = 0;
+
+    return;
+}
+
+/// This function returns the number of cells stored in the replayed trace.
+///
+/// \param None
+/// \return Number of cells, 0 if no trace is open
+uint8_t bms_trace_replay_cells(void)
+{
+    return s_rp_cells;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function stores a 16-bit value in little-endian byte order.
+///
+/// \param[out] p Destination
+/// \param[in] v Value
+/// \return None
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+
+    return;
+}
+
+/// This function stores a 32-bit value in little-endian byte order.
+///
+/// \param[out] p Destination
+/// \param[in] v Value
+/// \return None
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+
+    return;
+}
+
+/// This function loads a 16-bit value stored in little-endian byte order.
+///
+/// \param[in] p Source
+/// \return Value
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+/// This function loads a 32-bit value stored in little-endian byte order.
+///
+/// \param[in] p Source
+/// \return Value
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+/// This function stores an IEEE 754 single precision value in little-endian byte order.
+///
+/// \param[out] p Destination
+/// \param[in] v Value
+/// \return None
+static void put_f32(uint8_t *p, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(p, bits);
+
+    return;
+}
+
+/// This function loads an IEEE 754 single precision value stored in little-endian byte order.
+///
+/// \param[in] p Source
+/// \return Value
+static float get_f32(const uint8_t *p)
+{
+    uint32_t bits = get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+
+    return v;
+}
+
+/// This function writes the trace file header. Recording start is the timestamp of the first record, or the
+/// current tick count when no record was accepted yet.
+///
+/// \param None
+/// \return ESP_OK on success, ESP_FAIL on write error
+static esp_err_t write_header(void)
+{
+    taskENTER_CRITICAL(&s_rec_lock);
+    TickType_t start = s_rec_start_tick;
+    taskEXIT_CRITICAL(&s_rec_lock);
+
+    uint8_t hdr[BMS_TRACE_HEADER_SIZE] = {0};
+    put_u32(&hdr[0], BMS_TRACE_MAGIC);
+    hdr[4] = BMS_TRACE_VERSION;
+    hdr[5] = s_rec_cells;
+    put_u16(&hdr[6], (uint16_t)configTICK_RATE_HZ);
+    put_u32(&hdr[8], (uint32_t)start);
+    if (fwrite(hdr, 1, sizeof(hdr), s_rec_file) != sizeof(hdr)) {
+        return ESP_FAIL;
+    }
+    s_rec_header_pending = false;
+
+    taskENTER_CRITICAL(&s_rec_lock);
+    s_rec_stats.bytes_written += BMS_TRACE_HEADER_SIZE;
+    taskEXIT_CRITICAL(&s_rec_lock);
+
+    return ESP_OK;
+}
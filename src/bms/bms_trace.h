@@ -0,0 +1,97 @@
+/// Header file for `bms_trace.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "bms_data.h"
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Trace file magic ("BMST")
+#define BMS_TRACE_MAGIC         0x54534D42u
+
+/// Trace format version
+#define BMS_TRACE_VERSION       1
+
+/// Size of trace file header in bytes
+#define BMS_TRACE_HEADER_SIZE   16
+
+/// Size of one trace record in bytes for given number of cells
+#define BMS_TRACE_RECORD_SIZE(cells)  (2u + 2u * (size_t)(cells) + 4u + 4u)
+
+/// Trace recording from boot (raw adapter samples written to ::CONFIG_BMS_TRACE_PATH)
+#ifndef CONFIG_BMS_TRACE_RECORD
+#define CONFIG_BMS_TRACE_RECORD       0
+#endif
+
+/// Path of recorded trace and of trace replayed by the replay adapter
+#ifndef CONFIG_BMS_TRACE_PATH
+#define CONFIG_BMS_TRACE_PATH         "/spiffs/trace.bin"
+#endif
+
+/// Maximum size of recorded trace file in kilobytes
+#ifndef CONFIG_BMS_TRACE_MAX_KB
+#define CONFIG_BMS_TRACE_MAX_KB       256
+#endif
+
+/// Size of recorder RAM buffer between Fast Core and file writer in bytes
+#ifndef CONFIG_BMS_TRACE_BUFFER_SIZE
+#define CONFIG_BMS_TRACE_BUFFER_SIZE  4096
+#endif
+
+/// Restart replay from the beginning when the end of the trace is reached
+#ifndef CONFIG_BMS_TRACE_REPLAY_LOOP
+#define CONFIG_BMS_TRACE_REPLAY_LOOP  1
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Pacing of trace replay
+typedef enum {
+    BMS_TRACE_PACE_NONE = 0,    ///< Return records immediately (caller paces, or as fast as possible)
+    BMS_TRACE_PACE_REALTIME,    ///< Block until the recorded time of the record since replay start
+} bms_trace_pace_t;
+
+/// Structure of trace recorder counters
+typedef struct {
+    uint32_t records;           ///< Number of records accepted into the RAM buffer
+    uint32_t dropped;           ///< Number of records dropped (RAM buffer full or file size limit reached)
+    uint32_t bytes_written;     ///< Number of bytes written to the trace file including header
+    uint32_t buffer_peak;       ///< Peak RAM buffer occupancy in bytes
+    bool     active;            ///< Recorder running
+} bms_trace_rec_stats_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+esp_err_t bms_trace_rec_start(const char *path, uint8_t num_cells, uint32_t max_bytes);
+void bms_trace_rec_push(const bms_sample_t *sample);
+esp_err_t bms_trace_rec_flush(void);
+esp_err_t bms_trace_rec_stop(void);
+void bms_trace_rec_get_stats(bms_trace_rec_stats_t *out);
+
+esp_err_t bms_trace_replay_open(const char *path, bms_trace_pace_t pace, bool loop);
+esp_err_t bms_trace_replay_read(bms_sample_t *out);
+void bms_trace_replay_close(void);
+uint8_t bms_trace_replay_cells(void);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -29,6 +29,12 @@
 /*==============================================================================================================*/
 /*                                            Private Variables                                                 */
 /*==============================================================================================================*/
+#if CONFIG_BMS_STATIC_ALLOCATION
+/// Static storage of queue items
+static uint8_t s_bms_queue_storage[BMS_QUEUE_LEN * sizeof(bms_sample_t)];
+/// Static storage of queue control structure
+static StaticQueue_t s_bms_queue_struct;
+#endif
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -43,13 +49,17 @@ portMUX_TYPE g_bms_queue_spinlock = portMUX_INITIALIZER_UNLOCKED;
 /*                                       Public Function Definitions                                            */
 /*==============================================================================================================*/
 /// This function initializes the inter-core BMS sample queue. Creates FreeRTOS queue with length
-/// defined by ::BMS_QUEUE_LEN.
+/// defined by ::BMS_QUEUE_LEN. In static allocation mode the queue uses statically allocated storage.
 ///
 /// \param None
 /// \return None
 void bms_queue_init(void)
 {
+#if CONFIG_BMS_STATIC_ALLOCATION
+    g_bms_queue = xQueueCreateStatic(BMS_QUEUE_LEN, sizeof(bms_sample_t), s_bms_queue_storage, &s_bms_queue_struct);
+#else
     g_bms_queue = xQueueCreate(BMS_QUEUE_LEN, sizeof(bms_sample_t));
+#endif
     if (!g_bms_queue) {
         BMS_LOGE("Failed to create BMS queue (len=%d)", BMS_QUEUE_LEN);
     }
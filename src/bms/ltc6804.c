@@ -1,19 +1,28 @@
 /// LTC6804-2 multicell battery monitor ADC driver for ESP-IDF.
-/// Communicates with the LTC6804-2 over SPI to measure individual cell voltages.
+/// Communicates with LTC6804-2 devices over SPI to measure individual cell voltages.
 /// Ported from Linduino Arduino library - file LTC68042.cpp (https://www.analog.com/en/products/ltc6804-1.html)
-/// to ESP-IDF SPI master driver.
+/// to ESP-IDF. PEC calculation, command encoding and register parsing are implemented in `ltc6804_codec.c`.
+/// The devices are accessed only through transports (`ltc6804_transport.h`): the ESP32 SPI master by default, or
+/// the software LTC6804 model of `ltc6804_emu.c`, so the driver runs unmodified on host.
+///
+/// Devices are organized in chains: each chain is one SPI bus with its own CS line and up to ::LTC6804_MAX_ICS
+/// addressed devices. All chains are driven in lockstep by the calling task: one broadcast ADCV per chain starts
+/// the conversions of all devices at the same time, a single conversion wait covers all chains, and each register
+/// read is started on all chains before waiting for any of them, so transfers on different SPI hosts overlap.
+/// Cells of all chains are merged into one sample (chain 0 first, devices by address). A failure on any chain
+/// repeats conversion and read on all chains, so all cells of a sample come from the same conversion.
 
 /*==============================================================================================================*/
 /*                                                Includes                                                      */
 /*==============================================================================================================*/
 #include "ltc6804.h"
+#include "ltc6804_codec.h"
 #include "logging.h"
+#include "stage_timing.h"
 #include "esp_log.h"
-#include "driver/spi_master.h"
-#include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "rom/ets_sys.h"
+#include "freertos/portmacro.h"
 #include <string.h>
 
 /*==============================================================================================================*/
@@ -22,95 +31,118 @@
 /// Log module tag
 #define LOG_MODULE_TAG "LTC6804"
 
-/// Number of bytes received per register read (6 data + 2 PEC)
-#define NUM_RX_BYTES   8
-
-/// Number of data bytes in one register group
-#define BYTES_IN_REG   6
-
 /// ADC conversion delay for normal mode (in ms). Datasheet specifies ~2.3 ms for fast, ~3 ms for normal.
 /// Using 10 ms provides safe margin.
 #define ADC_CONV_DELAY_MS  10
 
-/// LTC6804-2 addressed mode prefix
-#define LTC6804_ADDR_CMD(addr)  (0x80 + ((addr) << 3))
+/// ADC conversion wait for fast mode (in us). Datasheet specifies 1.1 ms for all cells at 27 kHz.
+/// The wait is shorter than one RTOS tick, so it is done by busy waiting.
+#define ADC_CONV_FAST_US   1300
 
 /// Maximum number of read retries on PEC error before giving up
 #define LTC6804_MAX_RETRIES    3
 
+/// CFGR0 reference power-on bit. With REFON=0 the reference is powered down after conversions and the LTC6804
+/// enters SLEEP when its watchdog expires (2 s without communication).
+#define LTC6804_CFGR0_REFON    0x04
+
+/// Length of a register frame: command with PEC, 6 data bytes and data PEC
+#define LTC6804_FRAME_BYTES    (LTC6804_CMD_BYTES + LTC6804_REG_RX_BYTES)
+
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
+/// Structure of one chain of the active layout
+typedef struct {
+    const ltc6804_transport_t *transport;   ///< Transport of the chain
+    uint8_t num_ics;                        ///< Number of devices, addresses 0 .. num_ics-1
+    uint8_t cells_per_ic;                   ///< Cells per device on channels 1 .. cells_per_ic
+    uint8_t num_groups;                     ///< Cell voltage register groups holding these channels
+    uint8_t first_cell;                     ///< Sample index of the first cell of the chain
+} chain_t;
+
+/// Receive buffers of one frame on every chain
+typedef uint8_t chain_rx_t[LTC6804_MAX_CHAINS][LTC6804_FRAME_BYTES];
 
 /*==============================================================================================================*/
 /*                                       Private Function Prototypes                                            */
 /*==============================================================================================================*/
-static uint16_t pec15_calc(uint8_t len, const uint8_t *data);
 static void set_adc_cmd(uint8_t md, uint8_t dcp, uint8_t ch);
-static esp_err_t spi_transfer(const uint8_t *tx, uint8_t *rx, size_t len);
-static void cs_low(void);
-static void cs_high(void);
-static void wakeup_idle(void);
-static void wakeup_sleep(void);
-static esp_err_t ltc6804_adcv(void);
-static esp_err_t ltc6804_adstat(void);
-static esp_err_t ltc6804_rdcv(uint16_t cell_codes[LTC6804_MAX_CELLS]);
-static esp_err_t ltc6804_rdcv_reg(uint8_t reg, uint8_t *data);
-static esp_err_t ltc6804_rdstat_reg(uint8_t reg, uint8_t *data);
-static esp_err_t ltc6804_wrcfg(const uint8_t cfg[6]);
-static esp_err_t ltc6804_rdcfg(uint8_t r_cfg[8]);
+static void build_cmd_frames(void);
+static uint8_t all_chains(void);
+static uint8_t chains_with_ic(uint8_t mask, uint8_t addr);
+static void cs_set(uint8_t mask, uint32_t level);
+static void delay_us(uint32_t us);
+static void wakeup_idle(uint8_t mask);
+static void wakeup_sleep(uint8_t mask);
+static esp_err_t transfer_frame(uint8_t *mask, const uint8_t *tx, chain_rx_t rx, size_t len);
+static esp_err_t configure_ic(uint8_t chain, uint8_t addr, const uint8_t cfg[6]);
+static esp_err_t ltc6804_adcv(uint8_t *mask);
+static esp_err_t ltc6804_adstat(uint8_t *mask);
+static esp_err_t ltc6804_rdcv(uint8_t *mask, uint16_t cell_codes[LTC6804_MAX_CELLS]);
+static esp_err_t ltc6804_read_reg(uint8_t *mask, const uint8_t cmd[LTC6804_CMD_BYTES], chain_rx_t rx);
+static esp_err_t ltc6804_wrcfg(uint8_t *mask, uint8_t addr, const uint8_t cfg[6]);
+static esp_err_t ltc6804_wrcfg_all(uint8_t *mask, const uint8_t cfg[6]);
+static esp_err_t ltc6804_rdcfg(uint8_t chain, uint8_t addr, uint8_t r_cfg[8]);
+static void calib_capture(const uint16_t cell_codes[LTC6804_MAX_CELLS]);
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
 /*==============================================================================================================*/
-/// Pre-computed CRC15 lookup table for LTC6804 PEC calculation.
-/// Sourced from LTC6804 datasheet / Linduino reference code.
-static const uint16_t crc15_table[256] = {
-    0x0000, 0xC599, 0xCEAB, 0x0B32, 0xD8CF, 0x1D56, 0x1664, 0xD3FD,
-    0xF407, 0x319E, 0x3AAC, 0xFF35, 0x2CC8, 0xE951, 0xE263, 0x27FA,
-    0xAD97, 0x680E, 0x633C, 0xA6A5, 0x7558, 0xB0C1, 0xBBF3, 0x7E6A,
-    0x5990, 0x9C09, 0x973B, 0x52A2, 0x815F, 0x44C6, 0x4FF4, 0x8A6D,
-    0x5B2E, 0x9EB7, 0x9585, 0x501C, 0x83E1, 0x4678, 0x4D4A, 0x88D3,
-    0xAF29, 0x6AB0, 0x6182, 0xA41B, 0x77E6, 0xB27F, 0xB94D, 0x7CD4,
-    0xF6B9, 0x3320, 0x3812, 0xFD8B, 0x2E76, 0xEBEF, 0xE0DD, 0x2544,
-    0x02BE, 0xC727, 0xCC15, 0x098C, 0xDA71, 0x1FE8, 0x14DA, 0xD143,
-    0xF3C5, 0x365C, 0x3D6E, 0xF8F7, 0x2B0A, 0xEE93, 0xE5A1, 0x2038,
-    0x07C2, 0xC25B, 0xC969, 0x0CF0, 0xDF0D, 0x1A94, 0x11A6, 0xD43F,
-    0x5E52, 0x9BCB, 0x90F9, 0x5560, 0x869D, 0x4304, 0x4836, 0x8DAF,
-    0xAA55, 0x6FCC, 0x64FE, 0xA167, 0x729A, 0xB703, 0xBC31, 0x79A8,
-    0xA8EB, 0x6D72, 0x6640, 0xA3D9, 0x7024, 0xB5BD, 0xBE8F, 0x7B16,
-    0x5CEC, 0x9975, 0x9247, 0x57DE, 0x8423, 0x41BA, 0x4A88, 0x8F11,
-    0x057C, 0xC0E5, 0xCBD7, 0x0E4E, 0xDDB3, 0x182A, 0x1318, 0xD681,
-    0xF17B, 0x34E2, 0x3FD0, 0xFA49, 0x29B4, 0xEC2D, 0xE71F, 0x2286,
-    0xA213, 0x678A, 0x6CB8, 0xA921, 0x7ADC, 0xBF45, 0xB477, 0x71EE,
-    0x5614, 0x938D, 0x98BF, 0x5D26, 0x8EDB, 0x4B42, 0x4070, 0x85E9,
-    0x0F84, 0xCA1D, 0xC12F, 0x04B6, 0xD74B, 0x12D2, 0x19E0, 0xDC79,
-    0xFB83, 0x3E1A, 0x3528, 0xF0B1, 0x234C, 0xE6D5, 0xEDE7, 0x287E,
-    0xF93D, 0x3CA4, 0x3796, 0xF20F, 0x21F2, 0xE46B, 0xEF59, 0x2AC0,
-    0x0D3A, 0xC8A3, 0xC391, 0x0608, 0xD5F5, 0x106C, 0x1B5E, 0xDEC7,
-    0x54AA, 0x9133, 0x9A01, 0x5F98, 0x8C65, 0x49FC, 0x42CE, 0x8757,
-    0xA0AD, 0x6534, 0x6E06, 0xAB9F, 0x7862, 0xBDFB, 0xB6C9, 0x7350,
-    0x51D6, 0x944F, 0x9F7D, 0x5AE4, 0x8919, 0x4C80, 0x47B2, 0x822B,
-    0xA5D1, 0x6048, 0x6B7A, 0xAEE3, 0x7D1E, 0xB887, 0xB3B5, 0x762C,
-    0xFC41, 0x39D8, 0x32EA, 0xF773, 0x248E, 0xE117, 0xEA25, 0x2FBC,
-    0x0846, 0xCDDF, 0xC6ED, 0x0374, 0xD089, 0x1510, 0x1E22, 0xDBBB,
-    0x0AF8, 0xCF61, 0xC453, 0x01CA, 0xD237, 0x17AE, 0x1C9C, 0xD905,
-    0xFEFF, 0x3B66, 0x3054, 0xF5CD, 0x2630, 0xE3A9, 0xE89B, 0x2D02,
-    0xA76F, 0x62F6, 0x69C4, 0xAC5D, 0x7FA0, 0xBA39, 0xB10B, 0x7492,
-    0x5368, 0x96F1, 0x9DC3, 0x585A, 0x8BA7, 0x4E3E, 0x450C, 0x8095,
-};
 
 /*==============================================================================================================*/
 /*                                            Private Variables                                                 */
 /*==============================================================================================================*/
-/// SPI device handle for the LTC6804
-static spi_device_handle_t s_spi_dev = NULL;
+/// Active chain layout (Kconfig with ESP32 SPI master transports unless set by ltc6804_set_chains())
+static chain_t s_chains[LTC6804_MAX_CHAINS];
+static uint8_t s_num_chains = 0;
+/// Number of cells of all chains and highest number of devices of one chain
+static uint8_t s_num_cells = 0;
+static uint8_t s_max_ics = 0;
+
+/// Pre-computed broadcast ADCV command frame (command bytes and PEC)
+static uint8_t s_adcv_cmd[LTC6804_CMD_BYTES];
+
+/// Pre-computed broadcast ADSTAT command frame (command bytes and PEC)
+static uint8_t s_adstat_cmd[LTC6804_CMD_BYTES];
+
+/// Pre-computed addressed RDCVA..RDCVD command frames of every device address
+static uint8_t s_rdcv_cmd[LTC6804_MAX_ICS][LTC6804_NUM_CV_REG][LTC6804_CMD_BYTES];
+
+/// Pre-computed addressed RDSTATA and RDSTATB command frames of every device address
+static uint8_t s_rdstat_cmd[LTC6804_MAX_ICS][2][LTC6804_CMD_BYTES];
 
-/// Pre-computed ADCV command bytes
-static uint8_t s_adcv_cmd[2];
+/// Pre-computed addressed WRCFG and RDCFG command frames of every device address
+static uint8_t s_wrcfg_cmd[LTC6804_MAX_ICS][LTC6804_CMD_BYTES];
+static uint8_t s_rdcfg_cmd[LTC6804_MAX_ICS][LTC6804_CMD_BYTES];
 
-/// Pre-computed ADSTAT command bytes
-static uint8_t s_adstat_cmd[2];
+/// Currently selected ADC conversion mode for cell voltage reads
+static uint8_t s_adc_md = LTC6804_MD_NORMAL;
+
+/// Configuration register written at init, rewritten after wakeup from SLEEP (watchdog resets it)
+static uint8_t s_cfg[6];
+
+/// Low-power mode: LTC6804 sleeps between reads, each read wakes it and restores the configuration
+static bool s_low_power = false;
+
+/// Calibration applied by ltc6804_read_cell_voltages(). Only the reading task writes it.
+static ltc6804_calib_t s_calib;
+/// Calibration staged by ltc6804_set_calib(), taken over by the reading task at the start of its next read
+static ltc6804_calib_t s_calib_next;
+/// Flag indicating that ::s_calib_next holds constants not yet taken over, cleared by the reading task
+static volatile bool s_calib_pending = false;
+/// Spinlock protecting the staged calibration and the take-over copy across cores
+static portMUX_TYPE s_calib_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/// Raw cell codes of the last successful read (before calibration)
+static uint16_t s_raw_codes[LTC6804_MAX_CELLS];
+
+/// Calibration capture: sum of raw codes, number of reads still to accumulate and number accumulated
+static uint32_t s_capture_sum[LTC6804_MAX_CELLS];
+static volatile uint16_t s_capture_left = 0;
+static uint16_t s_capture_count = 0;
+/// Spinlock protecting calibration capture state across cores
+static portMUX_TYPE s_capture_lock = portMUX_INITIALIZER_UNLOCKED;
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -119,65 +151,43 @@ static uint8_t s_adstat_cmd[2];
 /*==============================================================================================================*/
 /*                                       Public Function Definitions                                            */
 /*==============================================================================================================*/
-/// This function initializes the SPI bus and configures the LTC6804-2.
-/// It configures the CS pin for manual GPIO control, initializes the ESP-IDF SPI master
-/// bus, adds the LTC6804 as an SPI device, selects ADC conversion commands for normal mode,
-/// and computes undervoltage/overvoltage threshold register values from cell_v_min and
-/// cell_v_max. Before configuration writes, the function issues repeated wakeup pulses to ensure the
-/// LTC6804 oscillator is running. It then writes the configuration register, reads it back,
-/// and verifies the written threshold bytes. Configuration write/readback is retried up to
-/// ::LTC6804_MAX_RETRIES times before failing.
+/// This function initializes the transports and configures all LTC6804-2 devices of all chains.
+/// It takes the chain layout from Kconfig when ltc6804_set_chains() was not called, initializes the transports
+/// (ESP32 SPI master with manual GPIO CS by default), pre-computes the command frames (with PEC) of fixed
+/// commands, selects ADC conversion commands for normal mode, and computes undervoltage/overvoltage threshold
+/// register values from cell_v_min and cell_v_max. Before configuration writes, the function issues repeated
+/// wakeup pulses to ensure the LTC6804 oscillators are running. It then writes the configuration register of
+/// every device, reads it back, and verifies the written threshold bytes. Configuration write/readback is retried
+/// up to ::LTC6804_MAX_RETRIES times per device before failing.
 ///
 /// \param[in] cell_v_min Minimum per-cell voltage (V) for undervoltage threshold
 /// \param[in] cell_v_max Maximum per-cell voltage (V) for overvoltage threshold
-/// \return ESP_OK on success, otherwise an error code from SPI/configuration failure
+/// \return ESP_OK on success, an error code of ltc6804_set_chains() for an invalid Kconfig layout, otherwise an
+///         error code from transport/configuration failure
 esp_err_t ltc6804_init(float cell_v_min, float cell_v_max)
 {
-    // Configure CS pin as GPIO output
-    gpio_config_t cs_cfg = {
-        .pin_bit_mask  = (1ULL << LTC6804_PIN_CS),
-        .mode          = GPIO_MODE_OUTPUT,
-        .pull_up_en    = GPIO_PULLUP_ENABLE,
-        .pull_down_en  = GPIO_PULLDOWN_DISABLE,
-        .intr_type     = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&cs_cfg);
-    // Set CS to high - idle
-    cs_high();
-
-    // Configure SPI bus
-    spi_bus_config_t bus_cfg = {
-        .mosi_io_num   = LTC6804_PIN_MOSI,
-        .miso_io_num   = LTC6804_PIN_MISO,
-        .sclk_io_num   = LTC6804_PIN_SCLK,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .max_transfer_sz = 64,
-    };
+    esp_err_t ret;
 
-    esp_err_t ret = spi_bus_initialize(LTC6804_SPI_HOST, &bus_cfg, SPI_DMA_DISABLED);
-    if (ret != ESP_OK) {
-        BMS_LOGE("SPI bus init failed: %s", esp_err_to_name(ret));
-        return ret;
+    if (s_num_chains == 0) {
+        ret = ltc6804_set_chains(NULL, 0);
+        if (ret != ESP_OK) {
+            return ret;
+        }
     }
 
-    // Add LTC6804 as SPI device — CS managed manually via GPIO
-    spi_device_interface_config_t dev_cfg = {
-        .mode           = 3,               // SPI Mode 3 (CPOL=1, CPHA=1) per LTC6804 datasheet
-        .clock_speed_hz = LTC6804_SPI_FREQ_HZ,
-        .spics_io_num   = -1,              // Manual CS control via GPIO (cs_high() and cs_low())
-        .queue_size     = 1,
-        .flags          = 0,
-    };
-
-    ret = spi_bus_add_device(LTC6804_SPI_HOST, &dev_cfg, &s_spi_dev);
-    if (ret != ESP_OK) {
-        BMS_LOGE("SPI add device failed: %s", esp_err_to_name(ret));
-        return ret;
+    for (uint8_t c = 0; c < s_num_chains; ++c) {
+        const ltc6804_transport_t *t = s_chains[c].transport;
+        ret = t->init(t->ctx);
+        if (ret != ESP_OK) {
+            BMS_LOGE("LTC6804 chain %u transport init failed: %s", (unsigned)c, esp_err_to_name(ret));
+            return ret;
+        }
     }
 
-    // Set ADC commands for normal mode, all cells, discharge disabled
-    set_adc_cmd(LTC6804_MD_NORMAL, LTC6804_DCP_DISABLED, LTC6804_CH_ALL);
+    // Command frames of fixed commands, and ADC commands for normal mode, all cells, discharge disabled
+    build_cmd_frames();
+    s_adc_md = LTC6804_MD_NORMAL;
+    set_adc_cmd(s_adc_md, LTC6804_DCP_DISABLED, LTC6804_CH_ALL);
 
     // Compute 12-bit VUV and VOV register values from voltage thresholds.
     // Datasheet formulas: Comparison Voltage (min value) = (VUV + 1) * 16 * 100µV
@@ -204,128 +214,231 @@ esp_err_t ltc6804_init(float cell_v_min, float cell_v_max)
         0x00,                                       // CFGR4: DCC1-DCC8 all off (no cell balancing)
         0x00,                                       // CFGR5: DCTO[3:0]=0, DCC9-DCC12 off
     };
+    // Kept for restoring after wakeup from SLEEP in low-power mode
+    memcpy(s_cfg, cfg, sizeof(s_cfg));
+    s_low_power = false;
 
-    // Wakeup with multiple sleep-wake pulses to ensure LTC6804 oscillator starts.
+    // Wakeup with multiple sleep-wake pulses to ensure LTC6804 oscillators start.
     // Datasheet tSTART (oscillator startup from SLEEP) can be up to ~3 ms.
     for (int w = 0; w < 3; ++w) {
-        wakeup_sleep();
+        wakeup_sleep(all_chains());
         vTaskDelay(pdMS_TO_TICKS(5));
     }
 
-    BMS_LOGI("SPI pins: MOSI=%d, MISO=%d, SCLK=%d, CS=%d",
-             LTC6804_PIN_MOSI, LTC6804_PIN_MISO, LTC6804_PIN_SCLK, LTC6804_PIN_CS);
-    BMS_LOGI("CS pin level: %d", gpio_get_level(LTC6804_PIN_CS));
+    for (uint8_t c = 0; c < s_num_chains; ++c) {
+        for (uint8_t addr = 0; addr < s_chains[c].num_ics; ++addr) {
+            ret = configure_ic(c, addr, cfg);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
 
-    // Write configuration with readback verification and retry
-    uint8_t r_cfg[8];
-    bool cfg_ok = false;
+    BMS_LOGI("LTC6804 ADC module initialized: %u chain(s), %u cells", (unsigned)s_num_chains,
+             (unsigned)s_num_cells);
 
-    for (int attempt = 0; attempt < LTC6804_MAX_RETRIES; ++attempt) {
-        wakeup_sleep();
-        vTaskDelay(pdMS_TO_TICKS(5));
+    return ESP_OK;
+}
 
-        ret = ltc6804_wrcfg(cfg);
-        if (ret != ESP_OK) {
-            BMS_LOGW("WRCFG attempt %d failed: %s", attempt + 1, esp_err_to_name(ret));
-            continue;
+/// This function sets the chain layout: transport, number of devices and cells per device of every chain. Must be
+/// called before ltc6804_init() when the layout of Kconfig (BMS_LTC_CHAINS, BMS_LTC_CHAINx_ICS,
+/// BMS_LTC_CHAINx_CELLS_PER_IC) with the ESP32 SPI master transports is not wanted, for example to read the
+/// software model of `ltc6804_emu.c`.
+///
+/// \param[in] chains     Array of chain descriptions (NULL selects the Kconfig layout)
+/// \param[in] num_chains Number of chains (1 to ::LTC6804_MAX_CHAINS, ignored for NULL chains)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid chain description, ESP_ERR_INVALID_SIZE if the chains
+///         have more than ::LTC6804_MAX_CELLS cells
+esp_err_t ltc6804_set_chains(const ltc6804_chain_cfg_t *chains, uint8_t num_chains)
+{
+    ltc6804_chain_cfg_t kconfig[LTC6804_MAX_CHAINS];
+
+    if (!chains) {
+        static const uint8_t s_ics[LTC6804_MAX_CHAINS] = {
+            CONFIG_BMS_LTC_CHAIN0_ICS, CONFIG_BMS_LTC_CHAIN1_ICS,
+        };
+        static const uint8_t s_cells[LTC6804_MAX_CHAINS] = {
+            CONFIG_BMS_LTC_CHAIN0_CELLS_PER_IC, CONFIG_BMS_LTC_CHAIN1_CELLS_PER_IC,
+        };
+        num_chains = CONFIG_BMS_LTC_CHAINS;
+        for (uint8_t c = 0; c < num_chains && c < LTC6804_MAX_CHAINS; ++c) {
+            kconfig[c].transport    = ltc6804_spi_transport(c);
+            kconfig[c].num_ics      = s_ics[c];
+            kconfig[c].cells_per_ic = s_cells[c];
         }
+        chains = kconfig;
+    }
 
-        // Read back and verify config was latched
-        ret = ltc6804_rdcfg(r_cfg);
-        if (ret != ESP_OK) {
-            BMS_LOGW("RDCFG attempt %d failed: %s | raw: %02X %02X %02X %02X %02X %02X %02X %02X",
-                     attempt + 1, esp_err_to_name(ret),
-                     r_cfg[0], r_cfg[1], r_cfg[2], r_cfg[3],
-                     r_cfg[4], r_cfg[5], r_cfg[6], r_cfg[7]);
-            continue;
-        }
+    if (num_chains == 0 || num_chains > LTC6804_MAX_CHAINS) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        // Verify CFGR1-CFGR3 match written values (CFGR0 has read-only bits so skip exact match)
-        if (r_cfg[1] == cfg[1] && r_cfg[2] == cfg[2] && r_cfg[3] == cfg[3]) {
-            cfg_ok = true;
-            break;
+    uint32_t total = 0;
+    for (uint8_t c = 0; c < num_chains; ++c) {
+        if (!chains[c].transport || chains[c].num_ics == 0 || chains[c].num_ics > LTC6804_MAX_ICS ||
+            chains[c].cells_per_ic == 0 || chains[c].cells_per_ic > LTC6804_IC_CELLS) {
+            BMS_LOGE("Invalid LTC6804 chain %u", (unsigned)c);
+            return ESP_ERR_INVALID_ARG;
         }
-
-        BMS_LOGW("WRCFG verify failed (attempt %d): wrote %02X %02X %02X, read %02X %02X %02X",
-                 attempt + 1, cfg[1], cfg[2], cfg[3], r_cfg[1], r_cfg[2], r_cfg[3]);
-        wakeup_sleep();
-        vTaskDelay(pdMS_TO_TICKS(4));
+        total += (uint32_t)chains[c].num_ics * chains[c].cells_per_ic;
     }
-
-    if (!cfg_ok) {
-        BMS_LOGE("LTC6804 write config failed after %d attempts", LTC6804_MAX_RETRIES);
-        return ESP_FAIL;
+    if (total > LTC6804_MAX_CELLS) {
+        BMS_LOGE("LTC6804 chains have %lu cells, at most %d supported", (unsigned long)total, LTC6804_MAX_CELLS);
+        return ESP_ERR_INVALID_SIZE;
     }
 
-    BMS_LOGI("LTC6804 ADC module initialized (SPI host %d, CS pin %d)", LTC6804_SPI_HOST, LTC6804_PIN_CS);
-    BMS_LOGI("RDCFG OK: %02X %02X %02X %02X %02X %02X  PEC: %02X %02X",
-             r_cfg[0], r_cfg[1], r_cfg[2], r_cfg[3], r_cfg[4], r_cfg[5],
-             r_cfg[6], r_cfg[7]);
+    uint8_t first = 0;
+    s_max_ics = 0;
+    for (uint8_t c = 0; c < num_chains; ++c) {
+        s_chains[c].transport    = chains[c].transport;
+        s_chains[c].num_ics      = chains[c].num_ics;
+        s_chains[c].cells_per_ic = chains[c].cells_per_ic;
+        s_chains[c].num_groups   = (uint8_t)((chains[c].cells_per_ic + LTC6804_CELLS_PER_REG - 1) /
+                                             LTC6804_CELLS_PER_REG);
+        s_chains[c].first_cell   = first;
+        first += (uint8_t)(chains[c].num_ics * chains[c].cells_per_ic);
+        if (chains[c].num_ics > s_max_ics) {
+            s_max_ics = chains[c].num_ics;
+        }
+    }
+    s_num_chains = num_chains;
+    s_num_cells  = first;
 
     return ESP_OK;
 }
 
-/// This function triggers a cell-voltage ADC conversion on the LTC6804, waits for
-/// conversion completion, reads all cell voltage register groups, and converts the raw
-/// ADC codes of the requested cells to volts.
+/// This function returns the number of cells of all chains of the active layout.
+///
+/// \param None
+/// \return Number of cells, 0 before ltc6804_set_chains() or ltc6804_init()
+uint8_t ltc6804_num_cells(void)
+{
+    return s_num_cells;
+}
+
+/// This function triggers a cell-voltage ADC conversion on all devices of all chains, waits for conversion
+/// completion, reads the cell voltage register groups holding the connected cells, and converts the raw ADC codes
+/// of the requested cells to volts. Conversions of all chains start together, so the merged sample has one
+/// acquisition time.
 /// The read sequence is retried up to ::LTC6804_MAX_RETRIES times because SPI transfer
-/// errors or PEC mismatches can be transient due to wakeup timing or communication noise.
-/// Only the first num_cells values are copied to the output array, although all register
-/// groups are read internally.
+/// errors or PEC mismatches can be transient due to wakeup timing or communication noise. A retry converts and
+/// reads all chains again, also those read successfully, so the sample stays one lockstep conversion.
+/// Only the first num_cells values are copied to the output array, although all cells are read internally.
 ///
 /// \param[out] voltages   Array to receive cell voltages in volts
-/// \param[in]  num_cells  Number of cell voltages to populate (1 to ::LTC6804_MAX_CELLS)
+/// \param[in]  num_cells  Number of cell voltages to populate (1 to ltc6804_num_cells())
 /// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters, or an error code
 ///         propagated from the underlying conversion/read sequence (for example
 ///         ESP_ERR_INVALID_CRC on PEC mismatch)
 esp_err_t ltc6804_read_cell_voltages(float *voltages, uint8_t num_cells)
 {
-    if (!voltages || num_cells == 0 || num_cells > LTC6804_MAX_CELLS) {
+    if (!voltages || num_cells == 0 || num_cells > s_num_cells) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint16_t cell_codes[LTC6804_MAX_CELLS];
-    esp_err_t ret = ESP_FAIL;
-
-    // Retry loop — SPI/PEC errors can be transient (noise, wakeup timing)
-    for (int attempt = 0; attempt < LTC6804_MAX_RETRIES; ++attempt) {
-        // Start ADC conversion for all cells
-        ret = ltc6804_adcv();
-        if (ret != ESP_OK) {
+    uint16_t cell_codes[LTC6804_MAX_CELLS] = {0};
+    const uint8_t all = all_chains();
+    uint8_t failed = all;
+    esp_err_t ret = ESP_OK;
+    esp_err_t err;
+
+    // Retry loop — SPI/PEC errors can be transient (noise, wakeup timing). Every attempt converts all chains, codes
+    // of chains read successfully in an earlier attempt would belong to another conversion.
+    for (int attempt = 0; attempt < LTC6804_MAX_RETRIES && failed; ++attempt) {
+        uint8_t mask = all;
+
+        // Start ADC conversion for all cells of the pending chains. In low-power mode the devices are woken from
+        // SLEEP first and their configuration (thresholds) restored, the reference powers up within the conversion.
+        uint32_t t_start = stage_timing_now_us();
+        if (s_low_power) {
+            wakeup_sleep(mask);
+            err = ltc6804_wrcfg_all(&mask, s_cfg);
+            if (err != ESP_OK) {
+                ret = err;
+            }
+        }
+        err = ltc6804_adcv(&mask);
+        if (err != ESP_OK) {
+            ret = err;
+        }
+        uint32_t t_conv = stage_timing_now_us();
+        stage_timing_record(FC_STAGE_CONV_START, t_conv - t_start);
+        if (mask != all) {
+            failed = (uint8_t)(all & ~mask);
             continue;
         }
 
-        // Wait for conversion to complete
-        vTaskDelay(pdMS_TO_TICKS(ADC_CONV_DELAY_MS));
+        // Wait for conversion to complete, devices of all chains convert concurrently
+        if (s_adc_md == LTC6804_MD_FAST && !s_low_power) {
+            delay_us(ADC_CONV_FAST_US);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(ADC_CONV_DELAY_MS));
+        }
+        uint32_t t_wait = stage_timing_now_us();
+        stage_timing_record(FC_STAGE_CONV_WAIT, t_wait - t_conv);
 
-        // Read raw cell codes from all 4 register groups
-        ret = ltc6804_rdcv(cell_codes);
-        if (ret == ESP_OK) {
-            break;
+        // Read raw cell codes, register reads of all chains overlap
+        err = ltc6804_rdcv(&mask, cell_codes);
+        if (err != ESP_OK) {
+            ret = err;
         }
+        stage_timing_record(FC_STAGE_REG_READ, stage_timing_now_us() - t_wait);
+        failed = (uint8_t)(all & ~mask);
     }
 
-    if (ret != ESP_OK) {
+    if (failed) {
         // Warning: only log every 20th failure to avoid UART overload and MCU reset
         static uint32_t s_fail_cnt = 0;
         if ((++s_fail_cnt % 20) == 1) {
-            BMS_LOGW("LTC6804 read failed (%lu total, last %d attempts): %s",
-                     (unsigned long)s_fail_cnt, LTC6804_MAX_RETRIES, esp_err_to_name(ret));
+            BMS_LOGW("LTC6804 read failed (%lu total, chains 0x%02X after %d attempts): %s",
+                     (unsigned long)s_fail_cnt, (unsigned)failed, LTC6804_MAX_RETRIES, esp_err_to_name(ret));
         }
         return ret;
     }
 
-    // Convert the requested raw LTC6804 cell codes to volts.
+    memcpy(s_raw_codes, cell_codes, s_num_cells * sizeof(uint16_t));
+    if (s_capture_left) {
+        calib_capture(cell_codes);
+    }
+
+    // Calibrate the requested raw LTC6804 cell codes in integer domain and convert them to volts.
     // Per datasheet, each code LSB corresponds to 100 uV, so voltage = code * 0.0001 V.
+    // Constants staged by ltc6804_set_calib() are taken over in one short critical section, so every read applies
+    // one complete set and a writer never overwrites the set being applied.
+    if (s_calib_pending) {
+        taskENTER_CRITICAL(&s_calib_lock);
+        s_calib = s_calib_next;
+        s_calib_pending = false;
+        taskEXIT_CRITICAL(&s_calib_lock);
+    }
     for (uint8_t i = 0; i < num_cells; ++i) {
-        voltages[i] = (float)cell_codes[i] * 0.0001f;
+        voltages[i] = (float)ltc6804_calib_apply(cell_codes[i], s_calib.gain[i], s_calib.offset[i]) * 0.0001f;
     }
 
     return ESP_OK;
 }
 
-/// This function reads the LTC6804 status registers. Triggers a status ADC conversion, reads both
-/// Status Register Groups A and B, verifies PEC, and returns the raw 6-byte contents of each group.
+/// This function selects ADC conversion mode used for cell voltage reads. Fast mode trades accuracy for a much
+/// shorter conversion wait and is used by the Fast Core when it degrades under overload. Must be called from
+/// the task which reads cell voltages.
+///
+/// \param[in] md ADC conversion mode (::LTC6804_MD_FAST or ::LTC6804_MD_NORMAL)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on unsupported mode
+esp_err_t ltc6804_set_adc_mode(uint8_t md)
+{
+    if (md != LTC6804_MD_FAST && md != LTC6804_MD_NORMAL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_adc_md = md;
+    set_adc_cmd(s_adc_md, LTC6804_DCP_DISABLED, LTC6804_CH_ALL);
+
+    return ESP_OK;
+}
+
+/// This function reads the status registers of the first device (address 0 of chain 0). Triggers a status ADC
+/// conversion, reads both Status Register Groups A and B, verifies PEC, and returns the raw 6-byte contents of
+/// each group.
 ///
 /// STATA layout (Table 43): STAR0-1: SOC[15:0], STAR2-3: ITMP[15:0], STAR4-5: VA[15:0]<br>
 /// STATB layout (Table 44): STBR0-1: VD[15:0], STBR2: C4OV..C1UV, STBR3: C8OV..C5UV,
@@ -341,10 +454,11 @@ esp_err_t ltc6804_read_status(uint8_t stata[6], uint8_t statb[6])
     }
 
     esp_err_t ret = ESP_FAIL;
-    uint8_t reg_data[NUM_RX_BYTES];
+    chain_rx_t rx;
 
     for (int attempt = 0; attempt < LTC6804_MAX_RETRIES; ++attempt) {
-        ret = ltc6804_adstat();
+        uint8_t mask = 0x01u;
+        ret = ltc6804_adstat(&mask);
         if (ret != ESP_OK) {
             continue;
         }
@@ -352,32 +466,28 @@ esp_err_t ltc6804_read_status(uint8_t stata[6], uint8_t statb[6])
         vTaskDelay(pdMS_TO_TICKS(ADC_CONV_DELAY_MS));
 
         // Read Status Register Group A
-        ret = ltc6804_rdstat_reg(1, reg_data);
+        ret = ltc6804_read_reg(&mask, s_rdstat_cmd[0][0], rx);
         if (ret != ESP_OK) {
             continue;
         }
 
-        uint16_t received_pec = ((uint16_t)reg_data[6] << 8) | reg_data[7];
-        uint16_t calc_pec = pec15_calc(BYTES_IN_REG, reg_data);
-        if (received_pec != calc_pec) {
+        if (!ltc6804_reg_pec_ok(&rx[0][LTC6804_CMD_BYTES])) {
             continue;
         }
 
-        memcpy(stata, reg_data, BYTES_IN_REG);
+        memcpy(stata, &rx[0][LTC6804_CMD_BYTES], LTC6804_REG_DATA_BYTES);
 
         // Read Status Register Group B
-        ret = ltc6804_rdstat_reg(2, reg_data);
+        ret = ltc6804_read_reg(&mask, s_rdstat_cmd[0][1], rx);
         if (ret != ESP_OK) {
             continue;
         }
 
-        received_pec = ((uint16_t)reg_data[6] << 8) | reg_data[7];
-        calc_pec = pec15_calc(BYTES_IN_REG, reg_data);
-        if (received_pec != calc_pec) {
+        if (!ltc6804_reg_pec_ok(&rx[0][LTC6804_CMD_BYTES])) {
             continue;
         }
 
-        memcpy(statb, reg_data, BYTES_IN_REG);
+        memcpy(statb, &rx[0][LTC6804_CMD_BYTES], LTC6804_REG_DATA_BYTES);
 
         return ESP_OK;
     }
@@ -385,313 +495,602 @@ esp_err_t ltc6804_read_status(uint8_t stata[6], uint8_t statb[6])
     return (ret != ESP_OK) ? ret : ESP_ERR_INVALID_CRC;
 }
 
-/*==============================================================================================================*/
-/*                                       Private Function Definitions                                           */
-/*==============================================================================================================*/
+/// This function reads only Status Register Group B of every device and returns the cell UV/OV comparator flags
+/// mapped to sample cell order. The LTC6804 updates the flags at the end of every cell conversion, so after
+/// ltc6804_read_cell_voltages() they belong to the same conversion as the cell codes. No status conversion is
+/// started (VD in the same group is not refreshed), so this is one register group read per device instead of
+/// ADSTAT, conversion wait and two register groups of ltc6804_read_status(). Reads of all chains overlap, each
+/// read is retried up to ::LTC6804_MAX_RETRIES times on PEC mismatch.
+///
+/// \param[out] uv Undervoltage flags by sample cell
+/// \param[out] ov Overvoltage flags by sample cell
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL argument, ESP_ERR_INVALID_CRC on PEC mismatch, or an
+///         error code propagated from the transport
+esp_err_t ltc6804_read_cell_flags(bms_cell_mask_t *uv, bms_cell_mask_t *ov)
+{
+    if (!uv || !ov) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bms_cell_mask_t out_uv = { 0 };
+    bms_cell_mask_t out_ov = { 0 };
+    chain_rx_t rx;
+
+    for (uint8_t addr = 0; addr < s_max_ics; ++addr) {
+        uint8_t pending = chains_with_ic(all_chains(), addr);
+        esp_err_t ret = ESP_OK;
+
+        for (int attempt = 0; attempt < LTC6804_MAX_RETRIES && pending; ++attempt) {
+            uint8_t mask = pending;
+            ret = ltc6804_read_reg(&mask, s_rdstat_cmd[addr][1], rx);
+
+            for (uint8_t c = 0; c < s_num_chains; ++c) {
+                if (!(mask & (1u << c))) {
+                    continue;
+                }
+                const uint8_t *reg = &rx[c][LTC6804_CMD_BYTES];
+                if (!ltc6804_reg_pec_ok(reg)) {
+                    ret = ESP_ERR_INVALID_CRC;
+                    continue;
+                }
+                // STATB bytes 2-4 hold UV/OV pairs of channels 1-12, little-endian
+                uint32_t ic_flags = reg[2] | ((uint32_t)reg[3] << 8) | ((uint32_t)reg[4] << 16);
+                const chain_t *ch = &s_chains[c];
+                uint8_t cell = (uint8_t)(ch->first_cell + addr * ch->cells_per_ic);
+                for (uint8_t k = 0; k < ch->cells_per_ic; ++k) {
+                    if (ic_flags & (1u << (2u * k))) {
+                        bms_cell_mask_set(&out_uv, cell + k);
+                    }
+                    if (ic_flags & (2u << (2u * k))) {
+                        bms_cell_mask_set(&out_ov, cell + k);
+                    }
+                }
+                pending &= (uint8_t)~(1u << c);
+            }
+        }
+        if (pending) {
+            return (ret != ESP_OK) ? ret : ESP_ERR_INVALID_CRC;
+        }
+    }
+
+    *uv = out_uv;
+    *ov = out_ov;
+    return ESP_OK;
+}
+
+/// This function switches the devices between full-rate and low-power operation. In low-power mode the reference
+/// is not kept powered (REFON=0), so the LTC6804 devices enter SLEEP two seconds after the last read; every
+/// ltc6804_read_cell_voltages() then wakes them, restores the configuration and waits for the normal-mode
+/// conversion including reference power-up. Must be called from the task which reads cell voltages.
+///
+/// \param[in] enable True for low-power operation, false to keep the reference powered between reads
+/// \return ESP_OK on success, otherwise an error code of the configuration write
+esp_err_t ltc6804_set_low_power(bool enable)
+{
+    if (enable) {
+        s_cfg[0] &= (uint8_t)~LTC6804_CFGR0_REFON;
+    } else {
+        s_cfg[0] |= LTC6804_CFGR0_REFON;
+    }
+    s_low_power = enable;
+
+    // Devices may be sleeping already, wake them before writing the configuration
+    uint8_t mask = all_chains();
+    wakeup_sleep(mask);
+    return ltc6804_wrcfg_all(&mask, s_cfg);
+}
+
+/// This function sets per-channel calibration applied by ltc6804_read_cell_voltages(). The new constants are
+/// staged and taken over by the reading task at the start of its next read. Safe to call from any task, repeated
+/// calls before the next read leave only the last constants staged.
+///
+/// \param[in] calib Calibration constants, NULL for identity
+/// \return None
+void ltc6804_set_calib(const ltc6804_calib_t *calib)
+{
+    taskENTER_CRITICAL(&s_calib_lock);
+    if (calib) {
+        s_calib_next = *calib;
+    } else {
+        memset(&s_calib_next, 0, sizeof(s_calib_next));
+    }
+    s_calib_pending = true;
+    taskEXIT_CRITICAL(&s_calib_lock);
+
+    return;
+}
+
+/// This function gets calibration constants applied by ltc6804_read_cell_voltages() from the next read on.
+///
+/// \param[out] calib Calibration constants
+/// \return None
+void ltc6804_get_calib(ltc6804_calib_t *calib)
+{
+    if (!calib) return;
+
+    // Staged constants are reported as current, they apply from the next read
+    taskENTER_CRITICAL(&s_calib_lock);
+    *calib = s_calib_pending ? s_calib_next : s_calib;
+    taskEXIT_CRITICAL(&s_calib_lock);
+
+    return;
+}
+
+/// This function copies raw (uncalibrated) cell codes of the last successful ltc6804_read_cell_voltages().
+/// Must be called from the task which reads cell voltages.
+///
+/// \param[out] codes Array of ::LTC6804_MAX_CELLS raw codes (100 uV LSB)
+/// \return None
+void ltc6804_get_raw_codes(uint16_t codes[LTC6804_MAX_CELLS])
+{
+    memcpy(codes, s_raw_codes, sizeof(s_raw_codes));
+
+    return;
+}
+
+/// This function starts averaging of raw cell codes over the next reads of ltc6804_read_cell_voltages() done by
+/// the reading task. Result is fetched by ltc6804_calib_capture_result(). A running capture is restarted.
+///
+/// \param[in] reads Number of reads to average (1 to 4096)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid number of reads
+esp_err_t ltc6804_calib_capture_start(uint16_t reads)
+{
+    if (reads == 0 || reads > 4096) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_capture_lock);
+    memset(s_capture_sum, 0, sizeof(s_capture_sum));
+    s_capture_count = 0;
+    s_capture_left = reads;
+    taskEXIT_CRITICAL(&s_capture_lock);
+
+    return ESP_OK;
+}
 
-/// This function calculates the CRC15/PEC15 used by the LTC6804 for data integrity verification.
-/// Uses the pre-computed lookup table. The result is left-shifted by 1 (LSB is always 0).
+/// This function stops a capture started by ltc6804_calib_capture_start() whose result is no longer awaited. The
+/// reading task stops accumulating and ltc6804_calib_capture_result() reports no result until the next start.
 ///
-/// \param[in] len   Number of bytes in data
-/// \param[in] data  Pointer to data bytes
-/// \return 16-bit PEC value (CRC15 * 2)
-static uint16_t pec15_calc(uint8_t len, const uint8_t *data)
+/// \param None
+/// \return None
+void ltc6804_calib_capture_cancel(void)
 {
-    uint16_t remainder = 16; // PEC seed per LTC6804 spec
-    for (uint8_t i = 0; i < len; ++i) {
-        uint16_t addr = ((remainder >> 7) ^ data[i]) & 0xFF;
-        remainder = (remainder << 8) ^ crc15_table[addr];
+    taskENTER_CRITICAL(&s_capture_lock);
+    s_capture_left = 0;
+    s_capture_count = 0;
+    taskEXIT_CRITICAL(&s_capture_lock);
+
+    return;
+}
+
+/// This function gets the result of capture started by ltc6804_calib_capture_start().
+///
+/// \param[out] codes Array of ::LTC6804_MAX_CELLS averaged raw codes (rounded), valid when true is returned
+/// \return True if the capture is complete, false while reads are still pending
+bool ltc6804_calib_capture_result(uint16_t codes[LTC6804_MAX_CELLS])
+{
+    bool done = false;
+
+    taskENTER_CRITICAL(&s_capture_lock);
+    if (s_capture_left == 0 && s_capture_count > 0) {
+        for (int c = 0; c < LTC6804_MAX_CELLS; ++c) {
+            codes[c] = (uint16_t)((s_capture_sum[c] + s_capture_count / 2u) / s_capture_count);
+        }
+        done = true;
     }
-    return remainder * 2; // CRC15 has 0 in LSB
+    taskEXIT_CRITICAL(&s_capture_lock);
+
+    return done;
 }
 
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+
 /// This function maps ADC mode, discharge control, and channel selection
-/// into the 2-byte ADCV and ADSTAT commands stored in ::s_adcv_cmd and ::s_adstat_cmd.
+/// into the ADCV and ADSTAT command frames (with PEC) stored in ::s_adcv_cmd and ::s_adstat_cmd.
 ///
 /// \param[in] md  ADC conversion mode
 /// \param[in] dcp Discharge control
 /// \param[in] ch  Cell channel selection
 static void set_adc_cmd(uint8_t md, uint8_t dcp, uint8_t ch)
 {
-    uint8_t md_bits;
+    uint8_t adcv[2];
+    uint8_t adstat[2];
 
-    // ADCV command encoding per LTC6804 datasheet:
-    // Byte 0: 0x02 + MD[1]
-    // Byte 1: MD[0]<<7 + 0x60 + DCP<<4 + CH[2:0]
-    md_bits = (md & 0x02) >> 1;
-    s_adcv_cmd[0] = md_bits + 0x02;
+    ltc6804_encode_adc_cmds(md, dcp, ch, adcv, adstat);
+    ltc6804_encode_cmd(adcv[0], adcv[1], s_adcv_cmd);
+    ltc6804_encode_cmd(adstat[0], adstat[1], s_adstat_cmd);
 
-    md_bits = (md & 0x01) << 7;
-    s_adcv_cmd[1] = md_bits + 0x60 + (dcp << 4) + ch;
+    return;
+}
 
-    // ADSTAT command encoding per LTC6804 datasheet:
-    // Byte 0: 0x04 + MD[1]
-    // Byte 1: MD[0]<<7 + 0x68 + CHST[2:0]  (CHST=0 for all status groups)
-    md_bits = (md & 0x02) >> 1;
-    s_adstat_cmd[0] = md_bits + 0x04;
+/// This function builds the frames (command bytes and PEC) of all fixed addressed commands of every device address
+/// of the layout once, so register reads and writes do not calculate command PECs.
+///
+/// \param None
+/// \return None
+static void build_cmd_frames(void)
+{
+    // Command byte 1 selects the register group: RDCVA=0x04, RDCVB=0x06, RDCVC=0x08, RDCVD=0x0A
+    static const uint8_t rdcv_cmd[LTC6804_NUM_CV_REG] = {0x04, 0x06, 0x08, 0x0A};
+    // RDSTATA = 0x10, RDSTATB = 0x12
+    static const uint8_t rdstat_cmd[2] = {0x10, 0x12};
+
+    for (uint8_t ic = 0; ic < s_max_ics; ++ic) {
+        const uint8_t addr = LTC6804_ADDR_CMD(ic);
+        for (uint8_t r = 0; r < LTC6804_NUM_CV_REG; ++r) {
+            ltc6804_encode_cmd(addr, rdcv_cmd[r], s_rdcv_cmd[ic][r]);
+        }
+        for (uint8_t r = 0; r < 2; ++r) {
+            ltc6804_encode_cmd(addr, rdstat_cmd[r], s_rdstat_cmd[ic][r]);
+        }
+        ltc6804_encode_cmd(addr, 0x01, s_wrcfg_cmd[ic]);    // WRCFG
+        ltc6804_encode_cmd(addr, 0x02, s_rdcfg_cmd[ic]);    // RDCFG
+    }
 
-    md_bits = (md & 0x01) << 7;
-    s_adstat_cmd[1] = md_bits + 0x68;
+    return;
 }
 
-/// This function performs an SPI transfer (simultaneous TX and RX).
-/// CS is NOT managed here — caller must assert/deassert CS via cs_low()/cs_high().
+/// This function returns the mask of all chains of the active layout.
 ///
-/// \param[in] tx   TX buffer (may be NULL to send zeros and discard output — effectively RX-only)
-/// \param[in] rx   RX buffer (may be NULL to discard received bytes — effectively TX-only)
-/// \param[in] len  Number of bytes to transfer
-/// \return ESP_OK on success, or an error code propagated from spi_device_transmit()
-static esp_err_t spi_transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+/// \param None
+/// \return Chain mask (bit c = chain c)
+static uint8_t all_chains(void)
 {
-    spi_transaction_t txn = {
-        .length    = len * 8,
-        .tx_buffer = tx,
-        .rx_buffer = rx,
-        .rxlength  = rx ? (len * 8) : 0,
-    };
-    return spi_device_transmit(s_spi_dev, &txn);
+    return (uint8_t)((1u << s_num_chains) - 1u);
 }
 
-/// This function pulls the LTC6804 CS line low to wake up the isoSPI interface from idle state.
+/// This function selects the chains which have a device with the given address.
 ///
-/// \param[in] None
+/// \param[in] mask Chain mask to select from
+/// \param[in] addr Device address
+/// \return Mask of chains of the input mask with more than addr devices
+static uint8_t chains_with_ic(uint8_t mask, uint8_t addr)
+{
+    uint8_t out = 0;
+
+    for (uint8_t c = 0; c < s_num_chains; ++c) {
+        if (addr < s_chains[c].num_ics) {
+            out |= (uint8_t)(1u << c);
+        }
+    }
+
+    return out & mask;
+}
+
+/// This function drives the CS lines of the selected chains.
+///
+/// \param[in] mask  Chain mask
+/// \param[in] level CS line level (0 = low/asserted, 1 = high)
 /// \return None
-static void cs_low(void)
+static void cs_set(uint8_t mask, uint32_t level)
 {
-    gpio_set_level(LTC6804_PIN_CS, 0);
+    for (uint8_t c = 0; c < s_num_chains; ++c) {
+        if (mask & (1u << c)) {
+            const ltc6804_transport_t *t = s_chains[c].transport;
+            t->cs_set(t->ctx, level);
+        }
+    }
 
     return;
 }
 
-/// This function releases the LTC6804 CS line to high, returning the isoSPI interface to idle state.
+/// This function busy waits given number of microseconds with the delay of the first chain transport.
 ///
-/// \param[in] None
+/// \param[in] us Delay in microseconds
 /// \return None
-static void cs_high(void)
+static void delay_us(uint32_t us)
 {
-    gpio_set_level(LTC6804_PIN_CS, 1);
+    s_chains[0].transport->delay_us(us);
 
     return;
 }
 
-/// Wake the LTC6804 communication interface from IDLE using a short CS pulse.
+/// Wake the communication interface of the selected chains from IDLE using a short CS pulse.
 ///
 /// Per datasheet timing, CS is held low for at least tWAKE(IDLE) (minimum 6.7 us),
 /// then released high. An additional short settling delay is inserted before the
-/// next SPI command to improve communication reliability.
+/// next SPI command to improve communication reliability. The pulses of all chains overlap.
 ///
-/// \param[in] None
+/// \param[in] mask Chain mask
 /// \return None
-static void wakeup_idle(void)
+static void wakeup_idle(uint8_t mask)
 {
-    cs_low();
-    ets_delay_us(10);
-    cs_high();
-    ets_delay_us(10);
+    cs_set(mask, 0);
+    delay_us(10);
+    cs_set(mask, 1);
+    delay_us(10);
 
     return;
 }
 
-/// Wake the LTC6804 from SLEEP state using an extended CS low pulse.
+/// Wake the devices of the selected chains from SLEEP state using an extended CS low pulse.
 ///
 /// The datasheet requires CS low for at least tWAKE(SLEEP) (minimum 300 us).
 /// This implementation uses a 1 ms pulse to provide timing margin, then releases
-/// CS high and waits briefly before subsequent communication.
+/// CS high and waits briefly before subsequent communication. The pulses of all chains overlap.
 ///
-/// \param[in] None
+/// \param[in] mask Chain mask
 /// \return None
-static void wakeup_sleep(void)
+static void wakeup_sleep(uint8_t mask)
 {
-    cs_low();
-    ets_delay_us(1000);
-    cs_high();
-    ets_delay_us(10);
+    cs_set(mask, 0);
+    delay_us(1000);
+    cs_set(mask, 1);
+    delay_us(10);
 
     return;
 }
 
-/// This function sends the ADCV (start cell voltage conversion) command to the LTC6804
-/// in addressed mode.
+/// This function sends one frame (isoSPI idle wakeup, CS low, transfer, CS high) with the same TX bytes on all
+/// selected chains. Transfers are started on every chain before waiting for any of them, so transfers of chains on
+/// different SPI hosts overlap. Chains whose transfer fails are removed from the mask.
 ///
-/// \param[in] None
-/// \return ESP_OK on success
-static esp_err_t ltc6804_adcv(void)
+/// \param[in,out] mask Chains to access, on return chains with successful transfer
+/// \param[in]     tx   TX bytes (NULL sends 0xFF)
+/// \param[out]    rx   Receive buffers indexed by chain (NULL to discard received bytes)
+/// \param[in]     len  Number of bytes to transfer (at most ::LTC6804_FRAME_BYTES)
+/// \return ESP_OK if all transfers succeeded, otherwise the error code of the last failed transfer
+static esp_err_t transfer_frame(uint8_t *mask, const uint8_t *tx, chain_rx_t rx, size_t len)
 {
-    uint8_t cmd[4];
+    esp_err_t ret = ESP_OK;
+    uint8_t started = 0;
 
-    wakeup_idle();
+    wakeup_idle(*mask);
 
-    // Build broadcast ADCV command
-    cmd[0] = s_adcv_cmd[0];
-    cmd[1] = s_adcv_cmd[1];
-
-    // Calculate and append PEC
-    uint16_t pec = pec15_calc(2, cmd);
-    cmd[2] = (uint8_t)(pec >> 8);
-    cmd[3] = (uint8_t)(pec);
+    cs_set(*mask, 0);
+    for (uint8_t c = 0; c < s_num_chains; ++c) {
+        if (!(*mask & (1u << c))) {
+            continue;
+        }
+        const ltc6804_transport_t *t = s_chains[c].transport;
+        uint8_t *buf = rx ? rx[c] : NULL;
+        esp_err_t err = t->transfer_start ? t->transfer_start(t->ctx, tx, buf, len)
+                                          : t->transfer(t->ctx, tx, buf, len);
+        if (err == ESP_OK) {
+            started |= (uint8_t)(1u << c);
+        } else {
+            ret = err;
+        }
+    }
+    for (uint8_t c = 0; c < s_num_chains; ++c) {
+        const ltc6804_transport_t *t = s_chains[c].transport;
+        if (!(started & (1u << c)) || !t->transfer_start) {
+            continue;
+        }
+        esp_err_t err = t->transfer_wait(t->ctx);
+        if (err != ESP_OK) {
+            started &= (uint8_t)~(1u << c);
+            ret = err;
+        }
+    }
+    cs_set(*mask, 1);
 
-    // Send with manual CS
-    cs_low();
-    esp_err_t ret = spi_transfer(cmd, NULL, 4);
-    cs_high();
+    *mask = started;
     return ret;
 }
 
-/// This function reads one cell voltage register group from the LTC6804 in addressed mode.
-/// Each register group contains 3 cell voltages (6 data bytes) + 2 PEC bytes = 8 bytes total.
+/// This function writes the configuration register of one device, reads it back and verifies the threshold
+/// bytes. Write/readback is retried up to ::LTC6804_MAX_RETRIES times.
 ///
-/// \param[in] reg   Register group number (1=A, 2=B, 3=C, 4=D)
-/// \param[out] data  Buffer of at least NUM_RX_BYTES (8) bytes to receive raw data
-/// \return ESP_OK on success
-static esp_err_t ltc6804_rdcv_reg(uint8_t reg, uint8_t *data)
+/// \param[in] chain Chain index
+/// \param[in] addr  Device address
+/// \param[in] cfg   Configuration bytes CFGR0 .. CFGR5
+/// \return ESP_OK on success, ESP_FAIL if the configuration could not be verified
+static esp_err_t configure_ic(uint8_t chain, uint8_t addr, const uint8_t cfg[6])
 {
-    // Command byte 1 selects the register group: A=0x04, B=0x06, C=0x08, D=0x0A
-    static const uint8_t reg_cmd[4] = {0x04, 0x06, 0x08, 0x0A};
-
-    if (reg < 1 || reg > 4) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    uint8_t r_cfg[8] = {0};
 
-    // Build addressed read command (LTC6804-2 addressed mode)
-    uint8_t cmd[4];
-    cmd[0] = LTC6804_ADDR_CMD(LTC6804_IC_ADDR);
-    cmd[1] = reg_cmd[reg - 1];
+    for (int attempt = 0; attempt < LTC6804_MAX_RETRIES; ++attempt) {
+        uint8_t mask = (uint8_t)(1u << chain);
+        wakeup_sleep(mask);
+        vTaskDelay(pdMS_TO_TICKS(5));
 
-    uint16_t pec = pec15_calc(2, cmd);
-    cmd[2] = (uint8_t)(pec >> 8);
-    cmd[3] = (uint8_t)(pec);
+        esp_err_t ret = ltc6804_wrcfg(&mask, addr, cfg);
+        if (ret != ESP_OK) {
+            BMS_LOGW("WRCFG %u/%u attempt %d failed: %s", (unsigned)chain, (unsigned)addr, attempt + 1,
+                     esp_err_to_name(ret));
+            continue;
+        }
 
-    // Full-duplex: send 4-byte command + clock 8 bytes of response
-    uint8_t tx_buf[4 + NUM_RX_BYTES];
-    uint8_t rx_buf[4 + NUM_RX_BYTES];
+        // Read back and verify config was latched
+        ret = ltc6804_rdcfg(chain, addr, r_cfg);
+        if (ret != ESP_OK) {
+            BMS_LOGW("RDCFG %u/%u attempt %d failed: %s | raw: %02X %02X %02X %02X %02X %02X %02X %02X",
+                     (unsigned)chain, (unsigned)addr, attempt + 1, esp_err_to_name(ret),
+                     r_cfg[0], r_cfg[1], r_cfg[2], r_cfg[3],
+                     r_cfg[4], r_cfg[5], r_cfg[6], r_cfg[7]);
+            continue;
+        }
 
-    memcpy(tx_buf, cmd, 4);
-    // Dummy bytes to clock in response
-    memset(&tx_buf[4], 0xFF, NUM_RX_BYTES);
+        // Verify CFGR1-CFGR3 match written values (CFGR0 has read-only bits so skip exact match)
+        if (r_cfg[1] == cfg[1] && r_cfg[2] == cfg[2] && r_cfg[3] == cfg[3]) {
+            BMS_LOGI("RDCFG %u/%u OK: %02X %02X %02X %02X %02X %02X  PEC: %02X %02X",
+                     (unsigned)chain, (unsigned)addr, r_cfg[0], r_cfg[1], r_cfg[2], r_cfg[3], r_cfg[4], r_cfg[5],
+                     r_cfg[6], r_cfg[7]);
+            return ESP_OK;
+        }
 
-    wakeup_idle();
+        BMS_LOGW("WRCFG %u/%u verify failed (attempt %d): wrote %02X %02X %02X, read %02X %02X %02X",
+                 (unsigned)chain, (unsigned)addr, attempt + 1, cfg[1], cfg[2], cfg[3], r_cfg[1], r_cfg[2], r_cfg[3]);
+        wakeup_sleep(mask);
+        vTaskDelay(pdMS_TO_TICKS(4));
+    }
 
-    cs_low();
-    esp_err_t ret = spi_transfer(tx_buf, rx_buf, sizeof(tx_buf));
-    cs_high();
+    BMS_LOGE("LTC6804 %u/%u write config failed after %d attempts", (unsigned)chain, (unsigned)addr,
+             LTC6804_MAX_RETRIES);
+    return ESP_FAIL;
+}
 
-    if (ret != ESP_OK) {
-        return ret;
-    }
+/// This function sends the broadcast ADCV (start cell voltage conversion) command on the selected chains, so all
+/// devices of these chains start converting within the time of a few command frames.
+///
+/// \param[in,out] mask Chains to access, on return chains where the command was sent
+/// \return ESP_OK on success, otherwise an error code of the transport
+static esp_err_t ltc6804_adcv(uint8_t *mask)
+{
+    return transfer_frame(mask, s_adcv_cmd, NULL, LTC6804_CMD_BYTES);
+}
 
-    // Response data starts after the 4-byte command phase
-    memcpy(data, &rx_buf[4], NUM_RX_BYTES);
-    return ESP_OK;
+/// This function sends the broadcast ADSTAT (start status group ADC conversion) command on the selected chains.
+/// Triggers conversion of internal temperature, sum of cells voltage, and power supply voltages.
+///
+/// \param[in,out] mask Chains to access, on return chains where the command was sent
+/// \return ESP_OK on success, or an error code propagated from the transport
+static esp_err_t ltc6804_adstat(uint8_t *mask)
+{
+    return transfer_frame(mask, s_adstat_cmd, NULL, LTC6804_CMD_BYTES);
 }
 
-/// This function reads all four cell voltage register groups (A–D) from the LTC6804,
-/// parses the 16-bit raw cell codes, and verifies the PEC for each group.
+/// This function reads one register group on the selected chains in addressed mode: the pre-computed read command
+/// followed by 8 clocked bytes (6 data bytes + 2 PEC bytes). Response data starts at offset ::LTC6804_CMD_BYTES
+/// of the receive buffers. PEC is not checked here.
 ///
-/// \param[out] cell_codes  Array of ::LTC6804_MAX_CELLS uint16_t values (raw ADC codes)
-/// \return ESP_OK on success, ESP_ERR_INVALID_CRC if any register PEC check fails
-static esp_err_t ltc6804_rdcv(uint16_t cell_codes[LTC6804_MAX_CELLS])
+/// \param[in,out] mask Chains to access, on return chains with successful transfer
+/// \param[in]     cmd  Pre-computed read command frame
+/// \param[out]    rx   Receive buffers indexed by chain
+/// \return ESP_OK on success, otherwise an error code of the transport
+static esp_err_t ltc6804_read_reg(uint8_t *mask, const uint8_t cmd[LTC6804_CMD_BYTES], chain_rx_t rx)
 {
-    uint8_t reg_data[NUM_RX_BYTES];
-    int pec_errors = 0;
+    uint8_t tx_buf[LTC6804_FRAME_BYTES];
 
-    for (uint8_t reg = 1; reg <= LTC6804_NUM_CV_REG; ++reg) {
-        esp_err_t ret = ltc6804_rdcv_reg(reg, reg_data);
-        if (ret != ESP_OK) {
-            return ret;
-        }
+    memcpy(tx_buf, cmd, LTC6804_CMD_BYTES);
+    // Dummy bytes to clock in response
+    memset(&tx_buf[LTC6804_CMD_BYTES], 0xFF, LTC6804_REG_RX_BYTES);
 
-        // Parse 3 cell voltages from the 6 data bytes (little-endian 16-bit)
-        for (uint8_t cell = 0; cell < LTC6804_CELLS_PER_REG; ++cell) {
-            uint8_t idx = cell * 2;
-            uint16_t raw = reg_data[idx] | ((uint16_t)reg_data[idx + 1] << 8);
-            cell_codes[cell + (reg - 1) * LTC6804_CELLS_PER_REG] = raw;
-        }
+    return transfer_frame(mask, tx_buf, rx, sizeof(tx_buf));
+}
 
-        // Verify PEC: received PEC is bytes 6-7 (big-endian), calculated over bytes 0-5
-        uint16_t received_pec = ((uint16_t)reg_data[6] << 8) | reg_data[7];
-        uint16_t calc_pec = pec15_calc(BYTES_IN_REG, reg_data);
-        if (received_pec != calc_pec) {
-            pec_errors++;
+/// This function reads the cell voltage register groups holding the connected cells of every device of the
+/// selected chains, parses the 16-bit raw cell codes, verifies the PEC of each group and stores the codes in
+/// sample cell order. The same register group of the same device address is read on all chains at once. A chain
+/// with a failed read or PEC mismatch is not read further.
+///
+/// \param[in,out] mask        Chains to read, on return chains read completely with valid PEC
+/// \param[out]    cell_codes  Array of ::LTC6804_MAX_CELLS raw ADC codes in sample cell order
+/// \return ESP_OK on success, ESP_ERR_INVALID_CRC if any register PEC check fails, otherwise an error code of the
+///         transport
+static esp_err_t ltc6804_rdcv(uint8_t *mask, uint16_t cell_codes[LTC6804_MAX_CELLS])
+{
+    esp_err_t ret = ESP_OK;
+    chain_rx_t rx;
+
+    for (uint8_t addr = 0; addr < s_max_ics; ++addr) {
+        for (uint8_t reg = 0; reg < LTC6804_NUM_CV_REG; ++reg) {
+            // Chains whose device at this address has connected cells in this register group
+            uint8_t read = 0;
+            for (uint8_t c = 0; c < s_num_chains; ++c) {
+                if (reg < s_chains[c].num_groups) {
+                    read |= (uint8_t)(1u << c);
+                }
+            }
+            read = chains_with_ic(*mask & read, addr);
+            if (!read) {
+                continue;
+            }
+
+            uint8_t done = read;
+            esp_err_t err = ltc6804_read_reg(&done, s_rdcv_cmd[addr][reg], rx);
+            if (err != ESP_OK) {
+                ret = err;
+            }
+
+            for (uint8_t c = 0; c < s_num_chains; ++c) {
+                if (!(done & (1u << c))) {
+                    continue;
+                }
+                // Parse 3 cell voltages from the 6 data bytes (little-endian 16-bit) and verify PEC in bytes 6-7
+                uint16_t words[LTC6804_CELLS_PER_REG];
+                if (!ltc6804_decode_reg(&rx[c][LTC6804_CMD_BYTES], words)) {
+                    done &= (uint8_t)~(1u << c);
+                    ret = ESP_ERR_INVALID_CRC;
+                    continue;
+                }
+                const chain_t *ch = &s_chains[c];
+                uint8_t cell = (uint8_t)(ch->first_cell + addr * ch->cells_per_ic);
+                for (uint8_t k = 0; k < LTC6804_CELLS_PER_REG; ++k) {
+                    uint8_t channel = (uint8_t)(reg * LTC6804_CELLS_PER_REG + k);
+                    if (channel < ch->cells_per_ic) {
+                        cell_codes[cell + channel] = words[k];
+                    }
+                }
+            }
+            *mask &= (uint8_t)~(read & (uint8_t)~done);
         }
     }
 
-    if (pec_errors > 0) {
-        return ESP_ERR_INVALID_CRC;
-    }
-
-    return ESP_OK;
+    return ret;
 }
 
-/// This function writes the 6-byte configuration register to the LTC6804 in addressed mode.
+/// This function writes the 6-byte configuration register of the device with the given address on the selected
+/// chains in addressed mode.
 ///
-/// \param[in] cfg  Pointer to 6 configuration bytes (CFGR0 .. CFGR5)
-/// \return ESP_OK on success
-static esp_err_t ltc6804_wrcfg(const uint8_t cfg[6])
+/// \param[in,out] mask Chains to access, on return chains with successful transfer
+/// \param[in]     addr Device address
+/// \param[in]     cfg  Pointer to 6 configuration bytes (CFGR0 .. CFGR5)
+/// \return ESP_OK on success, otherwise an error code of the transport
+static esp_err_t ltc6804_wrcfg(uint8_t *mask, uint8_t addr, const uint8_t cfg[6])
 {
-    // WRCFG command with LTC6804-2 addressing
-    uint8_t cmd[4];
-    cmd[0] = LTC6804_ADDR_CMD(LTC6804_IC_ADDR);
-    cmd[1] = 0x01;  // WRCFG register command
-
-    uint16_t cmd_pec = pec15_calc(2, cmd);
-    cmd[2] = (uint8_t)(cmd_pec >> 8);
-    cmd[3] = (uint8_t)(cmd_pec);
-
-    // Build data payload: 6 config bytes + 2 PEC bytes
-    uint8_t payload[8];
-    memcpy(payload, cfg, 6);
-    uint16_t data_pec = pec15_calc(6, cfg);
-    payload[6] = (uint8_t)(data_pec >> 8);
-    payload[7] = (uint8_t)(data_pec);
+    // Single TX: 4-byte cmd + 6 config bytes + 2 PEC bytes
+    uint8_t tx_buf[LTC6804_FRAME_BYTES];
+    memcpy(tx_buf, s_wrcfg_cmd[addr], LTC6804_CMD_BYTES);
+    memcpy(&tx_buf[LTC6804_CMD_BYTES], cfg, LTC6804_REG_DATA_BYTES);
+    uint16_t data_pec = ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, cfg);
+    tx_buf[LTC6804_CMD_BYTES + 6] = (uint8_t)(data_pec >> 8);
+    tx_buf[LTC6804_CMD_BYTES + 7] = (uint8_t)(data_pec);
+
+    return transfer_frame(mask, tx_buf, NULL, sizeof(tx_buf));
+}
 
-    // Combine into single TX: 4-byte cmd + 8-byte payload
-    uint8_t tx_buf[12];
-    memcpy(tx_buf, cmd, 4);
-    memcpy(&tx_buf[4], payload, 8);
+/// This function writes the configuration register of every device of the selected chains. The write of one
+/// device address is sent on all chains at once.
+///
+/// \param[in,out] mask Chains to access, on return chains where all writes succeeded
+/// \param[in]     cfg  Pointer to 6 configuration bytes (CFGR0 .. CFGR5)
+/// \return ESP_OK on success, otherwise the error code of the last failed write
+static esp_err_t ltc6804_wrcfg_all(uint8_t *mask, const uint8_t cfg[6])
+{
+    esp_err_t ret = ESP_OK;
 
-    wakeup_idle();
+    for (uint8_t addr = 0; addr < s_max_ics; ++addr) {
+        uint8_t write = chains_with_ic(*mask, addr);
+        if (!write) {
+            continue;
+        }
+        uint8_t done = write;
+        esp_err_t err = ltc6804_wrcfg(&done, addr, cfg);
+        if (err != ESP_OK) {
+            ret = err;
+            *mask &= (uint8_t)~(write & (uint8_t)~done);
+        }
+    }
 
-    cs_low();
-    esp_err_t ret = spi_transfer(tx_buf, NULL, sizeof(tx_buf));
-    cs_high();
     return ret;
 }
 
-/// This function reads back the 6-byte configuration register + 2 PEC bytes from the LTC6804
-/// in addressed mode. Used for diagnostics to verify SPI communication.
+/// This function reads back the 6-byte configuration register + 2 PEC bytes of one device in addressed mode. Used
+/// for diagnostics to verify SPI communication.
 ///
+/// \param[in]  chain  Chain index
+/// \param[in]  addr   Device address
 /// \param[out] r_cfg  Buffer of at least 8 bytes to receive CFGR0..CFGR5 + PEC_H + PEC_L
 /// \return ESP_OK if PEC matches, ESP_ERR_INVALID_CRC otherwise
-static esp_err_t ltc6804_rdcfg(uint8_t r_cfg[8])
+static esp_err_t ltc6804_rdcfg(uint8_t chain, uint8_t addr, uint8_t r_cfg[8])
 {
-    uint8_t cmd[4];
-    cmd[0] = LTC6804_ADDR_CMD(LTC6804_IC_ADDR);
-    cmd[1] = 0x02;  // RDCFG command
-
-    uint16_t pec = pec15_calc(2, cmd);
-    cmd[2] = (uint8_t)(pec >> 8);
-    cmd[3] = (uint8_t)(pec);
-
-    uint8_t tx_buf[4 + 8];
-    uint8_t rx_buf[4 + 8];
-    memcpy(tx_buf, cmd, 4);
-    memset(&tx_buf[4], 0xFF, 8);
-
-    wakeup_idle();
-
-    cs_low();
-    esp_err_t ret = spi_transfer(tx_buf, rx_buf, sizeof(tx_buf));
-    cs_high();
+    uint8_t mask = (uint8_t)(1u << chain);
+    chain_rx_t rx;
 
+    esp_err_t ret = ltc6804_read_reg(&mask, s_rdcfg_cmd[addr], rx);
     if (ret != ESP_OK) {
         return ret;
     }
 
-    memcpy(r_cfg, &rx_buf[4], 8);
+    memcpy(r_cfg, &rx[chain][LTC6804_CMD_BYTES], 8);
 
     // Verify PEC on the 6 data bytes
     uint16_t received_pec = ((uint16_t)r_cfg[6] << 8) | r_cfg[7];
-    uint16_t calc_pec = pec15_calc(6, r_cfg);
+    uint16_t calc_pec = ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, r_cfg);
     if (received_pec != calc_pec) {
         BMS_LOGW("RDCFG raw RX: %02X %02X %02X %02X %02X %02X %02X %02X | PEC recv=%04X calc=%04X",
                  r_cfg[0], r_cfg[1], r_cfg[2], r_cfg[3],
@@ -702,71 +1101,21 @@ static esp_err_t ltc6804_rdcfg(uint8_t r_cfg[8])
     return ESP_OK;
 }
 
-/// This function sends the ADSTAT (start status group ADC conversion) command to the LTC6804.
-/// Triggers conversion of internal temperature, sum of cells voltage, and power supply voltages.
-///
-/// \param[in] None
-/// \return ESP_OK on success, or an error code propagated from spi_transfer()
-static esp_err_t ltc6804_adstat(void)
-{
-    uint8_t cmd[4];
-
-    wakeup_idle();
-
-    cmd[0] = s_adstat_cmd[0];
-    cmd[1] = s_adstat_cmd[1];
-
-    uint16_t pec = pec15_calc(2, cmd);
-    cmd[2] = (uint8_t)(pec >> 8);
-    cmd[3] = (uint8_t)(pec);
-
-    cs_low();
-    esp_err_t ret = spi_transfer(cmd, NULL, 4);
-    cs_high();
-    return ret;
-}
-
-/// This function reads one status register group from the LTC6804 in addressed mode.
-/// Each register group contains 6 data bytes + 2 PEC bytes = 8 bytes total.
-/// Register A (RDSTATA = 0x10): SOC[15:0], ITMP[15:0], VA[15:0]
-/// Register B (RDSTATB = 0x12): VD[15:0], flags/revision
+/// This function accumulates raw cell codes of one read into a running calibration capture.
 ///
-/// \param[in] reg   Register group number (1=A, 2=B)
-/// \param[out] data  Buffer of at least ::NUM_RX_BYTES (8) bytes to receive raw data
-/// \return ESP_OK on success
-static esp_err_t ltc6804_rdstat_reg(uint8_t reg, uint8_t *data)
+/// \param[in] cell_codes Raw cell codes of all channels
+/// \return None
+static void calib_capture(const uint16_t cell_codes[LTC6804_MAX_CELLS])
 {
-    // RDSTATA = 0x10, RDSTATB = 0x12
-    static const uint8_t reg_cmd[2] = {0x10, 0x12};
-
-    if (reg < 1 || reg > 2) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    uint8_t cmd[4];
-    cmd[0] = LTC6804_ADDR_CMD(LTC6804_IC_ADDR);
-    cmd[1] = reg_cmd[reg - 1];
-
-    uint16_t pec = pec15_calc(2, cmd);
-    cmd[2] = (uint8_t)(pec >> 8);
-    cmd[3] = (uint8_t)(pec);
-
-    uint8_t tx_buf[4 + NUM_RX_BYTES];
-    uint8_t rx_buf[4 + NUM_RX_BYTES];
-
-    memcpy(tx_buf, cmd, 4);
-    memset(&tx_buf[4], 0xFF, NUM_RX_BYTES);
-
-    wakeup_idle();
-
-    cs_low();
-    esp_err_t ret = spi_transfer(tx_buf, rx_buf, sizeof(tx_buf));
-    cs_high();
-
-    if (ret != ESP_OK) {
-        return ret;
+    taskENTER_CRITICAL(&s_capture_lock);
+    if (s_capture_left) {
+        for (int c = 0; c < LTC6804_MAX_CELLS; ++c) {
+            s_capture_sum[c] += cell_codes[c];
+        }
+        s_capture_count++;
+        s_capture_left--;
     }
+    taskEXIT_CRITICAL(&s_capture_lock);
 
-    memcpy(data, &rx_buf[4], NUM_RX_BYTES);
-    return ESP_OK;
+    return;
 }
@@ -7,13 +7,21 @@
 #pragma once
 
 #include "esp_err.h"
+#include "ltc6804_transport.h"
+#include "ltc6804_codec.h"
+#include "bms_data.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
 /*==============================================================================================================*/
-/// Maximum number of cells the LTC6804 can measure
-#define LTC6804_MAX_CELLS      12
+/// Number of cell channels of one LTC6804
+#define LTC6804_IC_CELLS       12
+
+/// Maximum number of cells read by the driver over all chains and devices (size of raw code arrays), covers the
+/// Kconfig chain layout
+#define LTC6804_MAX_CELLS      BMS_MAX_CELLS
 
 /// Number of cell voltage register groups (A, B, C, D)
 #define LTC6804_NUM_CV_REG     4
@@ -21,23 +29,18 @@
 /// Number of cells per register group
 #define LTC6804_CELLS_PER_REG  3
 
-/// SPI pin assignments. GPIO 23/19/18/5 are native SPI pins on ESP32
-/// SPI HOST for ESP32 SPI master driver
-#define LTC6804_SPI_HOST       SPI3_HOST
-/// SPI MOSI pin
-#define LTC6804_PIN_MOSI       23
-/// SPI MISO pin
-#define LTC6804_PIN_MISO       19
-/// SPI SCLK pin
-#define LTC6804_PIN_SCLK       18
-/// SPI CS pin, can be any GPIO since CS is controlled manually via GPIO functions (cs_low() and cs_high())
-#define LTC6804_PIN_CS         5
+/// Maximum number of chains (SPI hosts with their own devices) read in parallel
+#define LTC6804_MAX_CHAINS     2
 
-/// SPI clock frequency 1 MHz. LTC6804-2 supports up to 10 MHz. Using 1 MHz provides safe margin for signal integrity and timing
-#define LTC6804_SPI_FREQ_HZ   1000000
+/// Maximum number of LTC6804-2 devices on one chain (4 address bits)
+#define LTC6804_MAX_ICS        16
 
-/// LTC6804-2 IC address. In a single-IC setup this is typically 0.
-#define LTC6804_IC_ADDR        0
+/// SPI clock frequency of all chains. LTC6804-2 supports up to 10 MHz. Default 1 MHz provides safe margin for signal
+/// integrity and timing
+#ifndef CONFIG_BMS_LTC_SPI_FREQ_HZ
+#define CONFIG_BMS_LTC_SPI_FREQ_HZ   1000000
+#endif
+#define LTC6804_SPI_FREQ_HZ    CONFIG_BMS_LTC_SPI_FREQ_HZ
 
 /// ADC conversion fast mode (27 kHz filter)
 #define LTC6804_MD_FAST        1
@@ -71,6 +74,12 @@
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
 /*==============================================================================================================*/
+/// Structure describing one chain of LTC6804-2 devices sharing an SPI bus and CS line
+typedef struct {
+    const ltc6804_transport_t *transport;   ///< Transport of the chain
+    uint8_t num_ics;                        ///< Number of devices, addresses 0 .. num_ics-1
+    uint8_t cells_per_ic;                   ///< Cells per device, connected to channels 1 .. cells_per_ic
+} ltc6804_chain_cfg_t;
 
 /*==============================================================================================================*/
 /*                                             Public Constants                                                 */
@@ -83,9 +92,20 @@
 /*==============================================================================================================*/
 /*                                        Public Function Prototypes                                            */
 /*==============================================================================================================*/
+esp_err_t ltc6804_set_chains(const ltc6804_chain_cfg_t *chains, uint8_t num_chains);
+uint8_t ltc6804_num_cells(void);
 esp_err_t ltc6804_init(float cell_v_min, float cell_v_max);
 esp_err_t ltc6804_read_cell_voltages(float *voltages, uint8_t num_cells);
 esp_err_t ltc6804_read_status(uint8_t stata[6], uint8_t statb[6]);
+esp_err_t ltc6804_read_cell_flags(bms_cell_mask_t *uv, bms_cell_mask_t *ov);
+esp_err_t ltc6804_set_adc_mode(uint8_t md);
+esp_err_t ltc6804_set_low_power(bool enable);
+void ltc6804_set_calib(const ltc6804_calib_t *calib);
+void ltc6804_get_calib(ltc6804_calib_t *calib);
+void ltc6804_get_raw_codes(uint16_t codes[LTC6804_MAX_CELLS]);
+esp_err_t ltc6804_calib_capture_start(uint16_t reads);
+void ltc6804_calib_capture_cancel(void);
+bool ltc6804_calib_capture_result(uint16_t codes[LTC6804_MAX_CELLS]);
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
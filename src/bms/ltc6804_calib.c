@@ -0,0 +1,290 @@
+/// LTC6804 cell channel calibration. Stores per-channel gain and offset constants (::ltc6804_calib_t) in NVS and
+/// applies them to the driver at boot. Constants are fitted from reference voltages applied to the cell inputs:
+/// for each reference point, raw codes are averaged over reads done by the Fast Core (the SPI bus is never
+/// accessed from the calling task), then gain and offset of every channel are fitted from one or two points.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "ltc6804_calib.h"
+#include "ltc6804_codec.h"
+#include "logging.h"
+#include "power_mode.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag
+#define LOG_MODULE_TAG "LTC6804_CALIB"
+
+/// NVS namespace and key of stored calibration
+#define CALIB_NVS_NAMESPACE  "storage"
+#define CALIB_NVS_KEY        "ltc_calib"
+
+/// Version of stored calibration blob
+#define CALIB_BLOB_VERSION   1
+
+/// Poll interval while waiting for capture of a reference point in milliseconds
+#define CALIB_POLL_MS        50
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Calibration blob stored in NVS
+typedef struct {
+    uint16_t        version;   ///< ::CALIB_BLOB_VERSION
+    uint16_t        channels;  ///< Number of channels (::LTC6804_CALIB_CHANNELS)
+    ltc6804_calib_t calib;     ///< Calibration constants
+} calib_blob_t;
+
+/// One captured reference point
+typedef struct {
+    bool     valid;                        ///< Flag identifying if the point was captured
+    uint16_t code[LTC6804_MAX_CELLS];      ///< Averaged raw codes
+    uint16_t ref[LTC6804_MAX_CELLS];       ///< Reference voltages in codes (100 uV)
+} calib_point_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static esp_err_t calib_store(const ltc6804_calib_t *calib);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Captured reference points
+static calib_point_t s_points[LTC6804_CALIB_POINTS];
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function loads calibration constants from NVS and applies them to the driver. Missing or incompatible
+/// calibration leaves the identity calibration in place.
+///
+/// \param None
+/// \return ESP_OK if calibration was applied or none is stored, otherwise an NVS error code
+esp_err_t ltc6804_calib_load(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(CALIB_NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    calib_blob_t blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs_handle, CALIB_NVS_KEY, &blob, &len);
+    nvs_close(nvs_handle);
+
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        BMS_LOGI("No cell calibration stored, using nominal conversion");
+        return ESP_OK;
+    }
+    if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+        // Stored for a larger chain layout (more channels)
+        BMS_LOGW("Stored cell calibration incompatible (larger than %u bytes), ignored", (unsigned)sizeof(blob));
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len != sizeof(blob) || blob.version != CALIB_BLOB_VERSION || blob.channels != LTC6804_CALIB_CHANNELS) {
+        BMS_LOGW("Stored cell calibration incompatible (len %u, version %u), ignored",
+                 (unsigned)len, (unsigned)blob.version);
+        return ESP_OK;
+    }
+
+    ltc6804_set_calib(&blob.calib);
+    BMS_LOGI("Cell calibration loaded");
+    return ESP_OK;
+}
+
+/// This function captures one reference point: averages raw codes of ::LTC6804_CALIB_CAPTURE_READS reads done by
+/// the Fast Core and stores them with the given reference voltages. Blocks the calling task until the capture
+/// is complete, at most ::LTC6804_CALIB_CAPTURE_TIMEOUT_MS; a capture that times out is cancelled. Rejected in
+/// low-power mode, where reads come every CONFIG_BMS_LOW_POWER_PERIOD_MS and the capture could not complete.
+///
+/// \param[in] point     Reference point index (0 to ::LTC6804_CALIB_POINTS - 1)
+/// \param[in] ref_v     Reference voltage of each cell in volts
+/// \param[in] num_cells Number of calibrated cells (1 to ::LTC6804_MAX_CELLS)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters, ESP_ERR_INVALID_STATE in low-power mode,
+///         ESP_ERR_TIMEOUT if cells are not being read (e.g. other adapter than LTC6804 selected)
+esp_err_t ltc6804_calib_capture_point(uint8_t point, const float *ref_v, uint8_t num_cells)
+{
+    if (point >= LTC6804_CALIB_POINTS || !ref_v || num_cells == 0 || num_cells > LTC6804_MAX_CELLS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        if (ref_v[c] < 0.0f || ref_v[c] > 6.5535f) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+#if CONFIG_BMS_LOW_POWER
+    if (power_mode_get() == PWR_MODE_LOW) {
+        BMS_LOGW("Calibration capture rejected in low-power mode");
+        return ESP_ERR_INVALID_STATE;
+    }
+#endif
+
+    calib_point_t *p = &s_points[point];
+    p->valid = false;
+
+    esp_err_t err = ltc6804_calib_capture_start(LTC6804_CALIB_CAPTURE_READS);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t waited_ms = 0;
+    while (!ltc6804_calib_capture_result(p->code)) {
+        if (waited_ms >= LTC6804_CALIB_CAPTURE_TIMEOUT_MS) {
+            // Reads must not keep accumulating into a capture nobody reads, nor race with the next start
+            ltc6804_calib_capture_cancel();
+            BMS_LOGE("Calibration capture of point %u timed out", (unsigned)point);
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CALIB_POLL_MS));
+        waited_ms += CALIB_POLL_MS;
+    }
+
+    memset(p->ref, 0, sizeof(p->ref));
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        p->ref[c] = (uint16_t)(ref_v[c] * 10000.0f + 0.5f);
+    }
+    p->valid = true;
+
+    BMS_LOGI("Calibration point %u captured (cell 1: code %u, reference %u)",
+             (unsigned)point, (unsigned)p->code[0], (unsigned)p->ref[0]);
+    return ESP_OK;
+}
+
+/// This function gets a captured reference point.
+///
+/// \param[in]  point Reference point index
+/// \param[out] code  Averaged raw codes of all channels
+/// \param[out] ref   Reference voltages in codes (0 for channels not calibrated)
+/// \return True if the point was captured, otherwise false (outputs untouched)
+bool ltc6804_calib_get_point(uint8_t point, uint16_t code[LTC6804_MAX_CELLS], uint16_t ref[LTC6804_MAX_CELLS])
+{
+    if (point >= LTC6804_CALIB_POINTS || !s_points[point].valid) {
+        return false;
+    }
+
+    memcpy(code, s_points[point].code, sizeof(s_points[point].code));
+    memcpy(ref, s_points[point].ref, sizeof(s_points[point].ref));
+    return true;
+}
+
+/// This function fits calibration constants of the first num_cells channels from captured reference points,
+/// applies them to the driver and stores them in NVS. With only point 0 captured, offsets are corrected and
+/// gains left nominal; with both points, gain and offset are fitted (see ltc6804_calib_fit()). Remaining
+/// channels get identity calibration.
+///
+/// \param[in] num_cells Number of calibrated cells (1 to ::LTC6804_MAX_CELLS)
+/// \return ESP_OK on success, ESP_ERR_INVALID_STATE if point 0 was not captured, ESP_ERR_INVALID_ARG on invalid
+///         number of cells, ESP_ERR_INVALID_RESPONSE if constants of a channel are out of range, or an NVS error
+esp_err_t ltc6804_calib_fit_and_save(uint8_t num_cells)
+{
+    if (num_cells == 0 || num_cells > LTC6804_MAX_CELLS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_points[0].valid) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const calib_point_t *p0 = &s_points[0];
+    const calib_point_t *p1 = s_points[1].valid ? &s_points[1] : &s_points[0];
+    ltc6804_calib_t calib = {0};
+
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        if (!ltc6804_calib_fit(p0->code[c], p0->ref[c], p1->code[c], p1->ref[c], &calib.gain[c], &calib.offset[c])) {
+            BMS_LOGE("Calibration of cell %u out of range (codes %u/%u, references %u/%u)", (unsigned)(c + 1),
+                     (unsigned)p0->code[c], (unsigned)p1->code[c], (unsigned)p0->ref[c], (unsigned)p1->ref[c]);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    ltc6804_set_calib(&calib);
+    esp_err_t err = calib_store(&calib);
+    if (err != ESP_OK) {
+        BMS_LOGE("Failed to store cell calibration: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    BMS_LOGI("Cell calibration of %u cells fitted from %u point(s) and stored",
+             (unsigned)num_cells, s_points[1].valid ? 2u : 1u);
+    return ESP_OK;
+}
+
+/// This function restores identity calibration, removes stored calibration from NVS and discards captured
+/// reference points.
+///
+/// \param None
+/// \return ESP_OK on success, otherwise an NVS error code
+esp_err_t ltc6804_calib_reset(void)
+{
+    ltc6804_set_calib(NULL);
+    memset(s_points, 0, sizeof(s_points));
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_erase_key(nvs_handle, CALIB_NVS_KEY);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    }
+    nvs_close(nvs_handle);
+
+    BMS_LOGI("Cell calibration reset");
+    return err;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function stores calibration constants in NVS.
+///
+/// \param[in] calib Calibration constants
+/// \return ESP_OK on success, otherwise an NVS error code
+static esp_err_t calib_store(const ltc6804_calib_t *calib)
+{
+    calib_blob_t blob = {
+        .version  = CALIB_BLOB_VERSION,
+        .channels = LTC6804_CALIB_CHANNELS,
+        .calib    = *calib,
+    };
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs_handle, CALIB_NVS_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    return err;
+}
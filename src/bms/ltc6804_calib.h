@@ -0,0 +1,48 @@
+/// Header file for `ltc6804_calib.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "esp_err.h"
+#include "ltc6804.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Number of calibration reference points (two-point gain and offset fit)
+#define LTC6804_CALIB_POINTS         2
+
+/// Number of cell reads averaged per captured reference point (1 s at 20 Hz)
+#define LTC6804_CALIB_CAPTURE_READS  20
+
+/// Maximum time to wait for capture of one reference point in milliseconds
+#define LTC6804_CALIB_CAPTURE_TIMEOUT_MS  5000
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+esp_err_t ltc6804_calib_load(void);
+esp_err_t ltc6804_calib_capture_point(uint8_t point, const float *ref_v, uint8_t num_cells);
+bool ltc6804_calib_get_point(uint8_t point, uint16_t code[LTC6804_MAX_CELLS], uint16_t ref[LTC6804_MAX_CELLS]);
+esp_err_t ltc6804_calib_fit_and_save(uint8_t num_cells);
+esp_err_t ltc6804_calib_reset(void);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
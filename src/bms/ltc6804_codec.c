@@ -0,0 +1,312 @@
+/// This module implements the hardware independent part of the LTC6804-2 protocol: PEC15 calculation, command
+/// encoding and parsing of register group data. It has no ESP-IDF dependencies, so it is also built by the host
+/// benchmark (tools/host).
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "ltc6804_codec.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Pre-computed CRC15 lookup table for LTC6804 PEC calculation.
+/// Sourced from LTC6804 datasheet / Linduino reference code.
+static const uint16_t crc15_table[256] = {
+    0x0000, 0xC599, 0xCEAB, 0x0B32, 0xD8CF, 0x1D56, 0x1664, 0xD3FD,
+    0xF407, 0x319E, 0x3AAC, 0xFF35, 0x2CC8, 0xE951, 0xE263, 0x27FA,
+    0xAD97, 0x680E, 0x633C, 0xA6A5, 0x7558, 0xB0C1, 0xBBF3, 0x7E6A,
+    0x5990, 0x9C09, 0x973B, 0x52A2, 0x815F, 0x44C6, 0x4FF4, 0x8A6D,
+    0x5B2E, 0x9EB7, 0x9585, 0x501C, 0x83E1, 0x4678, 0x4D4A, 0x88D3,
+    0xAF29, 0x6AB0, 0x6182, 0xA41B, 0x77E6, 0xB27F, 0xB94D, 0x7CD4,
+    0xF6B9, 0x3320, 0x3812, 0xFD8B, 0x2E76, 0xEBEF, 0xE0DD, 0x2544,
+    0x02BE, 0xC727, 0xCC15, 0x098C, 0xDA71, 0x1FE8, 0x14DA, 0xD143,
+    0xF3C5, 0x365C, 0x3D6E, 0xF8F7, 0x2B0A, 0xEE93, 0xE5A1, 0x2038,
+    0x07C2, 0xC25B, 0xC969, 0x0CF0, 0xDF0D, 0x1A94, 0x11A6, 0xD43F,
+    0x5E52, 0x9BCB, 0x90F9, 0x5560, 0x869D, 0x4304, 0x4836, 0x8DAF,
+    0xAA55, 0x6FCC, 0x64FE, 0xA167, 0x729A, 0xB703, 0xBC31, 0x79A8,
+    0xA8EB, 0x6D72, 0x6640, 0xA3D9, 0x7024, 0xB5BD, 0xBE8F, 0x7B16,
+    0x5CEC, 0x9975, 0x9247, 0x57DE, 0x8423, 0x41BA, 0x4A88, 0x8F11,
+    0x057C, 0xC0E5, 0xCBD7, 0x0E4E, 0xDDB3, 0x182A, 0x1318, 0xD681,
+    0xF17B, 0x34E2, 0x3FD0, 0xFA49, 0x29B4, 0xEC2D, 0xE71F, 0x2286,
+    0xA213, 0x678A, 0x6CB8, 0xA921, 0x7ADC, 0xBF45, 0xB477, 0x71EE,
+    0x5614, 0x938D, 0x98BF, 0x5D26, 0x8EDB, 0x4B42, 0x4070, 0x85E9,
+    0x0F84, 0xCA1D, 0xC12F, 0x04B6, 0xD74B, 0x12D2, 0x19E0, 0xDC79,
+    0xFB83, 0x3E1A, 0x3528, 0xF0B1, 0x234C, 0xE6D5, 0xEDE7, 0x287E,
+    0xF93D, 0x3CA4, 0x3796, 0xF20F, 0x21F2, 0xE46B, 0xEF59, 0x2AC0,
+    0x0D3A, 0xC8A3, 0xC391, 0x0608, 0xD5F5, 0x106C, 0x1B5E, 0xDEC7,
+    0x54AA, 0x9133, 0x9A01, 0x5F98, 0x8C65, 0x49FC, 0x42CE, 0x8757,
+    0xA0AD, 0x6534, 0x6E06, 0xAB9F, 0x7862, 0xBDFB, 0xB6C9, 0x7350,
+    0x51D6, 0x944F, 0x9F7D, 0x5AE4, 0x8919, 0x4C80, 0x47B2, 0x822B,
+    0xA5D1, 0x6048, 0x6B7A, 0xAEE3, 0x7D1E, 0xB887, 0xB3B5, 0x762C,
+    0xFC41, 0x39D8, 0x32EA, 0xF773, 0x248E, 0xE117, 0xEA25, 0x2FBC,
+    0x0846, 0xCDDF, 0xC6ED, 0x0374, 0xD089, 0x1510, 0x1E22, 0xDBBB,
+    0x0AF8, 0xCF61, 0xC453, 0x01CA, 0xD237, 0x17AE, 0x1C9C, 0xD905,
+    0xFEFF, 0x3B66, 0x3054, 0xF5CD, 0x2630, 0xE3A9, 0xE89B, 0x2D02,
+    0xA76F, 0x62F6, 0x69C4, 0xAC5D, 0x7FA0, 0xBA39, 0xB10B, 0x7492,
+    0x5368, 0x96F1, 0x9DC3, 0x585A, 0x8BA7, 0x4E3E, 0x450C, 0x8095,
+};
+
+/// Second table of the two bytes per step (slice-by-2) PEC calculation in ltc6804_decode_reg(): CRC15 remainder
+/// of byte i followed by a zero byte. Generated from ::crc15_table by
+/// t[i] = (((crc15_table[i] & 0x7F) << 8) ^ crc15_table[(crc15_table[i] >> 7) & 0xFF]) & 0x7FFF.
+static const uint16_t crc15_table_hi[256] = {
+    0x0000, 0x4426, 0x4dd5, 0x09f3, 0x5e33, 0x1a15, 0x13e6, 0x57c0,
+    0x79ff, 0x3dd9, 0x342a, 0x700c, 0x27cc, 0x63ea, 0x6a19, 0x2e3f,
+    0x3667, 0x7241, 0x7bb2, 0x3f94, 0x6854, 0x2c72, 0x2581, 0x61a7,
+    0x4f98, 0x0bbe, 0x024d, 0x466b, 0x11ab, 0x558d, 0x5c7e, 0x1858,
+    0x6cce, 0x28e8, 0x211b, 0x653d, 0x32fd, 0x76db, 0x7f28, 0x3b0e,
+    0x1531, 0x5117, 0x58e4, 0x1cc2, 0x4b02, 0x0f24, 0x06d7, 0x42f1,
+    0x5aa9, 0x1e8f, 0x177c, 0x535a, 0x049a, 0x40bc, 0x494f, 0x0d69,
+    0x2356, 0x6770, 0x6e83, 0x2aa5, 0x7d65, 0x3943, 0x30b0, 0x7496,
+    0x1c05, 0x5823, 0x51d0, 0x15f6, 0x4236, 0x0610, 0x0fe3, 0x4bc5,
+    0x65fa, 0x21dc, 0x282f, 0x6c09, 0x3bc9, 0x7fef, 0x761c, 0x323a,
+    0x2a62, 0x6e44, 0x67b7, 0x2391, 0x7451, 0x3077, 0x3984, 0x7da2,
+    0x539d, 0x17bb, 0x1e48, 0x5a6e, 0x0dae, 0x4988, 0x407b, 0x045d,
+    0x70cb, 0x34ed, 0x3d1e, 0x7938, 0x2ef8, 0x6ade, 0x632d, 0x270b,
+    0x0934, 0x4d12, 0x44e1, 0x00c7, 0x5707, 0x1321, 0x1ad2, 0x5ef4,
+    0x46ac, 0x028a, 0x0b79, 0x4f5f, 0x189f, 0x5cb9, 0x554a, 0x116c,
+    0x3f53, 0x7b75, 0x7286, 0x36a0, 0x6160, 0x2546, 0x2cb5, 0x6893,
+    0x380a, 0x7c2c, 0x75df, 0x31f9, 0x6639, 0x221f, 0x2bec, 0x6fca,
+    0x41f5, 0x05d3, 0x0c20, 0x4806, 0x1fc6, 0x5be0, 0x5213, 0x1635,
+    0x0e6d, 0x4a4b, 0x43b8, 0x079e, 0x505e, 0x1478, 0x1d8b, 0x59ad,
+    0x7792, 0x33b4, 0x3a47, 0x7e61, 0x29a1, 0x6d87, 0x6474, 0x2052,
+    0x54c4, 0x10e2, 0x1911, 0x5d37, 0x0af7, 0x4ed1, 0x4722, 0x0304,
+    0x2d3b, 0x691d, 0x60ee, 0x24c8, 0x7308, 0x372e, 0x3edd, 0x7afb,
+    0x62a3, 0x2685, 0x2f76, 0x6b50, 0x3c90, 0x78b6, 0x7145, 0x3563,
+    0x1b5c, 0x5f7a, 0x5689, 0x12af, 0x456f, 0x0149, 0x08ba, 0x4c9c,
+    0x240f, 0x6029, 0x69da, 0x2dfc, 0x7a3c, 0x3e1a, 0x37e9, 0x73cf,
+    0x5df0, 0x19d6, 0x1025, 0x5403, 0x03c3, 0x47e5, 0x4e16, 0x0a30,
+    0x1268, 0x564e, 0x5fbd, 0x1b9b, 0x4c5b, 0x087d, 0x018e, 0x45a8,
+    0x6b97, 0x2fb1, 0x2642, 0x6264, 0x35a4, 0x7182, 0x7871, 0x3c57,
+    0x48c1, 0x0ce7, 0x0514, 0x4132, 0x16f2, 0x52d4, 0x5b27, 0x1f01,
+    0x313e, 0x7518, 0x7ceb, 0x38cd, 0x6f0d, 0x2b2b, 0x22d8, 0x66fe,
+    0x7ea6, 0x3a80, 0x3373, 0x7755, 0x2095, 0x64b3, 0x6d40, 0x2966,
+    0x0759, 0x437f, 0x4a8c, 0x0eaa, 0x596a, 0x1d4c, 0x14bf, 0x5099,
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function calculates the CRC15/PEC15 used by the LTC6804 for data integrity verification, one byte per step
+/// with ::crc15_table (Linduino reference algorithm). Used for command frames and register writes, which are only
+/// 2 to 6 bytes long; received register groups are checked by ltc6804_decode_reg().
+/// The result is left-shifted by 1 (LSB is always 0).
+///
+/// \param[in] len   Number of bytes in data
+/// \param[in] data  Pointer to data bytes
+/// \return 16-bit PEC value (CRC15 * 2)
+uint16_t ltc6804_pec15_calc(uint8_t len, const uint8_t *data)
+{
+    uint16_t remainder = 16; // PEC seed per LTC6804 spec
+    for (uint8_t i = 0; i < len; ++i) {
+        uint16_t addr = ((remainder >> 7) ^ data[i]) & 0xFF;
+        remainder = (remainder << 8) ^ crc15_table[addr];
+    }
+    return remainder * 2; // CRC15 has 0 in LSB
+}
+
+/// This function builds a 4-byte command frame from the 2 command bytes followed by their PEC (big-endian).
+///
+/// \param[in]  cmd0 First command byte
+/// \param[in]  cmd1 Second command byte
+/// \param[out] out  Buffer of ::LTC6804_CMD_BYTES bytes to receive the command frame
+/// \return None
+void ltc6804_encode_cmd(uint8_t cmd0, uint8_t cmd1, uint8_t out[LTC6804_CMD_BYTES])
+{
+    out[0] = cmd0;
+    out[1] = cmd1;
+
+    uint16_t pec = ltc6804_pec15_calc(2, out);
+    out[2] = (uint8_t)(pec >> 8);
+    out[3] = (uint8_t)(pec);
+
+    return;
+}
+
+/// This function maps ADC mode, discharge control, and channel selection into the 2-byte ADCV and ADSTAT commands.
+///
+/// \param[in]  md     ADC conversion mode
+/// \param[in]  dcp    Discharge control
+/// \param[in]  ch     Cell channel selection
+/// \param[out] adcv   Buffer of 2 bytes to receive ADCV command
+/// \param[out] adstat Buffer of 2 bytes to receive ADSTAT command
+/// \return None
+void ltc6804_encode_adc_cmds(uint8_t md, uint8_t dcp, uint8_t ch, uint8_t adcv[2], uint8_t adstat[2])
+{
+    uint8_t md_bits;
+
+    // ADCV command encoding per LTC6804 datasheet:
+    // Byte 0: 0x02 + MD[1]
+    // Byte 1: MD[0]<<7 + 0x60 + DCP<<4 + CH[2:0]
+    md_bits = (md & 0x02) >> 1;
+    adcv[0] = md_bits + 0x02;
+
+    md_bits = (md & 0x01) << 7;
+    adcv[1] = md_bits + 0x60 + (dcp << 4) + ch;
+
+    // ADSTAT command encoding per LTC6804 datasheet:
+    // Byte 0: 0x04 + MD[1]
+    // Byte 1: MD[0]<<7 + 0x68 + CHST[2:0]  (CHST=0 for all status groups)
+    md_bits = (md & 0x02) >> 1;
+    adstat[0] = md_bits + 0x04;
+
+    md_bits = (md & 0x01) << 7;
+    adstat[1] = md_bits + 0x68;
+
+    return;
+}
+
+/// This function verifies the PEC of one received register group. Received PEC is stored in bytes 6-7
+/// (big-endian) and is calculated over data bytes 0-5.
+///
+/// \param[in] reg Register group data of ::LTC6804_REG_RX_BYTES bytes (6 data + 2 PEC)
+/// \return True if received PEC matches calculated PEC
+bool ltc6804_reg_pec_ok(const uint8_t reg[LTC6804_REG_RX_BYTES])
+{
+    uint16_t received_pec = ((uint16_t)reg[6] << 8) | reg[7];
+    return received_pec == ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, reg);
+}
+
+/// This function parses 3 raw 16-bit cell codes (little-endian) from the data bytes of one cell voltage
+/// register group.
+///
+/// \param[in]  reg   Register group data of ::LTC6804_REG_RX_BYTES bytes
+/// \param[out] codes Array of 3 raw cell codes
+/// \return None
+void ltc6804_parse_cell_codes(const uint8_t reg[LTC6804_REG_RX_BYTES], uint16_t codes[3])
+{
+    for (uint8_t cell = 0; cell < 3; ++cell) {
+        uint8_t idx = cell * 2;
+        codes[cell] = reg[idx] | ((uint16_t)reg[idx + 1] << 8);
+    }
+
+    return;
+}
+
+/// This function decodes one register group in a single pass: extracts the 3 little-endian 16-bit words of the
+/// data bytes and calculates their PEC at the same time (each word is one slice-by-2 step), then compares it
+/// with the received PEC in bytes 6-7 (big-endian). Words are written even if the PEC does not match.
+///
+/// \param[in]  reg   Register group data of ::LTC6804_REG_RX_BYTES bytes (6 data + 2 PEC)
+/// \param[out] words Array of 3 words (cell codes or status values)
+/// \return True if received PEC matches calculated PEC
+bool ltc6804_decode_reg(const uint8_t reg[LTC6804_REG_RX_BYTES], uint16_t words[3])
+{
+    // Bytes are loaded once into locals: stores to words may alias reg, which would force reloads
+    uint8_t b[LTC6804_REG_RX_BYTES];
+    memcpy(b, reg, sizeof(b));
+
+    uint16_t remainder = 16; // PEC seed per LTC6804 spec
+    remainder = crc15_table_hi[(uint8_t)((remainder >> 7) ^ b[0])] ^ crc15_table[(uint8_t)((remainder << 1) ^ b[1])];
+    remainder = crc15_table_hi[(uint8_t)((remainder >> 7) ^ b[2])] ^ crc15_table[(uint8_t)((remainder << 1) ^ b[3])];
+    remainder = crc15_table_hi[(uint8_t)((remainder >> 7) ^ b[4])] ^ crc15_table[(uint8_t)((remainder << 1) ^ b[5])];
+
+    words[0] = b[0] | ((uint16_t)b[1] << 8);
+    words[1] = b[2] | ((uint16_t)b[3] << 8);
+    words[2] = b[4] | ((uint16_t)b[5] << 8);
+
+    uint16_t received_pec = ((uint16_t)b[6] << 8) | b[7];
+    return received_pec == (uint16_t)(remainder * 2);
+}
+
+/// This function cross-checks the cell UV/OV comparator flags against software limits applied to the cell voltages
+/// of the same conversion. A cell disagrees when a flag is set although its voltage is clearly inside the limits,
+/// or clear although clearly outside, i.e. farther than ::LTC6804_FLAG_TOLERANCE_V from the limit. Bitmaps hold
+/// cell c in bit (c % 32) of word c / 32 and cover at least num_cells cells.
+///
+/// \param[in]  uv        Undervoltage comparator flags
+/// \param[in]  ov        Overvoltage comparator flags
+/// \param[in]  cell_v    Cell voltages in volts
+/// \param[in]  num_cells Number of cells to check
+/// \param[in]  v_min     Software undervoltage limit in volts
+/// \param[in]  v_max     Software overvoltage limit in volts
+/// \param[out] mismatch  Disagreeing cells (same layout as the flags, (num_cells + 31) / 32 words written)
+/// \return Number of disagreeing cells, 0 if flags and software limits agree
+uint16_t ltc6804_flags_mismatch(const uint32_t *uv, const uint32_t *ov, const float *cell_v, uint8_t num_cells,
+                                float v_min, float v_max, uint32_t *mismatch)
+{
+    uint16_t count = 0;
+
+    for (uint8_t w = 0; w < (num_cells + 31u) / 32u; ++w) {
+        mismatch[w] = 0;
+    }
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        uint32_t bit = 1u << (c % 32u);
+        bool hw_uv = uv[c / 32u] & bit;
+        bool hw_ov = ov[c / 32u] & bit;
+        float v = cell_v[c];
+        if ((hw_uv && v >= v_min + LTC6804_FLAG_TOLERANCE_V) || (!hw_uv && v < v_min - LTC6804_FLAG_TOLERANCE_V) ||
+            (hw_ov && v <= v_max - LTC6804_FLAG_TOLERANCE_V) || (!hw_ov && v > v_max + LTC6804_FLAG_TOLERANCE_V)) {
+            mismatch[c / 32u] |= bit;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/// This function fits calibration constants of one channel from two reference points (averaged raw codes and
+/// reference voltages in codes). Gain is fitted from the slope when the points are at least
+/// ::LTC6804_CALIB_MIN_SPAN apart, otherwise only the offset is corrected (gain correction 0). Offset is fitted
+/// with the quantized gain so that the residuals of both points are balanced. Floats are used only here, at
+/// calibration time.
+///
+/// \param[in]  code0  Averaged raw code at the first reference point
+/// \param[in]  ref0   Reference voltage of the first point in codes (100 uV)
+/// \param[in]  code1  Averaged raw code at the second reference point (equal to code0 for offset-only fit)
+/// \param[in]  ref1   Reference voltage of the second point in codes
+/// \param[out] gain   Fitted gain correction in units of 2^-::LTC6804_CALIB_GAIN_SHIFT
+/// \param[out] offset Fitted offset correction in codes
+/// \return True on success, false if the constants are out of the representable range
+bool ltc6804_calib_fit(uint16_t code0, uint16_t ref0, uint16_t code1, uint16_t ref1, int16_t *gain, int16_t *offset)
+{
+    int32_t span = (int32_t)code1 - (int32_t)code0;
+    float g = 0.0f;
+
+    if (span >= LTC6804_CALIB_MIN_SPAN || span <= -LTC6804_CALIB_MIN_SPAN) {
+        g = ((float)((int32_t)ref1 - (int32_t)ref0) / (float)span - 1.0f) * (float)(1 << LTC6804_CALIB_GAIN_SHIFT);
+        g = (g < 0.0f) ? (g - 0.5f) : (g + 0.5f);
+        if (g < -32768.0f || g > 32767.0f) {
+            return false;
+        }
+    }
+
+    int16_t q = (int16_t)g;
+    int32_t r0 = (int32_t)ref0 - (int32_t)ltc6804_calib_apply(code0, q, 0);
+    int32_t r1 = (int32_t)ref1 - (int32_t)ltc6804_calib_apply(code1, q, 0);
+    int32_t o = r0 + r1;
+    o = (o < 0) ? (o - 1) / 2 : (o + 1) / 2;
+    if (o < -32768 || o > 32767) {
+        return false;
+    }
+
+    *gain = q;
+    *offset = (int16_t)o;
+    return true;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
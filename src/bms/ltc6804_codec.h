@@ -0,0 +1,95 @@
+/// Header file for `ltc6804_codec.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bms_data.h"
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Number of data bytes in one register group
+#define LTC6804_REG_DATA_BYTES  6
+
+/// Number of bytes received per register read (6 data + 2 PEC)
+#define LTC6804_REG_RX_BYTES    8
+
+/// Number of bytes of a command including PEC
+#define LTC6804_CMD_BYTES       4
+
+/// Resolution of the VUV/VOV comparator thresholds in volts (16 ADC LSB)
+#define LTC6804_THRESHOLD_STEP_V    0.0016f
+
+/// Voltage band around a software limit where comparator flag and software check may disagree: thresholds are
+/// quantized up to one step below the limits (see ltc6804_init()), plus two ADC LSB for float rounding
+#define LTC6804_FLAG_TOLERANCE_V    (LTC6804_THRESHOLD_STEP_V + 0.0002f)
+
+/// Number of calibrated cell channels, one per sample cell
+#define LTC6804_CALIB_CHANNELS      BMS_MAX_CELLS
+
+/// Fixed-point scale of calibration gain correction: gain = 1 + gain_corr / 2^18 (3.8 ppm step, +-12.5 % range)
+#define LTC6804_CALIB_GAIN_SHIFT    18
+
+/// Minimum distance of two calibration points in ADC codes (0.5 V) for gain fitting
+#define LTC6804_CALIB_MIN_SPAN      5000
+
+/// LTC6804-2 addressed mode prefix
+#define LTC6804_ADDR_CMD(addr)  (0x80 + ((addr) << 3))
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Per-channel calibration of cell voltage codes: code' = code + code * gain / 2^::LTC6804_CALIB_GAIN_SHIFT + offset.
+/// All-zero structure is the identity.
+typedef struct {
+    int16_t gain[LTC6804_CALIB_CHANNELS];    ///< Gain correction in units of 2^-::LTC6804_CALIB_GAIN_SHIFT
+    int16_t offset[LTC6804_CALIB_CHANNELS];  ///< Offset correction in ADC codes (100 uV)
+} ltc6804_calib_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+uint16_t ltc6804_pec15_calc(uint8_t len, const uint8_t *data);
+void ltc6804_encode_cmd(uint8_t cmd0, uint8_t cmd1, uint8_t out[LTC6804_CMD_BYTES]);
+void ltc6804_encode_adc_cmds(uint8_t md, uint8_t dcp, uint8_t ch, uint8_t adcv[2], uint8_t adstat[2]);
+bool ltc6804_reg_pec_ok(const uint8_t reg[LTC6804_REG_RX_BYTES]);
+void ltc6804_parse_cell_codes(const uint8_t reg[LTC6804_REG_RX_BYTES], uint16_t codes[3]);
+bool ltc6804_decode_reg(const uint8_t reg[LTC6804_REG_RX_BYTES], uint16_t words[3]);
+uint16_t ltc6804_flags_mismatch(const uint32_t *uv, const uint32_t *ov, const float *cell_v, uint8_t num_cells,
+                                float v_min, float v_max, uint32_t *mismatch);
+bool ltc6804_calib_fit(uint16_t code0, uint16_t ref0, uint16_t code1, uint16_t ref1, int16_t *gain, int16_t *offset);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
+/// This function applies calibration of one channel to a raw cell voltage code in integer arithmetic. The product
+/// fits 32 bits for any code and gain correction, the result is saturated to the code range.
+///
+/// \param[in] code   Raw cell voltage code (100 uV LSB)
+/// \param[in] gain   Gain correction in units of 2^-::LTC6804_CALIB_GAIN_SHIFT
+/// \param[in] offset Offset correction in codes
+/// \return Calibrated cell voltage code
+static inline uint16_t ltc6804_calib_apply(uint16_t code, int16_t gain, int16_t offset)
+{
+    int32_t c = (int32_t)code;
+    c += ((c * gain) + (1 << (LTC6804_CALIB_GAIN_SHIFT - 1))) >> LTC6804_CALIB_GAIN_SHIFT;
+    c += offset;
+
+    if (c < 0) {
+        return 0;
+    }
+    return (c > 0xFFFF) ? 0xFFFF : (uint16_t)c;
+}
@@ -0,0 +1,912 @@
+/// Software model of LTC6804-2 devices on addressable isoSPI buses, used as a transport of the LTC6804 driver
+/// (`ltc6804_transport.h`), so the unmodified driver can be exercised without hardware (host builds, timing,
+/// retry and throughput tests at any cell count).
+///
+/// The model decodes commands and checks command PEC, keeps configuration, cell voltage and status registers of up
+/// to ::LTC6804_EMU_MAX_ICS devices on each of ::LTC6804_EMU_MAX_BUSES buses, converts programmable cell voltages
+/// with optional Gaussian noise, and models timing of the real device:
+/// - SPI transfers take as long as on a bus clocked at ::LTC6804_SPI_FREQ_HZ. Transfers started on different buses
+///   overlap in time, like transfers of parallel chains on separate SPI hosts.
+/// - Conversions take the datasheet conversion time of the selected mode. Channels being converted read as cleared
+///   registers (0xFFFF) until the conversion ends.
+/// - The isoSPI port goes idle after ::EMU_T_IDLE_US without CS activity. The CS falling edge of an idle port only
+///   wakes it up, so the frame is lost.
+/// - The device goes to SLEEP when no valid command arrives within the watchdog timeout ::EMU_T_SLEEP_US, which
+///   resets the configuration register. Frames are lost until ::EMU_T_WAKE_US after the waking CS falling edge.
+///
+/// PEC errors, bit flips of device responses and lost commands can be injected with given probabilities. Time is
+/// taken from esp_timer_get_time(), delays are busy waits.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "ltc6804_emu.h"
+#include "ltc6804.h"
+#include "ltc6804_codec.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// isoSPI port idle timeout in microseconds (tIDLE minimum)
+#define EMU_T_IDLE_US          4300
+
+/// isoSPI port ready time after wakeup from idle in microseconds (tREADY maximum)
+#define EMU_T_READY_US         10
+
+/// Watchdog timeout after which the device enters SLEEP in microseconds (tSLEEP minimum)
+#define EMU_T_SLEEP_US         1800000
+
+/// Wakeup time from SLEEP in microseconds (tWAKE maximum)
+#define EMU_T_WAKE_US          400
+
+/// Maximum frame length processed by the model (command + 6 data bytes + data PEC)
+#define EMU_FRAME_BYTES        (LTC6804_CMD_BYTES + LTC6804_REG_RX_BYTES)
+
+/// Number of status register values (SOC, ITMP, VA, VD)
+#define EMU_NUM_STAT           4
+
+/// Power-on value of configuration register byte 0 (GPIO pull-downs off, REFON=0, ADCOPT=0)
+#define EMU_CFGR0_DEFAULT      0xF8
+
+/// Cleared register value
+#define EMU_CLEARED            0xFFFF
+
+/// Emulated analog supply voltage in volts
+#define EMU_VA_V               5.0f
+
+/// Emulated digital supply voltage in volts
+#define EMU_VD_V               3.0f
+
+/// Command codes (11 bit) of the modeled commands
+#define CMD_WRCFG              0x001
+#define CMD_RDCFG              0x002
+#define CMD_RDCVA              0x004
+#define CMD_RDCVD              0x00A
+#define CMD_RDSTATA            0x010
+#define CMD_RDSTATB            0x012
+#define CMD_CLRCELL            0x711
+#define CMD_CLRSTAT            0x713
+
+/// ADCV command: 0x260 | MD[1:0] << 7 | DCP << 4 | CH[2:0]
+#define CMD_IS_ADCV(c)         (((c) & ~0x197u) == 0x260u)
+
+/// ADSTAT command: 0x468 | MD[1:0] << 7 | CHST[2:0]
+#define CMD_IS_ADSTAT(c)       (((c) & ~0x187u) == 0x468u)
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of one emulated device
+typedef struct {
+    uint8_t  cfgr[LTC6804_REG_DATA_BYTES];      ///< Configuration register group
+    float    cell_v[LTC6804_EMU_CELLS];         ///< Programmed cell voltages in volts
+    float    die_temp_c;                        ///< Programmed die temperature in degrees Celsius
+    uint16_t cell_codes[LTC6804_EMU_CELLS];     ///< Cell voltage registers
+    uint16_t cell_pending[LTC6804_EMU_CELLS];   ///< Results of running cell conversion
+    uint16_t cell_busy;                         ///< Bit mask of cells being converted
+    int64_t  cell_done_us;                      ///< End time of running cell conversion
+    uint16_t stat_codes[EMU_NUM_STAT];          ///< Status registers (SOC, ITMP, VA, VD)
+    uint16_t stat_pending[EMU_NUM_STAT];        ///< Results of running status conversion
+    uint8_t  stat_busy;                         ///< Bit mask of status values being converted
+    int64_t  stat_done_us;                      ///< End time of running status conversion
+    uint8_t  flags[3];                          ///< Cell UV/OV comparator flags (STBR2..STBR4)
+} emu_ic_t;
+
+/// Structure of one emulated bus (isoSPI port state and frame in progress)
+typedef struct {
+    emu_ic_t ics[LTC6804_EMU_MAX_ICS];          ///< Emulated devices, index is the device address
+    uint8_t  num_ics;                           ///< Number of devices on the bus (0 = bus not used)
+    uint32_t cs;                                ///< Current CS line level
+    int64_t  last_edge_us;                      ///< Time of the last CS edge (isoSPI activity)
+    int64_t  last_cmd_us;                       ///< Time of the last valid command (watchdog)
+    int64_t  port_ready_us;                     ///< Time when the isoSPI port is ready after wakeup from idle
+    bool     asleep;                            ///< Flag indicating devices are in SLEEP state
+    bool     waking;                            ///< Flag indicating wakeup from SLEEP is in progress
+    int64_t  wake_done_us;                      ///< Time when wakeup from SLEEP completes
+    uint8_t  frame[EMU_FRAME_BYTES];            ///< Bytes received in current frame
+    size_t   frame_len;                         ///< Number of bytes clocked in current frame
+    bool     frame_lost;                        ///< Flag indicating the current frame is ignored by devices
+    uint16_t cmd;                               ///< Decoded command of current frame
+    bool     cmd_valid;                         ///< Flag indicating command of current frame is decoded and valid
+    int      target;                            ///< Addressed device of current frame, or -1 for broadcast
+    uint8_t  resp[LTC6804_REG_RX_BYTES];        ///< Response of addressed device to a read command
+    bool     resp_valid;                        ///< Flag indicating current frame carries a read response
+    int64_t  xfer_done_us;                      ///< End time of the transfer in progress
+} emu_bus_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static esp_err_t emu_init(void *ctx);
+static esp_err_t emu_transfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+static esp_err_t emu_transfer_start(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+static esp_err_t emu_transfer_wait(void *ctx);
+static void emu_cs_set(void *ctx, uint32_t level);
+static void emu_delay_us(uint32_t us);
+static void frame_begin(emu_bus_t *bus, int64_t now);
+static void frame_end(emu_bus_t *bus);
+static void decode_command(emu_bus_t *bus, int64_t now);
+static void execute_read(emu_bus_t *bus, emu_ic_t *ic, uint16_t cmd, int64_t now);
+static void start_cell_conversion(emu_ic_t *ic, uint16_t cmd, int64_t now);
+static void start_stat_conversion(emu_ic_t *ic, uint16_t cmd, int64_t now);
+static void update_conversions(emu_ic_t *ic, int64_t now);
+static void reset_ic(emu_ic_t *ic);
+static uint32_t conversion_time_us(uint8_t md, bool adcopt, bool status);
+static uint16_t volts_to_code(float v, float lsb);
+static uint8_t device_byte(uint8_t value);
+static bool chance(uint32_t ppm);
+static uint32_t rand32(void);
+static float rand_gauss(void);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Conversion time of all cells in microseconds by MD (rows) and ADCOPT (columns)
+static const uint32_t s_cell_conv_us[4][2] = {
+    { 12807, 6303 },        // MD=0: 422 Hz, 1 kHz
+    {  1113, 1296 },        // MD=1: 27 kHz, 14 kHz
+    {  2335, 3033 },        // MD=2: 7 kHz, 3 kHz
+    { 201317, 4407 },       // MD=3: 26 Hz, 2 kHz
+};
+
+/// Conversion time of all status values in microseconds by MD (rows) and ADCOPT (columns)
+static const uint32_t s_stat_conv_us[4][2] = {
+    { 8537, 4203 },
+    {  742,  865 },
+    { 1555, 2021 },
+    { 134211, 2938 },
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Emulated buses
+static emu_bus_t s_buses[LTC6804_EMU_MAX_BUSES];
+/// Standard deviation of cell voltage conversion noise in volts
+static float s_noise_v = 0.0f;
+/// Fault injection settings
+static ltc6804_emu_faults_t s_faults;
+/// Emulator counters
+static ltc6804_emu_stats_t s_stats;
+/// Random generator state
+static uint32_t s_rng = 1;
+/// Transports of the emulated buses
+static const ltc6804_transport_t s_emu_transport[LTC6804_EMU_MAX_BUSES] = {
+    {
+        .init           = emu_init,
+        .transfer       = emu_transfer,
+        .transfer_start = emu_transfer_start,
+        .transfer_wait  = emu_transfer_wait,
+        .cs_set         = emu_cs_set,
+        .delay_us       = emu_delay_us,
+        .ctx            = &s_buses[0],
+    },
+    {
+        .init           = emu_init,
+        .transfer       = emu_transfer,
+        .transfer_start = emu_transfer_start,
+        .transfer_wait  = emu_transfer_wait,
+        .cs_set         = emu_cs_set,
+        .delay_us       = emu_delay_us,
+        .ctx            = &s_buses[1],
+    },
+};
+/// Spinlock protecting emulator state (setters may be called from other tasks)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function resets the emulated buses to power-on state: all devices asleep, configuration at default values,
+/// registers cleared, cells at 3.6 V, die temperature 25 °C, no noise and no fault injection.
+///
+/// \param[in] num_buses Number of independent buses (1 to ::LTC6804_EMU_MAX_BUSES)
+/// \param[in] num_ics   Number of devices on each bus (addresses 0 .. num_ics-1, 1 to ::LTC6804_EMU_MAX_ICS)
+/// \param[in] seed      Seed of the random generator used for noise and fault injection (0 is replaced by 1)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid number of buses or devices
+esp_err_t ltc6804_emu_init(uint8_t num_buses, uint8_t num_ics, uint32_t seed)
+{
+    if (num_buses == 0 || num_buses > LTC6804_EMU_MAX_BUSES || num_ics == 0 || num_ics > LTC6804_EMU_MAX_ICS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    for (uint8_t b = 0; b < LTC6804_EMU_MAX_BUSES; ++b) {
+        emu_bus_t *bus = &s_buses[b];
+        bus->num_ics = (b < num_buses) ? num_ics : 0;
+        for (uint8_t i = 0; i < LTC6804_EMU_MAX_ICS; ++i) {
+            reset_ic(&bus->ics[i]);
+            for (uint8_t c = 0; c < LTC6804_EMU_CELLS; ++c) {
+                bus->ics[i].cell_v[c] = 3.6f;
+            }
+            bus->ics[i].die_temp_c = 25.0f;
+        }
+        bus->cs = 1;
+        bus->last_edge_us = now;
+        bus->last_cmd_us = now;
+        bus->port_ready_us = now;
+        bus->asleep = true;
+        bus->waking = false;
+        bus->frame_len = 0;
+        bus->frame_lost = true;
+        bus->cmd_valid = false;
+        bus->resp_valid = false;
+        bus->xfer_done_us = now;
+    }
+    s_noise_v = 0.0f;
+    memset(&s_faults, 0, sizeof(s_faults));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_rng = seed ? seed : 1u;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+/// This function returns the transport of one emulated bus, to be used as a chain of ltc6804_set_chains().
+///
+/// \param[in] bus Bus index (0 to ::LTC6804_EMU_MAX_BUSES - 1)
+/// \return Pointer to transport operations, NULL for invalid bus index
+const ltc6804_transport_t *ltc6804_emu_transport(uint8_t bus)
+{
+    if (bus >= LTC6804_EMU_MAX_BUSES) {
+        return NULL;
+    }
+
+    return &s_emu_transport[bus];
+}
+
+/// This function programs cell voltages of one device. The values are used by following conversions.
+///
+/// \param[in] bus      Bus index
+/// \param[in] addr     Device address
+/// \param[in] voltages Array of cell voltages in volts, starting with cell 1
+/// \param[in] count    Number of cell voltages to set (1 to ::LTC6804_EMU_CELLS)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid bus, address or count
+esp_err_t ltc6804_emu_set_cell_voltages(uint8_t bus, uint8_t addr, const float *voltages, uint8_t count)
+{
+    if (bus >= LTC6804_EMU_MAX_BUSES || addr >= s_buses[bus].num_ics || !voltages || count == 0 ||
+        count > LTC6804_EMU_CELLS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(s_buses[bus].ics[addr].cell_v, voltages, count * sizeof(float));
+    taskEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+/// This function sets standard deviation of Gaussian noise added to every converted cell voltage.
+///
+/// \param[in] sigma_v Standard deviation in volts (0 disables noise)
+/// \return None
+void ltc6804_emu_set_noise(float sigma_v)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_noise_v = (sigma_v > 0.0f) ? sigma_v : 0.0f;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function programs die temperature of one device, reported by the ITMP status value.
+///
+/// \param[in] bus    Bus index
+/// \param[in] addr   Device address
+/// \param[in] temp_c Die temperature in degrees Celsius
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid bus or address
+esp_err_t ltc6804_emu_set_die_temp(uint8_t bus, uint8_t addr, float temp_c)
+{
+    if (bus >= LTC6804_EMU_MAX_BUSES || addr >= s_buses[bus].num_ics) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_buses[bus].ics[addr].die_temp_c = temp_c;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+/// This function sets fault injection probabilities.
+///
+/// \param[in] faults Pointer to fault injection settings (NULL disables fault injection)
+/// \return None
+void ltc6804_emu_set_faults(const ltc6804_emu_faults_t *faults)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (faults) {
+        s_faults = *faults;
+    } else {
+        memset(&s_faults, 0, sizeof(s_faults));
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function copies emulator counters.
+///
+/// \param[out] out Pointer to structure to receive counters
+/// \return None
+void ltc6804_emu_get_stats(ltc6804_emu_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// Transport init hook. The bus is set up by ltc6804_emu_init(), so only CS is released.
+///
+/// \param[in] ctx Emulated bus
+/// \return ESP_OK on success, ESP_ERR_INVALID_STATE if the bus was not set up by ltc6804_emu_init()
+static esp_err_t emu_init(void *ctx)
+{
+    emu_bus_t *bus = ctx;
+
+    if (bus->num_ics == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    emu_cs_set(bus, 1);
+
+    return ESP_OK;
+}
+
+/// Transport transfer hook. Clocks bytes through the current frame and takes as long as the transfer on an SPI bus
+/// clocked at ::LTC6804_SPI_FREQ_HZ. Bytes clocked with CS high are not seen by devices and MISO reads 0xFF.
+///
+/// \param[in]  ctx Emulated bus
+/// \param[in]  tx  TX buffer (NULL sends 0xFF)
+/// \param[out] rx  RX buffer (may be NULL)
+/// \param[in]  len Number of bytes to transfer
+/// \return ESP_OK
+static esp_err_t emu_transfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    emu_transfer_start(ctx, tx, rx, len);
+
+    return emu_transfer_wait(ctx);
+}
+
+/// Transport hook starting a transfer. The devices see the bytes immediately, the bus stays busy for the bus time
+/// of the transfer, which emu_transfer_wait() waits for. Bus times of different buses overlap.
+///
+/// \param[in]  ctx Emulated bus
+/// \param[in]  tx  TX buffer (NULL sends 0xFF)
+/// \param[out] rx  RX buffer (may be NULL)
+/// \param[in]  len Number of bytes to transfer
+/// \return ESP_OK
+static esp_err_t emu_transfer_start(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    emu_bus_t *bus = ctx;
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t in = tx ? tx[i] : 0xFF;
+        uint8_t out = 0xFF;
+
+        if (bus->cs == 0 && !bus->frame_lost) {
+            size_t pos = bus->frame_len;
+            if (pos < LTC6804_CMD_BYTES) {
+                bus->frame[pos] = in;
+                if (pos == LTC6804_CMD_BYTES - 1) {
+                    decode_command(bus, now);
+                }
+            } else if (bus->resp_valid && pos < EMU_FRAME_BYTES) {
+                out = device_byte(bus->resp[pos - LTC6804_CMD_BYTES]);
+            } else if (pos < EMU_FRAME_BYTES) {
+                bus->frame[pos] = in;
+            }
+        }
+        if (bus->cs == 0) {
+            bus->frame_len++;
+        }
+        if (rx) {
+            rx[i] = out;
+        }
+    }
+    // Bus time of the transfer
+    bus->xfer_done_us = now + (int64_t)((len * 8u * 1000000u) / LTC6804_SPI_FREQ_HZ);
+    taskEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+/// Transport hook waiting for the end of the transfer started by emu_transfer_start().
+///
+/// \param[in] ctx Emulated bus
+/// \return ESP_OK
+static esp_err_t emu_transfer_wait(void *ctx)
+{
+    emu_bus_t *bus = ctx;
+
+    while (esp_timer_get_time() < bus->xfer_done_us) {
+    }
+
+    return ESP_OK;
+}
+
+/// Transport CS hook. Falling edge starts a frame, rising edge ends it and executes pending register writes.
+///
+/// \param[in] ctx   Emulated bus
+/// \param[in] level CS line level (0 = low, 1 = high)
+/// \return None
+static void emu_cs_set(void *ctx, uint32_t level)
+{
+    emu_bus_t *bus = ctx;
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    if (level == 0 && bus->cs != 0) {
+        frame_begin(bus, now);
+    } else if (level != 0 && bus->cs == 0) {
+        frame_end(bus);
+    }
+    bus->cs = level ? 1u : 0u;
+    bus->last_edge_us = now;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// Transport delay hook. Busy waits on the system timer.
+///
+/// \param[in] us Delay in microseconds
+/// \return None
+static void emu_delay_us(uint32_t us)
+{
+    int64_t end = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < end) {
+    }
+
+    return;
+}
+
+/// This function handles a CS falling edge: applies watchdog timeout, SLEEP wakeup and isoSPI idle wakeup, and
+/// decides whether the starting frame reaches the devices.
+///
+/// \param[in] bus Emulated bus
+/// \param[in] now Current time in microseconds
+/// \return None
+static void frame_begin(emu_bus_t *bus, int64_t now)
+{
+    s_stats.frames++;
+    bus->frame_len = 0;
+    bus->frame_lost = false;
+    bus->cmd_valid = false;
+    bus->resp_valid = false;
+
+    // Watchdog timeout puts devices to SLEEP and resets configuration
+    if (!bus->asleep && (now - bus->last_cmd_us) > EMU_T_SLEEP_US) {
+        bus->asleep = true;
+        bus->waking = false;
+        s_stats.sleeps++;
+        for (uint8_t i = 0; i < bus->num_ics; ++i) {
+            reset_ic(&bus->ics[i]);
+        }
+    }
+
+    if (bus->asleep) {
+        // CS falling edge starts wakeup, devices accept commands only after wakeup time
+        if (!bus->waking) {
+            bus->waking = true;
+            bus->wake_done_us = now + EMU_T_WAKE_US;
+        }
+        if (now < bus->wake_done_us) {
+            bus->frame_lost = true;
+            return;
+        }
+        bus->asleep = false;
+        bus->waking = false;
+        bus->last_cmd_us = now;
+        bus->port_ready_us = now;
+    } else if ((now - bus->last_edge_us) > EMU_T_IDLE_US) {
+        // Idle port is only woken up by the edge
+        bus->port_ready_us = now + EMU_T_READY_US;
+        bus->frame_lost = true;
+        return;
+    }
+
+    if (now < bus->port_ready_us) {
+        bus->frame_lost = true;
+    }
+
+    return;
+}
+
+/// This function handles a CS rising edge. Executes WRCFG when the complete payload with valid PEC was received
+/// and counts lost frames which carried data.
+///
+/// \param[in] bus Emulated bus
+/// \return None
+static void frame_end(emu_bus_t *bus)
+{
+    if (bus->frame_lost) {
+        if (bus->frame_len > 0) {
+            if (bus->asleep) {
+                s_stats.lost_sleep++;
+            } else {
+                s_stats.lost_idle++;
+            }
+        }
+        return;
+    }
+
+    if (bus->cmd_valid && bus->cmd == CMD_WRCFG && bus->frame_len >= EMU_FRAME_BYTES) {
+        const uint8_t *data = &bus->frame[LTC6804_CMD_BYTES];
+        uint16_t pec = ((uint16_t)data[6] << 8) | data[7];
+        if (pec != ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, data)) {
+            s_stats.data_pec_errors++;
+            return;
+        }
+        for (uint8_t i = 0; i < bus->num_ics; ++i) {
+            if (bus->target < 0 || bus->target == i) {
+                memcpy(bus->ics[i].cfgr, data, LTC6804_REG_DATA_BYTES);
+            }
+        }
+    }
+
+    return;
+}
+
+/// This function decodes the 4 command bytes of the current frame, checks command PEC and executes the command.
+/// Register reads prepare the response of the addressed device, WRCFG is executed at the end of the frame.
+///
+/// \param[in] bus Emulated bus
+/// \param[in] now Current time in microseconds
+/// \return None
+static void decode_command(emu_bus_t *bus, int64_t now)
+{
+    uint16_t pec = ((uint16_t)bus->frame[2] << 8) | bus->frame[3];
+    if (pec != ltc6804_pec15_calc(2, bus->frame)) {
+        s_stats.cmd_pec_errors++;
+        bus->frame_lost = true;
+        return;
+    }
+    if (chance(s_faults.cmd_drop_ppm)) {
+        s_stats.dropped_cmds++;
+        bus->frame_lost = true;
+        return;
+    }
+
+    // Valid command resets watchdog of all devices
+    bus->last_cmd_us = now;
+    bus->cmd = (uint16_t)(((bus->frame[0] & 0x07u) << 8) | bus->frame[1]);
+    bus->target = (bus->frame[0] & 0x80u) ? (int)((bus->frame[0] >> 3) & 0x0Fu) : -1;
+    if (bus->target >= (int)bus->num_ics) {
+        // No device with this address
+        bus->frame_lost = true;
+        return;
+    }
+    bus->cmd_valid = true;
+    s_stats.commands++;
+
+    bool is_read = (bus->cmd == CMD_RDCFG) || (bus->cmd >= CMD_RDCVA && bus->cmd <= CMD_RDCVD && !(bus->cmd & 1u)) ||
+                   (bus->cmd == CMD_RDSTATA) || (bus->cmd == CMD_RDSTATB);
+    if (is_read) {
+        // Broadcast reads are not supported by LTC6804-2 (all devices would drive the bus)
+        if (bus->target < 0) {
+            s_stats.unsupported++;
+            return;
+        }
+        execute_read(bus, &bus->ics[bus->target], bus->cmd, now);
+        return;
+    }
+
+    // WRCFG is executed at the end of frame
+    if (bus->cmd == CMD_WRCFG) {
+        return;
+    }
+    if (!CMD_IS_ADCV(bus->cmd) && !CMD_IS_ADSTAT(bus->cmd) && bus->cmd != CMD_CLRCELL && bus->cmd != CMD_CLRSTAT) {
+        s_stats.unsupported++;
+        return;
+    }
+
+    for (uint8_t i = 0; i < bus->num_ics; ++i) {
+        if (bus->target >= 0 && bus->target != i) {
+            continue;
+        }
+        emu_ic_t *ic = &bus->ics[i];
+        if (CMD_IS_ADCV(bus->cmd)) {
+            start_cell_conversion(ic, bus->cmd, now);
+        } else if (CMD_IS_ADSTAT(bus->cmd)) {
+            start_stat_conversion(ic, bus->cmd, now);
+        } else if (bus->cmd == CMD_CLRCELL) {
+            update_conversions(ic, now);
+            for (uint8_t c = 0; c < LTC6804_EMU_CELLS; ++c) {
+                ic->cell_codes[c] = EMU_CLEARED;
+            }
+        } else if (bus->cmd == CMD_CLRSTAT) {
+            update_conversions(ic, now);
+            for (uint8_t s = 0; s < EMU_NUM_STAT; ++s) {
+                ic->stat_codes[s] = EMU_CLEARED;
+            }
+            memset(ic->flags, 0, sizeof(ic->flags));
+        }
+    }
+
+    return;
+}
+
+/// This function prepares the 6 data bytes and PEC of a register read response, with optional injected PEC error.
+///
+/// \param[in] bus Emulated bus
+/// \param[in] ic  Addressed device
+/// \param[in] cmd Read command code
+/// \param[in] now Current time in microseconds
+/// \return None
+static void execute_read(emu_bus_t *bus, emu_ic_t *ic, uint16_t cmd, int64_t now)
+{
+    uint16_t words[3];
+
+    update_conversions(ic, now);
+
+    if (cmd == CMD_RDCFG) {
+        memcpy(bus->resp, ic->cfgr, LTC6804_REG_DATA_BYTES);
+    } else if (cmd == CMD_RDSTATB) {
+        bus->resp[0] = (uint8_t)(ic->stat_codes[3]);
+        bus->resp[1] = (uint8_t)(ic->stat_codes[3] >> 8);
+        memcpy(&bus->resp[2], ic->flags, sizeof(ic->flags));
+        bus->resp[5] = 0x00;                           // REV=0, MUXFAIL=0, THSD=0
+        if (ic->stat_busy) {
+            s_stats.busy_reads++;
+        }
+    } else {
+        if (cmd == CMD_RDSTATA) {
+            memcpy(words, ic->stat_codes, sizeof(words));
+            if (ic->stat_busy) {
+                s_stats.busy_reads++;
+            }
+        } else {
+            uint8_t first = (uint8_t)(((cmd - CMD_RDCVA) / 2u) * LTC6804_CELLS_PER_REG);
+            memcpy(words, &ic->cell_codes[first], sizeof(words));
+            if (ic->cell_busy & (0x7u << first)) {
+                s_stats.busy_reads++;
+            }
+        }
+        for (uint8_t w = 0; w < 3; ++w) {
+            bus->resp[2 * w]     = (uint8_t)(words[w]);
+            bus->resp[2 * w + 1] = (uint8_t)(words[w] >> 8);
+        }
+    }
+
+    uint16_t pec = ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, bus->resp);
+    bus->resp[6] = (uint8_t)(pec >> 8);
+    bus->resp[7] = (uint8_t)(pec);
+    if (chance(s_faults.pec_error_ppm)) {
+        bus->resp[7] ^= 0x01u;
+        s_stats.injected_pec++;
+    }
+    bus->resp_valid = true;
+
+    return;
+}
+
+/// This function starts a cell voltage conversion (ADCV). Results include programmed voltages and noise, the
+/// converted channels read as cleared until the conversion time of the selected mode elapses.
+///
+/// \param[in] ic  Device
+/// \param[in] cmd ADCV command code (MD in bits 8:7, CH in bits 2:0)
+/// \param[in] now Current time in microseconds
+/// \return None
+static void start_cell_conversion(emu_ic_t *ic, uint16_t cmd, int64_t now)
+{
+    uint8_t md = (uint8_t)((cmd >> 7) & 0x03u);
+    uint8_t ch = (uint8_t)(cmd & 0x07u);
+    uint16_t mask = (ch == 0 || ch > 6) ? 0x0FFFu : (uint16_t)((1u << (ch - 1)) | (1u << (ch + 5)));
+    uint32_t t_us = conversion_time_us(md, ic->cfgr[0] & 0x01u, false);
+
+    update_conversions(ic, now);
+    for (uint8_t c = 0; c < LTC6804_EMU_CELLS; ++c) {
+        if (mask & (1u << c)) {
+            float v = ic->cell_v[c] + ((s_noise_v > 0.0f) ? s_noise_v * rand_gauss() : 0.0f);
+            ic->cell_pending[c] = volts_to_code(v, 0.0001f);
+            ic->cell_codes[c] = EMU_CLEARED;
+        }
+    }
+    // Single channel pair takes about one sixth of all channels
+    ic->cell_busy = mask;
+    ic->cell_done_us = now + ((mask == 0x0FFFu) ? t_us : t_us / 6u);
+    s_stats.conversions++;
+
+    return;
+}
+
+/// This function starts a status conversion (ADSTAT) of sum of cells, die temperature and supply voltages.
+///
+/// \param[in] ic  Device
+/// \param[in] cmd ADSTAT command code (MD in bits 8:7, CHST in bits 2:0)
+/// \param[in] now Current time in microseconds
+/// \return None
+static void start_stat_conversion(emu_ic_t *ic, uint16_t cmd, int64_t now)
+{
+    uint8_t md = (uint8_t)((cmd >> 7) & 0x03u);
+    uint8_t chst = (uint8_t)(cmd & 0x07u);
+    uint8_t mask = (chst == 0 || chst > EMU_NUM_STAT) ? 0x0Fu : (uint8_t)(1u << (chst - 1));
+    uint32_t t_us = conversion_time_us(md, ic->cfgr[0] & 0x01u, true);
+
+    update_conversions(ic, now);
+
+    float sum_v = 0.0f;
+    for (uint8_t c = 0; c < LTC6804_EMU_CELLS; ++c) {
+        sum_v += ic->cell_v[c];
+    }
+    // SOC LSB is 20 * 100 uV, ITMP is 7.5 mV/K over 100 uV LSB
+    ic->stat_pending[0] = volts_to_code(sum_v, 0.002f);
+    ic->stat_pending[1] = volts_to_code((ic->die_temp_c + 273.0f) * 0.0075f, 0.0001f);
+    ic->stat_pending[2] = volts_to_code(EMU_VA_V, 0.0001f);
+    ic->stat_pending[3] = volts_to_code(EMU_VD_V, 0.0001f);
+    for (uint8_t s = 0; s < EMU_NUM_STAT; ++s) {
+        if (mask & (1u << s)) {
+            ic->stat_codes[s] = EMU_CLEARED;
+        }
+    }
+    ic->stat_busy = mask;
+    ic->stat_done_us = now + ((mask == 0x0Fu) ? t_us : t_us / 4u);
+    s_stats.conversions++;
+
+    return;
+}
+
+/// This function completes conversions whose conversion time elapsed. Completed cell conversions update the cell
+/// UV/OV comparator flags against VUV/VOV of the configuration register.
+///
+/// \param[in] ic  Device
+/// \param[in] now Current time in microseconds
+/// \return None
+static void update_conversions(emu_ic_t *ic, int64_t now)
+{
+    if (ic->cell_busy && now >= ic->cell_done_us) {
+        uint16_t vuv = (uint16_t)(ic->cfgr[1] | ((ic->cfgr[2] & 0x0Fu) << 8));
+        uint16_t vov = (uint16_t)((ic->cfgr[2] >> 4) | (ic->cfgr[3] << 4));
+        for (uint8_t c = 0; c < LTC6804_EMU_CELLS; ++c) {
+            if (!(ic->cell_busy & (1u << c))) {
+                continue;
+            }
+            uint16_t code = ic->cell_pending[c];
+            uint8_t bits = 0;
+            if (code < (uint32_t)(vuv + 1u) * 16u) {
+                bits |= 0x01u;
+            }
+            if (code > (uint32_t)vov * 16u) {
+                bits |= 0x02u;
+            }
+            uint8_t shift = (uint8_t)((c % 4u) * 2u);
+            ic->flags[c / 4u] = (uint8_t)((ic->flags[c / 4u] & ~(0x03u << shift)) | (bits << shift));
+            ic->cell_codes[c] = code;
+        }
+        ic->cell_busy = 0;
+    }
+
+    if (ic->stat_busy && now >= ic->stat_done_us) {
+        for (uint8_t s = 0; s < EMU_NUM_STAT; ++s) {
+            if (ic->stat_busy & (1u << s)) {
+                ic->stat_codes[s] = ic->stat_pending[s];
+            }
+        }
+        ic->stat_busy = 0;
+    }
+
+    return;
+}
+
+/// This function puts one device to power-on state: default configuration, cleared registers, no conversion.
+/// Programmed voltages and die temperature are kept.
+///
+/// \param[in] ic Device
+/// \return None
+static void reset_ic(emu_ic_t *ic)
+{
+    memset(ic->cfgr, 0, sizeof(ic->cfgr));
+    ic->cfgr[0] = EMU_CFGR0_DEFAULT;
+    for (uint8_t c = 0; c < LTC6804_EMU_CELLS; ++c) {
+        ic->cell_codes[c] = EMU_CLEARED;
+    }
+    for (uint8_t s = 0; s < EMU_NUM_STAT; ++s) {
+        ic->stat_codes[s] = EMU_CLEARED;
+    }
+    memset(ic->flags, 0, sizeof(ic->flags));
+    ic->cell_busy = 0;
+    ic->stat_busy = 0;
+
+    return;
+}
+
+/// This function returns conversion time of all channels for the given mode.
+///
+/// \param[in] md     ADC mode bits of the command
+/// \param[in] adcopt ADCOPT bit of the configuration register
+/// \param[in] status True for status conversion, false for cell conversion
+/// \return Conversion time in microseconds
+static uint32_t conversion_time_us(uint8_t md, bool adcopt, bool status)
+{
+    return status ? s_stat_conv_us[md & 0x03u][adcopt ? 1 : 0] : s_cell_conv_us[md & 0x03u][adcopt ? 1 : 0];
+}
+
+/// This function converts voltage to a 16-bit ADC code saturated to the valid code range.
+///
+/// \param[in] v   Voltage in volts
+/// \param[in] lsb Code LSB in volts
+/// \return ADC code
+static uint16_t volts_to_code(float v, float lsb)
+{
+    float code = v / lsb + 0.5f;
+    if (code <= 0.0f) {
+        return 0;
+    }
+    if (code >= (float)(EMU_CLEARED - 1u)) {
+        return EMU_CLEARED - 1u;
+    }
+
+    return (uint16_t)code;
+}
+
+/// This function applies bit error injection to one byte sent by a device.
+///
+/// \param[in] value Byte value
+/// \return Byte value seen by the host
+static uint8_t device_byte(uint8_t value)
+{
+    if (chance(s_faults.bit_error_ppm)) {
+        value ^= (uint8_t)(1u << (rand32() & 0x07u));
+        s_stats.injected_bits++;
+    }
+
+    return value;
+}
+
+/// This function draws an event with the given probability.
+///
+/// \param[in] ppm Probability in parts per million
+/// \return True if the event happens
+static bool chance(uint32_t ppm)
+{
+    return ppm && ((rand32() % 1000000u) < ppm);
+}
+
+/// This function returns next value of the xorshift32 random generator.
+///
+/// \param None
+/// \return Random 32-bit value
+static uint32_t rand32(void)
+{
+    uint32_t x = s_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_rng = x;
+
+    return x;
+}
+
+/// This function returns a standard normal random value (Box-Muller transform).
+///
+/// \param None
+/// \return Random value with zero mean and unit variance
+static float rand_gauss(void)
+{
+    float u1 = ((float)(rand32() >> 8) + 1.0f) / 16777217.0f;
+    float u2 = (float)(rand32() >> 8) / 16777216.0f;
+
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
@@ -0,0 +1,73 @@
+/// Header file for `ltc6804_emu.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "esp_err.h"
+#include "ltc6804_transport.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Maximum number of emulated LTC6804-2 devices on one bus (4 address bits)
+#define LTC6804_EMU_MAX_ICS     16
+
+/// Maximum number of independent emulated buses (one per chain of the driver)
+#define LTC6804_EMU_MAX_BUSES   2
+
+/// Number of cell channels of one emulated device
+#define LTC6804_EMU_CELLS       12
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of fault injection settings. Probabilities are given in parts per million.
+typedef struct {
+    uint32_t pec_error_ppm;     ///< Probability that a read response is sent with corrupted PEC
+    uint32_t bit_error_ppm;     ///< Probability of a single bit flip in each byte sent by the device
+    uint32_t cmd_drop_ppm;      ///< Probability that a correct command is lost on the isoSPI link
+} ltc6804_emu_faults_t;
+
+/// Structure of emulator counters
+typedef struct {
+    uint32_t frames;            ///< Number of CS low frames
+    uint32_t commands;          ///< Number of executed commands
+    uint32_t cmd_pec_errors;    ///< Number of commands ignored due to command PEC mismatch
+    uint32_t data_pec_errors;   ///< Number of WRCFG writes ignored due to data PEC mismatch
+    uint32_t unsupported;       ///< Number of valid commands not modeled by the emulator
+    uint32_t lost_idle;         ///< Number of frames lost because the isoSPI port was idle
+    uint32_t lost_sleep;        ///< Number of frames lost because the device was asleep or waking up
+    uint32_t sleeps;            ///< Number of watchdog timeouts (transitions to SLEEP state)
+    uint32_t conversions;       ///< Number of started cell and status conversions
+    uint32_t busy_reads;        ///< Number of register reads during a conversion
+    uint32_t injected_pec;      ///< Number of injected PEC errors
+    uint32_t injected_bits;     ///< Number of injected bit flips
+    uint32_t dropped_cmds;      ///< Number of injected command losses
+} ltc6804_emu_stats_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+esp_err_t ltc6804_emu_init(uint8_t num_buses, uint8_t num_ics, uint32_t seed);
+const ltc6804_transport_t *ltc6804_emu_transport(uint8_t bus);
+esp_err_t ltc6804_emu_set_cell_voltages(uint8_t bus, uint8_t addr, const float *voltages, uint8_t count);
+void ltc6804_emu_set_noise(float sigma_v);
+esp_err_t ltc6804_emu_set_die_temp(uint8_t bus, uint8_t addr, float temp_c);
+void ltc6804_emu_set_faults(const ltc6804_emu_faults_t *faults);
+void ltc6804_emu_get_stats(ltc6804_emu_stats_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
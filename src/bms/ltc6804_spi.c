@@ -0,0 +1,296 @@
+/// ESP32 transport of the LTC6804 driver. Each chain of LTC6804 devices is connected to its own ESP-IDF SPI master
+/// host with the CS line controlled manually by GPIO, because the isoSPI wakeup requires CS pulses without SPI
+/// clocks. Hosts and pins of the chains are taken from Kconfig (BMS_LTC_CHAINx_*). Transfers are started with the
+/// polling API, so transfers of chains on different hosts overlap on the buses.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "ltc6804_transport.h"
+#include "ltc6804.h"
+#include "logging.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "rom/ets_sys.h"
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag
+#define LOG_MODULE_TAG "LTC6804_SPI"
+
+/// SPI host and pins of chain 0. GPIO 23/19/18/5 are native VSPI pins on ESP32.
+#ifndef CONFIG_BMS_LTC_CHAIN0_HOST
+#define CONFIG_BMS_LTC_CHAIN0_HOST   3
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN0_MOSI
+#define CONFIG_BMS_LTC_CHAIN0_MOSI   23
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN0_MISO
+#define CONFIG_BMS_LTC_CHAIN0_MISO   19
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN0_SCLK
+#define CONFIG_BMS_LTC_CHAIN0_SCLK   18
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN0_CS
+#define CONFIG_BMS_LTC_CHAIN0_CS     5
+#endif
+
+/// SPI host and pins of chain 1. GPIO 13/12/14/15 are native HSPI pins on ESP32.
+#ifndef CONFIG_BMS_LTC_CHAIN1_HOST
+#define CONFIG_BMS_LTC_CHAIN1_HOST   2
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN1_MOSI
+#define CONFIG_BMS_LTC_CHAIN1_MOSI   13
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN1_MISO
+#define CONFIG_BMS_LTC_CHAIN1_MISO   12
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN1_SCLK
+#define CONFIG_BMS_LTC_CHAIN1_SCLK   14
+#endif
+#ifndef CONFIG_BMS_LTC_CHAIN1_CS
+#define CONFIG_BMS_LTC_CHAIN1_CS     15
+#endif
+
+// Every chain needs its own SPI host; two chains on one host would fail spi_bus_initialize() at boot
+#if CONFIG_BMS_LTC_CHAINS > 1 && CONFIG_BMS_LTC_CHAIN0_HOST == CONFIG_BMS_LTC_CHAIN1_HOST
+#error "CONFIG_BMS_LTC_CHAIN0_HOST and CONFIG_BMS_LTC_CHAIN1_HOST must differ with two LTC6804 chains"
+#endif
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of one SPI chain: bus configuration and driver state
+typedef struct {
+    uint8_t             host;           ///< SPI host number (2 = SPI2/HSPI, 3 = SPI3/VSPI)
+    int                 mosi;           ///< MOSI pin
+    int                 miso;           ///< MISO pin
+    int                 sclk;           ///< SCLK pin
+    int                 cs;             ///< CS pin, any GPIO (controlled manually by spi_cs_set())
+    spi_device_handle_t dev;            ///< SPI device handle, NULL until initialized
+    spi_transaction_t   txn;            ///< Transaction started by spi_transfer_start()
+} spi_chain_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static esp_err_t spi_init(void *ctx);
+static esp_err_t spi_transfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+static esp_err_t spi_transfer_start(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+static esp_err_t spi_transfer_wait(void *ctx);
+static void spi_cs_set(void *ctx, uint32_t level);
+static void spi_delay_us(uint32_t us);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// SPI chains configured by Kconfig
+static spi_chain_t s_chains[LTC6804_MAX_CHAINS] = {
+    {
+        .host = CONFIG_BMS_LTC_CHAIN0_HOST,
+        .mosi = CONFIG_BMS_LTC_CHAIN0_MOSI,
+        .miso = CONFIG_BMS_LTC_CHAIN0_MISO,
+        .sclk = CONFIG_BMS_LTC_CHAIN0_SCLK,
+        .cs   = CONFIG_BMS_LTC_CHAIN0_CS,
+    },
+    {
+        .host = CONFIG_BMS_LTC_CHAIN1_HOST,
+        .mosi = CONFIG_BMS_LTC_CHAIN1_MOSI,
+        .miso = CONFIG_BMS_LTC_CHAIN1_MISO,
+        .sclk = CONFIG_BMS_LTC_CHAIN1_SCLK,
+        .cs   = CONFIG_BMS_LTC_CHAIN1_CS,
+    },
+};
+
+/// ESP32 SPI master transports of the chains
+static const ltc6804_transport_t s_spi_transport[LTC6804_MAX_CHAINS] = {
+    {
+        .init           = spi_init,
+        .transfer       = spi_transfer,
+        .transfer_start = spi_transfer_start,
+        .transfer_wait  = spi_transfer_wait,
+        .cs_set         = spi_cs_set,
+        .delay_us       = spi_delay_us,
+        .ctx            = &s_chains[0],
+    },
+    {
+        .init           = spi_init,
+        .transfer       = spi_transfer,
+        .transfer_start = spi_transfer_start,
+        .transfer_wait  = spi_transfer_wait,
+        .cs_set         = spi_cs_set,
+        .delay_us       = spi_delay_us,
+        .ctx            = &s_chains[1],
+    },
+};
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function returns the ESP32 SPI master transport of one LTC6804 chain.
+///
+/// \param[in] chain Chain index (0 to ::LTC6804_MAX_CHAINS - 1)
+/// \return Pointer to transport operations, NULL for invalid chain index
+const ltc6804_transport_t *ltc6804_spi_transport(uint8_t chain)
+{
+    if (chain >= LTC6804_MAX_CHAINS) {
+        return NULL;
+    }
+
+    return &s_spi_transport[chain];
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function configures the CS pin of the chain for manual GPIO control, initializes the ESP-IDF SPI master
+/// bus and adds the LTC6804 chain as an SPI device. Repeated calls keep the already added device.
+///
+/// \param[in] ctx SPI chain
+/// \return ESP_OK on success, otherwise an error code from GPIO/SPI driver
+static esp_err_t spi_init(void *ctx)
+{
+    spi_chain_t *chain = ctx;
+
+    if (chain->dev) {
+        return ESP_OK;
+    }
+
+    // Configure CS pin as GPIO output
+    gpio_config_t cs_cfg = {
+        .pin_bit_mask  = (1ULL << chain->cs),
+        .mode          = GPIO_MODE_OUTPUT,
+        .pull_up_en    = GPIO_PULLUP_ENABLE,
+        .pull_down_en  = GPIO_PULLDOWN_DISABLE,
+        .intr_type     = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&cs_cfg);
+    // Set CS to high - idle
+    spi_cs_set(chain, 1);
+
+    // Configure SPI bus
+    spi_bus_config_t bus_cfg = {
+        .mosi_io_num   = chain->mosi,
+        .miso_io_num   = chain->miso,
+        .sclk_io_num   = chain->sclk,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = 64,
+    };
+
+    spi_host_device_t host = (chain->host == 2) ? SPI2_HOST : SPI3_HOST;
+    esp_err_t ret = spi_bus_initialize(host, &bus_cfg, SPI_DMA_DISABLED);
+    if (ret != ESP_OK) {
+        BMS_LOGE("SPI%u bus init failed: %s", (unsigned)chain->host, esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Add LTC6804 chain as SPI device — CS managed manually via GPIO
+    spi_device_interface_config_t dev_cfg = {
+        .mode           = 3,               // SPI Mode 3 (CPOL=1, CPHA=1) per LTC6804 datasheet
+        .clock_speed_hz = LTC6804_SPI_FREQ_HZ,
+        .spics_io_num   = -1,              // Manual CS control via GPIO (spi_cs_set())
+        .queue_size     = 1,
+        .flags          = 0,
+    };
+
+    ret = spi_bus_add_device(host, &dev_cfg, &chain->dev);
+    if (ret != ESP_OK) {
+        BMS_LOGE("SPI%u add device failed: %s", (unsigned)chain->host, esp_err_to_name(ret));
+        return ret;
+    }
+
+    BMS_LOGI("SPI%u pins: MOSI=%d, MISO=%d, SCLK=%d, CS=%d",
+             (unsigned)chain->host, chain->mosi, chain->miso, chain->sclk, chain->cs);
+    BMS_LOGI("CS pin level: %d", gpio_get_level(chain->cs));
+
+    return ESP_OK;
+}
+
+/// This function performs an SPI transfer (simultaneous TX and RX).
+/// CS is NOT managed here — caller must assert/deassert CS via spi_cs_set().
+///
+/// \param[in] ctx  SPI chain
+/// \param[in] tx   TX buffer (may be NULL to send zeros and discard output — effectively RX-only)
+/// \param[in] rx   RX buffer (may be NULL to discard received bytes — effectively TX-only)
+/// \param[in] len  Number of bytes to transfer
+/// \return ESP_OK on success, or an error code propagated from spi_device_transmit()
+static esp_err_t spi_transfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    spi_chain_t *chain = ctx;
+    spi_transaction_t txn = {
+        .length    = len * 8,
+        .tx_buffer = tx,
+        .rx_buffer = rx,
+        .rxlength  = rx ? (len * 8) : 0,
+    };
+    return spi_device_transmit(chain->dev, &txn);
+}
+
+/// This function starts an SPI transfer with the polling API and returns while the host clocks the data, so
+/// transfers on the other SPI host can be started meanwhile. CS is NOT managed here.
+///
+/// \param[in] ctx  SPI chain
+/// \param[in] tx   TX buffer (may be NULL to send zeros)
+/// \param[in] rx   RX buffer (may be NULL to discard received bytes)
+/// \param[in] len  Number of bytes to transfer
+/// \return ESP_OK on success, or an error code propagated from spi_device_polling_start()
+static esp_err_t spi_transfer_start(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    spi_chain_t *chain = ctx;
+    chain->txn = (spi_transaction_t){
+        .length    = len * 8,
+        .tx_buffer = tx,
+        .rx_buffer = rx,
+        .rxlength  = rx ? (len * 8) : 0,
+    };
+    return spi_device_polling_start(chain->dev, &chain->txn, portMAX_DELAY);
+}
+
+/// This function waits for the end of the transfer started by spi_transfer_start().
+///
+/// \param[in] ctx SPI chain
+/// \return ESP_OK on success, or an error code propagated from spi_device_polling_end()
+static esp_err_t spi_transfer_wait(void *ctx)
+{
+    spi_chain_t *chain = ctx;
+
+    return spi_device_polling_end(chain->dev, portMAX_DELAY);
+}
+
+/// This function drives the CS line of the chain. Pulling CS low wakes up the isoSPI interface from idle state,
+/// releasing it high returns the interface to idle state.
+///
+/// \param[in] ctx   SPI chain
+/// \param[in] level CS line level (0 = low, 1 = high)
+/// \return None
+static void spi_cs_set(void *ctx, uint32_t level)
+{
+    spi_chain_t *chain = ctx;
+
+    gpio_set_level(chain->cs, level);
+
+    return;
+}
+
+/// This function busy waits given number of microseconds.
+///
+/// \param[in] us Delay in microseconds
+/// \return None
+static void spi_delay_us(uint32_t us)
+{
+    ets_delay_us(us);
+
+    return;
+}
@@ -0,0 +1,58 @@
+/// Header file of the LTC6804 transport interface. The driver in `ltc6804.c` accesses the devices only through
+/// transports: SPI transfer, CS line control and microsecond delays. Each chain (SPI bus with its own CS line) has
+/// its own transport instance. `ltc6804_spi.c` implements the transport with the ESP32 SPI master and GPIO
+/// drivers, `ltc6804_emu.c` with a software model of LTC6804-2 buses.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of LTC6804 transport operations. Operations get the instance context ::ltc6804_transport_t::ctx.
+typedef struct {
+    /// Prepares the transport (bus and CS line setup). CS is left high.
+    esp_err_t (*init)(void *ctx);
+    /// Full-duplex transfer of len bytes. tx may be NULL (sends 0xFF), rx may be NULL (received data discarded).
+    /// CS is not managed by the transfer.
+    esp_err_t (*transfer)(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+    /// Starts a transfer like transfer() and returns without waiting for its end. Buffers must stay valid until
+    /// transfer_wait() returns. Transfers started on different instances run concurrently. May be NULL, the
+    /// driver then uses transfer().
+    esp_err_t (*transfer_start)(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+    /// Waits for the end of the transfer started by transfer_start()
+    esp_err_t (*transfer_wait)(void *ctx);
+    /// Sets CS line level (0 = low/asserted, 1 = high)
+    void (*cs_set)(void *ctx, uint32_t level);
+    /// Busy waits given number of microseconds
+    void (*delay_us)(uint32_t us);
+    /// Instance context (bus) passed to the operations
+    void *ctx;
+} ltc6804_transport_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+const ltc6804_transport_t *ltc6804_spi_transport(uint8_t chain);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -0,0 +1,120 @@
+/// This module converts ADC readings of a PT1000 sensor in a voltage divider to temperature. It has no hardware
+/// dependencies, ADC reading is done by the caller.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "pt1000.h"
+#include "adc.h"
+#include "logging.h"
+#include <math.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "PT1000"
+/// PT1000 reference resistance at 0 deg C (Ohms)
+#define PT1000_R0      1000.0f
+/// Callendar-Van Dusen coefficient A (IEC 60751)
+#define PT1000_A       3.9083e-3f
+/// Callendar-Van Dusen coefficient B (IEC 60751)
+#define PT1000_B      -5.775e-7f
+/// Callendar-Van Dusen coefficient C (IEC 60751, used below 0 deg C only)
+#define PT1000_C      -4.183e-12f
+/// Assumed voltage reference for PT1000 divider calculations (V)
+#define PT1000_V_REF   3.3f
+/// Reference resistor in voltage divider circuit (Ohms)
+#define PT1000_R_REF   1000.0f
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function converts a raw ADC value of the PT1000 voltage divider output to temperature in degrees Celsius.
+/// Uses the Callendar-Van Dusen equation (IEC 60751) to convert resistance to temperature.
+///
+/// \param[in] raw_value Raw ADC value (0 to ::ADC_RANGE)
+/// \return Temperature in degrees Celsius, or 0 if the value is out of range
+float pt1000_raw_to_celsius(int raw_value)
+{
+    // Convert raw ADC value to voltage
+    float voltage = (float)raw_value * PT1000_V_REF / (float)ADC_RANGE;
+
+    // Calculate PT1000 resistance from voltage divider: R_pt1000 = R_ref * V / (V_ref - V)
+    float denom = PT1000_V_REF - voltage; // (V_ref - V)
+    if (denom <= 0.0f) {
+        BMS_LOGE("PT1000 voltage divider error: voltage too high");
+        return 0;
+    }
+    float resistance = PT1000_R_REF * voltage / denom;
+
+    // Convert resistance to temperature using Callendar-Van Dusen equation (IEC 60751)
+    // For T >= 0: R(T) = R0*(1 + A*T + B*T^2)                 - solve quadratic
+    // For T <  0: R(T) = R0*(1 + A*T + B*T^2 + C*(T-100)*T^3) - Newton-Raphson
+    float ratio = resistance / PT1000_R0;
+    float discriminant = PT1000_A * PT1000_A - 4.0f * PT1000_B * (1.0f - ratio);
+    if (discriminant < 0.0f) {
+        BMS_LOGE("PT1000 conversion error: resistance out of range");
+        return 0;
+    }
+    // Only positive root is valid. Check by assuming ratio as 0 (0 deg C). Calculation will be simplified to T1 = (A-A) / (2*B)
+    // and T2 = (-A-A) / (2*B). Since B is negative, T1 will be 0 deg C and T2 will be outside of PT1000 range.
+    float temperature = (-PT1000_A + sqrtf(discriminant)) / (2.0f * PT1000_B);
+
+    // If quadratic yields T < 0, refine with full equation including C coefficient
+    // using Newton-Raphson to calculate formula: f(T) = R0*(1 + A*T + B*T^2 + C*(T-100)*T^3)
+    if (temperature < 0.0f) {
+        float t = temperature; // initial guess from quadratic
+        // Perform Newton-Raphson iterations according to formula x_{n+1} = x_n - f(x_n) / f'(x_n). Max number of iterations is 5.
+        for (int iter = 0; iter < 5; ++iter) {
+            float t2 = t * t;
+            float t3 = t2 * t;
+            // f(T) = R0*(1 + A*T + B*T^2 + C*(T-100)*T^3)
+            float f  = PT1000_R0 * (1.0f + PT1000_A * t + PT1000_B * t2
+                       + PT1000_C * (t - 100.0f) * t3) - resistance;
+            // f'(T) = R0*(A + 2*B*T + C*(4*T^3 - 300*T^2))
+            float df = PT1000_R0 * (PT1000_A + 2.0f * PT1000_B * t
+                       + PT1000_C * (4.0f * t3 - 300.0f * t2));
+            // Accuracy threshold for Newton-Raphson. For thermal degree of freedom is standard engineering value 1e-6.
+            // Prevents to division by zero and limits iterations when close enough to solution.
+            if (fabsf(df) < 1e-6f) {
+                break;
+            }
+            // f(x_n) / f'(x_n)
+            float dt = f / df;
+            // x_n - f(x_n) / f'(x_n)
+            t -= dt;
+            // Stop iterations if change of temperature is below 0.01 deg C.
+            if (fabsf(dt) < 0.01f) {
+                break;
+            }
+        }
+        temperature = t;
+    }
+
+    return temperature;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
@@ -0,0 +1,327 @@
+/// This module samples pack current at CONFIG_BMS_RIPPLE_RATE_HZ, well above the 20 Hz cell voltage cycle, and
+/// tracks ripple amplitude at up to four configured frequencies (inverter and charger ripple) with a Goertzel filter
+/// bank over 1 s blocks. Window averages of pack current hide such ripple completely.
+///
+/// Sampling runs in a dedicated task on Core 0, woken by the alarm interrupt of a general purpose hardware timer, so
+/// neither the Fast Core cell voltage cycle on Core 1 nor the esp_timer task (shared by every esp_timer user) runs
+/// at the sample rate. A sample costs one ADC conversion and O(frequencies) filter updates; the amplitude
+/// computation at the end of a block is O(frequencies) too. The conversion is never retried: if the ADC is busy with
+/// the temperature reading of the Fast Core or fails, the previous sample is repeated and counted as missed. Alarms
+/// the task could not serve in time are filled the same way, which keeps the sample timing of the filters.
+///
+/// The Fast Core takes the mean of all current samples since its previous cycle as pack current of its sample,
+/// which replaces the single conversion per cycle and removes ripple aliasing from pack_i. Blocks run free of the
+/// statistics windows: readers on other tasks copy the amplitudes of the latest completed block under a spinlock,
+/// so consecutive windows (and all 0.2 s windows within a second) carry the same block, identified by its seq.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "ripple.h"
+#include "bms_adapter.h"
+#include "adc.h"
+#include "goertzel.h"
+#include "logging.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "BMS_RIPPLE"
+
+/// Block length (s)
+#define RIPPLE_BLOCK_S      1
+
+/// Resolution of the sampling timer (Hz)
+#define RIPPLE_TIMER_HZ     1000000u
+
+/// Sampling task stack size in bytes
+#define RIPPLE_TASK_STACK   3072
+
+/// Sampling task priority: above the Slow Core (4) and supervisor (5), below lwIP and Wi-Fi
+#define RIPPLE_TASK_PRIO    10
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void sample_task(void *arg);
+static bool alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *ctx);
+static void push_sample(int raw);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Configured ripple frequencies (Hz), 0 = unused
+static const uint16_t s_cfg_hz[BMS_RIPPLE_MAX_FREQS] = {
+    CONFIG_BMS_RIPPLE_FREQ1_HZ, CONFIG_BMS_RIPPLE_FREQ2_HZ, CONFIG_BMS_RIPPLE_FREQ3_HZ, CONFIG_BMS_RIPPLE_FREQ4_HZ,
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Goertzel filter bank over raw ADC codes (written by sampling task only)
+static bms_goertzel_t s_bank;
+/// Sampling timer, its alarm wakes the sampling task
+static gptimer_handle_t s_timer = NULL;
+/// Sampling task
+static TaskHandle_t s_task = NULL;
+/// Flag indicating the sampling timer runs
+static bool s_running = false;
+/// Last raw ADC code, repeated when a conversion is missed
+static int s_last_raw = 0;
+/// Missed samples of the current block
+static uint16_t s_missed = 0;
+/// Sum of raw ADC codes since the last bms_ripple_take_mean()
+static uint32_t s_mean_sum = 0;
+/// Number of samples since the last bms_ripple_take_mean()
+static uint32_t s_mean_n = 0;
+/// Amplitudes of the latest completed block
+static bms_ripple_t s_result;
+/// Spinlock protecting mean accumulator and result across cores
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function sets up the filter bank for the configured frequencies, creates the sampling task and starts the
+/// sampling timer. Frequencies of 0 and at or above half the sample rate are skipped. Called at initialization after
+/// ADC init when the LTC6804 adapter is selected.
+///
+/// \param None
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG if no frequency is usable, ESP_ERR_NO_MEM if the task cannot be
+///         created, otherwise a gptimer error code
+esp_err_t bms_ripple_start(void)
+{
+    if (s_timer) {
+        bms_ripple_set_running(true);
+        return ESP_OK;
+    }
+
+    bms_ripple_t result = { .samples = CONFIG_BMS_RIPPLE_RATE_HZ * RIPPLE_BLOCK_S };
+    float freqs[BMS_RIPPLE_MAX_FREQS];
+    for (int k = 0; k < BMS_RIPPLE_MAX_FREQS; ++k) {
+        if (s_cfg_hz[k] == 0) {
+            continue;
+        }
+        if (2u * s_cfg_hz[k] >= CONFIG_BMS_RIPPLE_RATE_HZ) {
+            BMS_LOGW("Ripple frequency %u Hz not below half the sample rate, skipped", (unsigned)s_cfg_hz[k]);
+            continue;
+        }
+        result.hz[result.count] = s_cfg_hz[k];
+        freqs[result.count] = (float)s_cfg_hz[k];
+        result.count++;
+    }
+    if (!bms_goertzel_init(&s_bank, (float)CONFIG_BMS_RIPPLE_RATE_HZ, freqs, result.count, result.samples)) {
+        BMS_LOGE("No usable ripple frequency");
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Amplitudes stay 0 until the first block completes
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(&s_result, &result, sizeof(s_result));
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (xTaskCreatePinnedToCore(sample_task, "ripple", RIPPLE_TASK_STACK, NULL, RIPPLE_TASK_PRIO, &s_task, 0)
+        != pdPASS) {
+        BMS_LOGE("Failed to create ripple task");
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Alarm interrupt is allocated on the calling core (Core 0 during initialization)
+    const gptimer_config_t timer_cfg = {
+        .clk_src       = GPTIMER_CLK_SRC_DEFAULT,
+        .direction     = GPTIMER_COUNT_UP,
+        .resolution_hz = RIPPLE_TIMER_HZ,
+    };
+    const gptimer_event_callbacks_t cbs = { .on_alarm = alarm_cb };
+    const gptimer_alarm_config_t alarm = {
+        .alarm_count                = RIPPLE_TIMER_HZ / CONFIG_BMS_RIPPLE_RATE_HZ,
+        .reload_count               = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_handle_t timer = NULL;
+    esp_err_t ret = gptimer_new_timer(&timer_cfg, &timer);
+    if (ret == ESP_OK) {
+        ret = gptimer_register_event_callbacks(timer, &cbs, NULL);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_set_alarm_action(timer, &alarm);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(timer);
+    }
+    if (ret != ESP_OK) {
+        BMS_LOGE("Failed to set up ripple timer: %s", esp_err_to_name(ret));
+        if (timer) {
+            gptimer_del_timer(timer);
+        }
+        vTaskDelete(s_task);
+        s_task = NULL;
+        return ret;
+    }
+    s_timer = timer;
+    bms_ripple_set_running(true);
+
+    BMS_LOGI("Ripple detector started (%u Hz, %u frequencies)", (unsigned)CONFIG_BMS_RIPPLE_RATE_HZ,
+             (unsigned)result.count);
+    return ESP_OK;
+}
+
+/// This function stops or resumes current sampling, e.g. while the pack rests in low-power mode. The block in
+/// progress continues after a resume.
+///
+/// \param[in] running True to sample, false to stop
+/// \return None
+void bms_ripple_set_running(bool running)
+{
+    if (!s_timer || running == s_running) {
+        return;
+    }
+
+    esp_err_t ret = running ? gptimer_start(s_timer) : gptimer_stop(s_timer);
+    if (ret != ESP_OK) {
+        BMS_LOGW("Failed to %s ripple timer: %s", running ? "start" : "stop", esp_err_to_name(ret));
+        return;
+    }
+    s_running = running;
+
+    return;
+}
+
+/// This function takes the mean pack current of all samples since the previous call. Called by the Fast Core once
+/// per cycle.
+///
+/// \param[out] pack_i Mean pack current (A), not changed if no sample was taken
+/// \return True if at least one sample was taken since the previous call, false otherwise
+bool bms_ripple_take_mean(float *pack_i)
+{
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t sum = s_mean_sum;
+    uint32_t n = s_mean_n;
+    s_mean_sum = 0;
+    s_mean_n = 0;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (n == 0 || !pack_i) {
+        return false;
+    }
+    float mean_raw = (float)sum / (float)n;
+    *pack_i = BMS_CURRENT_I_MIN + (BMS_CURRENT_I_MAX - BMS_CURRENT_I_MIN) * mean_raw / (float)ADC_RANGE;
+
+    return true;
+}
+
+/// This function gets the ripple amplitudes of the latest completed block. Blocks are not aligned to statistics
+/// windows; a new block replaces the result once per second. Safe to call from any task.
+///
+/// \param[out] out Ripple amplitudes
+/// \return True if the detector was started, false otherwise (out is not changed)
+bool bms_ripple_get(bms_ripple_t *out)
+{
+    if (!out || !s_timer) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(out, &s_result, sizeof(*out));
+    taskEXIT_CRITICAL(&s_lock);
+
+    return true;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// Sampling task. Takes one sample per timer alarm. Alarms which arrived while the task was delayed (higher
+/// priority work on Core 0) are filled with the previous sample and counted as missed, so blocks keep their length.
+///
+/// \param[in] arg Unused
+/// \return None
+static void sample_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        uint32_t alarms = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (uint32_t k = 1; k < alarms; ++k) {
+            if (s_missed < UINT16_MAX) {
+                s_missed++;
+            }
+            push_sample(s_last_raw);
+        }
+
+        // Single attempt: a conversion of the Fast Core is not waited for, its sample is repeated instead
+        int raw = 0;
+        if (adc_read_once(BMS_CURRENT_ADC_PIN, &raw) == ESP_OK) {
+            s_last_raw = raw;
+        } else {
+            raw = s_last_raw;
+            if (s_missed < UINT16_MAX) {
+                s_missed++;
+            }
+        }
+        push_sample(raw);
+    }
+}
+
+/// Sampling timer alarm callback (interrupt context). Wakes the sampling task.
+///
+/// \param[in] timer Timer handle
+/// \param[in] event Alarm event data
+/// \param[in] ctx   Unused
+/// \return True if a higher priority task was woken (yield at the end of the interrupt)
+static bool IRAM_ATTR alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *ctx)
+{
+    (void)timer;
+    (void)event;
+    (void)ctx;
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+
+    return woken == pdTRUE;
+}
+
+/// This function feeds one current sample to the Fast Core mean and the filter bank, and publishes amplitudes in
+/// amperes when a block completes.
+///
+/// \param[in] raw Raw ADC code
+/// \return None
+static void push_sample(int raw)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_mean_sum += (uint32_t)raw;
+    s_mean_n++;
+    taskEXIT_CRITICAL(&s_lock);
+
+    float amp[BMS_GOERTZEL_MAX_BINS];
+    if (!bms_goertzel_push(&s_bank, (float)raw, amp)) {
+        return;
+    }
+
+    // Filters run on raw codes, the current mapping is linear
+    const float a_per_code = (BMS_CURRENT_I_MAX - BMS_CURRENT_I_MIN) / (float)ADC_RANGE;
+    taskENTER_CRITICAL(&s_lock);
+    for (uint8_t k = 0; k < s_result.count; ++k) {
+        s_result.amp[k] = amp[k] * a_per_code;
+    }
+    s_result.missed = s_missed;
+    s_result.seq++;
+    taskEXIT_CRITICAL(&s_lock);
+    s_missed = 0;
+
+    return;
+}
@@ -0,0 +1,74 @@
+/// Header file for `ripple.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Enables the pack current ripple detector (high-rate current sampling with Goertzel filter bank)
+#ifndef CONFIG_BMS_RIPPLE
+#define CONFIG_BMS_RIPPLE               0
+#endif
+
+/// Pack current sample rate of the ripple detector (Hz)
+#ifndef CONFIG_BMS_RIPPLE_RATE_HZ
+#define CONFIG_BMS_RIPPLE_RATE_HZ       1000
+#endif
+
+/// Ripple frequencies (Hz), 0 = unused. Whole multiples of 1 Hz fit the 1 s blocks without leakage.
+#ifndef CONFIG_BMS_RIPPLE_FREQ1_HZ
+#define CONFIG_BMS_RIPPLE_FREQ1_HZ      50
+#endif
+#ifndef CONFIG_BMS_RIPPLE_FREQ2_HZ
+#define CONFIG_BMS_RIPPLE_FREQ2_HZ      100
+#endif
+#ifndef CONFIG_BMS_RIPPLE_FREQ3_HZ
+#define CONFIG_BMS_RIPPLE_FREQ3_HZ      120
+#endif
+#ifndef CONFIG_BMS_RIPPLE_FREQ4_HZ
+#define CONFIG_BMS_RIPPLE_FREQ4_HZ      300
+#endif
+
+/// Maximum number of ripple frequencies
+#define BMS_RIPPLE_MAX_FREQS            4
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of ripple amplitudes of the latest completed block (1 s, not aligned to statistics windows)
+typedef struct {
+    uint32_t seq;                           ///< Number of completed blocks since start
+    uint16_t samples;                       ///< Number of samples per block
+    uint16_t missed;                        ///< Samples of the block repeated (ADC busy or failed, or late task)
+    uint8_t  count;                         ///< Number of valid entries of hz and amp
+    uint16_t hz[BMS_RIPPLE_MAX_FREQS];      ///< Ripple frequencies (Hz)
+    float    amp[BMS_RIPPLE_MAX_FREQS];     ///< Peak ripple amplitude of pack current at each frequency (A)
+} bms_ripple_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+esp_err_t bms_ripple_start(void);
+void bms_ripple_set_running(bool running);
+bool bms_ripple_take_mean(float *pack_i);
+bool bms_ripple_get(bms_ripple_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
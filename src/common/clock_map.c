@@ -0,0 +1,254 @@
+/// This module maps the local clock (esp_timer, microseconds since boot) to UTC from occasional sync samples, pairs
+/// of local time and UTC delivered by a time source such as SNTP. RTOS ticks count the same crystal with at best
+/// millisecond resolution, so the microsecond clock is mapped instead and ticks stay a boot-relative timestamp.
+///
+/// The mapping is piecewise linear: UTC = anchor UTC + elapsed local time scaled by (1 + rate). The rate is the
+/// drift of the local crystal against UTC, estimated from consecutive sync samples and smoothed so that network
+/// jitter of a single sample moves it only by a quarter of its error. A sync sample within BMS_CLOCK_STEP_US of the
+/// mapping does not move mapped time; the mapping continues from its current value and the offset is removed by an
+/// additional rate (slew) over about one sync interval, bounded by BMS_CLOCK_MAX_PPB. Mapped time therefore never
+/// jumps and never runs backwards, so consecutive wall-clock windows are neither skipped nor repeated. Larger
+/// offsets (first sync, long outage, changed server) step the mapping and keep the drift estimate.
+///
+/// All arithmetic is 64-bit integer, a conversion costs a few multiplications and no floating point.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "clock_map.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Parts per billion
+#define PPB                     1000000000LL
+
+/// Shortest span between sync samples used for a drift measurement (us)
+#define MIN_DRIFT_SPAN_US       10000000LL
+
+/// Shortest time over which an offset is slewed (us)
+#define MIN_SLEW_US             16000000LL
+
+/// Weight of a new drift measurement is 1 / DRIFT_GAIN
+#define DRIFT_GAIN              4
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static int64_t apply_ppb(int64_t d, int32_t ppb);
+static int64_t clamp_ppb(int64_t ppb);
+static int64_t map_forward(const bms_clock_t *clk, int64_t mono_us);
+static int64_t map_inverse(const bms_clock_t *clk, int64_t epoch_us);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function clears a mapping. Conversions fail until the first sync sample.
+///
+/// \param[out] clk Mapping
+/// \return None
+void bms_clock_init(bms_clock_t *clk)
+{
+    memset(clk, 0, sizeof(*clk));
+
+    return;
+}
+
+/// This function applies a sync sample. The first sample and samples further than BMS_CLOCK_STEP_US from the
+/// mapping step it, others update the drift estimate and start slewing out the offset.
+///
+/// \param[in,out] clk      Mapping
+/// \param[in]     mono_us  Local time at which the sample was valid (us since boot)
+/// \param[in]     epoch_us UTC at that local time (us since the Unix epoch)
+/// \return Offset of the sample from the mapping before it was applied (us), 0 for the first sample
+int64_t bms_clock_sync(bms_clock_t *clk, int64_t mono_us, int64_t epoch_us)
+{
+    int64_t err = clk->valid ? epoch_us - map_forward(clk, mono_us) : 0;
+    int64_t span = mono_us - clk->last_mono_us;
+
+    clk->last_err_us = err;
+    clk->syncs++;
+
+    if (!clk->valid || err > BMS_CLOCK_STEP_US || err < -BMS_CLOCK_STEP_US) {
+        if (clk->valid) {
+            clk->steps++;
+        }
+        clk->ref_mono_us  = mono_us;
+        clk->ref_epoch_us = epoch_us;
+        clk->slew_ppb     = 0;
+        clk->slew_end_us  = mono_us;
+        clk->valid        = true;
+    } else {
+        // Drift from the previous sample pair; independent of the mapping and of corrections still running
+        if (span >= MIN_DRIFT_SPAN_US) {
+            int64_t diff = (epoch_us - clk->last_epoch_us) - span;
+            int64_t meas = clamp_ppb(diff * 1000000LL / (span / 1000LL));
+            int64_t drift = (clk->drift_n == 0) ? meas : clk->drift_ppb + (meas - clk->drift_ppb) / DRIFT_GAIN;
+            clk->drift_ppb = (int32_t)clamp_ppb(drift);
+            clk->drift_n++;
+        }
+
+        // Continue from the mapped time and remove the offset over about one sync interval
+        clk->ref_epoch_us = map_forward(clk, mono_us);
+        clk->ref_mono_us  = mono_us;
+        int64_t horizon = (span > MIN_SLEW_US) ? span : MIN_SLEW_US;
+        int64_t slew = clamp_ppb(err * 1000000LL / (horizon / 1000LL));
+        clk->slew_ppb    = (int32_t)slew;
+        clk->slew_end_us = mono_us + ((slew != 0) ? err * PPB / slew : 0);
+    }
+
+    clk->last_mono_us  = mono_us;
+    clk->last_epoch_us = epoch_us;
+
+    return err;
+}
+
+/// This function converts local time to UTC.
+///
+/// \param[in]  clk      Mapping
+/// \param[in]  mono_us  Local time (us since boot)
+/// \param[out] epoch_us UTC (us since the Unix epoch)
+/// \return True on success, false if no sync sample was applied yet (epoch_us is not changed)
+bool bms_clock_to_epoch(const bms_clock_t *clk, int64_t mono_us, int64_t *epoch_us)
+{
+    if (!clk->valid) {
+        return false;
+    }
+    *epoch_us = map_forward(clk, mono_us);
+
+    return true;
+}
+
+/// This function converts UTC to local time, e.g. to schedule a timer at a wall-clock edge.
+///
+/// \param[in]  clk      Mapping
+/// \param[in]  epoch_us UTC (us since the Unix epoch)
+/// \param[out] mono_us  Local time (us since boot)
+/// \return True on success, false if no sync sample was applied yet (mono_us is not changed)
+bool bms_clock_to_mono(const bms_clock_t *clk, int64_t epoch_us, int64_t *mono_us)
+{
+    if (!clk->valid) {
+        return false;
+    }
+    *mono_us = map_inverse(clk, epoch_us);
+
+    return true;
+}
+
+/// This function finds the next wall-clock edge, the first whole multiple of a period in UTC after a local time.
+/// A period dividing one second gives edges on every second.
+///
+/// \param[in]  clk           Mapping
+/// \param[in]  mono_us       Local time (us since boot)
+/// \param[in]  period_us     Period (us)
+/// \param[out] edge_epoch_us UTC of the edge (us since the Unix epoch)
+/// \param[out] edge_mono_us  Local time of the edge (us since boot)
+/// \return True on success, false if no sync sample was applied yet or the period is 0 (outputs are not changed)
+bool bms_clock_next_edge(const bms_clock_t *clk, int64_t mono_us, uint32_t period_us, int64_t *edge_epoch_us,
+                         int64_t *edge_mono_us)
+{
+    if (!clk->valid || period_us == 0) {
+        return false;
+    }
+    int64_t now = map_forward(clk, mono_us);
+    if (now < 0) {
+        return false;
+    }
+
+    int64_t edge = (now / (int64_t)period_us + 1) * (int64_t)period_us;
+    *edge_epoch_us = edge;
+    *edge_mono_us  = map_inverse(clk, edge);
+
+    return true;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function scales a time span by (1 + ppb / 10^9) without overflow for any span.
+///
+/// \param[in] d   Time span (us)
+/// \param[in] ppb Rate (ppb)
+/// \return Scaled time span (us)
+static int64_t apply_ppb(int64_t d, int32_t ppb)
+{
+    return d + (d / PPB) * ppb + (d % PPB) * ppb / PPB;
+}
+
+/// This function bounds a rate to +-BMS_CLOCK_MAX_PPB.
+///
+/// \param[in] ppb Rate (ppb)
+/// \return Bounded rate (ppb)
+static int64_t clamp_ppb(int64_t ppb)
+{
+    if (ppb > BMS_CLOCK_MAX_PPB) {
+        return BMS_CLOCK_MAX_PPB;
+    }
+    if (ppb < -BMS_CLOCK_MAX_PPB) {
+        return -BMS_CLOCK_MAX_PPB;
+    }
+
+    return ppb;
+}
+
+/// This function evaluates the mapping: slewed rate from the anchor until the end of the slew, drift rate after.
+///
+/// \param[in] clk     Mapping (valid)
+/// \param[in] mono_us Local time (us since boot)
+/// \return UTC (us since the Unix epoch)
+static int64_t map_forward(const bms_clock_t *clk, int64_t mono_us)
+{
+    int32_t rate = clk->drift_ppb + clk->slew_ppb;
+
+    if (clk->slew_ppb == 0 || mono_us <= clk->slew_end_us) {
+        return clk->ref_epoch_us + apply_ppb(mono_us - clk->ref_mono_us, rate);
+    }
+
+    return clk->ref_epoch_us + apply_ppb(clk->slew_end_us - clk->ref_mono_us, rate)
+         + apply_ppb(mono_us - clk->slew_end_us, clk->drift_ppb);
+}
+
+/// This function inverts the mapping on the segment containing the given UTC. The first-order inverse is refined
+/// by one step with the forward mapping; the remaining error is below 1 us for spans of days.
+///
+/// \param[in] clk      Mapping (valid)
+/// \param[in] epoch_us UTC (us since the Unix epoch)
+/// \return Local time (us since boot)
+static int64_t map_inverse(const bms_clock_t *clk, int64_t epoch_us)
+{
+    int64_t base_mono  = clk->ref_mono_us;
+    int64_t base_epoch = clk->ref_epoch_us;
+    int32_t rate = clk->drift_ppb + clk->slew_ppb;
+
+    if (clk->slew_ppb != 0) {
+        int64_t end_epoch = map_forward(clk, clk->slew_end_us);
+        if (epoch_us > end_epoch) {
+            base_mono  = clk->slew_end_us;
+            base_epoch = end_epoch;
+            rate       = clk->drift_ppb;
+        }
+    }
+
+    int64_t d = epoch_us - base_epoch;
+    int64_t m = 2 * d - apply_ppb(d, rate);
+    m += d - apply_ppb(m, rate);
+
+    return base_mono + m;
+}
@@ -0,0 +1,60 @@
+/// Header file for `clock_map.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Offset of a sync sample from the mapping above which the mapping is stepped instead of slewed (us)
+#define BMS_CLOCK_STEP_US           128000
+
+/// Largest drift and largest slew rate of the mapping (ppb)
+#define BMS_CLOCK_MAX_PPB           500000
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of a piecewise linear mapping from the local clock (esp_timer, us since boot) to UTC (us since the
+/// Unix epoch). Offsets are corrected by slewing the rate until slew_end_us.
+typedef struct {
+    int64_t  ref_mono_us;       ///< Local time of the anchor point
+    int64_t  ref_epoch_us;      ///< UTC at the anchor point
+    int64_t  slew_end_us;       ///< Local time when the offset correction ends
+    int64_t  last_mono_us;      ///< Local time of the previous sync sample
+    int64_t  last_epoch_us;     ///< UTC of the previous sync sample
+    int64_t  last_err_us;       ///< Offset of the last sync sample from the mapping before it was applied
+    int32_t  drift_ppb;         ///< Estimated rate of UTC against the local clock minus one (ppb)
+    int32_t  slew_ppb;          ///< Additional rate until slew_end_us (ppb)
+    uint32_t syncs;             ///< Number of sync samples applied
+    uint32_t steps;             ///< Number of steps after the first sync
+    uint32_t drift_n;           ///< Number of drift measurements
+    bool     valid;             ///< Flag indicating at least one sync sample was applied
+} bms_clock_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void bms_clock_init(bms_clock_t *clk);
+int64_t bms_clock_sync(bms_clock_t *clk, int64_t mono_us, int64_t epoch_us);
+bool bms_clock_to_epoch(const bms_clock_t *clk, int64_t mono_us, int64_t *epoch_us);
+bool bms_clock_to_mono(const bms_clock_t *clk, int64_t epoch_us, int64_t *mono_us);
+bool bms_clock_next_edge(const bms_clock_t *clk, int64_t mono_us, uint32_t period_us, int64_t *edge_epoch_us,
+                         int64_t *edge_mono_us);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -0,0 +1,223 @@
+/// This module implements the Fast Core deadline-miss policy. Misses are counted over a sliding window of wall time,
+/// converted to cycles of the current period, so the window and the recovery time mean the same at every sample
+/// rate. When misses in the window reach the degrade threshold, the Fast Core is asked to step to a cheaper
+/// configuration (faster ADC mode, then halved sample rate). After a long run of clean cycles it is asked to step
+/// back. A system reset is requested only if misses keep reaching the reset threshold at the highest degradation
+/// level. The monitor is updated from Core 1, statistics are read from Core 0.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "deadline_monitor.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+#include "logging.h"
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "DEADLINE_MON"
+
+/// Length of the sliding window in milliseconds (converted to cycles of the current period, 64 cycles at most)
+#ifndef CONFIG_BMS_DLM_WINDOW_MS
+#define CONFIG_BMS_DLM_WINDOW_MS       2000
+#endif
+
+/// Number of misses within the window which causes a step to the next degradation level
+#ifndef CONFIG_BMS_DLM_DEGRADE_MISSES
+#define CONFIG_BMS_DLM_DEGRADE_MISSES  3
+#endif
+
+/// Number of misses within the window at the highest degradation level which causes a reset request
+#ifndef CONFIG_BMS_DLM_RESET_MISSES
+#define CONFIG_BMS_DLM_RESET_MISSES    10
+#endif
+
+/// Time without a miss after which one degradation level is recovered (ms)
+#ifndef CONFIG_BMS_DLM_RECOVER_MS
+#define CONFIG_BMS_DLM_RECOVER_MS      30000
+#endif
+
+/// Most cycles the window can hold (one bit per cycle)
+#define DLM_MAX_WINDOW_CYCLES  64u
+
+#if (CONFIG_BMS_DLM_RESET_MISSES > DLM_MAX_WINDOW_CYCLES) || (CONFIG_BMS_DLM_DEGRADE_MISSES > DLM_MAX_WINDOW_CYCLES)
+#error "CONFIG_BMS_DLM_DEGRADE_MISSES and CONFIG_BMS_DLM_RESET_MISSES must not exceed 64"
+#endif
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void clear_window(void);
+static uint32_t window_cycles(uint32_t period_ms);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Miss history of the cycles in the window, bit 0 is the newest cycle
+static uint64_t s_window = 0;
+/// Time of consecutive cycles without a miss (ms)
+static uint32_t s_clean_ms = 0;
+/// Statistics exposed to Core 0
+static dlm_stats_t s_stats = {0};
+/// Spinlock for protecting statistics access across cores
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function resets the monitor to nominal level. Statistics since boot are kept, so restarting the
+/// Fast Core tasks does not hide earlier overload.
+///
+/// \param None
+/// \return None
+void deadline_monitor_init(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    clear_window();
+    s_stats.level = DLM_LEVEL_NOMINAL;
+    taskEXIT_CRITICAL(&s_lock);
+
+    BMS_LOGI("Deadline monitor: window=%d ms, degrade=%d, reset=%d, recover=%d ms",
+             CONFIG_BMS_DLM_WINDOW_MS, CONFIG_BMS_DLM_DEGRADE_MISSES,
+             CONFIG_BMS_DLM_RESET_MISSES, CONFIG_BMS_DLM_RECOVER_MS);
+
+    return;
+}
+
+/// This function records the result of one Fast Core cycle and evaluates the policy. The window is cleared on
+/// every level change, so the next decision is based only on cycles run in the new configuration.
+///
+/// \param[in] missed True if the cycle exceeded its deadline
+/// \param[in] period_ms Period of the cycle in milliseconds
+/// \return Action the caller has to apply
+dlm_action_t deadline_monitor_update(bool missed, uint32_t period_ms)
+{
+    dlm_action_t action = DLM_ACTION_NONE;
+    uint32_t cycles = window_cycles(period_ms);
+    uint64_t mask = (cycles == DLM_MAX_WINDOW_CYCLES) ? UINT64_MAX : ((UINT64_C(1) << cycles) - 1u);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_window = ((s_window << 1) | (missed ? 1u : 0u)) & mask;
+    s_stats.window_misses = (uint32_t)__builtin_popcountll(s_window);
+    s_stats.window_ms = cycles * period_ms;
+
+    if (missed) {
+        s_stats.total_misses++;
+        s_clean_ms = 0;
+
+        if (s_stats.level < (DLM_LEVEL_COUNT - 1)) {
+            if (s_stats.window_misses >= CONFIG_BMS_DLM_DEGRADE_MISSES) {
+                s_stats.level++;
+                s_stats.degrade_count++;
+                if (s_stats.level > s_stats.max_level) {
+                    s_stats.max_level = s_stats.level;
+                }
+                clear_window();
+                action = DLM_ACTION_DEGRADE;
+            }
+        } else if (s_stats.window_misses >= CONFIG_BMS_DLM_RESET_MISSES) {
+            action = DLM_ACTION_RESET;
+        }
+    } else if (s_stats.level > DLM_LEVEL_NOMINAL) {
+        s_clean_ms += period_ms;
+        if (s_clean_ms >= CONFIG_BMS_DLM_RECOVER_MS) {
+            s_stats.level--;
+            clear_window();
+            action = DLM_ACTION_RECOVER;
+        }
+    }
+    uint8_t level = s_stats.level;
+    taskEXIT_CRITICAL(&s_lock);
+
+    // Logging outside of critical section
+    if (action == DLM_ACTION_DEGRADE) {
+        BMS_LOGW("Fast Core overloaded, degrading to level %u", (unsigned)level);
+    } else if (action == DLM_ACTION_RECOVER) {
+        BMS_LOGI("Fast Core load recovered, returning to level %u", (unsigned)level);
+    } else if (action == DLM_ACTION_RESET) {
+        BMS_LOGE("Fast Core deadline misses persist at highest degradation level, requesting reset");
+    }
+
+    return action;
+}
+
+/// This function returns the current degradation level.
+///
+/// \param None
+/// \return Current degradation level
+dlm_level_t deadline_monitor_get_level(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    dlm_level_t level = (dlm_level_t)s_stats.level;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return level;
+}
+
+/// This function copies the deadline monitor statistics.
+///
+/// \param[out] out Pointer to structure to receive statistics
+/// \return None
+void deadline_monitor_get_stats(dlm_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function clears the sliding window and the clean time. Must be called with ::s_lock held.
+///
+/// \param None
+/// \return None
+static void clear_window(void)
+{
+    s_window = 0;
+    s_clean_ms = 0;
+    s_stats.window_misses = 0;
+
+    return;
+}
+
+/// This function converts the window length to cycles of a period. The window holds at least as many cycles as the
+/// reset threshold, so the thresholds stay reachable at long periods (low-power mode), and at most 64 cycles.
+///
+/// \param[in] period_ms Cycle period in milliseconds
+/// \return Window length in cycles
+static uint32_t window_cycles(uint32_t period_ms)
+{
+    uint32_t cycles = (period_ms > 0) ? (uint32_t)CONFIG_BMS_DLM_WINDOW_MS / period_ms : DLM_MAX_WINDOW_CYCLES;
+    uint32_t min_cycles = (CONFIG_BMS_DLM_RESET_MISSES > CONFIG_BMS_DLM_DEGRADE_MISSES) ?
+                          CONFIG_BMS_DLM_RESET_MISSES : CONFIG_BMS_DLM_DEGRADE_MISSES;
+
+    if (cycles < min_cycles) {
+        cycles = min_cycles;
+    }
+    if (cycles > DLM_MAX_WINDOW_CYCLES) {
+        cycles = DLM_MAX_WINDOW_CYCLES;
+    }
+
+    return cycles;
+}
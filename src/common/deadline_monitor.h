@@ -0,0 +1,62 @@
+/// Header file for `deadline_monitor.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Enumeration of Fast Core degradation levels. Higher level means less work per second.
+typedef enum {
+    DLM_LEVEL_NOMINAL = 0,      ///< Normal ADC mode, nominal sample period
+    DLM_LEVEL_FAST_ADC,         ///< Fast ADC mode with shorter conversion wait, nominal sample period
+    DLM_LEVEL_HALF_RATE,        ///< Fast ADC mode and doubled sample period
+    DLM_LEVEL_COUNT,            ///< Number of levels (not a level)
+} dlm_level_t;
+
+/// Enumeration of actions requested by the deadline monitor after a cycle
+typedef enum {
+    DLM_ACTION_NONE = 0,        ///< Keep current configuration
+    DLM_ACTION_DEGRADE,         ///< Switch to the (new) higher degradation level
+    DLM_ACTION_RECOVER,         ///< Switch back to the (new) lower degradation level
+    DLM_ACTION_RESET,           ///< Overload persists at the highest level, system reset is requested
+} dlm_action_t;
+
+/// Structure containing deadline monitor statistics
+typedef struct {
+    uint32_t total_misses;      ///< Number of missed deadlines since boot
+    uint32_t window_misses;     ///< Number of missed deadlines in the current sliding window
+    uint32_t window_ms;         ///< Wall time covered by the sliding window at the current period (ms)
+    uint32_t degrade_count;     ///< Number of degradation steps since boot
+    uint8_t  level;             ///< Current degradation level (::dlm_level_t)
+    uint8_t  max_level;         ///< Highest degradation level reached since boot
+} dlm_stats_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void deadline_monitor_init(void);
+dlm_action_t deadline_monitor_update(bool missed, uint32_t period_ms);
+dlm_level_t deadline_monitor_get_level(void);
+void deadline_monitor_get_stats(dlm_stats_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
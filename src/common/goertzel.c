@@ -0,0 +1,119 @@
+/// This module measures the amplitude of a signal at a few fixed frequencies with a bank of Goertzel filters. Each
+/// filter is a second-order resonator, s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2], so a sample costs one multiply and
+/// two adds per frequency and a bank has a bounded per-sample cost independent of the block length. At the end of a
+/// block of N samples the power at each frequency is computed from the last two filter states and the filters
+/// restart. Compared with an FFT of the same block, only the needed frequencies are computed and no sample buffer
+/// is kept.
+///
+/// The frequencies are not restricted to FFT bins, but a frequency with a whole number of periods per block (a
+/// multiple of rate / N) has no leakage from the other frequencies and from the mean. The mean of the previous
+/// block is subtracted from every sample, which keeps a large offset (pack current) from costing float precision
+/// in the filter states.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "goertzel.h"
+#include <math.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Pi in single precision
+#define GOERTZEL_PI     3.14159265358979f
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function sets up a filter bank. Frequencies must lie between 0 and half the sample rate (exclusive).
+///
+/// \param[out] bank      Filter bank
+/// \param[in]  rate_hz   Sample rate (Hz)
+/// \param[in]  freqs_hz  Frequencies (Hz)
+/// \param[in]  bins      Number of frequencies (1 .. ::BMS_GOERTZEL_MAX_BINS)
+/// \param[in]  block_len Number of samples per block (at least 2)
+/// \return True on success, false on invalid arguments (bank is cleared)
+bool bms_goertzel_init(bms_goertzel_t *bank, float rate_hz, const float *freqs_hz, uint8_t bins, uint32_t block_len)
+{
+    if (!bank) {
+        return false;
+    }
+    memset(bank, 0, sizeof(*bank));
+    if (!freqs_hz || bins < 1 || bins > BMS_GOERTZEL_MAX_BINS || block_len < 2 || !(rate_hz > 0.0f)) {
+        return false;
+    }
+
+    for (uint8_t k = 0; k < bins; ++k) {
+        if (!(freqs_hz[k] > 0.0f && freqs_hz[k] < 0.5f * rate_hz)) {
+            return false;
+        }
+        bank->coeff[k] = 2.0f * cosf(2.0f * GOERTZEL_PI * freqs_hz[k] / rate_hz);
+    }
+    bank->bins = bins;
+    bank->block_len = block_len;
+
+    return true;
+}
+
+/// This function feeds one sample to all filters of a bank. When the sample completes a block, the peak amplitude
+/// of a sine at each frequency is computed and the next block starts.
+///
+/// \param[in,out] bank Filter bank
+/// \param[in]     x    Sample
+/// \param[out]    amp  Peak amplitudes in order of frequencies (written only when a block completes)
+/// \return True if a block was completed and amp was written, false otherwise
+bool bms_goertzel_push(bms_goertzel_t *bank, float x, float *amp)
+{
+    if (!bank->primed) {
+        bank->dc = x;
+        bank->primed = true;
+    }
+    bank->sum += x;
+    x -= bank->dc;
+
+    for (uint8_t k = 0; k < bank->bins; ++k) {
+        float s0 = x + bank->coeff[k] * bank->s1[k] - bank->s2[k];
+        bank->s2[k] = bank->s1[k];
+        bank->s1[k] = s0;
+    }
+    if (++bank->n < bank->block_len) {
+        return false;
+    }
+
+    // |X(f)|^2 from the last two states; a sine of amplitude A gives |X| = A N / 2
+    float scale = 2.0f / (float)bank->block_len;
+    for (uint8_t k = 0; k < bank->bins; ++k) {
+        float s1 = bank->s1[k];
+        float s2 = bank->s2[k];
+        float power = s1 * s1 + s2 * s2 - bank->coeff[k] * s1 * s2;
+        amp[k] = scale * sqrtf(fmaxf(power, 0.0f));
+        bank->s1[k] = 0.0f;
+        bank->s2[k] = 0.0f;
+    }
+    bank->dc = bank->sum / (float)bank->block_len;
+    bank->sum = 0.0f;
+    bank->n = 0;
+
+    return true;
+}
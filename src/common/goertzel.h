@@ -0,0 +1,49 @@
+/// Header file for `goertzel.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Maximum number of frequencies of one filter bank
+#define BMS_GOERTZEL_MAX_BINS   8
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of a bank of Goertzel filters evaluated over consecutive blocks of samples
+typedef struct {
+    float    coeff[BMS_GOERTZEL_MAX_BINS];  ///< Filter coefficient 2 cos(2 pi f / fs) per bin
+    float    s1[BMS_GOERTZEL_MAX_BINS];     ///< Filter state, previous output
+    float    s2[BMS_GOERTZEL_MAX_BINS];     ///< Filter state, output before previous
+    float    dc;                            ///< Mean of the previous block, removed from input samples
+    float    sum;                           ///< Sum of input samples of the current block
+    uint32_t block_len;                     ///< Number of samples per block
+    uint32_t n;                             ///< Number of samples in the current block
+    uint8_t  bins;                          ///< Number of frequencies
+    bool     primed;                        ///< Flag indicating dc holds a block mean (or the first sample)
+} bms_goertzel_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+bool bms_goertzel_init(bms_goertzel_t *bank, float rate_hz, const float *freqs_hz, uint8_t bins, uint32_t block_len);
+bool bms_goertzel_push(bms_goertzel_t *bank, float x, float *amp);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
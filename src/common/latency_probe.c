@@ -0,0 +1,179 @@
+/// This module keeps the state of the end-to-end latency probe which is not carried by samples or statistics
+/// windows: duration of the last publish call (measured on Core 0) and round trip time of echoed messages.
+/// The latency tool (tools/latency-probe) echoes the "lat" object of every received message back to
+/// ::LATENCY_ECHO_TOPIC. All devices share that topic, so echoes carry the device ID and only the own ones are
+/// accepted. On reception, the echoed serialization stamp is subtracted from the current time, so the round trip is
+/// measured with the device clock only and needs no clock synchronization. Echoes are handled in the MQTT client
+/// task, state is read by the Slow Core when serializing the next message.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "latency_probe.h"
+#include "stage_timing.h"
+#include "telemetry.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Maximum length of echo payload which is parsed (longer payloads are truncated)
+#define ECHO_MAXLEN  256
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static bool find_u32(const char *json, const char *key, uint32_t *value);
+static bool find_str(const char *json, const char *key, char *value, size_t value_size);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Latency probe state
+static latency_probe_state_t s_state = {0};
+/// Spinlock for protecting state access across tasks
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function records the duration of a statistics publish call. It is reported with the next message,
+/// because a message cannot contain the duration of its own publishing.
+///
+/// \param[in] duration_us Duration of publish call in microseconds
+/// \return None
+void latency_probe_publish_done(uint32_t duration_us)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_state.publish_us = duration_us;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function handles a message received on ::LATENCY_ECHO_TOPIC. Payload is the echoed "lat" object,
+/// which contains at least device ID "dev", message sequence number "seq" and serialization stamp "ser". All
+/// devices share the topic, so echoes of other devices are ignored: their stamps are not from this clock.
+///
+/// \param[in] data Pointer to payload (not null-terminated)
+/// \param[in] len Payload length in bytes
+/// \return true if echo was recognized, false if a member is missing or the echo is for another device
+bool latency_probe_echo_received(const char *data, int len)
+{
+    uint32_t now = stage_timing_now_us();
+
+    if (!data || len <= 0) {
+        return false;
+    }
+
+    char json[ECHO_MAXLEN];
+    size_t n = ((size_t)len < sizeof(json) - 1u) ? (size_t)len : sizeof(json) - 1u;
+    memcpy(json, data, n);
+    json[n] = '\0';
+
+    char dev[18];
+    char own[18];
+    telemetry_get_device_id(own, sizeof(own));
+    if (!find_str(json, "\"dev\":\"", dev, sizeof(dev)) || strcmp(dev, own) != 0) {
+        return false;
+    }
+
+    uint32_t seq;
+    uint32_t ser;
+    if (!find_u32(json, "\"seq\":", &seq) || !find_u32(json, "\"ser\":", &ser)) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_state.echo_seq = seq;
+    // Unsigned difference stays correct across wrap of 32-bit microsecond stamps (71 minutes)
+    s_state.echo_rtt_us = now - ser;
+    s_state.echoes++;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return true;
+}
+
+/// This function returns a snapshot of latency probe state.
+///
+/// \param[out] state Pointer to state structure
+/// \return None
+void latency_probe_get_state(latency_probe_state_t *state)
+{
+    if (!state) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    *state = s_state;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function finds an unsigned integer member in a flat JSON object.
+///
+/// \param[in] json Null-terminated JSON text
+/// \param[in] key Member name including quotes and colon (e.g. "\"seq\":")
+/// \param[out] value Parsed value
+/// \return true if member was found and is a number, false otherwise
+static bool find_u32(const char *json, const char *key, uint32_t *value)
+{
+    const char *p = strstr(json, key);
+    if (!p) {
+        return false;
+    }
+    p += strlen(key);
+
+    char *end;
+    unsigned long v = strtoul(p, &end, 10);
+    if (end == p) {
+        return false;
+    }
+    *value = (uint32_t)v;
+
+    return true;
+}
+
+/// This function finds a string member in a flat JSON object. Escapes are not decoded (device IDs have none).
+///
+/// \param[in] json Null-terminated JSON text
+/// \param[in] key Member name including quotes, colon and opening quote (e.g. "\"dev\":\"")
+/// \param[out] value Buffer for the string
+/// \param[in] value_size Size of value buffer
+/// \return true if member was found and fits into value, false otherwise
+static bool find_str(const char *json, const char *key, char *value, size_t value_size)
+{
+    const char *p = strstr(json, key);
+    if (!p) {
+        return false;
+    }
+    p += strlen(key);
+
+    const char *end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= value_size) {
+        return false;
+    }
+    memcpy(value, p, (size_t)(end - p));
+    value[end - p] = '\0';
+
+    return true;
+}
@@ -0,0 +1,51 @@
+/// Header file for `latency_probe.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Enables acquisition to delivery timestamps in samples, statistics windows and published JSON
+#ifndef CONFIG_BMS_LATENCY_PROBE
+#define CONFIG_BMS_LATENCY_PROBE  0
+#endif
+
+/// Topic on which the latency tool echoes received "lat" objects back to the device
+#define LATENCY_ECHO_TOPIC        "bms/esp32/latency/echo"
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of latency probe state reported with every published statistics window
+typedef struct {
+    uint32_t publish_us;        ///< Duration of the last publish call in microseconds
+    uint32_t echo_seq;          ///< Message sequence number of the last echo received
+    uint32_t echo_rtt_us;       ///< Serialization to echo reception time of that message in microseconds
+    uint32_t echoes;            ///< Number of echoes received since boot
+} latency_probe_state_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void latency_probe_publish_done(uint32_t duration_us);
+bool latency_probe_echo_received(const char *data, int len);
+void latency_probe_get_state(latency_probe_state_t *state);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
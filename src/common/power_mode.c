@@ -0,0 +1,170 @@
+/// This module implements the acquisition power mode policy. While the pack is at rest (no current flow, all cells
+/// within limits) for ::CONFIG_BMS_LOW_POWER_IDLE_S, the Fast Core is asked to switch to low-rate acquisition with
+/// the LTC6804 and the ESP32 sleeping between samples. The first sample with current flow or a limit excursion
+/// switches back to full rate. Low-power cycles are accounted for wake-to-sample latency and awake duty, from which
+/// the average supply current is modelled. The policy is updated from Core 1, mode and statistics are read from
+/// Core 0.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "power_mode.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+#include "logging.h"
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "POWER_MODE"
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Time the pack has been at rest in full-rate mode in milliseconds
+static uint32_t s_rest_ms = 0;
+/// Sum of awake time and of period of low-power cycles (for duty), in microseconds and milliseconds
+static uint64_t s_awake_us_sum = 0;
+static uint64_t s_period_ms_sum = 0;
+/// Statistics exposed to Core 0
+static pwr_stats_t s_stats = {0};
+/// Current mode, read by Core 0 without lock
+static volatile uint8_t s_mode = PWR_MODE_FULL;
+/// Spinlock for protecting statistics access across cores
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function resets the policy to full-rate mode. Statistics since boot are kept.
+///
+/// \param None
+/// \return None
+void power_mode_init(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_rest_ms = 0;
+    s_mode = PWR_MODE_FULL;
+    s_stats.mode = PWR_MODE_FULL;
+    taskEXIT_CRITICAL(&s_lock);
+
+    BMS_LOGI("Power mode: low-power period=%d ms after %d s at rest (|I| < %d mA)",
+             CONFIG_BMS_LOW_POWER_PERIOD_MS, CONFIG_BMS_LOW_POWER_IDLE_S, CONFIG_BMS_LOW_POWER_IDLE_MA);
+
+    return;
+}
+
+/// This function records activity of one sample and evaluates the policy.
+///
+/// \param[in] active    True if the sample shows current flow or a limit excursion
+/// \param[in] period_ms Current sample period in milliseconds (time the sample stands for)
+/// \return Action the caller has to apply
+pwr_action_t power_mode_update(bool active, uint32_t period_ms)
+{
+    pwr_action_t action = PWR_ACTION_NONE;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_mode == PWR_MODE_LOW) {
+        if (active) {
+            s_mode = PWR_MODE_FULL;
+            s_rest_ms = 0;
+            action = PWR_ACTION_EXIT_LOW;
+        }
+    } else if (active) {
+        s_rest_ms = 0;
+    } else {
+        s_rest_ms += period_ms;
+        if (s_rest_ms >= (uint32_t)CONFIG_BMS_LOW_POWER_IDLE_S * 1000u) {
+            s_mode = PWR_MODE_LOW;
+            s_stats.entries++;
+            action = PWR_ACTION_ENTER_LOW;
+        }
+    }
+    s_stats.mode = s_mode;
+    taskEXIT_CRITICAL(&s_lock);
+
+    // Logging outside of critical section
+    if (action == PWR_ACTION_ENTER_LOW) {
+        BMS_LOGI("Pack at rest for %d s, entering low-power acquisition", CONFIG_BMS_LOW_POWER_IDLE_S);
+    } else if (action == PWR_ACTION_EXIT_LOW) {
+        BMS_LOGI("Current flow or limit excursion, returning to full-rate acquisition");
+    }
+
+    return action;
+}
+
+/// This function accounts one low-power cycle. The average current is modelled from the awake duty of all
+/// low-power cycles since boot with ::CONFIG_BMS_LOW_POWER_ACTIVE_UA and ::CONFIG_BMS_LOW_POWER_SLEEP_UA.
+///
+/// \param[in] wake_to_sample_us Time from task wakeup to the sample being available in microseconds
+/// \param[in] awake_us          Time from task wakeup to the end of the cycle in microseconds
+/// \param[in] period_ms         Sample period of the cycle in milliseconds
+/// \return None
+void power_mode_record_cycle(uint32_t wake_to_sample_us, uint32_t awake_us, uint32_t period_ms)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_awake_us_sum += awake_us;
+    s_period_ms_sum += period_ms;
+    s_stats.low_cycles++;
+    s_stats.wake_us_last = wake_to_sample_us;
+    if (wake_to_sample_us > s_stats.wake_us_max) {
+        s_stats.wake_us_max = wake_to_sample_us;
+    }
+    if (s_period_ms_sum > 0) {
+        uint64_t duty_ppm = (s_awake_us_sum * 1000u) / s_period_ms_sum;
+        s_stats.duty_ppm = (duty_ppm > 1000000u) ? 1000000u : (uint32_t)duty_ppm;
+        s_stats.avg_ua = (uint32_t)(((uint64_t)s_stats.duty_ppm * CONFIG_BMS_LOW_POWER_ACTIVE_UA +
+                                     (uint64_t)(1000000u - s_stats.duty_ppm) * CONFIG_BMS_LOW_POWER_SLEEP_UA) /
+                                    1000000u);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function returns the current acquisition power mode.
+///
+/// \param None
+/// \return Current power mode
+pwr_mode_t power_mode_get(void)
+{
+    return (pwr_mode_t)s_mode;
+}
+
+/// This function copies the power mode statistics.
+///
+/// \param[out] out Pointer to structure to receive statistics
+/// \return None
+void power_mode_get_stats(pwr_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
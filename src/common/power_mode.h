@@ -0,0 +1,90 @@
+/// Header file for `power_mode.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Low-power acquisition mode for idle packs (see Kconfig BMS_LOW_POWER)
+#ifndef CONFIG_BMS_LOW_POWER
+#define CONFIG_BMS_LOW_POWER             0
+#endif
+
+/// Sample period in low-power mode in milliseconds
+#ifndef CONFIG_BMS_LOW_POWER_PERIOD_MS
+#define CONFIG_BMS_LOW_POWER_PERIOD_MS   10000
+#endif
+
+/// Time at rest before low-power mode is entered in seconds
+#ifndef CONFIG_BMS_LOW_POWER_IDLE_S
+#define CONFIG_BMS_LOW_POWER_IDLE_S      300
+#endif
+
+/// Pack current magnitude below which the pack is considered at rest in milliamperes
+#ifndef CONFIG_BMS_LOW_POWER_IDLE_MA
+#define CONFIG_BMS_LOW_POWER_IDLE_MA     200
+#endif
+
+/// Modelled supply current while awake in microamperes (used for the average current estimate)
+#ifndef CONFIG_BMS_LOW_POWER_ACTIVE_UA
+#define CONFIG_BMS_LOW_POWER_ACTIVE_UA   45000
+#endif
+
+/// Modelled supply current while asleep in microamperes (light sleep, Wi-Fi power save, LTC6804 SLEEP)
+#ifndef CONFIG_BMS_LOW_POWER_SLEEP_UA
+#define CONFIG_BMS_LOW_POWER_SLEEP_UA    1500
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Enumeration of acquisition power modes
+typedef enum {
+    PWR_MODE_FULL = 0,          ///< Full-rate acquisition, everything powered
+    PWR_MODE_LOW,               ///< Low-rate acquisition, LTC6804 and ESP32 sleeping between samples
+} pwr_mode_t;
+
+/// Enumeration of actions requested by the power mode policy after a sample
+typedef enum {
+    PWR_ACTION_NONE = 0,        ///< Keep current mode
+    PWR_ACTION_ENTER_LOW,       ///< Pack has been at rest long enough, switch to low-power mode
+    PWR_ACTION_EXIT_LOW,        ///< Current flow or limit excursion, switch back to full rate
+} pwr_action_t;
+
+/// Structure containing power mode statistics
+typedef struct {
+    uint8_t  mode;              ///< Current mode (::pwr_mode_t)
+    uint32_t entries;           ///< Number of low-power mode entries since boot
+    uint32_t low_cycles;        ///< Number of samples taken in low-power mode since boot
+    uint32_t wake_us_last;      ///< Wake-to-sample latency of the last low-power sample in microseconds
+    uint32_t wake_us_max;       ///< Worst wake-to-sample latency since boot in microseconds
+    uint32_t duty_ppm;          ///< Awake fraction of low-power cycles in ppm (since boot)
+    uint32_t avg_ua;            ///< Modelled average supply current in low-power mode in microamperes
+} pwr_stats_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void power_mode_init(void);
+pwr_action_t power_mode_update(bool active, uint32_t period_ms);
+void power_mode_record_cycle(uint32_t wake_to_sample_us, uint32_t awake_us, uint32_t period_ms);
+pwr_mode_t power_mode_get(void);
+void power_mode_get_stats(pwr_stats_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
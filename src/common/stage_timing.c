@@ -0,0 +1,254 @@
+/// This module collects microsecond durations of individual Fast Core cycle stages into log-bucketed histograms.
+/// Each stage keeps one histogram since boot, one for the current reporting interval and one for the last complete
+/// interval. The Fast Core starts a new interval on a fixed period, so summaries are read-only and every reader
+/// sees the same interval. Recording is done from Core 1, summaries are computed on Core 0 from a copy of the
+/// histogram, so the critical section stays short.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "stage_timing.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "STAGE_TIMING"
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure defining one log-bucketed histogram
+typedef struct {
+    uint32_t buckets[STAGE_TIMING_NUM_BUCKETS];     ///< Number of durations per bucket
+    uint32_t count;                                 ///< Total number of recorded durations
+    uint32_t max_us;                                ///< Exact maximum recorded duration
+} stage_hist_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static uint32_t bucket_index(uint32_t us);
+static uint32_t bucket_upper_us(uint32_t idx);
+static void hist_add(stage_hist_t *h, uint32_t idx, uint32_t us);
+static uint32_t hist_percentile(const stage_hist_t *h, uint32_t permille);
+static void hist_summarize(const stage_hist_t *h, stage_timing_pct_t *out);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Stage names used in telemetry
+static const char *const s_stage_names[FC_STAGE_COUNT] = {
+    [FC_STAGE_CONV_START]  = "conv_start",
+    [FC_STAGE_CONV_WAIT]   = "conv_wait",
+    [FC_STAGE_REG_READ]    = "reg_read",
+    [FC_STAGE_CURRENT_ADC] = "current_adc",
+    [FC_STAGE_TEMP_ADC]    = "temp_adc",
+    [FC_STAGE_PUSH]        = "push",
+    [FC_STAGE_STATUS_READ] = "status_read",
+    [FC_STAGE_FLAGS_READ]  = "flags_read",
+    [FC_STAGE_TRACE]       = "trace",
+    [FC_STAGE_ROLLING]     = "rolling",
+    [FC_STAGE_CYCLE]       = "cycle",
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Histograms since boot
+static stage_hist_t s_boot_hist[FC_STAGE_COUNT];
+/// Histograms of the current reporting interval
+static stage_hist_t s_interval_hist[FC_STAGE_COUNT];
+/// Histograms of the last complete reporting interval
+static stage_hist_t s_last_hist[FC_STAGE_COUNT];
+/// Spinlock for protecting histogram access across cores
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function records one stage duration into the since-boot and interval histograms.
+/// Intended to be called from Core 1 real-time code, the work inside critical section is constant.
+///
+/// \param[in] stage Measured stage
+/// \param[in] duration_us Stage duration in microseconds
+/// \return None
+void stage_timing_record(fc_stage_t stage, uint32_t duration_us)
+{
+    if (stage >= FC_STAGE_COUNT) {
+        return;
+    }
+
+    uint32_t idx = bucket_index(duration_us);
+
+    taskENTER_CRITICAL(&s_lock);
+    hist_add(&s_boot_hist[stage], idx, duration_us);
+    hist_add(&s_interval_hist[stage], idx, duration_us);
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function ends the current reporting interval: its histograms become the last complete interval and a new
+/// interval starts. Called by the Fast Core every CONFIG_BMS_STAGE_TIMING_INTERVAL_MS; stages are switched one at a
+/// time under the spinlock.
+///
+/// \param None
+/// \return None
+void stage_timing_rotate_interval(void)
+{
+    for (int s = 0; s < FC_STAGE_COUNT; ++s) {
+        taskENTER_CRITICAL(&s_lock);
+        s_last_hist[s] = s_interval_hist[s];
+        memset(&s_interval_hist[s], 0, sizeof(s_interval_hist[s]));
+        taskEXIT_CRITICAL(&s_lock);
+    }
+
+    return;
+}
+
+/// This function computes p50/p99/max of all stages since boot and over the last complete reporting interval.
+/// Histograms are copied one stage at a time under the spinlock and evaluated outside of it. Reading does not
+/// change any histogram, so concurrent readers get the same values.
+///
+/// \param[out] out Array of ::FC_STAGE_COUNT summaries
+/// \return None
+void stage_timing_get_summary(stage_timing_summary_t out[FC_STAGE_COUNT])
+{
+    if (!out) {
+        return;
+    }
+
+    stage_hist_t boot;
+    stage_hist_t interval;
+
+    for (int s = 0; s < FC_STAGE_COUNT; ++s) {
+        taskENTER_CRITICAL(&s_lock);
+        boot     = s_boot_hist[s];
+        interval = s_last_hist[s];
+        taskEXIT_CRITICAL(&s_lock);
+
+        hist_summarize(&boot, &out[s].boot);
+        hist_summarize(&interval, &out[s].interval);
+    }
+
+    return;
+}
+
+/// This function returns the telemetry name of a stage.
+///
+/// \param[in] stage Stage identifier
+/// \return Stage name, or "unknown" for invalid identifier
+const char *stage_timing_name(fc_stage_t stage)
+{
+    if (stage >= FC_STAGE_COUNT) {
+        return "unknown";
+    }
+    return s_stage_names[stage];
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function maps a duration to its histogram bucket. Durations below 4 us map linearly, longer durations
+/// use the position of the most significant bit (octave) plus the two following bits (sub-bucket).
+///
+/// \param[in] us Duration in microseconds
+/// \return Bucket index (0 .. ::STAGE_TIMING_NUM_BUCKETS - 1)
+static uint32_t bucket_index(uint32_t us)
+{
+    if (us < STAGE_TIMING_SUB_BUCKETS) {
+        return us;
+    }
+
+    uint32_t msb = 31u - (uint32_t)__builtin_clz(us);
+    uint32_t idx = (msb - 1u) * STAGE_TIMING_SUB_BUCKETS + ((us >> (msb - 2u)) & (STAGE_TIMING_SUB_BUCKETS - 1u));
+    if (idx >= STAGE_TIMING_NUM_BUCKETS) {
+        idx = STAGE_TIMING_NUM_BUCKETS - 1u;
+    }
+    return idx;
+}
+
+/// This function returns the largest duration mapped to the given bucket.
+///
+/// \param[in] idx Bucket index
+/// \return Upper edge of the bucket in microseconds
+static uint32_t bucket_upper_us(uint32_t idx)
+{
+    if (idx < STAGE_TIMING_SUB_BUCKETS) {
+        return idx;
+    }
+
+    uint32_t msb   = idx / STAGE_TIMING_SUB_BUCKETS + 1u;
+    uint32_t sub   = idx % STAGE_TIMING_SUB_BUCKETS;
+    uint32_t width = 1u << (msb - 2u);
+    return ((STAGE_TIMING_SUB_BUCKETS + sub) << (msb - 2u)) + width - 1u;
+}
+
+/// This function adds one duration into a histogram.
+///
+/// \param[in,out] h Histogram
+/// \param[in] idx Precomputed bucket index of the duration
+/// \param[in] us Duration in microseconds
+/// \return None
+static void hist_add(stage_hist_t *h, uint32_t idx, uint32_t us)
+{
+    h->buckets[idx]++;
+    h->count++;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+
+    return;
+}
+
+/// This function finds the bucket containing the requested rank and returns its upper edge, limited by the
+/// exact maximum so the reported percentile never exceeds the observed maximum.
+///
+/// \param[in] h Histogram
+/// \param[in] permille Requested percentile in per mille (500 = p50, 990 = p99)
+/// \return Percentile in microseconds, 0 for empty histogram
+static uint32_t hist_percentile(const stage_hist_t *h, uint32_t permille)
+{
+    if (h->count == 0) {
+        return 0;
+    }
+
+    // Rank of the requested percentile (1-based, rounded up)
+    uint64_t rank = ((uint64_t)h->count * permille + 999u) / 1000u;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < STAGE_TIMING_NUM_BUCKETS; ++i) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = bucket_upper_us(i);
+            return (upper < h->max_us) ? upper : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+/// This function fills percentile summary of one histogram.
+///
+/// \param[in] h Histogram
+/// \param[out] out Summary
+/// \return None
+static void hist_summarize(const stage_hist_t *h, stage_timing_pct_t *out)
+{
+    out->count  = h->count;
+    out->p50_us = hist_percentile(h, 500);
+    out->p99_us = hist_percentile(h, 990);
+    out->max_us = h->max_us;
+
+    return;
+}
@@ -0,0 +1,86 @@
+/// Header file for `stage_timing.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_timer.h"
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Number of sub-buckets per power-of-two octave (2 bits of mantissa, max. relative bucket width 25 %)
+#define STAGE_TIMING_SUB_BUCKETS   4
+/// Number of histogram buckets. Covers 0 us up to 2^18 us (262 ms), longer durations fall into the last bucket.
+#define STAGE_TIMING_NUM_BUCKETS   68
+
+/// Length of the reporting interval in milliseconds. The Fast Core starts a new interval on this period, readers
+/// get the last complete one.
+#ifndef CONFIG_BMS_STAGE_TIMING_INTERVAL_MS
+#define CONFIG_BMS_STAGE_TIMING_INTERVAL_MS  10000
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Enumeration of measured Fast Core cycle stages
+typedef enum {
+    FC_STAGE_CONV_START = 0,    ///< LTC6804 ADCV command (cell conversion start)
+    FC_STAGE_CONV_WAIT,         ///< Waiting for LTC6804 cell conversion to complete
+    FC_STAGE_REG_READ,          ///< Reading and PEC checking of cell voltage register groups
+    FC_STAGE_CURRENT_ADC,       ///< Pack current read from ESP32 ADC
+    FC_STAGE_TEMP_ADC,          ///< Temperature read from ESP32 ADC including PT1000 conversion
+    FC_STAGE_PUSH,              ///< Push of sample into inter-core queue
+    FC_STAGE_STATUS_READ,       ///< Periodic LTC6804 status register read
+    FC_STAGE_FLAGS_READ,        ///< Per-cycle LTC6804 cell flag read and cross-check (only with hardware flags)
+    FC_STAGE_TRACE,             ///< Append of sample to trace recorder buffer (only when recording)
+    FC_STAGE_ROLLING,           ///< Update of sliding-window statistics
+    FC_STAGE_CYCLE,             ///< Whole Fast Core cycle (all stages above)
+    FC_STAGE_COUNT,             ///< Number of stages (not a stage)
+} fc_stage_t;
+
+/// Structure containing percentiles of one stage histogram
+typedef struct {
+    uint32_t count;             ///< Number of recorded durations
+    uint32_t p50_us;            ///< Median duration (upper edge of histogram bucket) in microseconds
+    uint32_t p99_us;            ///< 99th percentile duration (upper edge of histogram bucket) in microseconds
+    uint32_t max_us;            ///< Exact maximum duration in microseconds
+} stage_timing_pct_t;
+
+/// Structure containing summary of one stage since boot and over the last reporting interval
+typedef struct {
+    stage_timing_pct_t boot;    ///< Percentiles since boot
+    stage_timing_pct_t interval;///< Percentiles over the last complete reporting interval
+} stage_timing_summary_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void stage_timing_record(fc_stage_t stage, uint32_t duration_us);
+void stage_timing_rotate_interval(void);
+void stage_timing_get_summary(stage_timing_summary_t out[FC_STAGE_COUNT]);
+const char *stage_timing_name(fc_stage_t stage);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
+/// This function returns the current time in microseconds truncated to 32 bits. Differences of two values are
+/// valid for durations up to ~71 minutes, which is far more than any measured stage.
+///
+/// \param None
+/// \return Microseconds since boot (modulo 2^32)
+static inline uint32_t stage_timing_now_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
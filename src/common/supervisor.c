@@ -0,0 +1,447 @@
+/// This module implements the task supervisor. Monitored tasks post heartbeats into a fixed table, each slot is written
+/// only by its owning task, so posting a heartbeat takes no lock. A single supervisor task on Core 0 is the only task
+/// registered with the hardware TWDT and feeds it only when every registered heartbeat is younger than its deadline
+/// and no task requested a reset. A stalled task therefore lets the TWDT expire and reset the system.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "supervisor.h"
+#include "watchdog.h"
+#include "logging.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/portmacro.h"
+#include "esp_timer.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "SUPERVISOR"
+
+/// Supervisor task stack size in bytes
+#define SUPERVISOR_TASK_STACK  3072
+
+/// Supervisor check and TWDT feed period in milliseconds (half of TWDT timeout)
+#define SUPERVISOR_PERIOD_MS   (CONFIG_BMS_WDT_TIMEOUT_MS / 2)
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure defining one heartbeat slot. Fields marked volatile are written by the owning task only.
+typedef struct {
+    volatile bool     active;                   ///< Slot is registered and monitored
+    char              name[SUPERVISOR_NAME_LEN];///< Task name
+    volatile uint32_t period_us;                ///< Expected heartbeat period in microseconds
+    volatile uint32_t deadline_us;              ///< Maximum allowed heartbeat age in microseconds
+    volatile int64_t  last_us;                  ///< Time of last heartbeat (us since boot), accessed under s_lock
+    volatile uint32_t worst_late_us;            ///< Worst heartbeat lateness in microseconds
+} hb_slot_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void supervisor_task();
+static int64_t now_us(void);
+static int64_t slot_last_us(const hb_slot_t *slot);
+static uint32_t slot_age_us(const hb_slot_t *slot, int64_t now);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Heartbeat table
+static hb_slot_t s_slots[SUPERVISOR_MAX_TASKS];
+/// Spinlock protecting slot registration and heartbeat time stamps
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+/// Time when supervisor started checking. Heartbeats older than this count from this time.
+static volatile int64_t s_start_us = 0;
+/// Flag set by tasks requesting system reset. Supervisor stops feeding TWDT when set.
+static volatile bool s_reset_requested = false;
+/// Flag to signal supervisor task to exit gracefully
+static volatile bool s_should_exit = false;
+/// Requested check and TWDT feed period in milliseconds, applied by the supervisor task (TWDT timeout follows)
+static volatile uint32_t s_feed_period_ms = SUPERVISOR_PERIOD_MS;
+/// Supervisor task handle (needed for deletion)
+static TaskHandle_t s_supervisor_handle = NULL;
+
+#if CONFIG_BMS_STATIC_ALLOCATION
+/// Static stack of supervisor task
+static StackType_t s_supervisor_stack[SUPERVISOR_TASK_STACK];
+/// Static control block of supervisor task
+static StaticTask_t s_supervisor_tcb;
+#endif
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function creates supervisor task on Slow Core. Supervisor registers itself with TWDT, so it is created only
+/// after long initialization sequences are finished.
+///
+/// \param None
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t supervisor_start(void)
+{
+    BaseType_t result;
+
+    s_start_us = now_us();
+
+    // Higher priority than Slow Core task to ensure supervisor runs even when Slow Core task is busy
+#if CONFIG_BMS_STATIC_ALLOCATION
+    s_supervisor_handle = xTaskCreateStaticPinnedToCore(supervisor_task, "supervisor_task", SUPERVISOR_TASK_STACK,
+                                                        NULL, 5, s_supervisor_stack, &s_supervisor_tcb, 0);
+    result = s_supervisor_handle ? pdPASS : pdFAIL;
+#else
+    result = xTaskCreatePinnedToCore(supervisor_task, "supervisor_task", SUPERVISOR_TASK_STACK, NULL, 5,
+                                     &s_supervisor_handle, 0);
+#endif
+    if (result != pdPASS) {
+        BMS_LOGE("Failed to create supervisor task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/// This function deletes supervisor task. Task will unregister from TWDT gracefully before deletion.
+///
+/// \param None
+/// \return None
+void supervisor_stop(void)
+{
+    if (s_supervisor_handle) {
+        BMS_LOGI("Signaling supervisor to exit gracefully");
+        s_should_exit = true;
+
+        // Wait for task to exit gracefully (up to 200ms)
+        for (int i = 0; i < 4; i++) {
+            if (!s_supervisor_handle) {
+                break;  // Task exited
+            }
+            vTaskDelay(pdMS_TO_TICKS(50));
+        }
+
+        // Force delete if still running.
+        if (s_supervisor_handle) {
+            BMS_LOGW("Force deleting supervisor task (didn't exit gracefully)");
+            vTaskDelete(s_supervisor_handle);
+            s_supervisor_handle = NULL;
+        }
+
+        // Reset flags for potential restart
+        s_reset_requested = false;
+        s_should_exit = false;
+
+        BMS_LOGI("Supervisor cleaned up");
+    }
+
+    return;
+}
+
+/// This function registers a task for heartbeat monitoring. The first heartbeat is counted from registration.
+///
+/// \param[in] name Task name used in logs and telemetry
+/// \param[in] period_ms Expected heartbeat period in milliseconds, used for lateness statistics
+/// \param[in] deadline_ms Maximum allowed heartbeat age in milliseconds before TWDT feeding stops
+/// \return Heartbeat slot identifier, or ::SUPERVISOR_INVALID_ID if table is full
+int supervisor_register(const char *name, uint32_t period_ms, uint32_t deadline_ms)
+{
+    int id = SUPERVISOR_INVALID_ID;
+
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < SUPERVISOR_MAX_TASKS; ++i) {
+        if (!s_slots[i].active) {
+            hb_slot_t *slot = &s_slots[i];
+            strncpy(slot->name, name ? name : "?", SUPERVISOR_NAME_LEN - 1);
+            slot->name[SUPERVISOR_NAME_LEN - 1] = '\0';
+            slot->period_us     = period_ms * 1000u;
+            slot->deadline_us   = deadline_ms * 1000u;
+            slot->last_us       = now_us();
+            slot->worst_late_us = 0;
+            // Publish slot as the last step, supervisor reads only active slots
+            slot->active        = true;
+            id = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (id == SUPERVISOR_INVALID_ID) {
+        BMS_LOGE("Supervisor table full, task \"%s\" not monitored", name ? name : "?");
+    } else {
+        BMS_LOGI("Task \"%s\" supervised: period=%lu ms, deadline=%lu ms",
+                 s_slots[id].name, (unsigned long)period_ms, (unsigned long)deadline_ms);
+    }
+
+    return id;
+}
+
+/// This function removes a task from heartbeat monitoring. Call before deleting the task.
+///
+/// \param[in] id Heartbeat slot identifier returned by ::supervisor_register
+/// \return None
+void supervisor_unregister(int id)
+{
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_slots[id].active = false;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function posts a heartbeat of the calling task. Each slot has a single writer (its owning task), so the task
+/// reads its own time stamp without a lock. A 64-bit store is two 32-bit stores on ESP32, so the new stamp is
+/// written under the lock; a reader on the other core cannot see one half updated.
+///
+/// \param[in] id Heartbeat slot identifier returned by ::supervisor_register
+/// \return None
+void supervisor_heartbeat(int id)
+{
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return;
+    }
+
+    hb_slot_t *slot = &s_slots[id];
+    int64_t now = now_us();
+    int64_t gap = now - slot->last_us;
+
+    if (gap > (int64_t)slot->period_us) {
+        int64_t late64 = gap - (int64_t)slot->period_us;
+        uint32_t late = (late64 > UINT32_MAX) ? UINT32_MAX : (uint32_t)late64;
+        if (late > slot->worst_late_us) {
+            slot->worst_late_us = late;
+        }
+    }
+    taskENTER_CRITICAL(&s_lock);
+    slot->last_us = now;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function changes the expected heartbeat period of the calling task (e.g. when the task degrades its rate).
+/// Must be called by the owning task only.
+///
+/// \param[in] id Heartbeat slot identifier returned by ::supervisor_register
+/// \param[in] period_ms New expected heartbeat period in milliseconds
+/// \return None
+void supervisor_set_period(int id, uint32_t period_ms)
+{
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return;
+    }
+
+    s_slots[id].period_us = period_ms * 1000u;
+
+    return;
+}
+
+/// This function changes the maximum allowed heartbeat age of the calling task (e.g. when the task lengthens its
+/// period in low-power mode). Must be called by the owning task only.
+///
+/// \param[in] id Heartbeat slot identifier returned by ::supervisor_register
+/// \param[in] deadline_ms New maximum allowed heartbeat age in milliseconds
+/// \return None
+void supervisor_set_deadline(int id, uint32_t deadline_ms)
+{
+    if (id < 0 || id >= SUPERVISOR_MAX_TASKS) {
+        return;
+    }
+
+    s_slots[id].deadline_us = deadline_ms * 1000u;
+
+    return;
+}
+
+/// This function changes the supervisor check and TWDT feed period. The supervisor applies it on its next wakeup
+/// and sets the TWDT timeout to twice the period, so a long period lets the CPU sleep between checks. Heartbeat
+/// deadlines of supervised tasks must be adapted by the tasks themselves.
+///
+/// \param[in] period_ms New period in milliseconds, 0 restores the nominal period
+/// \return None
+void supervisor_set_feed_period(uint32_t period_ms)
+{
+    s_feed_period_ms = period_ms ? period_ms : SUPERVISOR_PERIOD_MS;
+
+    return;
+}
+
+/// This function requests system reset. Supervisor stops feeding TWDT, which then expires and resets the system.
+///
+/// \param[in] reason Reason logged as error (kept in reset message of telemetry)
+/// \return None
+void supervisor_request_reset(const char *reason)
+{
+    if (!s_reset_requested) {
+        BMS_LOGE("Reset requested: %s", reason ? reason : "unknown");
+    }
+    s_reset_requested = true;
+
+    return;
+}
+
+/// This function copies heartbeat status of all registered tasks.
+///
+/// \param[out] out Array to receive status entries
+/// \param[in] max_count Capacity of output array
+/// \return Number of entries written
+size_t supervisor_get_status(supervisor_status_t *out, size_t max_count)
+{
+    if (!out) {
+        return 0;
+    }
+
+    size_t count = 0;
+    int64_t now = now_us();
+
+    for (int i = 0; i < SUPERVISOR_MAX_TASKS && count < max_count; ++i) {
+        const hb_slot_t *slot = &s_slots[i];
+        if (!slot->active) {
+            continue;
+        }
+        memcpy(out[count].name, slot->name, SUPERVISOR_NAME_LEN);
+        out[count].age_ms        = slot_age_us(slot, now) / 1000u;
+        out[count].deadline_ms   = slot->deadline_us / 1000u;
+        out[count].worst_late_ms = slot->worst_late_us / 1000u;
+        count++;
+    }
+
+    return count;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// Supervisor task. Periodically checks age of all heartbeats and feeds TWDT only if all of them are within their
+/// deadlines and no reset was requested. Otherwise feeding is skipped, allowing TWDT to expire and reset the system.
+///
+/// \param None
+/// \return None
+static void supervisor_task()
+{
+    // Register current task with TWDT. If registration fails, delete task.
+    if (bms_wdt_register_current_task() != ESP_OK) {
+        BMS_LOGE("Failed to register supervisor to TWDT");
+        s_supervisor_handle = NULL;
+        vTaskDelete(NULL);
+    }
+
+    uint32_t period_ms = SUPERVISOR_PERIOD_MS;
+    TickType_t period = pdMS_TO_TICKS(period_ms);
+    TickType_t last_wake = xTaskGetTickCount();
+    // Stale state of each slot, used to log transition only once
+    bool stale_reported[SUPERVISOR_MAX_TASKS] = {false};
+
+    while (!s_should_exit)
+    {
+        int64_t now = now_us();
+        bool healthy = !s_reset_requested;
+
+        for (int i = 0; i < SUPERVISOR_MAX_TASKS; ++i) {
+            const hb_slot_t *slot = &s_slots[i];
+            if (!slot->active) {
+                stale_reported[i] = false;
+                continue;
+            }
+
+            uint32_t age = slot_age_us(slot, now);
+            if (age > slot->deadline_us) {
+                healthy = false;
+                if (!stale_reported[i]) {
+                    BMS_LOGE("Task \"%s\" heartbeat stale (%lu ms > %lu ms), stopping HW WD feed",
+                             slot->name, (unsigned long)(age / 1000u), (unsigned long)(slot->deadline_us / 1000u));
+                    stale_reported[i] = true;
+                }
+            } else {
+                stale_reported[i] = false;
+            }
+        }
+
+        if (healthy) {
+            if (bms_wdt_feed_self() != ESP_OK) {
+                BMS_LOGE("HW WD feed failed (supervisor)");
+            }
+        }
+
+        // Apply requested feed period. TWDT timeout is changed right after a feed, so it never expires in between.
+        uint32_t requested_ms = s_feed_period_ms;
+        if (requested_ms != period_ms && healthy) {
+            uint32_t timeout_ms = (requested_ms == SUPERVISOR_PERIOD_MS) ? CONFIG_BMS_WDT_TIMEOUT_MS
+                                                                           : 2u * requested_ms;
+            if (bms_wdt_set_timeout(timeout_ms) == ESP_OK) {
+                period_ms = requested_ms;
+                period = pdMS_TO_TICKS(period_ms);
+                last_wake = xTaskGetTickCount();
+            }
+        }
+
+        // Put task into blocked state until next absolute period
+        vTaskDelayUntil(&last_wake, period);
+    }
+
+    // Unregister from TWDT before exiting to prevent watchdog trigger
+    BMS_LOGI("Supervisor unregistering from TWDT and exiting gracefully");
+    bms_wdt_unregister_current_task();
+    s_supervisor_handle = NULL;
+    vTaskDelete(NULL);
+
+    return;
+}
+
+/// This function returns current time in microseconds.
+///
+/// \param None
+/// \return Microseconds since boot
+static int64_t now_us(void)
+{
+    return esp_timer_get_time();
+}
+
+/// This function reads the heartbeat time stamp of a slot written by another core. A 64-bit access is two 32-bit
+/// accesses on ESP32, so the stamp is read under the lock it is written with.
+///
+/// \param[in] slot Heartbeat slot
+/// \return Time of last heartbeat in microseconds since boot
+static int64_t slot_last_us(const hb_slot_t *slot)
+{
+    taskENTER_CRITICAL(&s_lock);
+    int64_t last = slot->last_us;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return last;
+}
+
+/// This function returns heartbeat age of a slot. Heartbeat posted after `now` was sampled counts as age 0, and ages
+/// are limited to time since supervisor start, so tasks are not blamed for initialization before supervision began.
+/// All times are 64-bit, so ages are exact for the whole uptime.
+///
+/// \param[in] slot Heartbeat slot
+/// \param[in] now Current time in microseconds
+/// \return Heartbeat age in microseconds (saturated at UINT32_MAX)
+static uint32_t slot_age_us(const hb_slot_t *slot, int64_t now)
+{
+    int64_t age = now - slot_last_us(slot);
+    if (age < 0) {
+        age = 0;
+    }
+
+    int64_t since_start = now - s_start_us;
+    if (age > since_start) {
+        age = since_start;
+    }
+
+    return (age > UINT32_MAX) ? UINT32_MAX : (uint32_t)age;
+}
@@ -0,0 +1,60 @@
+/// Header file for `supervisor.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Maximum number of tasks monitored by supervisor
+#define SUPERVISOR_MAX_TASKS     4
+
+/// Maximum length of monitored task name (including terminating zero)
+#define SUPERVISOR_NAME_LEN      16
+
+/// Invalid heartbeat slot identifier
+#define SUPERVISOR_INVALID_ID    (-1)
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure containing heartbeat status of one monitored task
+typedef struct {
+    char     name[SUPERVISOR_NAME_LEN];     ///< Task name
+    uint32_t age_ms;                        ///< Time since last heartbeat in milliseconds
+    uint32_t deadline_ms;                   ///< Maximum allowed heartbeat age in milliseconds
+    uint32_t worst_late_ms;                 ///< Worst heartbeat lateness against expected period in milliseconds
+} supervisor_status_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+esp_err_t supervisor_start(void);
+void supervisor_stop(void);
+int supervisor_register(const char *name, uint32_t period_ms, uint32_t deadline_ms);
+void supervisor_unregister(int id);
+void supervisor_heartbeat(int id);
+void supervisor_set_period(int id, uint32_t period_ms);
+void supervisor_set_deadline(int id, uint32_t deadline_ms);
+void supervisor_set_feed_period(uint32_t period_ms);
+void supervisor_request_reset(const char *reason);
+size_t supervisor_get_status(supervisor_status_t *out, size_t max_count);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -8,6 +8,8 @@
 #include "esp_mac.h"
 #include "esp_app_desc.h"
 #include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -19,6 +21,13 @@
 /// Log module tag used by logging module
 #define LOG_MODULE_TAG "TELEMETRY"
 
+/// Uptime in seconds after which minimum free heap is recorded as baseline. By then WiFi, MQTT and HTTP server
+/// have allocated their long-lived buffers, so later decrease of minimum free heap indicates runtime growth.
+#define HEAP_BASELINE_DELAY_S  120
+
+/// Capacity of static task status array used for CPU load measurement in static allocation mode
+#define TELEMETRY_MAX_TASKS  24
+
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -49,6 +58,13 @@ static ltc6804_status_t s_ltc_status = {0};
 static portMUX_TYPE s_ltc_status_lock = portMUX_INITIALIZER_UNLOCKED;
 /// Cached reset message (populated once at boot)
 static char s_reset_msg[RESET_MSG_MAXLEN] = {0};
+/// Minimum free heap when steady state was reached (0 until ::HEAP_BASELINE_DELAY_S elapsed)
+static uint32_t s_heap_baseline = 0;
+
+#if CONFIG_BMS_STATIC_ALLOCATION
+/// Static task status array used for CPU load measurement
+static TaskStatus_t s_task_array[TELEMETRY_MAX_TASKS];
+#endif
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -151,6 +167,15 @@ void telemetry_get_esp32_telemetry(esp32_telemetry_t *telem)
     telem->cpu_load = get_cpu_load();
     telem->free_heap = esp_get_free_heap_size();
     telem->min_free_heap = esp_get_minimum_free_heap_size();
+    telem->largest_free_block = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    telem->uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    // Heap stability: record baseline once steady state is reached, then report drift against it
+    if (s_heap_baseline == 0 && telem->uptime_s >= HEAP_BASELINE_DELAY_S) {
+        s_heap_baseline = telem->min_free_heap;
+        BMS_LOGI("Heap baseline: min free %lu bytes", (unsigned long)s_heap_baseline);
+    }
+    telem->heap_baseline = s_heap_baseline;
+    telem->heap_drift = s_heap_baseline ? (int32_t)(s_heap_baseline - telem->min_free_heap) : 0;
     telem->reset_reason = (uint8_t)esp_reset_reason();
     snprintf(telem->reset_msg, sizeof(telem->reset_msg), "%s", s_reset_msg);
 
@@ -198,6 +223,32 @@ void telemetry_update_ltc6804_status(const uint8_t stata[6], const uint8_t statb
     return;
 }
 
+/// Function updates cached LTC6804 cell flags from the per-cycle flag read and counts disagreements between flags
+/// and software limits. Intended to be called from Core 1 after ltc6804_read_cell_flags().
+///
+/// \param[in] flags          UV/OV flags of cells 0-11 in STATB layout (bytes 2-4)
+/// \param[in] mismatch_cells Number of cells where flags disagree with software limits, 0 if they agree
+/// \param[in] first_cell     First disagreeing cell (ignored if mismatch_cells is 0)
+/// \param[in] valid          True if the flags were read successfully (other arguments ignored otherwise)
+/// \return None
+void telemetry_update_ltc6804_flags(uint32_t flags, uint16_t mismatch_cells, uint16_t first_cell, bool valid)
+{
+    taskENTER_CRITICAL(&s_ltc_status_lock);
+    if (valid) {
+        s_ltc_status.cell_flags = flags;
+        if (mismatch_cells) {
+            s_ltc_status.flag_mismatches++;
+            s_ltc_status.flag_mismatch_cells = mismatch_cells;
+            s_ltc_status.flag_mismatch_first = first_cell;
+        }
+    } else {
+        s_ltc_status.flag_read_errors++;
+    }
+    taskEXIT_CRITICAL(&s_ltc_status_lock);
+
+    return;
+}
+
 /*==============================================================================================================*/
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
@@ -219,9 +270,15 @@ static uint8_t get_cpu_load(void)
     UBaseType_t num_tasks = uxTaskGetNumberOfTasks();
     if (num_tasks == 0) return 0;
     
+#if CONFIG_BMS_STATIC_ALLOCATION
+    // Use static array for task status
+    if (num_tasks > TELEMETRY_MAX_TASKS) return 0;
+    TaskStatus_t *task_array = s_task_array;
+#else
     // Allocate array for task status
     TaskStatus_t *task_array = pvPortMalloc(num_tasks * sizeof(TaskStatus_t));
     if (!task_array) return 0;
+#endif
     
     // Get runtime stats for all tasks
     uint32_t total_runtime;
@@ -236,7 +293,9 @@ static uint8_t get_cpu_load(void)
         }
     }
     
+#if !CONFIG_BMS_STATIC_ALLOCATION
     vPortFree(task_array);
+#endif
     
     // Calculate CPU load using delta since last measurement
     uint8_t load = 0;
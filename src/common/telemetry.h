@@ -26,6 +26,10 @@ typedef struct {
     uint8_t cpu_load;                   ///< CPU load percentage (0-100)
     uint32_t free_heap;                 ///< Free heap memory in bytes
     uint32_t min_free_heap;             ///< Minimum free heap since boot in bytes
+    uint32_t largest_free_block;        ///< Largest allocatable heap block in bytes (fragmentation indicator)
+    uint32_t heap_baseline;             ///< Minimum free heap at steady state baseline in bytes (0 if not set)
+    int32_t  heap_drift;                ///< Decrease of minimum free heap since baseline in bytes
+    uint32_t uptime_s;                  ///< Time since boot in seconds
     uint8_t reset_reason;               ///< Last reset reason (esp_reset_reason_t)
     char reset_msg[RESET_MSG_MAXLEN];   ///< Last 5 error logs before TWDT reset (empty if other reset reason)
 } esp32_telemetry_t;
@@ -39,6 +43,10 @@ typedef struct {
     uint32_t cell_flags;    ///< Cell UV/OV flags 24-bit (STATB bytes 2-4)
                             ///< Bit layout per byte: CnOV CnUV ... C1OV C1UV
     uint8_t  diag;          ///< Diagnostic byte (STATB byte 5): REV[7:4] RSVD[3:2] MUXFAIL[1] THSD[0]
+    uint32_t flag_mismatches;     ///< Cycles where cell flags disagreed with software limits (since boot)
+    uint16_t flag_mismatch_cells; ///< Number of cells disagreeing in the last mismatch
+    uint16_t flag_mismatch_first; ///< First cell disagreeing in the last mismatch
+    uint32_t flag_read_errors;    ///< Failed per-cycle cell flag reads (since boot)
     bool     valid;         ///< Flag identifying if status registers were read successfully
 } ltc6804_status_t;
 
@@ -59,6 +67,7 @@ void telemetry_get_sw_version(char *ver_buf, size_t buf_size);
 void telemetry_get_esp32_telemetry(esp32_telemetry_t *telem);
 void telemetry_get_ltc6804_status(ltc6804_status_t *status);
 void telemetry_update_ltc6804_status(const uint8_t stata[6], const uint8_t statb[6], bool valid);
+void telemetry_update_ltc6804_flags(uint32_t flags, uint16_t mismatch_cells, uint16_t first_cell, bool valid);
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
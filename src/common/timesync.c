@@ -0,0 +1,195 @@
+/// This module synchronizes the device to UTC with SNTP and provides the mapping from local time (esp_timer) to UTC
+/// for sample stamps and for wall-clock aligned Fast Core cycles.
+///
+/// The ESP-IDF SNTP client queries CONFIG_BMS_TIMESYNC_SERVER every CONFIG_BMS_TIMESYNC_INTERVAL_S and, after
+/// compensating the round trip, reports the server time. Each report is paired with the local time of the callback
+/// and applied to the clock mapping (`clock_map.c`), which estimates crystal drift and slews small offsets, so
+/// mapped time neither jumps nor runs backwards between syncs. The system time (gettimeofday) is set by SNTP as
+/// well, but it is stepped on every sync and is not used for stamps. Between syncs and after losing the server, the
+/// mapping continues with the last drift estimate (holdover).
+///
+/// The mapping is written by the SNTP callback (lwIP task) and read by the Fast Core and the Slow Core, a spinlock
+/// protects it.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "timesync.h"
+#include "clock_map.h"
+#include "logging.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_netif_sntp.h"
+#include "esp_sntp.h"
+#include <sys/time.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "BMS_TIMESYNC"
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void sync_cb(struct timeval *tv);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Mapping from local time to UTC
+static bms_clock_t s_clock;
+/// Local time of the last sync sample (us since boot)
+static int64_t s_last_sync_us = 0;
+/// Largest wake error at a wall-clock edge since the previous status read (us)
+static uint32_t s_wake_max_us = 0;
+/// Flag indicating the SNTP client was started
+static bool s_started = false;
+/// Spinlock protecting mapping and wake statistics across cores
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function starts the SNTP client. Requests are sent once the station has an IP address, so it can be called
+/// right after Wi-Fi initialization. Called in station mode only.
+///
+/// \param None
+/// \return ESP_OK on success, otherwise an error code of the SNTP client
+esp_err_t bms_timesync_start(void)
+{
+    if (s_started) {
+        return ESP_OK;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bms_clock_init(&s_clock);
+    taskEXIT_CRITICAL(&s_lock);
+
+    sntp_set_sync_interval(CONFIG_BMS_TIMESYNC_INTERVAL_S * 1000u);
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_BMS_TIMESYNC_SERVER);
+    config.sync_cb = sync_cb;
+    esp_err_t ret = esp_netif_sntp_init(&config);
+    if (ret != ESP_OK) {
+        BMS_LOGE("Failed to start SNTP: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_started = true;
+
+    BMS_LOGI("Time sync started (server %s, every %u s)", CONFIG_BMS_TIMESYNC_SERVER,
+             (unsigned)CONFIG_BMS_TIMESYNC_INTERVAL_S);
+    return ESP_OK;
+}
+
+/// This function converts local time to UTC.
+///
+/// \param[in]  mono_us  Local time (us since boot, esp_timer_get_time())
+/// \param[out] epoch_us UTC (us since the Unix epoch)
+/// \return True on success, false if the device was not synchronized yet (epoch_us is not changed)
+bool bms_timesync_to_epoch_us(int64_t mono_us, int64_t *epoch_us)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool ok = bms_clock_to_epoch(&s_clock, mono_us, epoch_us);
+    taskEXIT_CRITICAL(&s_lock);
+
+    return ok;
+}
+
+/// This function finds the next wall-clock edge of a period (first whole multiple of it in UTC) after a local time.
+///
+/// \param[in]  mono_us       Local time (us since boot)
+/// \param[in]  period_us     Period (us)
+/// \param[out] edge_epoch_us UTC of the edge (us since the Unix epoch)
+/// \param[out] edge_mono_us  Local time of the edge (us since boot)
+/// \return True on success, false if the device was not synchronized yet (outputs are not changed)
+bool bms_timesync_next_edge(int64_t mono_us, uint32_t period_us, int64_t *edge_epoch_us, int64_t *edge_mono_us)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool ok = bms_clock_next_edge(&s_clock, mono_us, period_us, edge_epoch_us, edge_mono_us);
+    taskEXIT_CRITICAL(&s_lock);
+
+    return ok;
+}
+
+/// This function records the error of a wake at a wall-clock edge (mapped wake time minus edge) for telemetry.
+///
+/// \param[in] err_us Wake error (us)
+/// \return None
+void bms_timesync_record_wake(int64_t err_us)
+{
+    uint32_t abs_us = (uint32_t)((err_us < 0) ? -err_us : err_us);
+
+    taskENTER_CRITICAL(&s_lock);
+    if (abs_us > s_wake_max_us) {
+        s_wake_max_us = abs_us;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function gets the synchronization status. The largest wake error restarts with every call.
+///
+/// \param[out] out Status
+/// \return None
+void bms_timesync_get_status(bms_timesync_status_t *out)
+{
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    out->synced      = s_clock.valid;
+    out->syncs       = s_clock.syncs;
+    out->steps       = s_clock.steps;
+    out->drift_ppb   = s_clock.drift_ppb;
+    out->offset_us   = (int32_t)s_clock.last_err_us;
+    out->age_s       = s_clock.valid ? (uint32_t)((now - s_last_sync_us) / 1000000) : 0;
+    out->wake_max_us = s_wake_max_us;
+    s_wake_max_us = 0;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// SNTP sync callback. Pairs the reported server time with the local time and applies it to the mapping.
+///
+/// \param[in] tv Server time, round trip compensated
+/// \return None
+static void sync_cb(struct timeval *tv)
+{
+    int64_t mono = esp_timer_get_time();
+    int64_t epoch = (int64_t)tv->tv_sec * 1000000LL + (int64_t)tv->tv_usec;
+
+    taskENTER_CRITICAL(&s_lock);
+    bool first = !s_clock.valid;
+    uint32_t steps = s_clock.steps;
+    int64_t err = bms_clock_sync(&s_clock, mono, epoch);
+    bool stepped = (s_clock.steps != steps);
+    int32_t drift = s_clock.drift_ppb;
+    s_last_sync_us = mono;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (first) {
+        BMS_LOGI("Clock synchronized to %s", CONFIG_BMS_TIMESYNC_SERVER);
+    } else if (stepped) {
+        BMS_LOGW("Clock stepped by %lld us", (long long)err);
+    } else {
+        BMS_LOGD("Clock offset %lld us, drift %ld ppb", (long long)err, (long)drift);
+    }
+
+    return;
+}
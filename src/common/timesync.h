@@ -0,0 +1,64 @@
+/// Header file for `timesync.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Enables wall-clock time synchronization (SNTP), UTC sample stamps and statistics windows aligned to UTC seconds
+#ifndef CONFIG_BMS_TIMESYNC
+#define CONFIG_BMS_TIMESYNC             0
+#endif
+
+/// NTP server (host name or IP address, e.g. a local NTP server on the broker host)
+#ifndef CONFIG_BMS_TIMESYNC_SERVER
+#define CONFIG_BMS_TIMESYNC_SERVER      "pool.ntp.org"
+#endif
+
+/// Interval between SNTP requests (s)
+#ifndef CONFIG_BMS_TIMESYNC_INTERVAL_S
+#define CONFIG_BMS_TIMESYNC_INTERVAL_S  60
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of time synchronization status reported in telemetry
+typedef struct {
+    bool     synced;            ///< Flag indicating UTC is known (at least one sync since boot)
+    uint32_t syncs;             ///< Number of sync samples since boot
+    uint32_t steps;             ///< Number of offsets too large for slewing since the first sync
+    int32_t  drift_ppb;         ///< Estimated rate of UTC against the local clock minus one (ppb)
+    int32_t  offset_us;         ///< Offset of the last sync sample from the mapping (us)
+    uint32_t age_s;             ///< Time since the last sync sample (s)
+    uint32_t wake_max_us;       ///< Largest wake error at a wall-clock edge since the previous status read (us)
+} bms_timesync_status_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+esp_err_t bms_timesync_start(void);
+bool bms_timesync_to_epoch_us(int64_t mono_us, int64_t *epoch_us);
+bool bms_timesync_next_edge(int64_t mono_us, uint32_t period_us, int64_t *edge_epoch_us, int64_t *edge_mono_us);
+void bms_timesync_record_wake(int64_t err_us);
+void bms_timesync_get_status(bms_timesync_status_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -20,11 +20,6 @@
 /// Log module tag used by logging module
 #define LOG_MODULE_TAG "BMS_WDT"
 
-/// Global TWDT timeout in milliseconds.
-#ifndef CONFIG_BMS_WDT_TIMEOUT_MS
-#define CONFIG_BMS_WDT_TIMEOUT_MS 80
-#endif
-
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -130,6 +125,27 @@ esp_err_t bms_wdt_unregister_current_task(void)
     return ESP_OK;
 }
 
+/// This function changes the TWDT timeout (e.g. when the feeding task lengthens its period in low-power mode).
+///
+/// \param[in] timeout_ms New timeout in milliseconds
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t bms_wdt_set_timeout(uint32_t timeout_ms)
+{
+    esp_task_wdt_config_t twdt_config = {
+        .timeout_ms = timeout_ms,
+        .idle_core_mask = 0,
+        .trigger_panic = true
+    };
+
+    esp_err_t err = esp_task_wdt_reconfigure(&twdt_config);
+    if (err != ESP_OK) {
+        BMS_LOGE("esp_task_wdt_reconfigure failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    BMS_LOGI("Task WDT timeout changed to %lu ms", (unsigned long)timeout_ms);
+    return ESP_OK;
+}
+
 /// This function deinitializes the Task Watchdog Timer (TWDT) subsystem.
 /// Call this to completely disable watchdog monitoring. All tasks must be
 /// unregistered before calling this function, otherwise it will return an error.
@@ -8,10 +8,15 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_err.h"
+#include "sdkconfig.h"
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
 /*==============================================================================================================*/
+/// Global TWDT timeout in milliseconds.
+#ifndef CONFIG_BMS_WDT_TIMEOUT_MS
+#define CONFIG_BMS_WDT_TIMEOUT_MS 80
+#endif
 
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
@@ -31,6 +36,7 @@
 esp_err_t bms_wdt_init(void);
 esp_err_t bms_wdt_register_current_task(void);
 esp_err_t bms_wdt_feed_self(void);
+esp_err_t bms_wdt_set_timeout(uint32_t timeout_ms);
 esp_err_t bms_wdt_unregister_current_task(void);
 esp_err_t bms_wdt_deinit(void);
 
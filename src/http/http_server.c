@@ -19,7 +19,12 @@
 #include "stats_history.h"
 #include "configuration.h"
 #include "bms_data.h"
+#include "ltc6804_calib.h"
 #include "cJSON.h"
+#include "json_arena.h"
+#include "boot_bench.h"
+#include "stress.h"
+#include "rolling_stats.h"
 #include "wifi.h"
 #include "led_control.h"
 
@@ -29,6 +34,32 @@
 /// Log module tag used by logging module
 #define LOG_MODULE_TAG "BMS_HTTP"
 
+/// Size of the configuration data JSON response buffer (all configuration strings at full length fit with room
+/// for escaping)
+#define CONFIG_DATA_JSON_MAXLEN  1024
+
+/// Size of the calibration data JSON response buffer (gain, offset and both reference points of every channel)
+#define CALIB_DATA_JSON_MAXLEN   (544 + 40 * LTC6804_CALIB_CHANNELS)
+
+/// Size of the rolling statistics JSON response buffer (average, minimum and maximum of every cell)
+#define ROLLING_DATA_JSON_MAXLEN (736 + 24 * BMS_MAX_CELLS)
+
+/// Appends formatted text to response buffer buf (an array) at offset off. A truncated write leaves off at
+/// sizeof(buf), so later appends write nothing and the handler can check for truncation once at the end.
+#define RESP_APPEND(off, buf, ...)                                                  \
+    do {                                                                            \
+        int _ret = snprintf((buf) + (off), sizeof(buf) - (off), __VA_ARGS__);       \
+        if (_ret < 0 || (off) + (size_t)_ret >= sizeof(buf)) {                      \
+            (off) = sizeof(buf);                                                    \
+        } else {                                                                    \
+            (off) += (size_t)_ret;                                                  \
+        }                                                                           \
+    } while (0)
+
+/// HTTP server task stack size in bytes, grows with the response buffers (calibration, latest statistics window) of
+/// a layout beyond 12 cells
+#define HTTPD_STACK_SIZE         (8192 + 40 * (BMS_MAX_CELLS - 12) + BMS_STATS_JSON_CELLS_LEN)
+
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -61,6 +92,13 @@ static esp_err_t h_stats_data(httpd_req_t *req);
 static esp_err_t h_led_on(httpd_req_t *req);
 static esp_err_t h_led_off(httpd_req_t *req);
 static esp_err_t h_led_status(httpd_req_t *req);
+static esp_err_t h_bench_data(httpd_req_t *req);
+static esp_err_t h_stress_data(httpd_req_t *req);
+static esp_err_t h_calib_data(httpd_req_t *req);
+static esp_err_t h_calib_post(httpd_req_t *req);
+#if CONFIG_BMS_ROLLING
+static esp_err_t h_rolling_data(httpd_req_t *req);
+#endif
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
@@ -94,9 +132,9 @@ esp_err_t http_server_start(void)
     httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
     cfg.lru_purge_enable = true;
     cfg.core_id = 0;
-    cfg.stack_size = 8192;
+    cfg.stack_size = HTTPD_STACK_SIZE;
     cfg.task_priority = 4;
-    cfg.max_uri_handlers = 20;
+    cfg.max_uri_handlers = 24;
 
     if (httpd_start(&s_httpd, &cfg) != ESP_OK) {
         s_httpd = NULL;
@@ -122,6 +160,13 @@ esp_err_t http_server_start(void)
     httpd_uri_t u_led_on        = { .uri = "/bms/led/on",           .method = HTTP_POST, .handler = h_led_on };
     httpd_uri_t u_led_off       = { .uri = "/bms/led/off",          .method = HTTP_POST, .handler = h_led_off };
     httpd_uri_t u_led_status    = { .uri = "/bms/led/status",       .method = HTTP_GET,  .handler = h_led_status };
+    httpd_uri_t u_bench         = { .uri = "/bms/bench",            .method = HTTP_GET,  .handler = h_bench_data };
+    httpd_uri_t u_stress        = { .uri = "/bms/stress",           .method = HTTP_GET,  .handler = h_stress_data };
+    httpd_uri_t u_calib         = { .uri = "/bms/calib",            .method = HTTP_GET,  .handler = h_calib_data };
+    httpd_uri_t u_calib_post    = { .uri = "/bms/calib",            .method = HTTP_POST, .handler = h_calib_post };
+#if CONFIG_BMS_ROLLING
+    httpd_uri_t u_rolling       = { .uri = "/bms/rolling",          .method = HTTP_GET,  .handler = h_rolling_data };
+#endif
     
     httpd_register_uri_handler(s_httpd, &u_root);
     httpd_register_uri_handler(s_httpd, &u_bms);
@@ -142,6 +187,18 @@ esp_err_t http_server_start(void)
     httpd_register_uri_handler(s_httpd, &u_led_on);
     httpd_register_uri_handler(s_httpd, &u_led_off);
     httpd_register_uri_handler(s_httpd, &u_led_status);
+    httpd_register_uri_handler(s_httpd, &u_bench);
+    httpd_register_uri_handler(s_httpd, &u_stress);
+    httpd_register_uri_handler(s_httpd, &u_calib);
+    httpd_register_uri_handler(s_httpd, &u_calib_post);
+#if CONFIG_BMS_ROLLING
+    httpd_register_uri_handler(s_httpd, &u_rolling);
+#endif
+
+#if CONFIG_BMS_STRESS
+    // The stress sweep runs after the server starts and exercises the history the stats handler reads
+    stress_set_history(bms_stats_hist_push, bms_stats_hist_copy_latest);
+#endif
 
     BMS_LOGI("HTTP server started");
     return ESP_OK;
@@ -293,7 +350,8 @@ static esp_err_t send_error_modal(httpd_req_t *req, const char *title, const cha
 }
 
 /// This is the GET handler for retrieving current configuration data as JSON response. It builds JSON object
-/// containing current configuration parameters and sends it to the HTTP client.
+/// containing current configuration parameters and sends it to the HTTP client. JSON tree is allocated within a JSON
+/// arena scope and printed into a stack buffer, so the scope is released before the response is sent.
 ///
 /// \param[in] req Pointer to HTTP request structure
 /// \return ESP_OK on success, otherwise an error code
@@ -301,6 +359,8 @@ static esp_err_t h_config_data(httpd_req_t *req)
 {
     httpd_resp_set_type(req, "application/json");
 
+    json_arena_scope_begin();
+
     cJSON *root = cJSON_CreateObject();
     cJSON *wifi = cJSON_CreateObject();
     cJSON *mqtt = cJSON_CreateObject();
@@ -318,9 +378,9 @@ static esp_err_t h_config_data(httpd_req_t *req)
     cJSON_AddStringToObject(mqtt, "uri", g_cfg.mqtt.uri);
 
     cJSON_AddItemToObject(root, "battery", bat);
-    cJSON_AddStringToObject(bat, "adapter",
-        g_cfg.battery.adapter_mode == BMS_ADAPTER_DEMO ? "demo" : "ltc6804");
+    cJSON_AddStringToObject(bat, "adapter", bms_adapter_mode_name(g_cfg.battery.adapter_mode));
     cJSON_AddNumberToObject(bat, "num_cells", g_cfg.battery.num_cells);
+    cJSON_AddNumberToObject(bat, "max_cells", BMS_MAX_CELLS);
     cJSON_AddBoolToObject(bat, "current_enable", g_cfg.battery.current_enable);
     cJSON_AddBoolToObject(bat, "temperature_enable", g_cfg.battery.temperature_enable);
     cJSON_AddNumberToObject(bat, "cell_v_min", g_cfg.battery.cell_v_min);
@@ -330,16 +390,15 @@ static esp_err_t h_config_data(httpd_req_t *req)
     cJSON_AddNumberToObject(bat, "series_pack_i_min", g_cfg.battery.series_pack_i_min);
     cJSON_AddNumberToObject(bat, "series_pack_i_max", g_cfg.battery.series_pack_i_max);
 
-    char *out = cJSON_PrintUnformatted(root);
+    char out[CONFIG_DATA_JSON_MAXLEN];
+    bool printed = cJSON_PrintPreallocated(root, out, sizeof(out), false);
     cJSON_Delete(root);
+    json_arena_scope_end();
 
-    if (!out) {
+    if (!printed) {
         return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "json");
     }
-
-    esp_err_t err = httpd_resp_sendstr(req, out);
-    free(out);
-    return err;
+    return httpd_resp_sendstr(req, out);
 }
 
 /// This is the POST handler for saving configuration data sent by the HTTP client. Function performs following steps:
@@ -442,11 +501,7 @@ static esp_err_t h_config_save(httpd_req_t *req)
     
     // Parse adapter mode
     if (parse_post_param(buf, "adapter", value, sizeof(value)) == ESP_OK) {
-        if (strcmp(value, "demo") == 0) {
-            g_cfg.battery.adapter_mode = BMS_ADAPTER_DEMO;
-        } else {
-            g_cfg.battery.adapter_mode = BMS_ADAPTER_LTC6804;
-        }
+        g_cfg.battery.adapter_mode = bms_adapter_mode_from_name(value);
     }
 
     // Parse battery parameters and round to 2 decimal places
@@ -587,8 +642,11 @@ static esp_err_t h_template_save(httpd_req_t *req)
 
     BMS_LOGI("Received template save request: %s", buf);
 
+    // Request body is parsed within its own arena scope, configuration update below opens a new one
+    json_arena_scope_begin();
     cJSON *body = cJSON_Parse(buf);
     if (!body) {
+        json_arena_scope_end();
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Invalid JSON\"}");
     }
@@ -601,6 +659,7 @@ static esp_err_t h_template_save(httpd_req_t *req)
     if (!cJSON_IsString(jid) || !cJSON_IsString(jname) || !cJSON_IsString(jcat) ||
         strlen(jname->valuestring) == 0 || strlen(jcat->valuestring) == 0) {
         cJSON_Delete(body);
+        json_arena_scope_end();
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Missing required fields\"}");
     }
@@ -618,6 +677,7 @@ static esp_err_t h_template_save(httpd_req_t *req)
     strncpy(name_buf, jname->valuestring, sizeof(name_buf) - 1);
     strncpy(cat_buf,  jcat->valuestring,  sizeof(cat_buf) - 1);
     cJSON_Delete(body);
+    json_arena_scope_end();
 
     esp_err_t err = configuration_add_battery_template(
         id_buf, name_buf, cat_buf,
@@ -655,8 +715,10 @@ static esp_err_t h_template_edit(httpd_req_t *req)
 
     BMS_LOGI("Received template edit request: %s", buf);
 
+    json_arena_scope_begin();
     cJSON *body = cJSON_Parse(buf);
     if (!body) {
+        json_arena_scope_end();
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Invalid JSON\"}");
     }
@@ -668,6 +730,7 @@ static esp_err_t h_template_edit(httpd_req_t *req)
     if (!cJSON_IsString(jid) || !cJSON_IsString(jname) || !cJSON_IsString(jcat) ||
         strlen(jid->valuestring) == 0 || strlen(jname->valuestring) == 0 || strlen(jcat->valuestring) == 0) {
         cJSON_Delete(body);
+        json_arena_scope_end();
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Missing required fields\"}");
     }
@@ -684,6 +747,7 @@ static esp_err_t h_template_edit(httpd_req_t *req)
     strncpy(name_buf, jname->valuestring, sizeof(name_buf) - 1);
     strncpy(cat_buf,  jcat->valuestring,  sizeof(cat_buf) - 1);
     cJSON_Delete(body);
+    json_arena_scope_end();
 
     esp_err_t err = configuration_edit_battery_template(
         id_buf, name_buf, cat_buf,
@@ -721,8 +785,10 @@ static esp_err_t h_template_delete(httpd_req_t *req)
 
     BMS_LOGI("Received template delete request: %s", buf);
 
+    json_arena_scope_begin();
     cJSON *body = cJSON_Parse(buf);
     if (!body) {
+        json_arena_scope_end();
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Invalid JSON\"}");
     }
@@ -730,6 +796,7 @@ static esp_err_t h_template_delete(httpd_req_t *req)
     cJSON *jid = cJSON_GetObjectItem(body, "id");
     if (!cJSON_IsString(jid) || strlen(jid->valuestring) == 0) {
         cJSON_Delete(body);
+        json_arena_scope_end();
         httpd_resp_set_type(req, "application/json");
         return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Missing id\"}");
     }
@@ -737,6 +804,7 @@ static esp_err_t h_template_delete(httpd_req_t *req)
     char id_buf[64] = {0};
     strncpy(id_buf, jid->valuestring, sizeof(id_buf) - 1);
     cJSON_Delete(body);
+    json_arena_scope_end();
 
     esp_err_t err = configuration_delete_battery_template(id_buf);
 
@@ -895,3 +963,182 @@ static esp_err_t h_led_status(httpd_req_t *req)
     const char *status = led_on ? "{\"status\":\"on\"}" : "{\"status\":\"off\"}";
     return httpd_resp_sendstr(req, status);
 }
+
+/// GET handler for retrieving results of the on-target boot benchmark (cycles per operation).
+/// Responds with JSON "null" if the firmware was built without CONFIG_BMS_BOOT_BENCH.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \return ESP_OK on success
+static esp_err_t h_bench_data(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    const char *json = boot_bench_get_json();
+    return httpd_resp_sendstr(req, json ? json : "null");
+}
+
+/// GET handler for retrieving results of the throughput stress sweep run at boot.
+/// Responds with JSON "null" if the firmware was built without CONFIG_BMS_STRESS.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \return ESP_OK on success
+static esp_err_t h_stress_data(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    const char *json = stress_get_json();
+    return httpd_resp_sendstr(req, json ? json : "null");
+}
+
+/// GET handler for retrieving cell calibration: applied gain and offset constants of all channels and captured
+/// reference points (averaged raw codes and reference voltages, both in 100 uV codes).
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \return ESP_OK on success, otherwise an error code
+static esp_err_t h_calib_data(httpd_req_t *req)
+{
+    ltc6804_calib_t calib;
+    ltc6804_get_calib(&calib);
+
+    char buf[CALIB_DATA_JSON_MAXLEN];
+    size_t off = 0;
+    RESP_APPEND(off, buf, "{\"gain_shift\":%d,\"gain\":[", LTC6804_CALIB_GAIN_SHIFT);
+    for (int c = 0; c < LTC6804_CALIB_CHANNELS; ++c) {
+        RESP_APPEND(off, buf, "%s%d", c ? "," : "", calib.gain[c]);
+    }
+    RESP_APPEND(off, buf, "],\"offset\":[");
+    for (int c = 0; c < LTC6804_CALIB_CHANNELS; ++c) {
+        RESP_APPEND(off, buf, "%s%d", c ? "," : "", calib.offset[c]);
+    }
+    RESP_APPEND(off, buf, "],\"points\":[");
+    for (uint8_t p = 0; p < LTC6804_CALIB_POINTS; ++p) {
+        uint16_t code[LTC6804_MAX_CELLS], ref[LTC6804_MAX_CELLS];
+        if (!ltc6804_calib_get_point(p, code, ref)) {
+            RESP_APPEND(off, buf, "%snull", p ? "," : "");
+            continue;
+        }
+        RESP_APPEND(off, buf, "%s{\"code\":[", p ? "," : "");
+        for (int c = 0; c < LTC6804_MAX_CELLS; ++c) {
+            RESP_APPEND(off, buf, "%s%u", c ? "," : "", (unsigned)code[c]);
+        }
+        RESP_APPEND(off, buf, "],\"ref\":[");
+        for (int c = 0; c < LTC6804_MAX_CELLS; ++c) {
+            RESP_APPEND(off, buf, "%s%u", c ? "," : "", (unsigned)ref[c]);
+        }
+        RESP_APPEND(off, buf, "]}");
+    }
+    RESP_APPEND(off, buf, "]}");
+    if (off >= sizeof(buf)) {
+        BMS_LOGE("Calibration response truncated");
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "json");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, buf);
+}
+
+#if CONFIG_BMS_ROLLING
+/// GET handler for sliding-window statistics over the last CONFIG_BMS_ROLLING_WINDOW samples, updated by the Fast
+/// Core with every sample. Values are [avg, min, max]; "null" before the first sample.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \return ESP_OK on success, otherwise an error code
+static esp_err_t h_rolling_data(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+
+    bms_rolling_t r;
+    if (!bms_rolling_get(&r)) {
+        return httpd_resp_sendstr(req, "null");
+    }
+
+    char buf[ROLLING_DATA_JSON_MAXLEN];
+    size_t off = 0;
+    RESP_APPEND(off, buf, "{\"timestamp\":%lu,\"seq\":%lu,\"window\":%u,\"sample_count\":%u,\"cell_v\":[",
+                (unsigned long)r.timestamp, (unsigned long)r.seq, (unsigned)r.window, (unsigned)r.sample_count);
+    for (uint8_t c = 0; c < r.num_cells; ++c) {
+        RESP_APPEND(off, buf, "%s[%.4f,%.4f,%.4f]", c ? "," : "", r.cell_v[c].avg, r.cell_v[c].min, r.cell_v[c].max);
+    }
+    RESP_APPEND(off, buf,
+                "],\"pack_v\":[%.3f,%.3f,%.3f],\"pack_i\":[%.3f,%.3f,%.3f],\"temperature\":[%.2f,%.2f,%.2f]}",
+                r.pack_v.avg, r.pack_v.min, r.pack_v.max, r.pack_i.avg, r.pack_i.min, r.pack_i.max,
+                r.temperature.avg, r.temperature.min, r.temperature.max);
+    if (off >= sizeof(buf)) {
+        BMS_LOGE("Rolling statistics response truncated");
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "json");
+    }
+
+    return httpd_resp_sendstr(req, buf);
+}
+#endif
+
+/// POST handler for cell calibration. Receives a JSON body with "action":
+/// - "capture": averages raw codes of point "point" (0 or 1) while reference voltage "ref_v" (volts, one number
+///   for all cells or an array per cell) is applied to the cell inputs. Blocks for about one second.
+/// - "fit": fits gain and offset of configured cells from captured points, applies and stores them in NVS.
+/// - "reset": restores nominal conversion and removes stored calibration.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \return ESP_OK on success, otherwise an error code
+static esp_err_t h_calib_post(httpd_req_t *req)
+{
+    char buf[512];
+    int remaining = req->content_len;
+
+    httpd_resp_set_type(req, "application/json");
+    if (remaining >= (int)sizeof(buf)) {
+        return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Content too long\"}");
+    }
+
+    int ret = httpd_req_recv(req, buf, remaining);
+    if (ret <= 0) {
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) httpd_resp_send_408(req);
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+
+    json_arena_scope_begin();
+    cJSON *body = cJSON_Parse(buf);
+    cJSON *jaction = body ? cJSON_GetObjectItem(body, "action") : NULL;
+    if (!cJSON_IsString(jaction)) {
+        cJSON_Delete(body);
+        json_arena_scope_end();
+        return httpd_resp_sendstr(req, "{\"ok\":false,\"error\":\"Missing action\"}");
+    }
+
+    uint8_t num_cells = g_cfg.battery.num_cells;
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+    if (strcmp(jaction->valuestring, "capture") == 0) {
+        cJSON *jpoint = cJSON_GetObjectItem(body, "point");
+        cJSON *jref   = cJSON_GetObjectItem(body, "ref_v");
+        float ref_v[LTC6804_MAX_CELLS];
+        bool valid = cJSON_IsNumber(jpoint) && num_cells <= LTC6804_MAX_CELLS;
+        for (uint8_t c = 0; valid && c < num_cells; ++c) {
+            cJSON *jv = cJSON_IsArray(jref) ? cJSON_GetArrayItem(jref, c) : jref;
+            valid = cJSON_IsNumber(jv);
+            ref_v[c] = valid ? (float)jv->valuedouble : 0.0f;
+        }
+        uint8_t point = valid ? (uint8_t)jpoint->valueint : 0;
+        // Body is released before the blocking capture
+        cJSON_Delete(body);
+        json_arena_scope_end();
+        if (valid) {
+            err = ltc6804_calib_capture_point(point, ref_v, num_cells);
+        }
+    } else {
+        bool fit = (strcmp(jaction->valuestring, "fit") == 0);
+        bool reset = (strcmp(jaction->valuestring, "reset") == 0);
+        cJSON_Delete(body);
+        json_arena_scope_end();
+        if (fit) {
+            err = ltc6804_calib_fit_and_save(num_cells);
+        } else if (reset) {
+            err = ltc6804_calib_reset();
+        }
+    }
+
+    if (err != ESP_OK) {
+        char resp[96];
+        snprintf(resp, sizeof(resp), "{\"ok\":false,\"error\":\"%s\"}", esp_err_to_name(err));
+        return httpd_resp_sendstr(req, resp);
+    }
+    return httpd_resp_sendstr(req, "{\"ok\":true}");
+}
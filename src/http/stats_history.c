@@ -72,6 +72,29 @@ void bms_stats_hist_push(const char *json, size_t len)
     return;
 }
 
+/// This function copies the latest statistics sample into the given buffer as NUL-terminated string. Samples
+/// longer than the buffer are truncated.
+///
+/// \param[out] buf Output buffer
+/// \param[in] size Size of output buffer in bytes
+/// \return Length of copied JSON string, 0 if no sample is available yet
+size_t bms_stats_hist_copy_latest(char *buf, size_t size)
+{
+    if (!buf || size == 0) return 0;
+
+    size_t len = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_has_sample && s_latest_len > 0) {
+        len = (s_latest_len < size) ? s_latest_len : size - 1;
+        memcpy(buf, s_latest_json, len);
+    }
+    buf[len] = '\0';
+    taskEXIT_CRITICAL(&s_lock);
+
+    return len;
+}
+
 /// This function sends the latest statistics sample as a single JSON object via HTTP response.
 /// Returns JSON "null" if no sample is available yet.
 ///
@@ -82,24 +105,13 @@ esp_err_t bms_stats_hist_send_latest(httpd_req_t *req)
     httpd_resp_set_type(req, "application/json");
 
     char tmp[BMS_STATS_JSON_MAXLEN];
-    uint16_t tmplen;
-    bool has;
-
-    taskENTER_CRITICAL(&s_lock);
-    has    = s_has_sample;
-    tmplen = s_latest_len;
-    if (has && tmplen > 0) {
-        if (tmplen >= BMS_STATS_JSON_MAXLEN) tmplen = BMS_STATS_JSON_MAXLEN - 1;
-        memcpy(tmp, s_latest_json, tmplen);
-    }
-    tmp[tmplen] = '\0';
-    taskEXIT_CRITICAL(&s_lock);
+    size_t tmplen = bms_stats_hist_copy_latest(tmp, sizeof(tmp));
 
-    if (!has || tmplen == 0) {
+    if (tmplen == 0) {
         return httpd_resp_sendstr(req, "null");
     }
 
-    return httpd_resp_send(req, tmp, tmplen);
+    return httpd_resp_send(req, tmp, (ssize_t)tmplen);
 }
 
 /*==============================================================================================================*/
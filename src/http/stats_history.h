@@ -9,12 +9,11 @@
 #include <stdint.h>
 #include "esp_err.h"
 #include "esp_http_server.h"
+#include "json_formatter.h"
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
 /*==============================================================================================================*/
-/// Maximum length of JSON string for one statistics window.
-#define BMS_STATS_JSON_MAXLEN      1536u
 
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
@@ -32,4 +31,5 @@
 /*                                        Public Function Prototypes                                            */
 /*==============================================================================================================*/
 void bms_stats_hist_push(const char *json, size_t len);
+size_t     bms_stats_hist_copy_latest(char *buf, size_t size);
 esp_err_t  bms_stats_hist_send_latest(struct httpd_req *req);
@@ -8,6 +8,7 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "bms_data.h"
+#include "bms_trace.h"
 #include "intercore_comm.h"
 #include "logging.h"
 #include "process.h"
@@ -19,7 +20,11 @@
 #include "stats_history.h"
 #include "spiffs.h"
 #include "configuration.h"
+#include "json_arena.h"
 #include "watchdog.h"
+#include "supervisor.h"
+#include "latency_probe.h"
+#include "stage_timing.h"
 
 
 /*==============================================================================================================*/
@@ -83,6 +88,11 @@ static appsm_t s_appsm = {
 /// Ring buffer used to stage samples popped from inter-core queue
 static bms_sample_buffer_t buf;
 
+#if CONFIG_BMS_STATIC_ALLOCATION
+/// Static storage of ring buffer samples. Used for the whole lifetime instead of heap allocation.
+static bms_sample_t s_samples_storage[MAX_SAMPLES_PER_POP];
+#endif
+
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -206,6 +216,14 @@ static app_state_t state_config_handler(void)
 
         for (size_t i = 0; i < stats_buf.stats_count; ++i) {
             const bms_stats_t *st = &stats_buf.stats_array[i];
+#if CONFIG_BMS_ANOMALY
+            bms_anomaly_update(st->timestamp, st->cell_v_avg, g_cfg.battery.num_cells,
+                               &stats_buf.stats_array[i].anomaly);
+#endif
+#if CONFIG_BMS_RIPPLE
+            // Latest completed 1 s ripple block (not aligned to the window), empty while the detector does not run
+            bms_ripple_get(&stats_buf.stats_array[i].ripple_last);
+#endif
             int len = bms_stats_to_json(st, json_buf, sizeof(json_buf));
             if (len < 0) {
                 BMS_LOGE("Failed to serialize stats to JSON");
@@ -270,6 +288,13 @@ static app_state_t state_processing_handler(void)
         buf.count++;
     }
 
+#if CONFIG_BMS_TRACE_RECORD
+    // 1.1) Write trace records buffered by Fast Core since last cycle
+    if (bms_trace_rec_flush() != ESP_OK) {
+        BMS_LOGW("Trace recording stopped after write error");
+    }
+#endif
+
     // 2) Compute stats and publish them using QoS 0 (fire-and-forget)
     bms_stats_buffer_t stats_buf;
     // Buffer for JSON serialization
@@ -285,6 +310,15 @@ static app_state_t state_processing_handler(void)
         // 2.2) Publish computed stats via MQTT in JSON format
         for (size_t i = 0; i < stats_buf.stats_count; ++i) {
             const bms_stats_t *st = &stats_buf.stats_array[i];
+#if CONFIG_BMS_ANOMALY
+            // Score cells against the pack consensus, alarms are logged by the detector
+            bms_anomaly_update(st->timestamp, st->cell_v_avg, g_cfg.battery.num_cells,
+                               &stats_buf.stats_array[i].anomaly);
+#endif
+#if CONFIG_BMS_RIPPLE
+            // Latest completed 1 s ripple block (not aligned to the window), empty while the detector does not run
+            bms_ripple_get(&stats_buf.stats_array[i].ripple_last);
+#endif
 
             // Serialize stats to JSON
             int len = bms_stats_to_json(st, json_buf, sizeof(json_buf));
@@ -294,11 +328,17 @@ static app_state_t state_processing_handler(void)
             }
 
             // Publish with QoS 0 - fire and forget, no acknowledgment needed
+#if CONFIG_BMS_LATENCY_PROBE
+            uint32_t pub_start = stage_timing_now_us();
+#endif
             esp_err_t perr = bms_mqtt_publish_qos0(
                 "bms/esp32/stats",
                 json_buf,
                 len
             );
+#if CONFIG_BMS_LATENCY_PROBE
+            latency_probe_publish_done(stage_timing_now_us() - pub_start);
+#endif
 
             if (perr != ESP_OK) {
                 BMS_LOGW("MQTT publish failed (%s). Message dropped.", esp_err_to_name(perr));
@@ -338,7 +378,10 @@ static void state_input_handler(void)
                     break;
                 }
 
-                // 2) Load config overrides (keeps defaults if file missing/bad)
+                // 2) Install cJSON allocator before first cJSON use (bounded arena when enabled)
+                json_arena_init();
+
+                // 3) Load config overrides (keeps defaults if file missing/bad)
                 err = configuration_load("/spiffs/config.json");
                 if (err != ESP_OK) {
                     BMS_LOGW("Config not loaded (%s). Using defaults.", esp_err_to_name(err));
@@ -381,14 +424,18 @@ static void state_output_handler(void)
         switch (s_appsm.curr_state)
         {
             case APP_ST_INIT:
-                // Slow core TWDT is created separately after finishing initialization
-                // to avoid triggering it during long initialization sequences.
-                slow_core_TWDT_create();
+                // Supervisor (the only TWDT feeder) is started separately after finishing initialization
+                // to avoid triggering TWDT during long initialization sequences.
+                supervisor_start();
                 // Initialize ring buffer used to stage samples popped from inter-core queue
                 buf.capacity = MAX_SAMPLES_PER_POP;
                 buf.head     = 0;
                 buf.count    = 0;
+#if CONFIG_BMS_STATIC_ALLOCATION
+                buf.samples  = s_samples_storage;
+#else
                 buf.samples  = malloc(sizeof(bms_sample_t) * buf.capacity);
+#endif
                 
                 if (!buf.samples) {
                     BMS_LOGE("Failed to allocate samples buffer");
@@ -397,14 +444,18 @@ static void state_output_handler(void)
                 break;
 
             case APP_ST_PROCESSING:
+#if !CONFIG_BMS_STATIC_ALLOCATION
                 // Free allocated buffer
                 free(buf.samples);
                 buf.samples = NULL;
+#endif
                 break;
 
             case APP_ST_CONFIG:
+#if !CONFIG_BMS_STATIC_ALLOCATION
                 free(buf.samples);
                 buf.samples = NULL;
+#endif
                 break;
 
             default:
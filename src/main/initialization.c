@@ -11,6 +11,7 @@
 #include "tasksSC.h"
 #include "tasksFC.h"
 #include "bms_adapter.h"
+#include "bms_trace.h"
 #include "configuration.h"
 #include "intercore_comm.h"
 #include "logging.h"
@@ -19,6 +20,10 @@
 #include "http_server.h"
 #include "telemetry.h"
 #include "adc.h"
+#include "ripple.h"
+#include "timesync.h"
+#include "boot_bench.h"
+#include "stress.h"
 
 
 /*==============================================================================================================*/
@@ -85,11 +90,22 @@ bool initialization_exec(void)
             BMS_LOGE("MQTT init failed: %s", esp_err_to_name(err));
             return false;
         }
+#if CONFIG_BMS_TIMESYNC
+        // Wall-clock sync for UTC window stamps, optional (windows stay counted in samples until synchronized)
+        err = bms_timesync_start();
+        if (err != ESP_OK) {
+            BMS_LOGW("Time sync not started: %s", esp_err_to_name(err));
+        }
+#endif
     }
 
     // Select and initialize BMS adapter based on configuration
     if (g_cfg.battery.adapter_mode == BMS_ADAPTER_DEMO) {
         err = bms_demo_adapter_select();
+    } else if (g_cfg.battery.adapter_mode == BMS_ADAPTER_SIM) {
+        err = bms_sim_adapter_select();
+    } else if (g_cfg.battery.adapter_mode == BMS_ADAPTER_REPLAY) {
+        err = bms_replay_adapter_select();
     } else {
         err = bms_ltc6804_adapter_select();
     }
@@ -98,6 +114,16 @@ bool initialization_exec(void)
         return false;
     }
 
+#if CONFIG_BMS_TRACE_RECORD
+    // Record raw adapter samples from boot (a replayed trace is not recorded again)
+    if (g_cfg.battery.adapter_mode != BMS_ADAPTER_REPLAY) {
+        err = bms_trace_rec_start(CONFIG_BMS_TRACE_PATH, g_cfg.battery.num_cells, CONFIG_BMS_TRACE_MAX_KB * 1024u);
+        if (err != ESP_OK) {
+            BMS_LOGW("Trace recording not started: %s", esp_err_to_name(err));
+        }
+    }
+#endif
+
     // Initialize ESP32 ADC
     err = adc_init();
     if (err != ESP_OK) {
@@ -105,9 +131,36 @@ bool initialization_exec(void)
         return false;
     }
 
+#if CONFIG_BMS_RIPPLE
+    // High-rate pack current sampling of the hardware adapter, optional (pack current falls back to one conversion
+    // per cycle)
+    if (g_cfg.battery.adapter_mode == BMS_ADAPTER_LTC6804) {
+        err = bms_ripple_start();
+        if (err != ESP_OK) {
+            BMS_LOGW("Ripple detector not started: %s", esp_err_to_name(err));
+        }
+    }
+#endif
+
     // Initialize inter-core communication queue
     bms_queue_init();
 
+#if CONFIG_BMS_BOOT_BENCH
+    // Run on-target microbenchmark while Core 1 is idle and the queue is empty (results over UART and /bms/bench)
+    err = boot_bench_run();
+    if (err != ESP_OK) {
+        BMS_LOGW("Boot benchmark failed: %s", esp_err_to_name(err));
+    }
+#endif
+
+#if CONFIG_BMS_STRESS
+    // Find saturation point of the pipeline before normal operation (results over UART and /bms/stress)
+    err = stress_run(ap_mode ? NULL : bms_mqtt_publish_qos0, CONFIG_BMS_STRESS_STEP_MS);
+    if (err != ESP_OK) {
+        BMS_LOGW("Stress sweep failed: %s", esp_err_to_name(err));
+    }
+#endif
+
     // Create Fast Core tasks
     err = fast_core_tasks_create();
     if (err != ESP_OK) {
@@ -8,14 +8,27 @@
 #include "freertos/task.h"
 #include "esp_err.h"
 #include "esp_log.h"
-#include "watchdog.h"
 #include "bms_adapter.h"
 #include "bms_data.h"
+#include "bms_trace.h"
 #include "configuration.h"
 #include "intercore_comm.h"
+#include "rolling_stats.h"
+#include "ripple.h"
 #include "ltc6804.h"
 #include "telemetry.h"
+#include "stage_timing.h"
+#include "deadline_monitor.h"
+#include "power_mode.h"
+#include "supervisor.h"
+#include "timesync.h"
+#include "esp_timer.h"
 #include "logging.h"
+#include <math.h>
+#include <string.h>
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
@@ -23,15 +36,25 @@
 /// Log module tag used by logging module
 #define LOG_MODULE_TAG "TASKS_FC"
 
-/// TWDT feeding period in milliseconds. Used by Fast Core feeder.
-#define WDT_FEED_MS             20
+/// Fast Core processing task stack size in bytes, grows with the sample and raw code arrays of a layout beyond 12
+/// cells
+#define FAST_CORE_TASK_STACK    (5120 + (BMS_MAX_CELLS - 12) * 16)
 
 /// Fast Core real-time processing task period in milliseconds.
 #define FAST_CORE_PERIOD_MS     50
 
+/// Maximum allowed age of Fast Core heartbeat in milliseconds. Covers several periods at the lowest rate, so only
+/// a stalled task (not an occasional deadline miss handled by deadline monitor) stops feeding of HW TWDT.
+#ifndef CONFIG_BMS_SUP_FAST_DEADLINE_MS
+#define CONFIG_BMS_SUP_FAST_DEADLINE_MS  500
+#endif
+
 /// LTC6804 status register read interval (every Nth sample cycle, 20 = once per second at 20 Hz)
 #define STATUS_READ_INTERVAL    20
 
+/// Minimum number of cycles between cell flag warnings (100 = 5 s at 20 Hz)
+#define FLAGS_WARN_INTERVAL     100
+
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -41,7 +64,19 @@
 /*                                       Private Function Prototypes                                            */
 /*==============================================================================================================*/
 static void fast_core_task();
-static void fast_core_feeder_task();
+static uint32_t apply_degradation_level(dlm_level_t level);
+#if CONFIG_BMS_LOW_POWER
+static bool sample_is_active(const bms_sample_t *sample);
+static uint32_t apply_power_mode(pwr_mode_t mode, int hb_id);
+#endif
+#if CONFIG_BMS_LTC_HW_FLAGS
+static void read_cell_flags(bms_sample_t *sample);
+#endif
+#if CONFIG_BMS_TIMESYNC
+static uint64_t wait_next_cycle(TickType_t *last_wake, TickType_t period, uint32_t period_ms);
+static uint64_t cycle_epoch_ms(void);
+static void edge_timer_cb(void *arg);
+#endif
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
@@ -51,17 +86,23 @@ static void fast_core_feeder_task();
 /*==============================================================================================================*/
 /*                                            Private Variables                                                 */
 /*==============================================================================================================*/
-/// Flag indicating whether feeding of HW TWDT is allowed. Set to false on Slow Core SW watchdog timeout.
-static volatile bool s_allow_feeding = true;
-
 /// Flag to signal tasks to exit gracefully
 static volatile bool s_should_exit = false;
 
 /// Main task handle for Fast Core tasks
 static TaskHandle_t s_fast_core_task_handle = NULL;
 
-/// TWDT task handle for Fast Core tasks
-static TaskHandle_t s_fast_core_feeder_handle = NULL;
+#if CONFIG_BMS_TIMESYNC
+/// One-shot timer waking the Fast Core task at wall-clock edges
+static esp_timer_handle_t s_edge_timer = NULL;
+#endif
+
+#if CONFIG_BMS_STATIC_ALLOCATION
+/// Static stack of Fast Core processing task
+static StackType_t s_fast_core_task_stack[FAST_CORE_TASK_STACK];
+/// Static control block of Fast Core processing task
+static StaticTask_t s_fast_core_task_tcb;
+#endif
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -78,25 +119,26 @@ esp_err_t fast_core_tasks_create(void)
 {
     BaseType_t result;
 
-    // Create Fast Core processing task. Higher priority than Fast Core feeder to ensure real-time processing.
-    result = xTaskCreatePinnedToCore(fast_core_task, "fast_core_task", 5120, NULL, 7, &s_fast_core_task_handle, 1);
+    // Create Fast Core processing task. Health of the task is reported to supervisor by heartbeats.
+#if CONFIG_BMS_STATIC_ALLOCATION
+    s_fast_core_task_handle = xTaskCreateStaticPinnedToCore(fast_core_task, "fast_core_task", FAST_CORE_TASK_STACK,
+                                                            NULL, 7, s_fast_core_task_stack,
+                                                            &s_fast_core_task_tcb, 1);
+    result = s_fast_core_task_handle ? pdPASS : pdFAIL;
+#else
+    result = xTaskCreatePinnedToCore(fast_core_task, "fast_core_task", FAST_CORE_TASK_STACK, NULL, 7,
+                                     &s_fast_core_task_handle, 1);
+#endif
     if (result != pdPASS) {
         BMS_LOGE("Failed to create Fast Core processing task");
         return ESP_FAIL;
     }
 
-    // Create Fast Core TWDT feeder task. Lower priority than Fast Core processing to ensure processing runs.
-    result = xTaskCreatePinnedToCore(fast_core_feeder_task, "fast_core_feeder_task", 3072, NULL, 6, &s_fast_core_feeder_handle, 1);
-    if (result != pdPASS) {
-        BMS_LOGE("Failed to create Fast Core feeder task");
-        return ESP_FAIL;
-    }
-
     return ESP_OK;
 }
 
 /// This function deletes all Fast Core tasks. Used before entering CONFIG state.
-/// Tasks will unregister from TWDT gracefully before deletion.
+/// Tasks will unregister from supervisor gracefully before deletion.
 ///
 /// \param None
 /// \return None
@@ -107,19 +149,13 @@ void fast_core_tasks_delete(void)
     
     // Wait for tasks to exit gracefully (up to 500ms)
     for (int i = 0; i < 10; i++) {
-        if (!s_fast_core_task_handle && !s_fast_core_feeder_handle) {
-            break;  // Both tasks exited
+        if (!s_fast_core_task_handle) {
+            break;  // Task exited
         }
         vTaskDelay(pdMS_TO_TICKS(50));
     }
     
     // Force delete if still running
-    if (s_fast_core_feeder_handle) {
-        BMS_LOGW("Force deleting Fast Core feeder task (didn't exit gracefully)");
-        vTaskDelete(s_fast_core_feeder_handle);
-        s_fast_core_feeder_handle = NULL;
-    }
-    
     if (s_fast_core_task_handle) {
         BMS_LOGW("Force deleting Fast Core processing task (didn't exit gracefully)");
         vTaskDelete(s_fast_core_task_handle);
@@ -127,7 +163,6 @@ void fast_core_tasks_delete(void)
     }
     
     // Reset flags for potential restart
-    s_allow_feeding = true;
     s_should_exit = false;
     
     BMS_LOGI("Fast Core tasks cleaned up");
@@ -140,8 +175,9 @@ void fast_core_tasks_delete(void)
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
 /// Fast Core task reads BMS samples from BMS adapter and pushes them into inter-core queue for Slow Core (Core 0)
-/// processing. Fast Core task runs in real-time and must complete its work within defined period, otherwise it
-/// disables feeding of the hardware TWDT, allowing it to expire and reset the system.
+/// processing. Fast Core task runs in real-time and every cycle exceeding its period is reported to the deadline
+/// monitor. Persistent overload first degrades the cycle (faster ADC mode, longer period); system reset is requested
+/// from supervisor only when misses continue at the highest degradation level. Every cycle posts a heartbeat.
 ///
 /// \param None
 /// \return None
@@ -153,35 +189,102 @@ static void fast_core_task()
         vTaskDelete(NULL);
     }
 
+    // Start at nominal level and full rate. Real-time period (ms) depends on degradation level and power mode.
+    deadline_monitor_init();
+#if CONFIG_BMS_LOW_POWER
+    power_mode_init();
+#endif
+    uint32_t period_ms = apply_degradation_level(DLM_LEVEL_NOMINAL);
     // Waiting period for real-time loop
-    const TickType_t period = pdMS_TO_TICKS(FAST_CORE_PERIOD_MS);
+    TickType_t period = pdMS_TO_TICKS(period_ms);
+    // Real-time period in microseconds used for overrun check
+    uint32_t period_us = period_ms * 1000u;
+    // Register heartbeat with supervisor
+    int hb_id = supervisor_register("fast_core", period_ms, CONFIG_BMS_SUP_FAST_DEADLINE_MS);
     // Variable handling previous wake time for accurate periodic delay
     TickType_t last_wake = xTaskGetTickCount();
-    // Timing variables for checking real-time overrun
-    TickType_t start;
-    TickType_t end;
+    // Timing variables (microseconds) for per-stage histograms and real-time overrun check
+    uint32_t start;
+    uint32_t stage_start;
+    uint32_t end;
+    // Start of the current stage timing reporting interval
+    uint32_t interval_start = stage_timing_now_us();
+#if CONFIG_BMS_LOW_POWER
+    // Time when the sample of the cycle was available (for wake-to-sample latency in low-power mode)
+    uint32_t sampled;
+#endif
 
     bms_sample_t sample;
+#if CONFIG_BMS_ROLLING
+    // Sliding-window statistics start empty with every (re)start of the task
+    bms_rolling_init(CONFIG_BMS_ROLLING_WINDOW);
+#endif
     // Counter for periodic LTC6804 status register reading
     uint32_t status_counter = 0;
+#if CONFIG_BMS_TIMESYNC
+    // UTC of the current cycle, carried by its sample (0 until synchronized)
+    uint64_t cycle_ms = cycle_epoch_ms();
+    if (!s_edge_timer) {
+        const esp_timer_create_args_t args = {
+            .callback        = edge_timer_cb,
+            .arg             = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name            = "fc_edge",
+        };
+        if (esp_timer_create(&args, &s_edge_timer) != ESP_OK) {
+            BMS_LOGW("Failed to create edge timer, cycles not aligned to wall clock");
+            s_edge_timer = NULL;
+        }
+    }
+#endif
 
     // Main Fast Core loop
     while (!s_should_exit)
     {
         // Start timing for real-time overrun check
-        start = xTaskGetTickCount();
+        start = stage_timing_now_us();
 
-        // Check free slots in inter-core queue. If none, disable feeding of HW TWDT.
+        // Check free slots in inter-core queue. If none, Slow Core is not consuming samples, request reset.
         if (bms_queue_free_slots() == 0) {
-            BMS_LOGE("BMS queue full (no free slots), stopping feeders and core1");
-            s_allow_feeding = false;
+            supervisor_request_reset("BMS queue full (no free slots)");
         }
 
         // Read one sample from BMS adapter
         esp_err_t err = bms->read_sample(&sample);
+#if CONFIG_BMS_LOW_POWER
+        sampled = stage_timing_now_us();
+#endif
         // On success, push sample into inter-core queue
         if (err == ESP_OK) {
-            if (!bms_queue_push(&sample)) {
+#if CONFIG_BMS_LATENCY_PROBE
+            sample.acq_us = stage_timing_now_us();
+#endif
+#if CONFIG_BMS_TIMESYNC
+            sample.epoch_ms = cycle_ms;
+#endif
+#if CONFIG_BMS_LTC_HW_FLAGS
+            // Comparator flags of the same conversion travel with the sample to the limit check
+            read_cell_flags(&sample);
+#endif
+#if CONFIG_BMS_TRACE_RECORD
+            // Append raw sample to trace RAM buffer (written to file by Slow Core)
+            stage_start = stage_timing_now_us();
+            bms_trace_rec_push(&sample);
+            stage_timing_record(FC_STAGE_TRACE, stage_timing_now_us() - stage_start);
+#endif
+#if CONFIG_BMS_ROLLING
+            // Sliding window is updated with every sample, readers get values at most one cycle old
+            stage_start = stage_timing_now_us();
+            bms_rolling_push(&sample);
+            stage_timing_record(FC_STAGE_ROLLING, stage_timing_now_us() - stage_start);
+#endif
+            stage_start = stage_timing_now_us();
+#if CONFIG_BMS_LATENCY_PROBE
+            sample.enq_us = stage_start;
+#endif
+            bool pushed = bms_queue_push(&sample);
+            stage_timing_record(FC_STAGE_PUSH, stage_timing_now_us() - stage_start);
+            if (!pushed) {
                 //On next iteration bms_queue_free_slots()==0 will trip and stop tasks
                 BMS_LOGE("Failed to enqueue BMS sample (queue full or error)");
             }
@@ -195,25 +298,76 @@ static void fast_core_task()
             if (++status_counter >= STATUS_READ_INTERVAL) {
                 status_counter = 0;
                 uint8_t stata[6] = {0}, statb[6] = {0};
+                stage_start = stage_timing_now_us();
                 esp_err_t status_ret = ltc6804_read_status(stata, statb);
+                stage_timing_record(FC_STAGE_STATUS_READ, stage_timing_now_us() - stage_start);
                 telemetry_update_ltc6804_status(stata, statb, (status_ret == ESP_OK));
             }
         }
 
         // End timing and check for real-time overrun
-        end = xTaskGetTickCount();
-        // If real-time period was exceeded, disable feeding of HW TWDT
-        if ((end - start) > period) {
-            BMS_LOGW("Fast Core RT overrun: %lu ms > %d ms",
-                     (unsigned long)pdTICKS_TO_MS(end - start), FAST_CORE_PERIOD_MS);
-            s_allow_feeding = false;
+        end = stage_timing_now_us();
+        stage_timing_record(FC_STAGE_CYCLE, end - start);
+        // Stage timing reporting interval follows wall time, independent of how often telemetry is read
+        if (end - interval_start >= CONFIG_BMS_STAGE_TIMING_INTERVAL_MS * 1000u) {
+            stage_timing_rotate_interval();
+            interval_start = end;
+        }
+        // Report the cycle to deadline monitor and apply its decision
+        bool missed = (end - start) > period_us;
+        if (missed) {
+            BMS_LOGW("Fast Core RT overrun: %lu us > %lu ms",
+                     (unsigned long)(end - start), (unsigned long)period_ms);
+        }
+        dlm_action_t action = deadline_monitor_update(missed, period_ms);
+#if CONFIG_BMS_LOW_POWER
+        // Low-power period is kept, the degradation level is applied when returning to full rate
+        bool low_power = (power_mode_get() == PWR_MODE_LOW);
+        if (low_power) {
+            power_mode_record_cycle(sampled - start, end - start, period_ms);
+        }
+        if (err == ESP_OK) {
+            pwr_action_t pwr_action = power_mode_update(sample_is_active(&sample), period_ms);
+            if (pwr_action != PWR_ACTION_NONE) {
+                low_power = (pwr_action == PWR_ACTION_ENTER_LOW);
+                period_ms = apply_power_mode(low_power ? PWR_MODE_LOW : PWR_MODE_FULL, hb_id);
+                period    = pdMS_TO_TICKS(period_ms);
+                period_us = period_ms * 1000u;
+            }
         }
+        if (low_power && (action == DLM_ACTION_DEGRADE || action == DLM_ACTION_RECOVER)) {
+            action = DLM_ACTION_NONE;
+        }
+#endif
+        if (action == DLM_ACTION_DEGRADE || action == DLM_ACTION_RECOVER) {
+            period_ms = apply_degradation_level(deadline_monitor_get_level());
+            period    = pdMS_TO_TICKS(period_ms);
+            period_us = period_ms * 1000u;
+            supervisor_set_period(hb_id, period_ms);
+        } else if (action == DLM_ACTION_RESET) {
+            // Overload persists even in cheapest configuration, let HW TWDT reset the system
+            supervisor_request_reset("Fast Core deadline misses at highest degradation level");
+        }
+
+        supervisor_heartbeat(hb_id);
 
-        // Puts task into blocked state for absolute period until next cycle (ensures real-time periodicity 20 Hz)
+        // Puts task into blocked state for absolute period until next cycle (20 Hz nominal, 10 Hz at half rate,
+        // CONFIG_BMS_LOW_POWER_PERIOD_MS in low-power mode)
+#if CONFIG_BMS_TIMESYNC
+        // Once synchronized, cycles start on wall-clock edges of the period (every 50 ms from a whole UTC second)
+        cycle_ms = wait_next_cycle(&last_wake, period, period_ms);
+#else
         vTaskDelayUntil(&last_wake, period);
+#endif
     }
     
+#if CONFIG_BMS_TIMESYNC
+    if (s_edge_timer) {
+        esp_timer_stop(s_edge_timer);
+    }
+#endif
     BMS_LOGI("Fast Core processing task exiting gracefully");
+    supervisor_unregister(hb_id);
     s_fast_core_task_handle = NULL;
     vTaskDelete(NULL);
 
@@ -221,42 +375,248 @@ static void fast_core_task()
 }
 
 
+/// This function applies configuration of the given degradation level to the Fast Core. ADC mode is switched only
+/// when hardware adapter is used. At half rate, statistics windows (counted in samples) span twice the time.
+///
+/// \param[in] level Degradation level to apply
+/// \return Fast Core period in milliseconds for the given level
+static uint32_t apply_degradation_level(dlm_level_t level)
+{
+    if (g_cfg.battery.adapter_mode == BMS_ADAPTER_LTC6804) {
+        uint8_t md = (level >= DLM_LEVEL_FAST_ADC) ? LTC6804_MD_FAST : LTC6804_MD_NORMAL;
+        if (ltc6804_set_adc_mode(md) != ESP_OK) {
+            BMS_LOGE("Failed to set LTC6804 ADC mode %u", (unsigned)md);
+        }
+    }
+
+    return (level >= DLM_LEVEL_HALF_RATE) ? (2u * FAST_CORE_PERIOD_MS) : FAST_CORE_PERIOD_MS;
+}
+
+#if CONFIG_BMS_LOW_POWER
+/// This function checks whether a sample keeps the pack out of rest: current flow above
+/// ::CONFIG_BMS_LOW_POWER_IDLE_MA (when current is measured) or a cell outside the configured limits.
+///
+/// \param[in] sample Sample read in this cycle
+/// \return True if the sample shows activity
+static bool sample_is_active(const bms_sample_t *sample)
+{
+    if (g_cfg.battery.current_enable && fabsf(sample->pack_i) * 1000.0f >= (float)CONFIG_BMS_LOW_POWER_IDLE_MA) {
+        return true;
+    }
+    for (int c = 0; c < g_cfg.battery.num_cells; ++c) {
+        if (sample->cell_v[c] < g_cfg.battery.cell_v_min || sample->cell_v[c] > g_cfg.battery.cell_v_max) {
+            return true;
+        }
+    }
+#if CONFIG_BMS_LTC_HW_FLAGS
+    if (bms_cell_mask_any(&sample->hw_uv) || bms_cell_mask_any(&sample->hw_ov)) {
+        return true;
+    }
+#endif
+
+    return false;
+}
 
-/// Fast Core TWDT feeder task. This task periodically feeds (resets) the hardware TWDT to prevent timeout.
-/// Feeding is only performed if ::s_allow_feeding flag is true, otherwise feeding is skipped, allowing TWDT to expire
-/// and reset the system.
+/// This function applies the given power mode to the Fast Core. In low-power mode the LTC6804 sleeps between
+/// samples, the ESP32 enters light sleep when idle (with CONFIG_PM_ENABLE and tickless idle) and the supervisor
+/// checks heartbeats and feeds the HW TWDT less often. Returning to full rate restores the period of the current
+/// degradation level. Wi-Fi power save is switched by the Slow Core.
 ///
-/// \param None
+/// \param[in] mode  Power mode to apply
+/// \param[in] hb_id Heartbeat slot of the Fast Core task
+/// \return Fast Core period in milliseconds for the given mode
+static uint32_t apply_power_mode(pwr_mode_t mode, int hb_id)
+{
+    bool low = (mode == PWR_MODE_LOW);
+
+    if (g_cfg.battery.adapter_mode == BMS_ADAPTER_LTC6804) {
+        if (ltc6804_set_low_power(low) != ESP_OK) {
+            BMS_LOGE("Failed to switch LTC6804 %s low-power mode", low ? "to" : "from");
+        }
+#if CONFIG_BMS_RIPPLE
+        // High-rate current sampling would keep the ESP32 awake, pack current is converted once per cycle instead
+        bms_ripple_set_running(!low);
+#endif
+    }
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = low ? CONFIG_XTAL_FREQ : CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = low,
+    };
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        BMS_LOGW("Failed to configure power management: %s", esp_err_to_name(err));
+    }
+#endif
+
+    uint32_t period_ms = low ? CONFIG_BMS_LOW_POWER_PERIOD_MS : apply_degradation_level(deadline_monitor_get_level());
+    supervisor_set_period(hb_id, period_ms);
+    supervisor_set_deadline(hb_id, low ? 2u * CONFIG_BMS_LOW_POWER_PERIOD_MS : CONFIG_BMS_SUP_FAST_DEADLINE_MS);
+    supervisor_set_feed_period(low ? CONFIG_BMS_LOW_POWER_PERIOD_MS / 2u : 0);
+
+    return period_ms;
+}
+#endif
+
+#if CONFIG_BMS_LTC_HW_FLAGS
+/// This function reads LTC6804 cell UV/OV flags of the conversion just read into the sample and cross-checks them
+/// against software limits. Flags disagreeing with the cell voltages (e.g. stuck comparator, wrong thresholds,
+/// corrupted cell codes) are counted in telemetry. Warnings are logged on a new hardware violation and on
+/// disagreement, at most once per ::FLAGS_WARN_INTERVAL cycles. Other adapters get no flags.
+///
+/// \param[in,out] sample Sample read in this cycle, hw_uv and hw_ov are set
 /// \return None
-static void fast_core_feeder_task()
+static void read_cell_flags(bms_sample_t *sample)
 {
-    // Register current task with TWDT. If registration fails, delete task.
-    if (bms_wdt_register_current_task() != ESP_OK) {
-        BMS_LOGE("Failed to register Fast Core feeder to TWDT");
-        vTaskDelete(NULL);
+    // Flags of the previous cycle for edge detection, cycles since the last warning
+    static bms_cell_mask_t s_prev_uv = { 0 };
+    static bms_cell_mask_t s_prev_ov = { 0 };
+    static uint32_t s_warn_age = FLAGS_WARN_INTERVAL;
+
+    memset(&sample->hw_uv, 0, sizeof(sample->hw_uv));
+    memset(&sample->hw_ov, 0, sizeof(sample->hw_ov));
+    if (g_cfg.battery.adapter_mode != BMS_ADAPTER_LTC6804) {
+        return;
     }
 
-    const TickType_t feed_ticks = pdMS_TO_TICKS(WDT_FEED_MS);
+    uint8_t num_cells = g_cfg.battery.num_cells;
+    uint32_t stage_start = stage_timing_now_us();
+    esp_err_t ret = ltc6804_read_cell_flags(&sample->hw_uv, &sample->hw_ov);
+    bms_cell_mask_t mismatch = { 0 };
+    uint16_t mismatch_cells = 0;
+    uint32_t statb_flags = 0;
+    if (ret == ESP_OK) {
+        // Comparators see uncalibrated codes, so the cross-check uses raw voltages
+        uint16_t codes[LTC6804_MAX_CELLS];
+        float raw_v[LTC6804_MAX_CELLS];
+        ltc6804_get_raw_codes(codes);
+        for (uint8_t c = 0; c < num_cells; ++c) {
+            raw_v[c] = (float)codes[c] * 0.0001f;
+        }
+        mismatch_cells = ltc6804_flags_mismatch(sample->hw_uv.w, sample->hw_ov.w, raw_v, num_cells,
+                                                g_cfg.battery.cell_v_min, g_cfg.battery.cell_v_max, mismatch.w);
+        // Telemetry keeps the STATB layout of cells 0-11
+        for (uint8_t c = 0; c < num_cells && c < LTC6804_IC_CELLS; ++c) {
+            statb_flags |= (uint32_t)bms_cell_mask_test(&sample->hw_uv, c) << (2u * c);
+            statb_flags |= (uint32_t)bms_cell_mask_test(&sample->hw_ov, c) << (2u * c + 1u);
+        }
+    }
 
-    // Main Fast Core feeder loop. Periodically feed TWDT if allowed.
-    while (!s_should_exit)
-    {
-        // Variable s_allow_feeding indicates whether feeding is allowed. Variable can be set to false
-        // by Fast Core tasks on error conditions.
-        if (s_allow_feeding) {
-            if (bms_wdt_feed_self() != ESP_OK) {
-                BMS_LOGE("HW WD feed failed (Fast Core feeder)");
+    // First disagreeing cell and first cell with a newly set flag, num_cells if none
+    uint8_t first_mismatch = num_cells;
+    uint8_t first_new = num_cells;
+    for (uint8_t c = 0; c < num_cells && ret == ESP_OK; ++c) {
+        if (first_mismatch == num_cells && bms_cell_mask_test(&mismatch, c)) {
+            first_mismatch = c;
+        }
+        if (first_new == num_cells &&
+            ((bms_cell_mask_test(&sample->hw_uv, c) && !bms_cell_mask_test(&s_prev_uv, c)) ||
+             (bms_cell_mask_test(&sample->hw_ov, c) && !bms_cell_mask_test(&s_prev_ov, c)))) {
+            first_new = c;
+        }
+    }
+    telemetry_update_ltc6804_flags(statb_flags, mismatch_cells, first_mismatch, (ret == ESP_OK));
+    stage_timing_record(FC_STAGE_FLAGS_READ, stage_timing_now_us() - stage_start);
+
+    if (s_warn_age < FLAGS_WARN_INTERVAL) {
+        s_warn_age++;
+    }
+    if (ret != ESP_OK) {
+        if (s_warn_age >= FLAGS_WARN_INTERVAL) {
+            BMS_LOGW("LTC6804 cell flag read failed: %s", esp_err_to_name(ret));
+            s_warn_age = 0;
+        }
+        return;
+    }
+    if (first_new < num_cells && s_warn_age >= FLAGS_WARN_INTERVAL) {
+        BMS_LOGW("LTC6804 cell %u %s flag set", (unsigned)first_new,
+                 bms_cell_mask_test(&sample->hw_uv, first_new) ? "UV" : "OV");
+        s_warn_age = 0;
+    }
+    if (mismatch_cells && s_warn_age >= FLAGS_WARN_INTERVAL) {
+        BMS_LOGW("LTC6804 cell flags disagree with software limits on %u cells (first cell %u)",
+                 (unsigned)mismatch_cells, (unsigned)first_mismatch);
+        s_warn_age = 0;
+    }
+    s_prev_uv = sample->hw_uv;
+    s_prev_ov = sample->hw_ov;
+
+    return;
+}
+#endif
+
+#if CONFIG_BMS_TIMESYNC
+/// This function waits for the next Fast Core cycle. Once the device is synchronized, the cycle starts at the next
+/// wall-clock edge of the period (whole multiple of it in UTC). The edge falls between RTOS ticks, so a one-shot
+/// esp_timer notifies the task, and the wake error is recorded for telemetry. Before synchronization, or if the
+/// timer fails, the periodic tick delay is used.
+///
+/// \param[in,out] last_wake Wake time of the periodic delay (follows aligned wakes)
+/// \param[in] period Period in ticks
+/// \param[in] period_ms Period in milliseconds
+/// \return UTC of the new cycle in ms since the Unix epoch (the edge for aligned cycles), 0 if not synchronized
+static uint64_t wait_next_cycle(TickType_t *last_wake, TickType_t period, uint32_t period_ms)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t edge_epoch;
+    int64_t edge_mono;
+
+    if (s_edge_timer && bms_timesync_next_edge(now, period_ms * 1000u, &edge_epoch, &edge_mono)) {
+        int64_t delay_us = edge_mono - now;
+        if (delay_us < 1) {
+            delay_us = 1;
+        }
+        // Drop a notification left over from a timed out wait
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (esp_timer_start_once(s_edge_timer, (uint64_t)delay_us) == ESP_OK) {
+            // Two periods without notification mean the timer is lost, fall back to the tick delay
+            if (ulTaskNotifyTake(pdTRUE, 2 * period + 1) != 0) {
+                int64_t woke_epoch;
+                if (bms_timesync_to_epoch_us(esp_timer_get_time(), &woke_epoch)) {
+                    bms_timesync_record_wake(woke_epoch - edge_epoch);
+                }
+                *last_wake = xTaskGetTickCount();
+                return (uint64_t)(edge_epoch / 1000);
             }
+            esp_timer_stop(s_edge_timer);
+            BMS_LOGW("Edge timer did not fire, waiting for tick");
         }
-        // Put task into blocked state for defined period
-        vTaskDelay(feed_ticks);
     }
-    
-    // Unregister from TWDT before exiting to prevent watchdog trigger
-    BMS_LOGI("Fast Core feeder unregistering from TWDT and exiting gracefully");
-    bms_wdt_unregister_current_task();
-    s_fast_core_feeder_handle = NULL;
-    vTaskDelete(NULL);
+
+    vTaskDelayUntil(last_wake, period);
+
+    return cycle_epoch_ms();
+}
+
+/// This function gets UTC of a cycle not started on a wall-clock edge (current time).
+///
+/// \param None
+/// \return UTC in ms since the Unix epoch, 0 if not synchronized
+static uint64_t cycle_epoch_ms(void)
+{
+    int64_t epoch_us;
+    if (!bms_timesync_to_epoch_us(esp_timer_get_time(), &epoch_us) || epoch_us <= 0) {
+        return 0;
+    }
+
+    return (uint64_t)(epoch_us / 1000);
+}
+
+/// Edge timer callback (esp_timer task, Core 0). Wakes the Fast Core task.
+///
+/// \param[in] arg Unused
+/// \return None
+static void edge_timer_cb(void *arg)
+{
+    (void)arg;
+
+    TaskHandle_t task = s_fast_core_task_handle;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
 
     return;
 }
+#endif
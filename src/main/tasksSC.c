@@ -9,9 +9,12 @@
 #include "freertos/task.h"
 #include "esp_err.h"
 #include "esp_log.h"
-#include "watchdog.h"
+#include "supervisor.h"
 #include "tasksSC.h"
 #include "appsm.h"
+#include "json_formatter.h"
+#include "power_mode.h"
+#include "wifi.h"
 #include "logging.h"
 
 /*==============================================================================================================*/
@@ -20,15 +23,21 @@
 /// Log module tag used by logging module
 #define LOG_MODULE_TAG "TASKS_SC"
 
-/// Slow Core SW watchdog strobe period and timeout in miliseconds.
-/// Slow Core SW watchdog monitors duty cycle of Slow Core task.
-/// If Slow Core task does not strobe within timeout period, HW TWDT is allowed to expire, causing system reset.
+/// Slow Core task stack size in bytes, grows with the statistics of a layout beyond 12 cells
+#define SLOW_CORE_TASK_STACK  (7680 + BMS_STATS_STACK_CELLS_LEN)
+
+/// Slow Core task period (heartbeat period) in milliseconds.
 #define CORE0_SW_STROBE_MS    1000
-/// Slow Core SW watchdog timeout in milliseconds.
-#define CORE0_SW_TIMEOUT_MS  30000
 
-/// TWDT feeding period in milliseconds. Used by Slow Core feeder.
-#define WDT_FEED_MS             20
+/// Slow Core task period in low-power mode in milliseconds. Samples arrive once per CONFIG_BMS_LOW_POWER_PERIOD_MS,
+/// so statistics windows (counted in samples) are complete only every few minutes and are published in one batch.
+#define CORE0_LOW_POWER_MS    5000
+
+/// Maximum allowed age of Slow Core heartbeat in milliseconds.
+/// If Slow Core task does not post heartbeat within this time, HW TWDT is allowed to expire, causing system reset.
+#ifndef CONFIG_BMS_SUP_SLOW_DEADLINE_MS
+#define CONFIG_BMS_SUP_SLOW_DEADLINE_MS  30000
+#endif
 
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
@@ -38,7 +47,6 @@
 /*                                       Private Function Prototypes                                            */
 /*==============================================================================================================*/
 static void slow_core_task();
-static void slow_core_feeder_task();
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
@@ -47,14 +55,12 @@ static void slow_core_feeder_task();
 /*==============================================================================================================*/
 /*                                            Private Variables                                                 */
 /*==============================================================================================================*/
-/// Flag indicating whether feeding of HW TWDT is allowed. Set to false on Slow Core SW watchdog timeout.
-static volatile bool s_allow_feeding = true;
-
-/// Flag to signal feeder task to exit gracefully
-static volatile bool s_should_exit_feeder = false;
-
-/// Task handle for Slow Core feeder (needed for deletion)
-static TaskHandle_t s_slow_core_feeder_handle = NULL;
+#if CONFIG_BMS_STATIC_ALLOCATION
+/// Static stack of Slow Core task
+static StackType_t s_slow_core_task_stack[SLOW_CORE_TASK_STACK];
+/// Static control block of Slow Core task
+static StaticTask_t s_slow_core_task_tcb;
+#endif
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -73,8 +79,14 @@ esp_err_t slow_core_task_create(void)
 {
     BaseType_t result;
 
-    // Create Slow Core task. Lower priority than Slow Core feeder to ensure feeder runs.
-    result = xTaskCreatePinnedToCore(slow_core_task, "slow_core_task", 6144, NULL, 4, NULL, 0);
+    // Create Slow Core task. Lower priority than supervisor to ensure supervisor runs.
+#if CONFIG_BMS_STATIC_ALLOCATION
+    TaskHandle_t handle = xTaskCreateStaticPinnedToCore(slow_core_task, "slow_core_task", SLOW_CORE_TASK_STACK,
+                                                        NULL, 4, s_slow_core_task_stack, &s_slow_core_task_tcb, 0);
+    result = handle ? pdPASS : pdFAIL;
+#else
+    result = xTaskCreatePinnedToCore(slow_core_task, "slow_core_task", SLOW_CORE_TASK_STACK, NULL, 4, NULL, 0);
+#endif
     if (result != pdPASS) {
         BMS_LOGE("Failed to create Slow Core task");
         return ESP_FAIL;
@@ -83,139 +95,57 @@ esp_err_t slow_core_task_create(void)
     return ESP_OK;
 }
 
-/// This function creates TWDT task on Slow Core. Used to feed HW TWDT periodically.
-///
-/// \param None
-/// \return ESP_OK on success, otherwise an error code
-esp_err_t slow_core_TWDT_create(void)
-{
-    BaseType_t result;
-
-    // Create Slow Core TWDT feeder task. Higher priority than Slow Core task to ensure feeder runs.
-    result = xTaskCreatePinnedToCore(slow_core_feeder_task, "slow_core_feeder_task", 3072, NULL, 5, &s_slow_core_feeder_handle, 0);
-    if (result != pdPASS) {
-        BMS_LOGE("Failed to create Slow Core feeder task");
-        return ESP_FAIL;
-    }
-
-    return ESP_OK;
-}
-
-/// This function deletes Slow Core feeder task.
-/// Task will unregister from TWDT gracefully before deletion.
-///
-/// \param None
-/// \return None
-void slow_core_TWDT_delete(void)
-{
-    if (s_slow_core_feeder_handle) {
-        BMS_LOGI("Signaling Slow Core feeder to exit gracefully");
-        s_should_exit_feeder = true;
-        
-        // Wait for task to exit gracefully (up to 200ms)
-        for (int i = 0; i < 4; i++) {
-            if (!s_slow_core_feeder_handle) {
-                break;  // Task exited
-            }
-            vTaskDelay(pdMS_TO_TICKS(50));
-        }
-        
-        // Force delete if still running.
-        if (s_slow_core_feeder_handle) {
-            BMS_LOGW("Force deleting Slow Core feeder task (didn't exit gracefully)");
-            vTaskDelete(s_slow_core_feeder_handle);
-            s_slow_core_feeder_handle = NULL;
-        }
-        
-        // Reset flags for potential restart
-        s_allow_feeding = true;
-        s_should_exit_feeder = false;
-        
-        BMS_LOGI("Slow Core feeder cleaned up");
-    }
-
-    return;
-}
-
 /*==============================================================================================================*/
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
 /// Slow Core task handles application state machine execution and non-real-time processing. Contains infinite loop
-/// that periodically calls application state machine executor and monitors its execution time for SW watchdog purposes.
+/// that periodically calls application state machine executor and posts heartbeat to supervisor after each run.
 ///
 /// \param None
 /// \return None
 static void slow_core_task()
 {
-    // SW watchdog timing parameters
-    const TickType_t sw_check_ticks   = pdMS_TO_TICKS(CORE0_SW_STROBE_MS);
-    const TickType_t sw_timeout_ticks = pdMS_TO_TICKS(CORE0_SW_TIMEOUT_MS);
+    const TickType_t sw_check_ticks = pdMS_TO_TICKS(CORE0_SW_STROBE_MS);
 
-    // Timing variables for SW watchdog
-    TickType_t start;
-    TickType_t end;
+    // Register heartbeat with supervisor. Supervisor itself is started after initialization state.
+    int hb_id = supervisor_register("slow_core", CORE0_SW_STROBE_MS, CONFIG_BMS_SUP_SLOW_DEADLINE_MS);
 
     // Previous wake time for absolute periodic delay (ensures 1 s period regardless of processing time)
     TickType_t last_wake = xTaskGetTickCount();
+#if CONFIG_BMS_LOW_POWER
+    // Power mode applied to this task and to Wi-Fi (mode itself is switched by the Fast Core)
+    pwr_mode_t applied_mode = PWR_MODE_FULL;
+    TickType_t period = sw_check_ticks;
+#endif
 
     // Main Slow Core loop
     while (1)
     {
-        // Start SW watchdog timing
-        start = xTaskGetTickCount();
-
         app_states_exec();
 
-        // End SW watchdog timing and check for timeout
-        end = xTaskGetTickCount();
-        // If Slow Core task overran SW watchdog timeout, disable TWDT feeding
-        if ((end - start) > sw_timeout_ticks) {
-            BMS_LOGE("Slow Core SW watchdog timeout (> %d ms), disabling HW WD feed", CORE0_SW_TIMEOUT_MS);
-            s_allow_feeding = false;
+        // Stalled state machine stops heartbeats, supervisor then stops feeding HW TWDT
+        supervisor_heartbeat(hb_id);
+
+#if CONFIG_BMS_LOW_POWER
+        // Follow power mode of the Fast Core: Wi-Fi modem sleep and longer period in low-power mode
+        pwr_mode_t mode = power_mode_get();
+        if (mode != applied_mode) {
+            bool low = (mode == PWR_MODE_LOW);
+            bms_wifi_set_power_save(low);
+            uint32_t period_ms = low ? CORE0_LOW_POWER_MS : CORE0_SW_STROBE_MS;
+            supervisor_set_period(hb_id, period_ms);
+            period = pdMS_TO_TICKS(period_ms);
+            last_wake = xTaskGetTickCount();
+            applied_mode = mode;
         }
 
+        // Puts task into blocked state until next absolute period
+        vTaskDelayUntil(&last_wake, period);
+#else
         // Puts task into blocked state until next absolute period
         vTaskDelayUntil(&last_wake, sw_check_ticks);
+#endif
     }
 
     // Missing return because it is not reachable
 }
-
-/// Slow Core TWDT feeder task. This task periodically feeds (resets) the hardware TWDT to prevent timeout.
-/// Feeding is only performed if ::s_allow_feeding flag is true, otherwise feeding is skipped, allowing TWDT to expire
-/// and reset the system.
-///
-/// \param None
-/// \return None
-static void slow_core_feeder_task()
-{
-    // Register current task with TWDT. If registration fails, delete task.
-    if (bms_wdt_register_current_task() != ESP_OK) {
-        BMS_LOGE("Failed to register Slow Core feeder to TWDT");
-        vTaskDelete(NULL);
-    }
-
-    const TickType_t feed_ticks = pdMS_TO_TICKS(WDT_FEED_MS);
-
-    // Main Slow Core feeder loop. Periodically feed TWDT if allowed.
-    while (!s_should_exit_feeder)
-    {
-        // Variable s_allow_feeding indicates whether feeding is allowed. Variable can be set to false
-        // by Slow Core tasks on error conditions.
-        if (s_allow_feeding) {
-            if (bms_wdt_feed_self() != ESP_OK) {
-                BMS_LOGE("HW WD feed failed (Slow Core feeder)");
-            }
-        }
-        // Put task into blocked state for defined period
-        vTaskDelay(feed_ticks);
-    }
-    
-    // Unregister from TWDT before exiting to prevent watchdog trigger
-    BMS_LOGI("Slow Core feeder unregistering from TWDT and exiting gracefully");
-    bms_wdt_unregister_current_task();
-    s_slow_core_feeder_handle = NULL;
-    vTaskDelete(NULL);
-
-    return;
-}
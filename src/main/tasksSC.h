@@ -27,8 +27,6 @@
 /*                                        Public Function Prototypes                                            */
 /*==============================================================================================================*/
 esp_err_t slow_core_task_create(void);
-esp_err_t slow_core_TWDT_create(void);
-void slow_core_TWDT_delete(void);
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
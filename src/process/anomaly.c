@@ -0,0 +1,307 @@
+/// This module detects cells drifting away from the rest of the pack before they reach the hard voltage limits. It
+/// runs once per statistics window on the window's average cell voltages and keeps a fixed amount of state per cell,
+/// so a window costs O(cells) (median by selection, expected linear time) and memory does not grow with run time.
+///
+/// The pack consensus is the median of the cell voltages, which a single weak cell cannot pull. For each cell the
+/// deviation from the median is followed by an exponentially weighted average and variance with time constant
+/// CONFIG_BMS_ANOMALY_TAU_S; weights follow the window length, so 0.2 s windows during violations do not speed up
+/// the averages. Each window yields three features per cell: the averaged deviation, the spread (standard
+/// deviation) of the deviation, which grows when a cell reacts more strongly to load, and the rate of change of the
+/// deviation (dV/dt against the pack). Every feature is turned into a robust z value against all cells (distance
+/// from the median over 1.4826 times the median absolute deviation), so normal spread between healthy cells sets the
+/// scale. Scales are bounded below (CONFIG_BMS_ANOMALY_FLOOR_MV, 2 mV/s) so a very uniform pack does not amplify
+/// tiny differences. The graded score of a cell is its largest z value.
+///
+/// A cell whose score stays at or above CONFIG_BMS_ANOMALY_ALARM_SCORE for CONFIG_BMS_ANOMALY_HOLD_S raises an alarm,
+/// which clears after the score stayed below half of the alarm score for the same time. Alarm changes are logged.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "anomaly.h"
+#include "logging.h"
+#include <math.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "BMS_ANOMALY"
+
+/// Scale of the median absolute deviation to the standard deviation of normally distributed values
+#define MAD_TO_SIGMA        1.4826f
+
+/// Lower bound of the dV/dt scale (V/s)
+#define SLOPE_FLOOR_V_S     0.002f
+
+/// Longest gap between windows (s) over which the deviation rate of change is computed; averages are then
+/// weighted as if this much time had passed
+#define MAX_GAP_S           10.0f
+
+/// Largest reported score
+#define SCORE_MAX           99.9f
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of detector state of one cell
+typedef struct {
+    float dev_avg;                          ///< Weighted average of the deviation from the pack median (V)
+    float dev_var;                          ///< Weighted variance of the deviation (V^2)
+    float dev_prev;                         ///< Deviation in the previous window (V)
+    float hold_s;                           ///< Time the score stayed beyond the alarm raise (clear) threshold (s)
+} cell_state_t;
+
+/// Structure of per-cell scratch values of one window
+typedef struct {
+    float work[BMS_MAX_CELLS];              ///< Copy reordered by median selection
+    float dev[BMS_MAX_CELLS];               ///< Deviation from the pack median (V)
+    float avg[BMS_MAX_CELLS];               ///< Weighted average of the deviation (V)
+    float spread[BMS_MAX_CELLS];            ///< Standard deviation of the deviation (V)
+    float slope[BMS_MAX_CELLS];             ///< Rate of change of the deviation (V/s)
+    float z_avg[BMS_MAX_CELLS];             ///< Robust z of avg
+    float z_spread[BMS_MAX_CELLS];          ///< Robust z of spread
+    float z_slope[BMS_MAX_CELLS];           ///< Robust z of slope
+} scratch_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static float median(float *v, uint8_t n);
+static void robust_z(const float *x, uint8_t n, float floor, float *z);
+static void update_alarm(uint8_t c, float score, float dt);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Detector state per cell
+static cell_state_t s_cells[BMS_MAX_CELLS];
+/// Number of cells the state was built for (0 until the first window)
+static uint8_t s_num_cells = 0;
+/// Timestamp of the previous window
+static TickType_t s_prev_ts = 0;
+/// Cells in alarm
+static bms_cell_mask_t s_alarm = { 0 };
+/// Scratch values of bms_anomaly_update(); static like the detector state, which is used by a single task only, so
+/// the caller's stack (Slow Core) does not grow with BMS_MAX_CELLS
+static scratch_t s_scratch;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function clears the detector state and all alarms. The next window seeds the averages.
+///
+/// \param None
+/// \return None
+void bms_anomaly_init(void)
+{
+    memset(s_cells, 0, sizeof(s_cells));
+    s_num_cells = 0;
+    s_prev_ts = 0;
+    memset(&s_alarm, 0, sizeof(s_alarm));
+
+    return;
+}
+
+/// This function updates the detector with the average cell voltages of one statistics window and computes scores
+/// and alarms. Windows must be passed in time order; a change of the cell count restarts the detector.
+///
+/// \param[in]  timestamp Timestamp of the window
+/// \param[in]  cell_v    Average cell voltages of the window (V)
+/// \param[in]  num_cells Number of cells (scores stay 0 below ::BMS_ANOMALY_MIN_CELLS)
+/// \param[out] out       Scores, averaged deviations and alarm bitmask
+/// \return None
+void bms_anomaly_update(TickType_t timestamp, const float *cell_v, uint8_t num_cells, bms_anomaly_t *out)
+{
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!cell_v || num_cells < BMS_ANOMALY_MIN_CELLS || num_cells > BMS_MAX_CELLS) {
+        return;
+    }
+
+    bool first = (num_cells != s_num_cells);
+    if (first) {
+        bms_anomaly_init();
+        s_num_cells = num_cells;
+    }
+
+    float dt = (float)(TickType_t)(timestamp - s_prev_ts) * (float)portTICK_PERIOD_MS * 0.001f;
+    bool have_slope = !first && dt > 0.0f && dt <= MAX_GAP_S;
+    if (dt > MAX_GAP_S) {
+        dt = MAX_GAP_S;
+    }
+    s_prev_ts = timestamp;
+
+    // Pack consensus and deviation of each cell from it
+    float *work = s_scratch.work;
+    float *dev = s_scratch.dev;
+    memcpy(work, cell_v, num_cells * sizeof(float));
+    float consensus = median(work, num_cells);
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        dev[c] = cell_v[c] - consensus;
+    }
+
+    // Weighted average and variance of the deviation; the first window seeds the average with zero variance
+    float alpha = first ? 1.0f : dt / ((float)CONFIG_BMS_ANOMALY_TAU_S + dt);
+    float *spread = s_scratch.spread;
+    float *slope = s_scratch.slope;
+    float *avg = s_scratch.avg;
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        cell_state_t *cs = &s_cells[c];
+        float diff = dev[c] - cs->dev_avg;
+        float incr = alpha * diff;
+        cs->dev_avg += incr;
+        cs->dev_var = (1.0f - alpha) * (cs->dev_var + diff * incr);
+        slope[c] = have_slope ? (dev[c] - cs->dev_prev) / dt : 0.0f;
+        cs->dev_prev = dev[c];
+        avg[c] = cs->dev_avg;
+        spread[c] = sqrtf(cs->dev_var);
+    }
+
+    // Robust z of each feature against all cells
+    const float floor_v = (float)CONFIG_BMS_ANOMALY_FLOOR_MV * 0.001f;
+    float *z_avg = s_scratch.z_avg;
+    float *z_spread = s_scratch.z_spread;
+    float *z_slope = s_scratch.z_slope;
+    robust_z(avg, num_cells, floor_v, z_avg);
+    robust_z(spread, num_cells, floor_v, z_spread);
+    robust_z(slope, num_cells, SLOPE_FLOOR_V_S, z_slope);
+
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        float score = fmaxf(fmaxf(z_avg[c], z_spread[c]), z_slope[c]);
+        score = fminf(score, SCORE_MAX);
+        update_alarm(c, score, first ? 0.0f : dt);
+
+        out->score[c] = score;
+        out->dev_v[c] = avg[c];
+    }
+    out->alarm = s_alarm;
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function computes the median of values by selection (Hoare's quickselect, expected linear time). The values
+/// are reordered.
+///
+/// \param[in,out] v Values
+/// \param[in]     n Number of values (at least 1)
+/// \return Median (mean of the two middle values for even n)
+static float median(float *v, uint8_t n)
+{
+    const int k = n / 2;
+    int lo = 0;
+    int hi = n - 1;
+
+    // Partition around the middle element until v[k] is in its sorted position
+    while (lo < hi) {
+        float pivot = v[(lo + hi) / 2];
+        int i = lo;
+        int j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) {
+                i++;
+            }
+            while (v[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                float t = v[i];
+                v[i] = v[j];
+                v[j] = t;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+
+    if (n & 1u) {
+        return v[k];
+    }
+
+    // Values below index k are not greater than v[k], the lower middle value is their maximum
+    float lower = v[0];
+    for (int i = 1; i < k; ++i) {
+        lower = fmaxf(lower, v[i]);
+    }
+
+    return 0.5f * (lower + v[k]);
+}
+
+/// This function computes robust z values: distance of each value from the median of all values, in units of
+/// the median absolute deviation scaled to a standard deviation.
+///
+/// \param[in]  x     Values
+/// \param[in]  n     Number of values (at least 1)
+/// \param[in]  floor Lower bound of the scale, in units of x
+/// \param[out] z     Absolute robust z of each value
+/// \return None
+static void robust_z(const float *x, uint8_t n, float floor, float *z)
+{
+    // The consensus copy of bms_anomaly_update() is no longer needed here
+    float *work = s_scratch.work;
+
+    memcpy(work, x, n * sizeof(float));
+    float center = median(work, n);
+    for (uint8_t i = 0; i < n; ++i) {
+        work[i] = fabsf(x[i] - center);
+    }
+    float inv_scale = 1.0f / fmaxf(MAD_TO_SIGMA * median(work, n), floor);
+    for (uint8_t i = 0; i < n; ++i) {
+        z[i] = fabsf(x[i] - center) * inv_scale;
+    }
+
+    return;
+}
+
+/// This function raises or clears the alarm of a cell once its score stayed beyond the threshold for
+/// CONFIG_BMS_ANOMALY_HOLD_S.
+///
+/// \param[in] c     Cell index
+/// \param[in] score Score of the cell in this window
+/// \param[in] dt    Time since the previous window (s)
+/// \return None
+static void update_alarm(uint8_t c, float score, float dt)
+{
+    cell_state_t *cs = &s_cells[c];
+    const float raise = (float)CONFIG_BMS_ANOMALY_ALARM_SCORE;
+    bool active = bms_cell_mask_test(&s_alarm, c);
+    bool beyond = active ? (score < 0.5f * raise) : (score >= raise);
+
+    cs->hold_s = beyond ? (cs->hold_s + dt) : 0.0f;
+    if (cs->hold_s < (float)CONFIG_BMS_ANOMALY_HOLD_S) {
+        return;
+    }
+
+    cs->hold_s = 0.0f;
+    if (active) {
+        bms_cell_mask_clear(&s_alarm, c);
+        BMS_LOGI("Cell %u anomaly cleared (score %.1f)", (unsigned)c + 1u, (double)score);
+    } else {
+        bms_cell_mask_set(&s_alarm, c);
+        BMS_LOGW("Cell %u anomaly (score %.1f, deviation %+.1f mV)", (unsigned)c + 1u, (double)score,
+                 (double)(cs->dev_avg * 1000.0f));
+    }
+
+    return;
+}
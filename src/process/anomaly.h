@@ -0,0 +1,69 @@
+/// Header file for `anomaly.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "bms_data.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Enables per-cell anomaly scores and alarms in statistics and published JSON
+#ifndef CONFIG_BMS_ANOMALY
+#define CONFIG_BMS_ANOMALY              0
+#endif
+
+/// Time constant of the per-cell deviation average and variance (s)
+#ifndef CONFIG_BMS_ANOMALY_TAU_S
+#define CONFIG_BMS_ANOMALY_TAU_S        30
+#endif
+
+/// Lower bound of the deviation scale (mV), keeps scores of a very uniform pack from amplifying tiny offsets
+#ifndef CONFIG_BMS_ANOMALY_FLOOR_MV
+#define CONFIG_BMS_ANOMALY_FLOOR_MV     5
+#endif
+
+/// Score at which a cell counts as anomalous; the alarm clears below half of it
+#ifndef CONFIG_BMS_ANOMALY_ALARM_SCORE
+#define CONFIG_BMS_ANOMALY_ALARM_SCORE  6
+#endif
+
+/// Time a cell has to stay above (below) the alarm score before its alarm is raised (cleared) (s)
+#ifndef CONFIG_BMS_ANOMALY_HOLD_S
+#define CONFIG_BMS_ANOMALY_HOLD_S       10
+#endif
+
+/// Minimum number of cells for a meaningful pack consensus
+#define BMS_ANOMALY_MIN_CELLS           3
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of anomaly detector output for one statistics window
+typedef struct {
+    float    score[BMS_MAX_CELLS];          ///< Graded anomaly score per cell (robust z units, about 1 = typical)
+    float    dev_v[BMS_MAX_CELLS];          ///< Averaged deviation of each cell from the pack median (V)
+    bms_cell_mask_t alarm;                  ///< Cells with a sustained anomaly
+} bms_anomaly_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void bms_anomaly_init(void);
+void bms_anomaly_update(TickType_t timestamp, const float *cell_v, uint8_t num_cells, bms_anomaly_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
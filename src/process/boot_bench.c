@@ -0,0 +1,369 @@
+/// This module implements the on-target microbenchmark run at boot when CONFIG_BMS_BOOT_BENCH is enabled. A fixed
+/// suite of pipeline operations runs on the Fast Core (Core 1) before real-time tasks are created, every
+/// iteration is measured in CPU cycles by esp_cpu_get_cycle_count(). Results (min/mean/max cycles per operation)
+/// are logged over UART and kept as JSON served at /bms/bench, then boot continues normally.
+/// The minimum is the most reproducible value and is intended for comparing commits.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "boot_bench.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "logging.h"
+#include "process.h"
+#include "json_formatter.h"
+#include "intercore_comm.h"
+#include "ltc6804_codec.h"
+#include "ltc6804.h"
+#include "pt1000.h"
+#include "goertzel.h"
+#include "configuration.h"
+#include <stdio.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "BOOT_BENCH"
+
+/// Stack size of benchmark task in bytes (holds one statistics JSON buffer)
+#define BOOT_BENCH_TASK_STACK   (6144 + BMS_STATS_STACK_CELLS_LEN)
+
+/// Maximum time to wait for benchmark task in milliseconds
+#define BOOT_BENCH_TIMEOUT_MS   10000
+
+/// Maximum length of results JSON
+#define BOOT_BENCH_JSON_MAXLEN  1024
+
+/// Number of samples in one statistics window (1 s at 20 Hz)
+#define BOOT_BENCH_WINDOW       20
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Enumeration of benchmark cases
+typedef enum {
+    BB_CASE_PEC_REGS = 0,       ///< Byte-wise PEC check of the four cell voltage register groups
+    BB_CASE_DECODE_REGS,        ///< Cell codes and PEC of the four register groups in one pass (driver read)
+    BB_CASE_STATS_CLEAN,        ///< Statistics of a full window without limit violations (single 1 s window)
+    BB_CASE_STATS_VIOLATION,    ///< Statistics of a full window with limit violation (five 0.2 s windows)
+    BB_CASE_JSON,               ///< Serialization of one statistics window (telemetry every 10th message)
+    BB_CASE_QUEUE_RT,           ///< Inter-core queue push and pop of one sample
+    BB_CASE_PT1000_POS,         ///< PT1000 conversion above 0 deg C (quadratic solution)
+    BB_CASE_PT1000_NEG,         ///< PT1000 conversion below 0 deg C (Newton-Raphson refinement)
+    BB_CASE_GOERTZEL,           ///< One current sample into the ripple filter bank (4 frequencies, 1 kHz, 1 s blocks)
+    BB_CASE_COUNT,              ///< Number of cases (not a case)
+} bb_case_t;
+
+/// Structure containing cycle counts of one benchmark case
+typedef struct {
+    uint32_t iterations;        ///< Number of measured iterations
+    uint32_t min;               ///< Minimum cycles per iteration
+    uint32_t max;               ///< Maximum cycles per iteration
+    uint64_t sum;               ///< Sum of cycles of all iterations
+} bb_result_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void boot_bench_task(void *arg);
+static void run_suite(void);
+static void record(bb_case_t c, uint32_t cycles);
+static void fill_samples(bms_sample_t *samples, size_t count, bool violation);
+static void format_results(void);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Names of benchmark cases
+static const char *const s_case_names[BB_CASE_COUNT] = {
+    "pec_regs", "decode_regs", "stats_clean", "stats_violation", "json", "queue_rt",
+    "pt1000_pos", "pt1000_neg", "goertzel",
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Results of benchmark cases
+static bb_result_t s_results[BB_CASE_COUNT];
+
+/// Results JSON, empty until the suite has run
+static char s_json[BOOT_BENCH_JSON_MAXLEN];
+
+/// Semaphore signalled by benchmark task when done
+static SemaphoreHandle_t s_done = NULL;
+
+/// Sample storage for statistics cases
+static bms_sample_t s_samples[BOOT_BENCH_WINDOW];
+
+/// Sink preventing the compiler from removing benchmarked work
+static volatile uint32_t s_sink;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function runs the benchmark suite in a task pinned to the Fast Core and waits until it finishes.
+/// Must be called after inter-core queue initialization and before Fast Core tasks are created, so the
+/// queue is empty and Core 1 is idle.
+///
+/// \param None
+/// \return ESP_OK on success, ESP_ERR_NO_MEM if task cannot be created, ESP_ERR_TIMEOUT if suite does not finish
+esp_err_t boot_bench_run(void)
+{
+    s_done = xSemaphoreCreateBinary();
+    if (!s_done) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreatePinnedToCore(boot_bench_task, "boot_bench", BOOT_BENCH_TASK_STACK, NULL, 7, NULL, 1) != pdPASS) {
+        BMS_LOGE("Failed to create boot benchmark task");
+        vSemaphoreDelete(s_done);
+        s_done = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xSemaphoreTake(s_done, pdMS_TO_TICKS(BOOT_BENCH_TIMEOUT_MS)) != pdTRUE) {
+        BMS_LOGE("Boot benchmark did not finish within %d ms", BOOT_BENCH_TIMEOUT_MS);
+        // Task still references the semaphore, keep it
+        return ESP_ERR_TIMEOUT;
+    }
+    vSemaphoreDelete(s_done);
+    s_done = NULL;
+
+    return ESP_OK;
+}
+
+/// This function returns results of the boot benchmark as JSON object, or NULL if the suite has not run.
+///
+/// \param None
+/// \return Pointer to JSON string, or NULL
+const char *boot_bench_get_json(void)
+{
+    return s_json[0] ? s_json : NULL;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// Benchmark task. Runs the suite once, logs results and deletes itself.
+///
+/// \param[in] arg Unused
+/// \return None
+static void boot_bench_task(void *arg)
+{
+    (void)arg;
+
+    BMS_LOGI("Running boot benchmark (%d iterations per case)", CONFIG_BMS_BOOT_BENCH_ITERATIONS);
+    run_suite();
+    format_results();
+
+    for (int c = 0; c < BB_CASE_COUNT; ++c) {
+        const bb_result_t *r = &s_results[c];
+        BMS_LOGI("%-16s min %7lu  mean %7lu  max %7lu cycles",
+                 s_case_names[c],
+                 (unsigned long)r->min,
+                 (unsigned long)(r->iterations ? r->sum / r->iterations : 0),
+                 (unsigned long)r->max);
+    }
+    BMS_LOGI("BENCH %s", s_json);
+
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+
+    return;
+}
+
+/// This function runs all benchmark cases. Every iteration is measured separately, so that preemption by an
+/// interrupt only affects the maximum and the mean of a case.
+///
+/// \param None
+/// \return None
+static void run_suite(void)
+{
+    const int n = CONFIG_BMS_BOOT_BENCH_ITERATIONS;
+    uint32_t start;
+
+    memset(s_results, 0, sizeof(s_results));
+    for (int c = 0; c < BB_CASE_COUNT; ++c) {
+        s_results[c].min = UINT32_MAX;
+    }
+
+    // PEC over the four cell voltage register groups (as in one cell voltage read)
+    uint8_t regs[LTC6804_NUM_CV_REG][LTC6804_REG_RX_BYTES];
+    for (int r = 0; r < LTC6804_NUM_CV_REG; ++r) {
+        for (int b = 0; b < LTC6804_REG_DATA_BYTES; ++b) {
+            regs[r][b] = (uint8_t)(r * 17 + b * 5 + 3);
+        }
+        uint16_t pec = ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, regs[r]);
+        regs[r][6] = (uint8_t)(pec >> 8);
+        regs[r][7] = (uint8_t)pec;
+    }
+    for (int i = 0; i < n; ++i) {
+        int ok = 0;
+        start = esp_cpu_get_cycle_count();
+        for (int r = 0; r < LTC6804_NUM_CV_REG; ++r) {
+            ok += ltc6804_reg_pec_ok(regs[r]);
+        }
+        record(BB_CASE_PEC_REGS, esp_cpu_get_cycle_count() - start);
+        s_sink += (uint32_t)ok;
+    }
+    uint16_t codes[LTC6804_NUM_CV_REG * 3];
+    for (int i = 0; i < n; ++i) {
+        int ok = 0;
+        start = esp_cpu_get_cycle_count();
+        for (int r = 0; r < LTC6804_NUM_CV_REG; ++r) {
+            ok += ltc6804_decode_reg(regs[r], &codes[r * 3]);
+        }
+        record(BB_CASE_DECODE_REGS, esp_cpu_get_cycle_count() - start);
+        s_sink += (uint32_t)ok + codes[i % (LTC6804_NUM_CV_REG * 3)];
+    }
+
+    // Statistics of one full window, clean and with violation
+    bms_sample_buffer_t buf = { .samples = s_samples, .capacity = BOOT_BENCH_WINDOW };
+    bms_stats_buffer_t stats;
+    for (int v = 0; v < 2; ++v) {
+        bb_case_t c = v ? BB_CASE_STATS_VIOLATION : BB_CASE_STATS_CLEAN;
+        fill_samples(s_samples, BOOT_BENCH_WINDOW, v != 0);
+        for (int i = 0; i < n; ++i) {
+            buf.head  = 0;
+            buf.count = BOOT_BENCH_WINDOW;
+            start = esp_cpu_get_cycle_count();
+            bms_compute_stats(&buf, &stats);
+            record(c, esp_cpu_get_cycle_count() - start);
+            s_sink += stats.stats_count;
+        }
+    }
+
+    // JSON serialization of the last computed window
+    char json[BMS_STATS_JSON_MAXLEN];
+    for (int i = 0; i < n; ++i) {
+        start = esp_cpu_get_cycle_count();
+        int len = bms_stats_to_json(&stats.stats_array[0], json, sizeof(json));
+        record(BB_CASE_JSON, esp_cpu_get_cycle_count() - start);
+        s_sink += (uint32_t)len;
+    }
+
+    // Inter-core queue round trip
+    bms_sample_t out;
+    for (int i = 0; i < n; ++i) {
+        start = esp_cpu_get_cycle_count();
+        bool ok = bms_queue_push(&s_samples[0]) && bms_queue_pop(&out);
+        record(BB_CASE_QUEUE_RT, esp_cpu_get_cycle_count() - start);
+        s_sink += ok;
+    }
+
+    // PT1000 conversion. Raw values cover approx. 3..37 deg C and -63..-37 deg C.
+    for (int i = 0; i < n; ++i) {
+        int raw = 2060 + (i % 64) * 2;
+        start = esp_cpu_get_cycle_count();
+        float t = pt1000_raw_to_celsius(raw);
+        record(BB_CASE_PT1000_POS, esp_cpu_get_cycle_count() - start);
+        s_sink += (uint32_t)t;
+    }
+    for (int i = 0; i < n; ++i) {
+        int raw = 1760 + (i % 64) * 2;
+        start = esp_cpu_get_cycle_count();
+        float t = pt1000_raw_to_celsius(raw);
+        record(BB_CASE_PT1000_NEG, esp_cpu_get_cycle_count() - start);
+        s_sink += (uint32_t)(int32_t)t;
+    }
+
+    // Ripple filter bank, raw current codes of a 100 Hz ripple. Maximum includes the amplitude computation at the
+    // end of a block when the iteration count reaches the 1000 samples of a block.
+    static const float s_ripple_hz[4] = { 50.0f, 100.0f, 120.0f, 300.0f };
+    bms_goertzel_t bank;
+    bms_goertzel_init(&bank, 1000.0f, s_ripple_hz, 4, 1000);
+    float amp[BMS_GOERTZEL_MAX_BINS];
+    for (int i = 0; i < n; ++i) {
+        float x = 2048.0f + (float)(((i % 10) < 5) ? 300 : -300);
+        start = esp_cpu_get_cycle_count();
+        bool done = bms_goertzel_push(&bank, x, amp);
+        record(BB_CASE_GOERTZEL, esp_cpu_get_cycle_count() - start);
+        s_sink += done ? (uint32_t)amp[1] : 0u;
+    }
+
+    return;
+}
+
+/// This function adds one measured iteration to the results of a case.
+///
+/// \param[in] c Benchmark case
+/// \param[in] cycles Measured CPU cycles
+/// \return None
+static void record(bb_case_t c, uint32_t cycles)
+{
+    bb_result_t *r = &s_results[c];
+    r->iterations++;
+    r->sum += cycles;
+    if (cycles < r->min) {
+        r->min = cycles;
+    }
+    if (cycles > r->max) {
+        r->max = cycles;
+    }
+
+    return;
+}
+
+/// This function fills samples with cell voltages in the middle of configured limits. With violation, one cell
+/// of every 7th sample is above the overvoltage limit.
+///
+/// \param[out] samples Array of samples
+/// \param[in] count Number of samples
+/// \param[in] violation True to inject overvoltage
+/// \return None
+static void fill_samples(bms_sample_t *samples, size_t count, bool violation)
+{
+    const float mid = 0.5f * (g_cfg.battery.cell_v_min + g_cfg.battery.cell_v_max);
+
+    for (size_t i = 0; i < count; ++i) {
+        bms_sample_t *s = &samples[i];
+        s->pack_v = 0.0f;
+        for (int c = 0; c < BMS_MAX_CELLS; ++c) {
+            s->cell_v[c] = mid + 0.001f * (float)((i * 7 + (size_t)c * 3) % 50);
+            s->pack_v += s->cell_v[c];
+        }
+        if (violation && (i % 7) == 3) {
+            s->cell_v[i % g_cfg.battery.num_cells] = g_cfg.battery.cell_v_max + 0.1f;
+        }
+        s->pack_i      = 0.5f * (g_cfg.battery.series_pack_i_min + g_cfg.battery.series_pack_i_max);
+        s->temperature = 25.0f;
+        s->timestamp   = (TickType_t)i;
+    }
+
+    return;
+}
+
+/// This function formats results into ::s_json. CPU frequency is included so cycles can be converted to time.
+///
+/// \param None
+/// \return None
+static void format_results(void)
+{
+    int off = snprintf(s_json, sizeof(s_json), "{\"cpu_mhz\":%lu,\"iterations\":%d,\"num_cells\":%u,\"cycles\":{",
+                       (unsigned long)esp_rom_get_cpu_ticks_per_us(), CONFIG_BMS_BOOT_BENCH_ITERATIONS,
+                       (unsigned)g_cfg.battery.num_cells);
+
+    for (int c = 0; c < BB_CASE_COUNT && off > 0 && (size_t)off < sizeof(s_json); ++c) {
+        const bb_result_t *r = &s_results[c];
+        off += snprintf(s_json + off, sizeof(s_json) - (size_t)off, "%s\"%s\":[%lu,%lu,%lu]",
+                        c ? "," : "", s_case_names[c],
+                        (unsigned long)r->min,
+                        (unsigned long)(r->iterations ? r->sum / r->iterations : 0),
+                        (unsigned long)r->max);
+    }
+    if (off > 0 && (size_t)off < sizeof(s_json)) {
+        snprintf(s_json + off, sizeof(s_json) - (size_t)off, "}}");
+    }
+
+    return;
+}
@@ -1,4 +1,5 @@
-/// This module implements configuration loading and saving.
+/// This module implements configuration loading and saving. Public functions run all cJSON work within a JSON arena
+/// scope (see `json_arena.c`), so parse trees and printed strings never outlive the call.
 
 /*==============================================================================================================*/
 /*                                                Includes                                                      */
@@ -12,6 +13,7 @@
 #include "esp_log.h"
 #include "cJSON.h"
 #include "bms_data.h"
+#include "json_arena.h"
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
@@ -22,6 +24,14 @@
 /// Maximum allowed configuration file size in bytes (16 KB)
 #define MAX_CONFIG_FILE_SIZE  16384
 
+/// Path of configuration file updated by battery template changes
+#define CONFIG_FILE_PATH  "/spiffs/config.json"
+
+/// Maximum length of cached battery templates JSON when cJSON arena is used (including terminating zero)
+#ifndef CONFIG_BMS_TEMPLATES_JSON_MAXLEN
+#define CONFIG_BMS_TEMPLATES_JSON_MAXLEN  4096
+#endif
+
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
 /*==============================================================================================================*/
@@ -33,6 +43,16 @@ static void json_get_str(cJSON *obj, const char *key, char *out, size_t out_sz);
 static void json_get_float(cJSON *obj, const char *key, float *out);
 static void json_get_int(cJSON *obj, const char *key, int *out);
 static void json_get_bool(cJSON *obj, const char *key, bool *out);
+static esp_err_t load_config(const char *path);
+static esp_err_t save_config(const char *path);
+static esp_err_t add_template(const char *id, const char *name, const char *category,
+                              float cell_v_min, float cell_v_max,
+                              float series_pack_i_min, float series_pack_i_max);
+static esp_err_t edit_template(const char *id, const char *name, const char *category,
+                               float cell_v_min, float cell_v_max,
+                               float series_pack_i_min, float series_pack_i_max);
+static esp_err_t delete_template(const char *id);
+static esp_err_t store_templates(cJSON *templates);
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
@@ -44,6 +64,11 @@ static void json_get_bool(cJSON *obj, const char *key, bool *out);
 /// Cached JSON string of battery_templates array from config file.
 static char *s_battery_templates_json = NULL;
 
+#if CONFIG_BMS_JSON_ARENA
+/// Static storage of cached battery templates JSON. cJSON strings live in arena and are copied here.
+static char s_templates_buf[CONFIG_BMS_TEMPLATES_JSON_MAXLEN];
+#endif
+
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
 /*==============================================================================================================*/
@@ -81,6 +106,120 @@ configuration_t g_cfg = {
 /// \param[in] path Path to configuration file
 /// \return ESP_OK on success, otherwise an error code
 esp_err_t configuration_load(const char *path)
+{
+    json_arena_scope_begin();
+    esp_err_t ret = load_config(path);
+    json_arena_scope_end();
+
+    return ret;
+}
+
+/// This function saves the global configuration instance to a JSON file at the specified path.
+///
+/// \param[in] path Path to configuration file
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t configuration_save(const char *path)
+{
+    json_arena_scope_begin();
+    esp_err_t ret = save_config(path);
+    json_arena_scope_end();
+
+    return ret;
+}
+
+/// This function returns the cached battery templates JSON string loaded from config file.
+/// The returned string is a JSON array. Returns NULL if no templates were loaded.
+///
+/// \param None
+/// \return Pointer to battery templates JSON string, or NULL
+const char *configuration_get_battery_templates_json(void)
+{
+    return s_battery_templates_json;
+}
+
+/// This function adds a new custom battery template to the cached templates and saves to config file.
+/// If a group with the given category label already exists, the battery is appended to that group.
+/// Otherwise, a new group is created.
+///
+/// \param[in] id        Unique identifier for the battery
+/// \param[in] name      Display name for the battery
+/// \param[in] category  Bttery group
+/// \param[in] cell_v_min  Minimum cell voltage
+/// \param[in] cell_v_max  Maximum cell voltage
+/// \param[in] series_pack_i_min Minimum current
+/// \param[in] series_pack_i_max Maximum current
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t configuration_add_battery_template(const char *id, const char *name, const char *category,
+                                              float cell_v_min, float cell_v_max,
+                                              float series_pack_i_min, float series_pack_i_max)
+{
+    json_arena_scope_begin();
+    esp_err_t ret = add_template(id, name, category, cell_v_min, cell_v_max, series_pack_i_min, series_pack_i_max);
+    json_arena_scope_end();
+
+    // Persist to config file (in its own scope, so the peak arena usage is that of the larger step)
+    if (ret == ESP_OK) {
+        ret = configuration_save(CONFIG_FILE_PATH);
+    }
+
+    return ret;
+}
+
+/// This function edits an existing battery template identified by its id.
+/// It first removes the old entry, then adds the updated one.
+/// If the update leaves an empty group, that group is also removed.
+///
+/// \param[in] id        Unique identifier of the battery to edit
+/// \param[in] name      Updated display name
+/// \param[in] category  Battery group
+/// \param[in] cell_v_min  Minimum cell voltage
+/// \param[in] cell_v_max  Maximum cell voltage
+/// \param[in] series_pack_i_min Minimum current
+/// \param[in] series_pack_i_max Maximum current
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t configuration_edit_battery_template(const char *id, const char *name, const char *category,
+                                              float cell_v_min, float cell_v_max,
+                                              float series_pack_i_min, float series_pack_i_max)
+{
+    json_arena_scope_begin();
+    esp_err_t ret = edit_template(id, name, category, cell_v_min, cell_v_max, series_pack_i_min, series_pack_i_max);
+    json_arena_scope_end();
+
+    // Add updated entry (reuses existing add logic which also saves to file)
+    if (ret == ESP_OK) {
+        ret = configuration_add_battery_template(id, name, category,
+                                                 cell_v_min, cell_v_max, series_pack_i_min, series_pack_i_max);
+    }
+
+    return ret;
+}
+
+/// This function removes a battery template by its id from the cached templates and saves to config file.
+/// If the removal leaves an empty group, that group is also removed.
+///
+/// \param[in] id Unique identifier of the battery to remove
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t configuration_delete_battery_template(const char *id)
+{
+    json_arena_scope_begin();
+    esp_err_t ret = delete_template(id);
+    json_arena_scope_end();
+
+    if (ret == ESP_OK) {
+        ret = configuration_save(CONFIG_FILE_PATH);
+    }
+
+    return ret;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function implements ::configuration_load. Must be called within an arena scope.
+///
+/// \param[in] path Path to configuration file
+/// \return ESP_OK on success, otherwise an error code
+static esp_err_t load_config(const char *path)
 {
     FILE *f = fopen(path, "rb");
     if (!f) {
@@ -98,7 +237,8 @@ esp_err_t configuration_load(const char *path)
         return ESP_FAIL;
     }
 
-    char *buf = malloc((size_t)fsize + 1);
+    // Buffer is allocated through cJSON allocator, so it comes from JSON arena when arena is enabled
+    char *buf = cJSON_malloc((size_t)fsize + 1);
     if (!buf) {
         fclose(f);
         ESP_LOGE(LOG_MODULE_TAG, "Failed to allocate config buffer");
@@ -108,13 +248,13 @@ esp_err_t configuration_load(const char *path)
     size_t n = fread(buf, 1, (size_t)fsize, f);
     fclose(f);
     if (n == 0) {
-        free(buf);
+        cJSON_free(buf);
         return ESP_FAIL;
     }
     buf[n] = '\0';
 
     cJSON *root = cJSON_Parse(buf);
-    free(buf);
+    cJSON_free(buf);
     if (!root) return ESP_FAIL;
 
     cJSON *jwifi = cJSON_GetObjectItem(root, "wifi");
@@ -136,11 +276,7 @@ esp_err_t configuration_load(const char *path)
         // Load adapter mode (default: ltc6804)
         char adapter_str[16] = "";
         json_get_str(jbatt, "adapter", adapter_str, sizeof(adapter_str));
-        if (strcmp(adapter_str, "demo") == 0) {
-            g_cfg.battery.adapter_mode = BMS_ADAPTER_DEMO;
-        } else {
-            g_cfg.battery.adapter_mode = BMS_ADAPTER_LTC6804;
-        }
+        g_cfg.battery.adapter_mode = bms_adapter_mode_from_name(adapter_str);
 
         int num_cells = (int)g_cfg.battery.num_cells;
         json_get_int(jbatt, "num_cells", &num_cells);
@@ -159,13 +295,9 @@ esp_err_t configuration_load(const char *path)
 
     // Cache battery_templates JSON for later use
     cJSON *jtemplates = cJSON_GetObjectItem(root, "battery_templates");
-    if (cJSON_IsArray(jtemplates)) {
-        free(s_battery_templates_json);
-        s_battery_templates_json = cJSON_PrintUnformatted(jtemplates);
-        if (s_battery_templates_json) {
-            ESP_LOGI(LOG_MODULE_TAG, "Battery templates loaded (%u bytes)",
-                     (unsigned)strlen(s_battery_templates_json));
-        }
+    if (cJSON_IsArray(jtemplates) && store_templates(jtemplates) == ESP_OK) {
+        ESP_LOGI(LOG_MODULE_TAG, "Battery templates loaded (%u bytes)",
+                 (unsigned)strlen(s_battery_templates_json));
     }
 
     cJSON_Delete(root);
@@ -173,11 +305,11 @@ esp_err_t configuration_load(const char *path)
     return ESP_OK;
 }
 
-/// This function saves the global configuration instance to a JSON file at the specified path.
+/// This function implements ::configuration_save. Must be called within an arena scope.
 ///
 /// \param[in] path Path to configuration file
 /// \return ESP_OK on success, otherwise an error code
-esp_err_t configuration_save(const char *path)
+static esp_err_t save_config(const char *path)
 {
     cJSON *root = cJSON_CreateObject();
     if (!root) return ESP_FAIL;
@@ -198,8 +330,7 @@ esp_err_t configuration_save(const char *path)
 
     // Battery configuration
     cJSON *jbatt = cJSON_CreateObject();
-    cJSON_AddStringToObject(jbatt, "adapter",
-        g_cfg.battery.adapter_mode == BMS_ADAPTER_DEMO ? "demo" : "ltc6804");
+    cJSON_AddStringToObject(jbatt, "adapter", bms_adapter_mode_name(g_cfg.battery.adapter_mode));
     cJSON_AddNumberToObject(jbatt, "num_cells", g_cfg.battery.num_cells);
     cJSON_AddBoolToObject(jbatt, "current_enable", g_cfg.battery.current_enable);
     cJSON_AddBoolToObject(jbatt, "temperature_enable", g_cfg.battery.temperature_enable);
@@ -219,8 +350,10 @@ esp_err_t configuration_save(const char *path)
         }
     }
 
-    // Convert to compact JSON string (unformatted to reduce heap usage on ESP32)
-    char *json_str = cJSON_PrintUnformatted(root);
+    // Convert to compact JSON string (unformatted to reduce heap usage on ESP32). Buffer is pre-sized for the
+    // templates plus the rest of configuration so printing does not need to grow it.
+    size_t prebuffer = (s_battery_templates_json ? strlen(s_battery_templates_json) : 0) + 1024;
+    char *json_str = cJSON_PrintBuffered(root, (int)prebuffer, false);
     cJSON_Delete(root);
 
     if (!json_str) {
@@ -232,14 +365,14 @@ esp_err_t configuration_save(const char *path)
     FILE *f = fopen(path, "wb");
     if (!f) {
         ESP_LOGE(LOG_MODULE_TAG, "Failed to open %s for writing", path);
-        free(json_str);
+        cJSON_free(json_str);
         return ESP_FAIL;
     }
 
     size_t len = strlen(json_str);
     size_t written = fwrite(json_str, 1, len, f);
     fclose(f);
-    free(json_str);
+    cJSON_free(json_str);
 
     if (written != len) {
         ESP_LOGE(LOG_MODULE_TAG, "Failed to write config file");
@@ -250,19 +383,7 @@ esp_err_t configuration_save(const char *path)
     return ESP_OK;
 }
 
-/// This function returns the cached battery templates JSON string loaded from config file.
-/// The returned string is a JSON array. Returns NULL if no templates were loaded.
-///
-/// \param None
-/// \return Pointer to battery templates JSON string, or NULL
-const char *configuration_get_battery_templates_json(void)
-{
-    return s_battery_templates_json;
-}
-
-/// This function adds a new custom battery template to the cached templates and saves to config file.
-/// If a group with the given category label already exists, the battery is appended to that group.
-/// Otherwise, a new group is created.
+/// This function implements ::configuration_add_battery_template. Must be called within an arena scope.
 ///
 /// \param[in] id        Unique identifier for the battery
 /// \param[in] name      Display name for the battery
@@ -272,9 +393,9 @@ const char *configuration_get_battery_templates_json(void)
 /// \param[in] series_pack_i_min Minimum current
 /// \param[in] series_pack_i_max Maximum current
 /// \return ESP_OK on success, otherwise an error code
-esp_err_t configuration_add_battery_template(const char *id, const char *name, const char *category,
-                                              float cell_v_min, float cell_v_max,
-                                              float series_pack_i_min, float series_pack_i_max)
+static esp_err_t add_template(const char *id, const char *name, const char *category,
+                              float cell_v_min, float cell_v_max,
+                              float series_pack_i_min, float series_pack_i_max)
 {
     // Parse existing templates or create empty array
     cJSON *templates = NULL;
@@ -321,26 +442,20 @@ esp_err_t configuration_add_battery_template(const char *id, const char *name, c
     cJSON_AddItemToArray(batteries_arr, battery);
 
     // Re-serialize and update cache
-    char *new_json = cJSON_PrintUnformatted(templates);
+    esp_err_t err = store_templates(templates);
     cJSON_Delete(templates);
 
-    if (!new_json) {
+    if (err != ESP_OK) {
         ESP_LOGE(LOG_MODULE_TAG, "Failed to serialize updated templates");
-        return ESP_FAIL;
+        return err;
     }
 
-    free(s_battery_templates_json);
-    s_battery_templates_json = new_json;
-
     ESP_LOGI(LOG_MODULE_TAG, "Battery template '%s' added to group '%s'", name, category);
 
-    // Persist to config file
-    return configuration_save("/spiffs/config.json");
+    return ESP_OK;
 }
 
-/// This function edits an existing battery template identified by its id.
-/// It first removes the old entry, then adds the updated one.
-/// If the update leaves an empty group, that group is also removed.
+/// This function implements ::configuration_edit_battery_template. Must be called within an arena scope.
 ///
 /// \param[in] id        Unique identifier of the battery to edit
 /// \param[in] name      Updated display name
@@ -350,9 +465,9 @@ esp_err_t configuration_add_battery_template(const char *id, const char *name, c
 /// \param[in] series_pack_i_min Minimum current
 /// \param[in] series_pack_i_max Maximum current
 /// \return ESP_OK on success, otherwise an error code
-esp_err_t configuration_edit_battery_template(const char *id, const char *name, const char *category,
-                                              float cell_v_min, float cell_v_max,
-                                              float series_pack_i_min, float series_pack_i_max)
+static esp_err_t edit_template(const char *id, const char *name, const char *category,
+                               float cell_v_min, float cell_v_max,
+                               float series_pack_i_min, float series_pack_i_max)
 {
     cJSON *templates = NULL;
     if (s_battery_templates_json) {
@@ -399,27 +514,22 @@ esp_err_t configuration_edit_battery_template(const char *id, const char *name,
     }
 
     // Update cache with the entry removed
-    char *tmp_json = cJSON_PrintUnformatted(templates);
+    esp_err_t err = store_templates(templates);
     cJSON_Delete(templates);
-    if (!tmp_json) {
+    if (err != ESP_OK) {
         ESP_LOGE(LOG_MODULE_TAG, "Failed to serialize templates after removal");
-        return ESP_FAIL;
+        return err;
     }
-    free(s_battery_templates_json);
-    s_battery_templates_json = tmp_json;
 
-    // Add updated entry (reuses existing add logic which also saves to file)
     ESP_LOGI(LOG_MODULE_TAG, "Editing template '%s' in group '%s'", name, category);
-    return configuration_add_battery_template(id, name, category,
-                                               cell_v_min, cell_v_max, series_pack_i_min, series_pack_i_max);
+    return ESP_OK;
 }
 
-/// This function removes a battery template by its id from the cached templates and saves to config file.
-/// If the removal leaves an empty group, that group is also removed.
+/// This function implements ::configuration_delete_battery_template. Must be called within an arena scope.
 ///
 /// \param[in] id Unique identifier of the battery to remove
 /// \return ESP_OK on success, otherwise an error code
-esp_err_t configuration_delete_battery_template(const char *id)
+static esp_err_t delete_template(const char *id)
 {
     cJSON *templates = NULL;
     if (s_battery_templates_json) {
@@ -464,23 +574,55 @@ esp_err_t configuration_delete_battery_template(const char *id)
         }
     }
 
-    char *new_json = cJSON_PrintUnformatted(templates);
+    esp_err_t err = store_templates(templates);
     cJSON_Delete(templates);
-    if (!new_json) {
+    if (err != ESP_OK) {
         ESP_LOGE(LOG_MODULE_TAG, "Failed to serialize templates after delete");
-        return ESP_FAIL;
+        return err;
+    }
+
+    ESP_LOGI(LOG_MODULE_TAG, "Battery template '%s' deleted", id);
+    return ESP_OK;
+}
+
+/// This function serializes battery templates array and replaces the cached templates JSON string. In static
+/// allocation mode the serialized string (allocated in arena) is copied into fixed buffer, so the cache does not
+/// depend on arena or heap after the scope ends. Cache is left unchanged on failure.
+///
+/// \param[in] templates Pointer to cJSON array of template groups
+/// \return ESP_OK on success, ESP_ERR_NO_MEM if serialization fails, ESP_ERR_INVALID_SIZE if templates do not fit
+static esp_err_t store_templates(cJSON *templates)
+{
+#if CONFIG_BMS_JSON_ARENA
+    // Pre-sized buffer avoids growing (and leaving abandoned blocks in arena) while printing
+    char *json = cJSON_PrintBuffered(templates, CONFIG_BMS_TEMPLATES_JSON_MAXLEN, false);
+    if (!json) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t len = strlen(json);
+    if (len >= sizeof(s_templates_buf)) {
+        ESP_LOGE(LOG_MODULE_TAG, "Templates JSON too long (%u >= %u bytes)",
+                 (unsigned)len, (unsigned)sizeof(s_templates_buf));
+        cJSON_free(json);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(s_templates_buf, json, len + 1);
+    cJSON_free(json);
+    s_battery_templates_json = s_templates_buf;
+#else
+    char *json = cJSON_PrintUnformatted(templates);
+    if (!json) {
+        return ESP_ERR_NO_MEM;
     }
 
     free(s_battery_templates_json);
-    s_battery_templates_json = new_json;
+    s_battery_templates_json = json;
+#endif
 
-    ESP_LOGI(LOG_MODULE_TAG, "Battery template '%s' deleted", id);
-    return configuration_save("/spiffs/config.json");
+    return ESP_OK;
 }
 
-/*==============================================================================================================*/
-/*                                       Private Function Definitions                                           */
-/*==============================================================================================================*/
 /// This function retrieves a string value from a cJSON object by key.
 ///
 /// \param[in] obj Pointer to cJSON object
@@ -0,0 +1,252 @@
+/// This module implements a bounded bump allocator used by cJSON. Allocations made by the task which holds an arena
+/// scope are served from a static buffer, freeing the most recent block rolls the arena back, other frees are no-ops.
+/// Every scope releases what was allocated within it when it ends, so parse and print of one request never
+/// fragments the heap. Allocations outside of a scope, or when the arena is full, fall back to the heap and are
+/// counted.
+/// Configuration functions and HTTP handlers wrap their cJSON work in a scope, which holds the arena mutex, so scopes
+/// must not span network sends or other blocking work. The arena is installed when CONFIG_BMS_JSON_ARENA is enabled
+/// (off by default, implied by CONFIG_BMS_STATIC_ALLOCATION), otherwise no arena storage is reserved, cJSON keeps
+/// using the heap and scope functions do nothing.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "json_arena.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include <stdlib.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "JSON_ARENA"
+
+/// Alignment of arena blocks in bytes
+#define ARENA_ALIGN          8u
+
+/// Rounds size up to ::ARENA_ALIGN
+#define ARENA_ROUND_UP(x)    (((x) + (ARENA_ALIGN - 1u)) & ~(size_t)(ARENA_ALIGN - 1u))
+
+/// Maximum scope nesting depth. Deeper scopes are allowed but released together with the deepest tracked one.
+#define ARENA_MAX_DEPTH      8
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Header stored in front of every arena block. Keeps payload aligned to ::ARENA_ALIGN.
+typedef struct {
+    uint32_t size;          ///< Size of the whole block including header
+    uint32_t reserved;      ///< Padding to keep payload aligned
+} arena_hdr_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+#if CONFIG_BMS_JSON_ARENA
+static void *arena_malloc(size_t size);
+static void arena_free(void *ptr);
+#endif
+static bool arena_owned_by_caller(void);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+#if CONFIG_BMS_JSON_ARENA
+/// Arena storage
+static uint8_t s_arena[CONFIG_BMS_JSON_ARENA_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+/// Static storage of the arena mutex
+static StaticSemaphore_t s_mutex_buf;
+#endif
+/// Offset of first free byte in arena
+static size_t s_offset = 0;
+/// Scope nesting depth of the task holding the arena
+static uint32_t s_depth = 0;
+/// Arena offsets at the beginning of each tracked scope
+static size_t s_marks[ARENA_MAX_DEPTH];
+/// Recursive mutex owning the arena
+static SemaphoreHandle_t s_mutex = NULL;
+/// Flag indicating whether arena hooks are installed
+static bool s_enabled = false;
+/// Arena statistics (size stays 0 while the arena is not installed)
+static json_arena_stats_t s_stats = { 0 };
+/// Spinlock protecting statistics (heap fallbacks are counted from any task)
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function installs arena allocator into cJSON. Must be called before any cJSON object is created, because
+/// objects allocated by the previous allocator cannot be freed by the new one.
+///
+/// \param None
+/// \return None
+void json_arena_init(void)
+{
+#if CONFIG_BMS_JSON_ARENA
+    if (s_enabled) {
+        return;
+    }
+
+    s_mutex = xSemaphoreCreateRecursiveMutexStatic(&s_mutex_buf);
+
+    cJSON_Hooks hooks = {
+        .malloc_fn = arena_malloc,
+        .free_fn   = arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+    s_stats.size = CONFIG_BMS_JSON_ARENA_SIZE;
+    s_enabled = true;
+
+    ESP_LOGI(LOG_MODULE_TAG, "cJSON arena installed (%u bytes)", (unsigned)CONFIG_BMS_JSON_ARENA_SIZE);
+#endif
+
+    return;
+}
+
+/// This function opens an arena scope for the calling task. Scopes nest, other tasks block until the outermost
+/// scope is closed. All cJSON allocations of the calling task within the scope are served from the arena and
+/// released when the scope ends.
+///
+/// \param None
+/// \return None
+void json_arena_scope_begin(void)
+{
+    if (!s_enabled) {
+        return;
+    }
+
+    xSemaphoreTakeRecursive(s_mutex, portMAX_DELAY);
+    if (s_depth < ARENA_MAX_DEPTH) {
+        s_marks[s_depth] = s_offset;
+    }
+    s_depth++;
+
+    return;
+}
+
+/// This function closes an arena scope and releases arena memory allocated within it, so no pointer allocated
+/// within the scope may be used afterwards.
+///
+/// \param None
+/// \return None
+void json_arena_scope_end(void)
+{
+    if (!s_enabled || !arena_owned_by_caller() || s_depth == 0) {
+        return;
+    }
+
+    if (--s_depth < ARENA_MAX_DEPTH) {
+        s_offset = s_marks[s_depth];
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_stats.used = (uint32_t)s_offset;
+        taskEXIT_CRITICAL(&s_stats_lock);
+    }
+    xSemaphoreGiveRecursive(s_mutex);
+
+    return;
+}
+
+/// This function copies arena statistics.
+///
+/// \param[out] out Pointer to structure to receive statistics
+/// \return None
+void json_arena_get_stats(json_arena_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+#if CONFIG_BMS_JSON_ARENA
+/// cJSON allocation hook. Serves allocation from arena if the caller holds an arena scope and the block fits,
+/// otherwise falls back to heap.
+///
+/// \param[in] size Requested size in bytes
+/// \return Pointer to allocated memory, or NULL
+static void *arena_malloc(size_t size)
+{
+    if (s_depth > 0 && arena_owned_by_caller()) {
+        size_t need = ARENA_ROUND_UP(sizeof(arena_hdr_t) + size);
+        if (need <= CONFIG_BMS_JSON_ARENA_SIZE - s_offset) {
+            arena_hdr_t *hdr = (arena_hdr_t *)&s_arena[s_offset];
+            hdr->size = (uint32_t)need;
+            s_offset += need;
+
+            taskENTER_CRITICAL(&s_stats_lock);
+            s_stats.used = (uint32_t)s_offset;
+            if (s_stats.used > s_stats.high_water) {
+                s_stats.high_water = s_stats.used;
+            }
+            s_stats.allocs++;
+            taskEXIT_CRITICAL(&s_stats_lock);
+
+            return hdr + 1;
+        }
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.fallbacks++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    return malloc(size);
+}
+
+/// cJSON free hook. Arena blocks are released only if they are the most recent block, other arena blocks are
+/// released together at the end of the outermost scope. Heap blocks are returned to heap.
+///
+/// \param[in] ptr Pointer to memory to free
+/// \return None
+static void arena_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    uint8_t *p = (uint8_t *)ptr;
+    if (p < s_arena || p >= s_arena + sizeof(s_arena)) {
+        free(ptr);
+        return;
+    }
+
+    // Roll back the most recent block (typical for cJSON print buffers)
+    arena_hdr_t *hdr = (arena_hdr_t *)ptr - 1;
+    if (arena_owned_by_caller() && ((uint8_t *)hdr + hdr->size) == &s_arena[s_offset]) {
+        s_offset -= hdr->size;
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_stats.used = (uint32_t)s_offset;
+        taskEXIT_CRITICAL(&s_stats_lock);
+    }
+
+    return;
+}
+#endif
+
+/// This function checks whether the calling task holds the arena mutex.
+///
+/// \param None
+/// \return True if calling task holds the arena
+static bool arena_owned_by_caller(void)
+{
+    return s_mutex && (xSemaphoreGetMutexHolder(s_mutex) == xTaskGetCurrentTaskHandle());
+}
@@ -0,0 +1,51 @@
+/// Header file for `json_arena.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Size of the cJSON arena in bytes (used when CONFIG_BMS_JSON_ARENA is enabled)
+#ifndef CONFIG_BMS_JSON_ARENA_SIZE
+#define CONFIG_BMS_JSON_ARENA_SIZE  32768
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure containing cJSON arena statistics
+typedef struct {
+    uint32_t size;              ///< Arena size in bytes
+    uint32_t used;              ///< Bytes currently allocated from arena
+    uint32_t high_water;        ///< Highest number of bytes allocated from arena since boot
+    uint32_t allocs;            ///< Number of allocations served by arena since boot
+    uint32_t fallbacks;         ///< Number of allocations served by heap since boot (arena full or no scope)
+} json_arena_stats_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void json_arena_init(void);
+void json_arena_scope_begin(void);
+void json_arena_scope_end(void);
+void json_arena_get_stats(json_arena_stats_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -8,7 +8,15 @@
 #include "json_formatter.h"
 #include "configuration.h"
 #include "telemetry.h"
+#include "stage_timing.h"
+#include "deadline_monitor.h"
+#include "supervisor.h"
+#include "json_arena.h"
+#include "latency_probe.h"
+#include "power_mode.h"
+#include "timesync.h"
 #include <stdio.h>
+#include <sys/time.h>
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
@@ -35,6 +43,8 @@
 /*==============================================================================================================*/
 /*                                       Private Function Prototypes                                            */
 /*==============================================================================================================*/
+static int append_cell_mask(char *buf, size_t buf_size, int off, const char *key, const bms_cell_mask_t *mask,
+                            int nc);
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
@@ -85,6 +95,28 @@ int bms_stats_to_json(const bms_stats_t *st, char *buf, size_t buf_size)
         (unsigned)st->timestamp,
         (unsigned)st->sample_count,
         (unsigned long)st->cell_errors);
+
+    // Per-cell undervoltage / overvoltage bitmaps when cells beyond the pairs of cell_errors exist (bit 27)
+    if (nc > BMS_CELL_ERRORS_CELLS) {
+        off = append_cell_mask(buf, buf_size, off, "cell_uv", &st->cell_uv, nc);
+        if (off < 0) {
+            return -1;
+        }
+        JSON_APPEND(off, buf, buf_size, ",");
+        off = append_cell_mask(buf, buf_size, off, "cell_ov", &st->cell_ov, nc);
+        if (off < 0) {
+            return -1;
+        }
+        JSON_APPEND(off, buf, buf_size, ",");
+    }
+
+#if CONFIG_BMS_TIMESYNC
+    // Wall-clock start of the window in ms since the Unix epoch (whole second, 0.2 s edge while limits are
+    // violated), omitted until the device is synchronized
+    if (st->epoch_ms != 0) {
+        JSON_APPEND(off, buf, buf_size, "\"ts_ms\":%llu,", (unsigned long long)st->epoch_ms);
+    }
+#endif
     
     // cell_v_avg array
     JSON_APPEND(off, buf, buf_size, "\"cell_v_avg\":[");
@@ -133,12 +165,17 @@ int bms_stats_to_json(const bms_stats_t *st, char *buf, size_t buf_size)
         
         JSON_APPEND(off, buf, buf_size,
             ",\"telemetry\":{\"sw_version\":\"%s\",\"cpu_load\":%u,"
-            "\"free_heap\":%u,\"min_heap\":%u,\"reset_reason\":%u",
+            "\"free_heap\":%u,\"min_heap\":%u,\"reset_reason\":%u,"
+            "\"largest_block\":%u,\"heap_base\":%u,\"heap_drift\":%ld,\"uptime_s\":%lu",
             sw_version,
             (unsigned)esp_telem.cpu_load,
             (unsigned)esp_telem.free_heap,
             (unsigned)esp_telem.min_free_heap,
-            (unsigned)esp_telem.reset_reason);
+            (unsigned)esp_telem.reset_reason,
+            (unsigned)esp_telem.largest_free_block,
+            (unsigned)esp_telem.heap_baseline,
+            (long)esp_telem.heap_drift,
+            (unsigned long)esp_telem.uptime_s);
 
         // Include last error messages if reset was caused by TWDT
         if (esp_telem.reset_msg[0] != '\0') {
@@ -158,16 +195,253 @@ int bms_stats_to_json(const bms_stats_t *st, char *buf, size_t buf_size)
                 (unsigned long)ltc_status.cell_flags,
                 (unsigned)ltc_status.diag);
         }
+
+#if CONFIG_BMS_LTC_HW_FLAGS
+        // Per-cycle cell flag check: cycles with flags disagreeing with software limits, number and first of the
+        // cells of the last disagreement and failed flag reads (all since boot)
+        JSON_APPEND(off, buf, buf_size,
+            ",\"ltc_hwf\":{\"mism\":%lu,\"cells\":%u,\"first\":%u,\"err\":%lu}",
+            (unsigned long)ltc_status.flag_mismatches,
+            (unsigned)ltc_status.flag_mismatch_cells,
+            (unsigned)ltc_status.flag_mismatch_first,
+            (unsigned long)ltc_status.flag_read_errors);
+#endif
+
+        // Fast Core deadline monitor: degradation level, highest level reached, misses since boot and in window,
+        // wall time covered by the window, number of degradation steps
+        dlm_stats_t dlm;
+        deadline_monitor_get_stats(&dlm);
+        JSON_APPEND(off, buf, buf_size,
+            ",\"dlm\":{\"level\":%u,\"max_level\":%u,\"misses\":%lu,\"window_misses\":%lu,\"window_ms\":%lu,"
+            "\"degrades\":%lu}",
+            (unsigned)dlm.level,
+            (unsigned)dlm.max_level,
+            (unsigned long)dlm.total_misses,
+            (unsigned long)dlm.window_misses,
+            (unsigned long)dlm.window_ms,
+            (unsigned long)dlm.degrade_count);
+
+#if CONFIG_BMS_LOW_POWER
+        // Acquisition power mode: mode, low-power entries and samples, wake-to-sample latency [last, max] in
+        // microseconds, awake duty of low-power cycles in ppm and modelled average supply current in microamperes
+        pwr_stats_t pwr;
+        power_mode_get_stats(&pwr);
+        JSON_APPEND(off, buf, buf_size,
+            ",\"lp\":{\"mode\":%u,\"entries\":%lu,\"samples\":%lu,\"wake_us\":[%lu,%lu],"
+            "\"duty_ppm\":%lu,\"avg_ua\":%lu}",
+            (unsigned)pwr.mode,
+            (unsigned long)pwr.entries,
+            (unsigned long)pwr.low_cycles,
+            (unsigned long)pwr.wake_us_last,
+            (unsigned long)pwr.wake_us_max,
+            (unsigned long)pwr.duty_ppm,
+            (unsigned long)pwr.avg_ua);
+#endif
+
+#if CONFIG_BMS_TIMESYNC
+        // Clock synchronization: sync samples and steps since boot, drift estimate in ppb, offset of the last
+        // sync sample in microseconds, seconds since it, and largest Fast Core wake error at a wall-clock edge
+        // in this reporting interval in microseconds
+        bms_timesync_status_t clk;
+        bms_timesync_get_status(&clk);
+        if (clk.synced) {
+            JSON_APPEND(off, buf, buf_size,
+                ",\"clock\":{\"syncs\":%lu,\"steps\":%lu,\"drift_ppb\":%ld,\"offset_us\":%ld,\"age_s\":%lu,"
+                "\"wake_us\":%lu}",
+                (unsigned long)clk.syncs,
+                (unsigned long)clk.steps,
+                (long)clk.drift_ppb,
+                (long)clk.offset_us,
+                (unsigned long)clk.age_s,
+                (unsigned long)clk.wake_max_us);
+        }
+#endif
+
+        // Supervised task heartbeats [age, worst lateness] in milliseconds
+        supervisor_status_t hb[SUPERVISOR_MAX_TASKS];
+        size_t hb_count = supervisor_get_status(hb, SUPERVISOR_MAX_TASKS);
+        JSON_APPEND(off, buf, buf_size, ",\"hb\":{");
+        for (size_t i = 0; i < hb_count; ++i) {
+            JSON_APPEND(off, buf, buf_size,
+                "%s\"%s\":[%lu,%lu]",
+                i ? "," : "",
+                hb[i].name,
+                (unsigned long)hb[i].age_ms,
+                (unsigned long)hb[i].worst_late_ms);
+        }
+        JSON_APPEND(off, buf, buf_size, "}");
+
+        // cJSON arena usage in bytes and number of allocations which had to fall back to heap
+        json_arena_stats_t arena;
+        json_arena_get_stats(&arena);
+        JSON_APPEND(off, buf, buf_size,
+            ",\"arena\":{\"size\":%lu,\"high_water\":%lu,\"allocs\":%lu,\"fallbacks\":%lu}",
+            (unsigned long)arena.size,
+            (unsigned long)arena.high_water,
+            (unsigned long)arena.allocs,
+            (unsigned long)arena.fallbacks);
+
+        // Fast Core per-stage timing [p50, p99, max] since boot followed by the same for the last complete
+        // reporting interval (CONFIG_BMS_STAGE_TIMING_INTERVAL_MS). Reading does not start a new interval.
+        stage_timing_summary_t timing[FC_STAGE_COUNT];
+        stage_timing_get_summary(timing);
+        JSON_APPEND(off, buf, buf_size, ",\"fc_us\":{");
+        bool first_stage = true;
+        for (int s = 0; s < FC_STAGE_COUNT; ++s) {
+            // Skip stages that never ran (e.g. LTC6804 stages with demo adapter)
+            if (timing[s].boot.count == 0) {
+                continue;
+            }
+            JSON_APPEND(off, buf, buf_size,
+                "%s\"%s\":[%lu,%lu,%lu,%lu,%lu,%lu]",
+                first_stage ? "" : ",",
+                stage_timing_name((fc_stage_t)s),
+                (unsigned long)timing[s].boot.p50_us,
+                (unsigned long)timing[s].boot.p99_us,
+                (unsigned long)timing[s].boot.max_us,
+                (unsigned long)timing[s].interval.p50_us,
+                (unsigned long)timing[s].interval.p99_us,
+                (unsigned long)timing[s].interval.max_us);
+            first_stage = false;
+        }
+        JSON_APPEND(off, buf, buf_size, "}");
         
         JSON_APPEND(off, buf, buf_size, "}");
     }
 
+#if CONFIG_BMS_PERCENTILES
+    // Per-window P50, P95 and P99 of each cell voltage (one array per percentile) and of pack current
+    JSON_APPEND(off, buf, buf_size, ",\"pct\":{");
+    for (int j = 0; j < BMS_PCT_COUNT; ++j) {
+        JSON_APPEND(off, buf, buf_size, "%s\"cell_v_p%u\":[", j ? "," : "", (unsigned)g_bms_pct_levels[j]);
+        for (int i = 0; i < nc; ++i) {
+            JSON_APPEND(off, buf, buf_size, "%s%.4f", i ? "," : "", st->cell_v_pct[i][j]);
+        }
+        JSON_APPEND(off, buf, buf_size, "]");
+    }
+    if (g_cfg.battery.current_enable) {
+        JSON_APPEND(off, buf, buf_size, ",\"pack_i\":[%.3f,%.3f,%.3f]",
+                    st->pack_i_pct[0], st->pack_i_pct[1], st->pack_i_pct[2]);
+    }
+    JSON_APPEND(off, buf, buf_size, "}");
+#endif
+
+#if CONFIG_BMS_ANOMALY
+    // Per-cell anomaly score, averaged deviation from the pack median (mV) and bitmask of cells in alarm
+    JSON_APPEND(off, buf, buf_size, ",\"anomaly\":{\"score\":[");
+    for (int i = 0; i < nc; ++i) {
+        JSON_APPEND(off, buf, buf_size, "%s%.1f", i ? "," : "", st->anomaly.score[i]);
+    }
+    JSON_APPEND(off, buf, buf_size, "],\"dev_mv\":[");
+    for (int i = 0; i < nc; ++i) {
+        JSON_APPEND(off, buf, buf_size, "%s%.1f", i ? "," : "", st->anomaly.dev_v[i] * 1000.0f);
+    }
+    JSON_APPEND(off, buf, buf_size, "],");
+    off = append_cell_mask(buf, buf_size, off, "alarm", &st->anomaly.alarm, nc);
+    if (off < 0) {
+        return -1;
+    }
+    JSON_APPEND(off, buf, buf_size, "}");
+#endif
+
+#if CONFIG_BMS_RIPPLE
+    // Peak pack current ripple (A) at each configured frequency over the latest completed 1 s block and missed
+    // samples of it. Blocks are not aligned to windows, blk tells repeated blocks apart. Omitted while the detector
+    // does not run (other adapters than LTC6804).
+    if (g_cfg.battery.current_enable && st->ripple_last.count > 0) {
+        JSON_APPEND(off, buf, buf_size, ",\"ripple_last\":{\"blk\":%lu,\"hz\":[", (unsigned long)st->ripple_last.seq);
+        for (int k = 0; k < st->ripple_last.count; ++k) {
+            JSON_APPEND(off, buf, buf_size, "%s%u", k ? "," : "", (unsigned)st->ripple_last.hz[k]);
+        }
+        JSON_APPEND(off, buf, buf_size, "],\"a\":[");
+        for (int k = 0; k < st->ripple_last.count; ++k) {
+            JSON_APPEND(off, buf, buf_size, "%s%.3f", k ? "," : "", st->ripple_last.amp[k]);
+        }
+        JSON_APPEND(off, buf, buf_size, "],\"missed\":%u}", (unsigned)st->ripple_last.missed);
+    }
+#endif
+
+#if CONFIG_BMS_LATENCY_PROBE
+    // Provenance of this window (us since boot): acquisition of first and last sample, enqueue of last sample,
+    // statistics computation and serialization (now), wall clock at serialization (valid only if device clock is
+    // synchronized), previous publish call duration and round trip of the last echoed message. Device ID is
+    // repeated so the echo of the object identifies the device it belongs to.
+    latency_probe_state_t probe;
+    latency_probe_get_state(&probe);
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    JSON_APPEND(off, buf, buf_size,
+        ",\"lat\":{\"dev\":\"%s\",\"seq\":%lu,\"acq0\":%lu,\"acq1\":%lu,\"enq1\":%lu,\"stats\":%lu,\"ser\":%lu"
+        ",\"wall\":%lld"
+        ",\"pub_prev\":%lu,\"echo_seq\":%lu,\"rtt\":%lu,\"echoes\":%lu}",
+        device_id,
+        (unsigned long)(s_message_counter - 1u),
+        (unsigned long)st->lat.acq_first_us,
+        (unsigned long)st->lat.acq_last_us,
+        (unsigned long)st->lat.enq_last_us,
+        (unsigned long)st->lat.stats_us,
+        (unsigned long)stage_timing_now_us(),
+        (long long)tv.tv_sec * 1000000LL + (long long)tv.tv_usec,
+        (unsigned long)probe.publish_us,
+        (unsigned long)probe.echo_seq,
+        (unsigned long)probe.echo_rtt_us,
+        (unsigned long)probe.echoes);
+#endif
+
     // Closing brace
     JSON_APPEND(off, buf, buf_size, "}");
 
     return off;
 }
 
+/// This function returns the number of messages serialized so far. Every 10th message (counter value 0, 10, ...)
+/// carries telemetry.
+///
+/// \param None
+/// \return Message counter
+uint32_t bms_stats_json_get_counter(void)
+{
+    return s_message_counter;
+}
+
+/// This function sets the message counter. Used by host fleet emulation to serialize messages of several emulated
+/// devices, each with its own telemetry cadence, with one formatter.
+///
+/// \param[in] counter Message counter
+/// \return None
+void bms_stats_json_set_counter(uint32_t counter)
+{
+    s_message_counter = counter;
+
+    return;
+}
+
 /*==============================================================================================================*/
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
+/// This function appends a per-cell bitmap as JSON member: one number (bit c = cell c) for up to 32 cells, an
+/// array of 32-bit words (bit c % 32 of word c / 32) for more.
+///
+/// \param[out] buf Pointer to output buffer
+/// \param[in] buf_size Size of output buffer in bytes
+/// \param[in] off Current length of the JSON string in the buffer
+/// \param[in] key Member name
+/// \param[in] mask Bitmap to append
+/// \param[in] nc Number of cells
+/// \return New length of the JSON string on success, -1 on truncation
+static int append_cell_mask(char *buf, size_t buf_size, int off, const char *key, const bms_cell_mask_t *mask,
+                            int nc)
+{
+    if (nc <= 32) {
+        JSON_APPEND(off, buf, buf_size, "\"%s\":%lu", key, (unsigned long)mask->w[0]);
+        return off;
+    }
+
+    JSON_APPEND(off, buf, buf_size, "\"%s\":[", key);
+    for (int i = 0; i < (nc + 31) / 32; ++i) {
+        JSON_APPEND(off, buf, buf_size, "%s%lu", i ? "," : "", (unsigned long)mask->w[i]);
+    }
+    JSON_APPEND(off, buf, buf_size, "]");
+
+    return off;
+}
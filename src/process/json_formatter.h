@@ -6,11 +6,72 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include "process.h"
+#include "percentile.h"
+#include "anomaly.h"
+#include "ripple.h"
+#include "timesync.h"
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
 /*==============================================================================================================*/
+/// Space reserved for per-cell percentiles of 12 cells, and of each further cell
+#if CONFIG_BMS_PERCENTILES
+#define BMS_STATS_JSON_PCT_LEN     512u
+#define BMS_STATS_JSON_PCT_CELL     24u
+#else
+#define BMS_STATS_JSON_PCT_LEN     0u
+#define BMS_STATS_JSON_PCT_CELL     0u
+#endif
+
+/// Space reserved for per-cell anomaly scores of 12 cells, and of each further cell
+#if CONFIG_BMS_ANOMALY
+#define BMS_STATS_JSON_ANOMALY_LEN 256u
+#define BMS_STATS_JSON_ANOMALY_CELL 16u
+#else
+#define BMS_STATS_JSON_ANOMALY_LEN 0u
+#define BMS_STATS_JSON_ANOMALY_CELL 0u
+#endif
+
+/// Space reserved for pack current ripple amplitudes
+#if CONFIG_BMS_RIPPLE
+#define BMS_STATS_JSON_RIPPLE_LEN  160u
+#else
+#define BMS_STATS_JSON_RIPPLE_LEN  0u
+#endif
+
+/// Space reserved for the UTC window start and clock synchronization telemetry
+#if CONFIG_BMS_TIMESYNC
+#define BMS_STATS_JSON_TIMESYNC_LEN 128u
+#else
+#define BMS_STATS_JSON_TIMESYNC_LEN 0u
+#endif
+
+/// Space reserved for cells beyond 12 of a larger LTC6804 layout: average, percentiles and anomaly scores of each
+/// cell, and the UV/OV and alarm bitmaps
+#if BMS_MAX_CELLS > 12
+#define BMS_STATS_JSON_CELLS_LEN   ((BMS_MAX_CELLS - 12u) * (8u + BMS_STATS_JSON_PCT_CELL + \
+                                                         BMS_STATS_JSON_ANOMALY_CELL) + \
+                                    3u * (16u + 11u * BMS_CELL_MASK_WORDS))
+#else
+#define BMS_STATS_JSON_CELLS_LEN   0u
+#endif
+
+/// Maximum length of JSON string for one statistics window. Sized for telemetry messages with 12 cells,
+/// full reset message, Fast Core stage timing, heap and arena statistics, plus per-cell percentiles, anomaly
+/// scores, current ripple and clock synchronization when enabled, and the cells of a larger layout.
+#define BMS_STATS_JSON_MAXLEN      (2304u + BMS_STATS_JSON_PCT_LEN + BMS_STATS_JSON_ANOMALY_LEN + \
+                                    BMS_STATS_JSON_RIPPLE_LEN + BMS_STATS_JSON_TIMESYNC_LEN + \
+                                    BMS_STATS_JSON_CELLS_LEN)
+
+/// Additional task stack for cells beyond 12 of a larger LTC6804 layout, for tasks holding a statistics buffer
+/// (up to 24 bytes per cell and window) and the JSON text of one window
+#if BMS_MAX_CELLS > 12
+#define BMS_STATS_STACK_CELLS_LEN  ((BMS_MAX_CELLS - 12u) * BMS_MAX_STATS_WINDOWS * 24u + BMS_STATS_JSON_CELLS_LEN)
+#else
+#define BMS_STATS_STACK_CELLS_LEN  0u
+#endif
 
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
@@ -28,6 +89,8 @@
 /*                                        Public Function Prototypes                                            */
 /*==============================================================================================================*/
 int bms_stats_to_json(const bms_stats_t *st, char *buf, size_t buf_size);
+uint32_t bms_stats_json_get_counter(void);
+void bms_stats_json_set_counter(uint32_t counter);
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
@@ -6,12 +6,14 @@
 #include "logging.h"
 #include "mqtt.h"
 #include "configuration.h"
+#include "latency_probe.h"
 
 #include "freertos/FreeRTOS.h"
 
 #include "mqtt_client.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include <string.h>
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
@@ -145,6 +147,10 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     case MQTT_EVENT_CONNECTED:
         s_connected = true;
         BMS_LOGI("MQTT connected");
+#if CONFIG_BMS_LATENCY_PROBE
+        // Echoes from latency tool (tools/latency-probe), subscription is lost on reconnect with clean session
+        esp_mqtt_client_subscribe(s_mqtt, LATENCY_ECHO_TOPIC, 0);
+#endif
         break;
 
     case MQTT_EVENT_DISCONNECTED:
@@ -152,6 +158,15 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         BMS_LOGW("MQTT disconnected");
         break;
 
+#if CONFIG_BMS_LATENCY_PROBE
+    case MQTT_EVENT_DATA:
+        if (event->topic_len == (int)strlen(LATENCY_ECHO_TOPIC) &&
+            memcmp(event->topic, LATENCY_ECHO_TOPIC, (size_t)event->topic_len) == 0) {
+            latency_probe_echo_received(event->data, event->data_len);
+        }
+        break;
+#endif
+
     case MQTT_EVENT_ERROR:
         BMS_LOGE("MQTT event error");
         break;
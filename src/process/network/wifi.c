@@ -215,6 +215,24 @@ bool bms_wifi_is_ap_mode(void)
     return s_is_ap_mode;
 }
 
+/// This function selects Wi-Fi power save of STA mode. Maximum modem sleep lets the radio sleep for several DTIM
+/// intervals (listen interval), at the cost of delivery latency of incoming traffic. AP mode is left untouched.
+///
+/// \param[in] enable True for maximum modem sleep, false for the default minimum modem sleep
+/// \return ESP_OK on success, otherwise an error code
+esp_err_t bms_wifi_set_power_save(bool enable)
+{
+    if (s_is_ap_mode) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = esp_wifi_set_ps(enable ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+    if (err != ESP_OK) {
+        BMS_LOGW("WiFi power save %s failed: %s", enable ? "on" : "off", esp_err_to_name(err));
+    }
+    return err;
+}
+
 /*==============================================================================================================*/
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
@@ -28,6 +28,7 @@
 /*==============================================================================================================*/
 esp_err_t bms_wifi_init(void);
 bool bms_wifi_is_ap_mode(void);
+esp_err_t bms_wifi_set_power_save(bool enable);
 
 /*==============================================================================================================*/
 /*                                          Public Inline Functions                                             */
@@ -0,0 +1,232 @@
+/// This module estimates P50, P95 and P99 of a stream of values in constant memory with the extended P² algorithm
+/// (Jain & Chlamtac, generalized to several quantiles by Raatikainen). The stream is not stored: nine markers
+/// track the minimum, the maximum, the three percentiles and the midpoints between them. Each observation shifts
+/// the ranks of the markers above it, and markers whose rank drifted from the desired rank by one or more are
+/// moved along a piecewise-parabolic fit of their neighbours. An observation costs O(markers).
+///
+/// P² needs many observations before the upper markers reach their ranks: a marker moves by one rank per
+/// observation, so P95/P99 markers seeded from 9 values are still near the median after 20. The first
+/// ::BMS_PCT_EXACT observations are therefore kept sorted and percentiles are exact; statistics windows (20 samples)
+/// never leave this phase, which costs 60 bytes per value over the 9 P² markers. Longer streams (host tools, windows
+/// stretched by a stall) then seed the markers with the sorted observations at their desired ranks. Percentiles
+/// follow the linear interpolation definition (rank 1 + (N - 1) * p), the same definition the desired marker ranks
+/// use. `tools/host/pct` checks both phases against exact sorting.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "percentile.h"
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static float parabolic(const bms_pct_t *est, int i, int d);
+static float linear(const bms_pct_t *est, int i, int d);
+static float exact(const bms_pct_t *est, float p);
+static void set_markers(bms_pct_t *est);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Desired quantile of each marker: minimum, midpoints and percentiles, maximum
+static const float s_marker_p[BMS_PCT_MARKERS] = {
+    0.0f, 0.25f, 0.50f, 0.725f, 0.95f, 0.97f, 0.99f, 0.995f, 1.0f,
+};
+
+/// Estimated percentiles as fractions
+static const float s_pct_p[BMS_PCT_COUNT] = { 0.50f, 0.95f, 0.99f };
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+/// Estimated percentiles in percent
+const uint8_t g_bms_pct_levels[BMS_PCT_COUNT] = { 50, 95, 99 };
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function clears an estimator.
+///
+/// \param[out] est Estimator
+/// \return None
+void bms_pct_init(bms_pct_t *est)
+{
+    memset(est, 0, sizeof(*est));
+
+    return;
+}
+
+/// This function adds one observation to an estimator.
+///
+/// \param[in,out] est Estimator
+/// \param[in]     x   Observed value
+/// \return None
+void bms_pct_add(bms_pct_t *est, float x)
+{
+    // Keep first observations sorted (insertion), seed the markers from them when the exact phase is full
+    if (est->count < BMS_PCT_EXACT) {
+        int i = (int)est->count;
+        while (i > 0 && est->q[i - 1] > x) {
+            est->q[i] = est->q[i - 1];
+            i--;
+        }
+        est->q[i] = x;
+        est->count++;
+        return;
+    }
+    if (est->count == BMS_PCT_EXACT) {
+        set_markers(est);
+    }
+
+    // Find cell k with q[k] <= x < q[k+1], extremes extend the outer markers
+    int k;
+    if (x < est->q[0]) {
+        est->q[0] = x;
+        k = 0;
+    } else if (x >= est->q[BMS_PCT_MARKERS - 1]) {
+        est->q[BMS_PCT_MARKERS - 1] = x;
+        k = BMS_PCT_MARKERS - 2;
+    } else {
+        k = 0;
+        while (x >= est->q[k + 1]) {
+            k++;
+        }
+    }
+    for (int m = k + 1; m < BMS_PCT_MARKERS; ++m) {
+        est->n[m]++;
+    }
+    est->count++;
+
+    // Move inner markers which are off their desired rank by one or more
+    float last = (float)(est->count - 1u);
+    for (int i = 1; i < BMS_PCT_MARKERS - 1; ++i) {
+        float off = 1.0f + last * s_marker_p[i] - (float)est->n[i];
+        int below = est->n[i - 1] - est->n[i];
+        int above = est->n[i + 1] - est->n[i];
+        if ((off >= 1.0f && above > 1) || (off <= -1.0f && below < -1)) {
+            int d = (off > 0.0f) ? 1 : -1;
+            float q = parabolic(est, i, d);
+            if (!(est->q[i - 1] < q && q < est->q[i + 1])) {
+                q = linear(est, i, d);
+            }
+            est->q[i] = q;
+            est->n[i] += d;
+        }
+    }
+
+    return;
+}
+
+/// This function gets the estimated P50, P95 and P99. Exact while at most ::BMS_PCT_EXACT values were added.
+///
+/// \param[in]  est Estimator
+/// \param[out] out Percentiles in order of ::g_bms_pct_levels (0 if no value was added)
+/// \return None
+void bms_pct_get(const bms_pct_t *est, float out[BMS_PCT_COUNT])
+{
+    for (int j = 0; j < BMS_PCT_COUNT; ++j) {
+        if (est->count == 0) {
+            out[j] = 0.0f;
+        } else if (est->count <= BMS_PCT_EXACT) {
+            out[j] = exact(est, s_pct_p[j]);
+        } else {
+            // Percentile markers sit between the midpoint markers
+            out[j] = est->q[2 * j + 2];
+        }
+    }
+
+    return;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function computes the piecewise-parabolic (P²) height of marker i moved by d ranks.
+///
+/// \param[in] est Estimator
+/// \param[in] i   Marker index (inner marker)
+/// \param[in] d   Rank change (+1 or -1)
+/// \return New marker height
+static float parabolic(const bms_pct_t *est, int i, int d)
+{
+    float n0 = (float)est->n[i - 1];
+    float n1 = (float)est->n[i];
+    float n2 = (float)est->n[i + 1];
+    float fd = (float)d;
+
+    return est->q[i] + fd / (n2 - n0) * ((n1 - n0 + fd) * (est->q[i + 1] - est->q[i]) / (n2 - n1) +
+                                         (n2 - n1 - fd) * (est->q[i] - est->q[i - 1]) / (n1 - n0));
+}
+
+/// This function computes the linear height of marker i moved by d ranks towards its neighbour. Used when the
+/// parabolic height would break the marker order.
+///
+/// \param[in] est Estimator
+/// \param[in] i   Marker index (inner marker)
+/// \param[in] d   Rank change (+1 or -1)
+/// \return New marker height
+static float linear(const bms_pct_t *est, int i, int d)
+{
+    return est->q[i] + (float)d * (est->q[i + d] - est->q[i]) / (float)(est->n[i + d] - est->n[i]);
+}
+
+/// This function computes a percentile from the sorted observations kept before all markers are set.
+///
+/// \param[in] est Estimator with 1 to ::BMS_PCT_EXACT observations
+/// \param[in] p   Percentile as fraction
+/// \return Percentile by linear interpolation between closest ranks
+static float exact(const bms_pct_t *est, float p)
+{
+    float rank = p * (float)(est->count - 1u);
+    uint32_t lo = (uint32_t)rank;
+    if (lo + 1u >= est->count) {
+        return est->q[est->count - 1u];
+    }
+    float frac = rank - (float)lo;
+
+    return est->q[lo] + frac * (est->q[lo + 1u] - est->q[lo]);
+}
+
+/// This function switches from sorted observations to P² markers. Each marker takes the observation at the rank
+/// closest to its desired rank; ranks are made strictly increasing, which pushes the upper markers down when
+/// P99 and its neighbours round to the same rank.
+///
+/// \param[in,out] est Estimator with ::BMS_PCT_EXACT sorted observations
+/// \return None
+static void set_markers(bms_pct_t *est)
+{
+    const int32_t total = BMS_PCT_EXACT;
+
+    for (int i = 0; i < BMS_PCT_MARKERS; ++i) {
+        int32_t rank = (int32_t)(1.5f + (float)(total - 1) * s_marker_p[i]);
+        if (i > 0 && rank <= est->n[i - 1]) {
+            rank = est->n[i - 1] + 1;
+        }
+        est->n[i] = rank;
+    }
+    for (int i = BMS_PCT_MARKERS - 1; i >= 0; --i) {
+        int32_t limit = (i == BMS_PCT_MARKERS - 1) ? total : (est->n[i + 1] - 1);
+        if (est->n[i] > limit) {
+            est->n[i] = limit;
+        }
+    }
+    // Ranks increase by at least one per marker, so q[i] is set from an index not yet overwritten
+    for (int i = 0; i < BMS_PCT_MARKERS; ++i) {
+        est->q[i] = est->q[est->n[i] - 1];
+    }
+
+    return;
+}
@@ -0,0 +1,59 @@
+/// Header file for `percentile.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "sdkconfig.h"
+#include <stdint.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Enables per-window P50/P95/P99 of cell voltages and pack current in statistics and published JSON
+#ifndef CONFIG_BMS_PERCENTILES
+#define CONFIG_BMS_PERCENTILES  0
+#endif
+
+/// Number of estimated percentiles (P50, P95, P99)
+#define BMS_PCT_COUNT           3
+
+/// Number of P² markers: minimum, maximum, each percentile and the midpoints between them
+#define BMS_PCT_MARKERS         (2 * BMS_PCT_COUNT + 3)
+
+/// Number of observations kept sorted (exact percentiles) before switching to P² markers. Covers a whole 1 s
+/// statistics window of 20 samples plus late samples of a stretched window. Seeding P² from the first 9 values
+/// instead puts P95/P99 of a 1 s window 0.5 to 1.3 standard deviations off (bms_pct_check).
+#define BMS_PCT_EXACT           24
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of a streaming percentile estimator of one value (extended P² algorithm, constant memory)
+typedef struct {
+    float    q[BMS_PCT_EXACT];              ///< Sorted observations, then marker heights in q[0 .. MARKERS-1]
+    int32_t  n[BMS_PCT_MARKERS];            ///< Marker positions (1-based ranks, set after BMS_PCT_EXACT values)
+    uint32_t count;                         ///< Number of observations
+} bms_pct_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+/// Estimated percentiles in percent, order of values returned by bms_pct_get()
+extern const uint8_t g_bms_pct_levels[BMS_PCT_COUNT];
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void bms_pct_init(bms_pct_t *est);
+void bms_pct_add(bms_pct_t *est, float x);
+void bms_pct_get(const bms_pct_t *est, float out[BMS_PCT_COUNT]);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -6,11 +6,18 @@
 /*==============================================================================================================*/
 #include "process.h"
 #include "configuration.h"
+#include "stage_timing.h"
 #include <string.h>
 
 /*==============================================================================================================*/
 /*                                             Private Macros                                                   */
 /*==============================================================================================================*/
+#if CONFIG_BMS_TIMESYNC
+/// Length of a wall-clock aligned window (ms)
+#define ALIGNED_1S_MS       1000u
+/// Length of a wall-clock aligned window while limits are violated (ms)
+#define ALIGNED_0_2S_MS     200u
+#endif
 
 /*==============================================================================================================*/
 /*                                              Private Types                                                   */
@@ -24,6 +31,18 @@ static void init_stats_from_first(const bms_sample_t *raw_sample, bms_stats_t *o
 static void accumulate_sample(const bms_sample_t *raw_sample, bms_stats_t *out);
 static void calculate_average(bms_stats_t *accumulated_samples);
 static void remove_processed_samples(bms_sample_buffer_t *buf, size_t sample_count);
+#if CONFIG_BMS_PERCENTILES
+static void pct_window_init(void);
+static void pct_window_add(const bms_sample_t *raw_sample);
+static void pct_window_get(bms_stats_t *out);
+#endif
+#if CONFIG_BMS_LATENCY_PROBE
+static void set_latency(const bms_sample_buffer_t *buf, size_t offset, size_t count, bms_stats_t *out);
+#endif
+#if CONFIG_BMS_TIMESYNC
+static size_t compute_aligned(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats);
+static void build_window(const bms_sample_buffer_t *buf, size_t offset, size_t count, bool check, bms_stats_t *st);
+#endif
 
 /*==============================================================================================================*/
 /*                                            Private Constants                                                 */
@@ -32,6 +51,11 @@ static void remove_processed_samples(bms_sample_buffer_t *buf, size_t sample_cou
 /*==============================================================================================================*/
 /*                                            Private Variables                                                 */
 /*==============================================================================================================*/
+#if CONFIG_BMS_PERCENTILES
+/// Percentile estimators of the window being accumulated (per cell voltage and pack current)
+static bms_pct_t s_cell_v_pct[BMS_MAX_CELLS];
+static bms_pct_t s_pack_i_pct;
+#endif
 
 /*==============================================================================================================*/
 /*                                      Public Variables and Constants                                          */
@@ -43,7 +67,8 @@ static void remove_processed_samples(bms_sample_buffer_t *buf, size_t sample_cou
 /// This function computes aggregated statistics from raw BMS samples stored in a ring buffer. It processes up to
 /// 1 second worth of samples (20 samples). If no limit violations are detected in these samples, a single 1 s statistics
 /// window is computed. If any limit violations are detected, the samples are split into 0.2 s windows (4 samples each) and
-/// multiple statistics windows are computed.
+/// multiple statistics windows are computed. Samples stamped with UTC (CONFIG_BMS_TIMESYNC) are grouped by
+/// wall-clock second and 0.2 s edges instead.
 ///
 /// \param[in,out] buf Pointer to ring buffer containing raw BMS samples. Head and count are updated after processing.
 /// \param[out] out_stats Pointer to output statistics buffer
@@ -56,6 +81,13 @@ size_t bms_compute_stats(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats
 
     out_stats->stats_count = 0;
 
+#if CONFIG_BMS_TIMESYNC
+    // From the first sample with UTC on, windows are aligned to wall-clock seconds
+    if (buf->samples[bms_buf_index(buf, 0)].epoch_ms != 0) {
+        return compute_aligned(buf, out_stats);
+    }
+#endif
+
     // Definition of count of samples per 1s time window
     const size_t samples_per_1s   = 20;
     // Definition of count of samples per 0.2s time window
@@ -71,6 +103,15 @@ size_t bms_compute_stats(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats
     if (available_samples_count > samples_per_1s) {
         available_samples_count = samples_per_1s;
     }
+#if CONFIG_BMS_TIMESYNC
+    // Samples from the first one with UTC on go to aligned windows
+    for (size_t i = 1; i < available_samples_count; ++i) {
+        if (buf->samples[bms_buf_index(buf, i)].epoch_ms != 0) {
+            available_samples_count = i;
+            break;
+        }
+    }
+#endif
 
     // First pass: check for any limit violations in the available samples
     bms_stats_t flags = {0};
@@ -102,6 +143,9 @@ size_t bms_compute_stats(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats
         calculate_average(&st);
         // Set inspection bit to indicate valid data
         st.cell_errors |= 0x0001u;
+#if CONFIG_BMS_LATENCY_PROBE
+        set_latency(buf, 0, available_samples_count, &st);
+#endif
         // Store single stats window in output buffer
         out_stats->stats_array[0] = st;
         out_stats->stats_count    = 1;
@@ -123,9 +167,14 @@ size_t bms_compute_stats(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats
             // Initialize stats for accumulation and set timestamp from first sample
             const bms_sample_t *first = &buf->samples[bms_buf_index(buf, offset)];
             init_stats_from_first(first, &st);
+            // Last subwindow may be shorter when aligned windows take over
+            size_t count = available_samples_count - offset;
+            if (count > samples_per_0_2s) {
+                count = samples_per_0_2s;
+            }
     
             // Second pass: accumulate all samples
-            for (size_t i = 0; i < samples_per_0_2s; ++i) {
+            for (size_t i = 0; i < count; ++i) {
                 const bms_sample_t *s = &buf->samples[bms_buf_index(buf, offset + i)];
                 accumulate_sample(s, &st);
                 check_limits_sample(s, &st);
@@ -135,12 +184,15 @@ size_t bms_compute_stats(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats
             calculate_average(&st);
             // Set inspection bit to indicate valid data
             st.cell_errors |= 0x0001u;
+#if CONFIG_BMS_LATENCY_PROBE
+            set_latency(buf, offset, count, &st);
+#endif
             // Store single stats window in output buffer
             out_stats->stats_array[windows_created] = st;
             windows_created++;
     
             // Calculate offset for storing samples in correct index
-            offset += samples_per_0_2s;
+            offset += count;
         }
     
         out_stats->stats_count = windows_created;
@@ -155,6 +207,102 @@ size_t bms_compute_stats(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats
 /*==============================================================================================================*/
 /*                                       Private Function Definitions                                           */
 /*==============================================================================================================*/
+#if CONFIG_BMS_TIMESYNC
+/// This function computes statistics windows aligned to UTC: one window per wall-clock second, split at 0.2 s edges
+/// if limits are violated. Samples carry the UTC of their Fast Core cycle, which starts on an edge of its period,
+/// so windows of all synchronized devices cover the same intervals and carry the same start time. A window is
+/// complete when a sample of a later second is buffered, one Fast Core period after its end.
+///
+/// \param[in,out] buf Pointer to ring buffer containing raw BMS samples. Head and count are updated after processing.
+/// \param[out] out_stats Pointer to output statistics buffer
+/// \return Number of processed samples (0 while the second of the first sample is not complete)
+static size_t compute_aligned(bms_sample_buffer_t *buf, bms_stats_buffer_t *out_stats)
+{
+    const uint64_t first_ms = buf->samples[bms_buf_index(buf, 0)].epoch_ms;
+    const uint64_t start_ms = first_ms - first_ms % ALIGNED_1S_MS;
+
+    // Samples of the same second; a sample of another second or without UTC closes the window
+    size_t n = 0;
+    while (n < buf->count) {
+        uint64_t t = buf->samples[bms_buf_index(buf, n)].epoch_ms;
+        if (t < start_ms || t >= start_ms + ALIGNED_1S_MS) {
+            break;
+        }
+        n++;
+    }
+    // Wait for the end of the second unless the buffer is full
+    if (n == buf->count && buf->count < buf->capacity) {
+        return 0;
+    }
+
+    bms_stats_t flags = {0};
+    for (size_t i = 0; i < n; ++i) {
+        check_limits_sample(&buf->samples[bms_buf_index(buf, i)], &flags);
+    }
+
+    bms_stats_t st = {0};
+    if (flags.cell_errors == 0) {
+        build_window(buf, 0, n, false, &st);
+        st.epoch_ms = start_ms;
+        out_stats->stats_array[0] = st;
+        out_stats->stats_count    = 1;
+    } else {
+        // Violation present - split at 0.2 s edges
+        size_t windows_created = 0;
+        size_t offset = 0;
+        while (offset < n && windows_created < BMS_MAX_STATS_WINDOWS) {
+            uint64_t t = buf->samples[bms_buf_index(buf, offset)].epoch_ms;
+            uint64_t sub_ms = t - t % ALIGNED_0_2S_MS;
+            size_t count = 1;
+            while (offset + count < n &&
+                   buf->samples[bms_buf_index(buf, offset + count)].epoch_ms < sub_ms + ALIGNED_0_2S_MS) {
+                count++;
+            }
+            build_window(buf, offset, count, true, &st);
+            st.epoch_ms = sub_ms;
+            out_stats->stats_array[windows_created] = st;
+            windows_created++;
+            offset += count;
+        }
+        out_stats->stats_count = windows_created;
+        n = offset;
+    }
+
+    // Consume processed samples from ring buffer (advance head and reduce count)
+    remove_processed_samples(buf, n);
+
+    return n;
+}
+
+/// This function computes one statistics window from consecutive samples of the ring buffer.
+///
+/// \param[in] buf Pointer to ring buffer containing raw BMS samples
+/// \param[in] offset Offset of first sample of the window from buffer head
+/// \param[in] count Number of samples in the window (at least 1)
+/// \param[in] check True to set limit violation bits of the samples
+/// \param[out] st Pointer to statistics window
+/// \return None
+static void build_window(const bms_sample_buffer_t *buf, size_t offset, size_t count, bool check, bms_stats_t *st)
+{
+    init_stats_from_first(&buf->samples[bms_buf_index(buf, offset)], st);
+    for (size_t i = 0; i < count; ++i) {
+        const bms_sample_t *s = &buf->samples[bms_buf_index(buf, offset + i)];
+        accumulate_sample(s, st);
+        if (check) {
+            check_limits_sample(s, st);
+        }
+    }
+    calculate_average(st);
+    // Set inspection bit to indicate valid data
+    st->cell_errors |= 0x0001u;
+#if CONFIG_BMS_LATENCY_PROBE
+    set_latency(buf, offset, count, st);
+#endif
+
+    return;
+}
+#endif
+
 /// This function consumes samples from buffer by moving head and reducing count by value of sample_count.
 ///
 /// \param[in, out] buf Pointer to ring buffer containing raw BMS samples
@@ -180,11 +328,31 @@ static void check_limits_sample(const bms_sample_t *s, bms_stats_t *flags)
 {
     for (int i = 0; i < g_cfg.battery.num_cells; ++i) {
         float v = s->cell_v[i];
-        if (v < g_cfg.battery.cell_v_min) {
+        bool uv = (v < g_cfg.battery.cell_v_min);
+        bool ov = (v > g_cfg.battery.cell_v_max);
+#if CONFIG_BMS_LTC_HW_FLAGS
+        // LTC6804 comparator flags of the same conversion count as violations of the cell
+        uv = uv || bms_cell_mask_test(&s->hw_uv, (unsigned)i);
+        ov = ov || bms_cell_mask_test(&s->hw_ov, (unsigned)i);
+#endif
+        if (uv) {
+            bms_cell_mask_set(&flags->cell_uv, (unsigned)i);
+        }
+        if (ov) {
+            bms_cell_mask_set(&flags->cell_ov, (unsigned)i);
+        }
+        if (i >= BMS_CELL_ERRORS_CELLS) {
+            // Cells beyond the pairs of cell_errors share one bit, the bitmaps tell which
+            if (uv || ov) {
+                flags->cell_errors |= (1u << 27);
+            }
+            continue;
+        }
+        if (uv) {
             // Undervoltage bit
             flags->cell_errors |= (uint32_t)(1u << (i * 2 + 1u));
         }
-        if (v > g_cfg.battery.cell_v_max) {
+        if (ov) {
             // Overvoltage bit
             flags->cell_errors |= (uint32_t)(1u << (i * 2 + 2u));
         }
@@ -215,6 +383,8 @@ static void init_stats_from_first(const bms_sample_t *raw_sample, bms_stats_t *o
     out->timestamp     = raw_sample->timestamp;
     out->sample_count  = 0;
     out->cell_errors = 0;
+    memset(&out->cell_uv, 0, sizeof(out->cell_uv));
+    memset(&out->cell_ov, 0, sizeof(out->cell_ov));
 
     for (int c = 0; c < g_cfg.battery.num_cells; ++c) {
         out->cell_v_avg[c] = 0.0f;
@@ -226,6 +396,10 @@ static void init_stats_from_first(const bms_sample_t *raw_sample, bms_stats_t *o
 
     out->temperature_avg = 0.0f;
 
+#if CONFIG_BMS_PERCENTILES
+    pct_window_init();
+#endif
+
     return;
 }
 
@@ -254,6 +428,10 @@ static void accumulate_sample(const bms_sample_t *raw_sample, bms_stats_t *out)
 
     out->sample_count++;
 
+#if CONFIG_BMS_PERCENTILES
+    pct_window_add(raw_sample);
+#endif
+
     return;
 }
 
@@ -280,5 +458,78 @@ static void calculate_average(bms_stats_t *accumulated_samples)
         accumulated_samples->temperature_avg *= inv_n;
     }
 
+#if CONFIG_BMS_PERCENTILES
+    pct_window_get(accumulated_samples);
+#endif
+
+    return;
+}
+
+#if CONFIG_BMS_LATENCY_PROBE
+/// This function sets provenance timestamps of a statistics window from its first and last sample and stamps
+/// completion of the computation.
+///
+/// \param[in] buf Pointer to ring buffer containing raw BMS samples
+/// \param[in] offset Offset of first sample of the window from buffer head
+/// \param[in] count Number of samples in the window
+/// \param[out] out Pointer to statistics window
+/// \return None
+static void set_latency(const bms_sample_buffer_t *buf, size_t offset, size_t count, bms_stats_t *out)
+{
+    const bms_sample_t *first = &buf->samples[bms_buf_index(buf, offset)];
+    const bms_sample_t *last  = &buf->samples[bms_buf_index(buf, offset + count - 1u)];
+
+    out->lat.acq_first_us = first->acq_us;
+    out->lat.acq_last_us  = last->acq_us;
+    out->lat.enq_last_us  = last->enq_us;
+    out->lat.stats_us     = stage_timing_now_us();
+
+    return;
+}
+#endif
+
+#if CONFIG_BMS_PERCENTILES
+/// This function clears percentile estimators at the start of a statistics window.
+///
+/// \param None
+/// \return None
+static void pct_window_init(void)
+{
+    for (int c = 0; c < g_cfg.battery.num_cells; ++c) {
+        bms_pct_init(&s_cell_v_pct[c]);
+    }
+    bms_pct_init(&s_pack_i_pct);
+
+    return;
+}
+
+/// This function adds cell voltages and pack current of a raw sample to the percentile estimators of the window.
+///
+/// \param[in] raw_sample Pointer to the raw BMS sample to accumulate
+/// \return None
+static void pct_window_add(const bms_sample_t *raw_sample)
+{
+    for (int c = 0; c < g_cfg.battery.num_cells; ++c) {
+        bms_pct_add(&s_cell_v_pct[c], raw_sample->cell_v[c]);
+    }
+    if (g_cfg.battery.current_enable) {
+        bms_pct_add(&s_pack_i_pct, raw_sample->pack_i);
+    }
+
+    return;
+}
+
+/// This function stores P50/P95/P99 of the window into the statistics window.
+///
+/// \param[out] out Pointer to the statistics window
+/// \return None
+static void pct_window_get(bms_stats_t *out)
+{
+    for (int c = 0; c < g_cfg.battery.num_cells; ++c) {
+        bms_pct_get(&s_cell_v_pct[c], out->cell_v_pct[c]);
+    }
+    bms_pct_get(&s_pack_i_pct, out->pack_i_pct);
+
     return;
 }
+#endif
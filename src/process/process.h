@@ -8,6 +8,9 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "bms_data.h"
+#include "percentile.h"
+#include "anomaly.h"
+#include "ripple.h"
 
 /*==============================================================================================================*/
 /*                                               Public Macros                                                  */
@@ -16,13 +19,27 @@
 /// Value 5 corresponds to 1 second (1 s / 0.2 s) and is used if overvoltage/undervoltage violations are detected.
 #define BMS_MAX_STATS_WINDOWS 5
 
+/// Number of cells with their own undervoltage / overvoltage bit pair in cell_errors (bits 1-24)
+#define BMS_CELL_ERRORS_CELLS 12
+
 /*==============================================================================================================*/
 /*                                               Public Types                                                   */
 /*==============================================================================================================*/
+/// Structure defining provenance timestamps of one statistics window (microseconds since boot)
+typedef struct {
+    uint32_t acq_first_us;                              ///< Acquisition of first sample in window
+    uint32_t acq_last_us;                               ///< Acquisition of last sample in window
+    uint32_t enq_last_us;                               ///< Enqueue of last sample in window
+    uint32_t stats_us;                                  ///< Completion of statistics computation
+} bms_latency_t;
+
 /// Structure defining one statistics one window computed from BMS samples. Calculated over 1 s or 0.2 s intervals.
 typedef struct {
     TickType_t timestamp;                               ///< Timestamp containing earliest sample in this window
     size_t     sample_count;                            ///< Number of samples aggregated into this window
+#if CONFIG_BMS_TIMESYNC
+    uint64_t   epoch_ms;                                ///< UTC window start (ms since the Unix epoch), 0 if unsynced
+#endif
 
     float cell_v_avg[BMS_MAX_CELLS];                    ///< Average  per-cell voltages
 
@@ -48,7 +65,24 @@ typedef struct {
                                                         ///< Bit 23-24:    cell 11 undervoltage / overvoltage
                                                         ///< Bit 25:       pack undercurrent
                                                         ///< Bit 26:       pack overcurrent
-                                                        ///< Bit 27-31:    spare
+                                                        ///< Bit 27:       undervoltage / overvoltage of a cell beyond
+                                                        ///<               cell 11 (see cell_uv, cell_ov)
+                                                        ///< Bit 28-31:    spare
+    bms_cell_mask_t cell_uv;                            ///< Undervoltage of each cell (all cells of the layout)
+    bms_cell_mask_t cell_ov;                            ///< Overvoltage of each cell (all cells of the layout)
+#if CONFIG_BMS_PERCENTILES
+    float cell_v_pct[BMS_MAX_CELLS][BMS_PCT_COUNT];     ///< Per-cell voltage P50/P95/P99
+    float pack_i_pct[BMS_PCT_COUNT];                    ///< Pack current P50/P95/P99
+#endif
+#if CONFIG_BMS_ANOMALY
+    bms_anomaly_t anomaly;                              ///< Per-cell anomaly scores and alarms
+#endif
+#if CONFIG_BMS_RIPPLE
+    bms_ripple_t ripple_last;                           ///< Pack current ripple of the latest completed 1 s block
+#endif
+#if CONFIG_BMS_LATENCY_PROBE
+    bms_latency_t lat;                                  ///< Provenance timestamps for latency probe
+#endif
 } bms_stats_t;
 
 /// Structure defining buffer for storing multiple statistics windows.
@@ -0,0 +1,295 @@
+/// This module keeps statistics of BMS samples over a sliding window of the last CONFIG_BMS_ROLLING_WINDOW
+/// samples. Unlike bms_compute_stats(), which emits tumbling windows on the Slow Core, the sliding window is updated
+/// by the Fast Core with every sample, so consumers (HTTP endpoint, protection checks) get values at most one
+/// sample old.
+///
+/// Every sample costs O(cells), independent of the window length:
+/// - Values are quantized to fixed-point integers (cell voltage in 100 uV LTC6804 codes, pack voltage and current
+///   in mV and mA, temperature in 0.01 deg C). Running sums add the entering and subtract the leaving sample, which
+///   is exact in integers, so the sums do not drift over long runs like float sums would.
+/// - Minimum and maximum are kept by monotonic deques of ring positions. The front of the deque is the extreme of
+///   the window; a new sample removes all candidates it dominates from the back, and the leaving sample is removed
+///   from the front when its ring position is reused. Each sample enters and leaves a deque once (amortized O(1)).
+///
+/// The Fast Core publishes a snapshot after each sample, readers on other tasks copy it under a spinlock.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "rolling_stats.h"
+#include "configuration.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Channel index of pack voltage (cells use channels 0 .. BMS_MAX_CELLS-1)
+#define CH_PACK_V           (BMS_MAX_CELLS)
+/// Channel index of pack current
+#define CH_PACK_I           (BMS_MAX_CELLS + 1)
+/// Channel index of temperature
+#define CH_TEMP             (BMS_MAX_CELLS + 2)
+/// Number of channels
+#define CH_COUNT            (BMS_MAX_CELLS + 3)
+
+/// Fixed-point scale of cell voltages (100 uV, LTC6804 code resolution)
+#define SCALE_CELL_V        10000.0f
+/// Fixed-point scale of pack voltage (mV)
+#define SCALE_PACK_V        1000.0f
+/// Fixed-point scale of pack current (mA)
+#define SCALE_PACK_I        1000.0f
+/// Fixed-point scale of temperature (0.01 deg C)
+#define SCALE_TEMP          100.0f
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of a monotonic deque of ring positions. Values at the positions increase (minimum deque) or decrease
+/// (maximum deque) from front to back, so the front holds the extreme of the window.
+typedef struct {
+    uint8_t pos[BMS_ROLLING_CAPACITY];      ///< Ring positions of candidate samples (circular, oldest at head)
+    uint8_t head;                           ///< Index of the front entry in pos
+    uint8_t len;                            ///< Number of entries
+} mono_deque_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void push_channel(uint8_t ch, int32_t value, bool full);
+static void deque_push(mono_deque_t *dq, uint8_t ch, int32_t value, bool is_max);
+static void fill_value(uint8_t ch, float scale, bms_rolling_value_t *out);
+static int32_t quantize(float value, float scale);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Quantized values of samples in the window, indexed by ring position and channel
+static int32_t s_ring[BMS_ROLLING_CAPACITY][CH_COUNT];
+/// Running sums of quantized values per channel
+static int32_t s_sum[CH_COUNT];
+/// Minimum deques per channel
+static mono_deque_t s_min_dq[CH_COUNT];
+/// Maximum deques per channel
+static mono_deque_t s_max_dq[CH_COUNT];
+/// Window length in samples
+static uint16_t s_window = CONFIG_BMS_ROLLING_WINDOW;
+/// Ring position of the next sample
+static uint16_t s_next = 0;
+/// Number of samples in the window
+static uint16_t s_count = 0;
+/// Number of samples pushed since init
+static uint32_t s_seq = 0;
+/// Snapshot after the newest sample (written by Fast Core, read by other tasks)
+static bms_rolling_t s_snapshot;
+/// Flag indicating the snapshot holds at least one sample
+static bool s_valid = false;
+/// Spinlock protecting the snapshot across cores
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function clears the sliding window and sets its length. Called by the Fast Core task before its first
+/// sample.
+///
+/// \param[in] window Window length in samples (clamped to 1 .. ::BMS_ROLLING_CAPACITY)
+/// \return None
+void bms_rolling_init(uint16_t window)
+{
+    if (window < 1) {
+        window = 1;
+    }
+    if (window > BMS_ROLLING_CAPACITY) {
+        window = BMS_ROLLING_CAPACITY;
+    }
+
+    s_window = window;
+    s_next = 0;
+    s_count = 0;
+    s_seq = 0;
+    memset(s_sum, 0, sizeof(s_sum));
+    memset(s_min_dq, 0, sizeof(s_min_dq));
+    memset(s_max_dq, 0, sizeof(s_max_dq));
+
+    taskENTER_CRITICAL(&s_lock);
+    s_valid = false;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function adds a sample to the sliding window, drops the oldest sample when the window is full and
+/// publishes the updated statistics. Must be called from one task only (Fast Core).
+///
+/// \param[in] sample Newest BMS sample
+/// \return None
+void bms_rolling_push(const bms_sample_t *sample)
+{
+    if (!sample) {
+        return;
+    }
+
+    uint8_t num_cells = g_cfg.battery.num_cells;
+    bool full = (s_count == s_window);
+
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        push_channel(c, quantize(sample->cell_v[c], SCALE_CELL_V), full);
+    }
+    push_channel(CH_PACK_V, quantize(sample->pack_v, SCALE_PACK_V), full);
+    push_channel(CH_PACK_I, quantize(sample->pack_i, SCALE_PACK_I), full);
+    push_channel(CH_TEMP, quantize(sample->temperature, SCALE_TEMP), full);
+
+    s_next = (uint16_t)((s_next + 1u) % s_window);
+    if (!full) {
+        s_count++;
+    }
+    s_seq++;
+
+    // Snapshot is built outside of the critical section, only the copy is locked
+    bms_rolling_t snap;
+    snap.timestamp    = sample->timestamp;
+    snap.seq          = s_seq;
+    snap.window       = s_window;
+    snap.sample_count = s_count;
+    snap.num_cells    = num_cells;
+    for (uint8_t c = 0; c < num_cells; ++c) {
+        fill_value(c, SCALE_CELL_V, &snap.cell_v[c]);
+    }
+    fill_value(CH_PACK_V, SCALE_PACK_V, &snap.pack_v);
+    fill_value(CH_PACK_I, SCALE_PACK_I, &snap.pack_i);
+    fill_value(CH_TEMP, SCALE_TEMP, &snap.temperature);
+
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(&s_snapshot, &snap, sizeof(s_snapshot));
+    s_valid = true;
+    taskEXIT_CRITICAL(&s_lock);
+
+    return;
+}
+
+/// This function gets the sliding-window statistics after the newest sample. Safe to call from any task.
+///
+/// \param[out] out Statistics snapshot
+/// \return True if at least one sample was pushed since init, false otherwise (out is not changed)
+bool bms_rolling_get(bms_rolling_t *out)
+{
+    if (!out) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool valid = s_valid;
+    if (valid) {
+        memcpy(out, &s_snapshot, sizeof(*out));
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    return valid;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function stores a quantized value of the newest sample at ring position ::s_next and updates the running
+/// sum and deques of the channel. When the window is full, the value stored there before leaves the window.
+///
+/// \param[in] ch    Channel index
+/// \param[in] value Quantized value of the newest sample
+/// \param[in] full  Flag indicating the window is full (the oldest sample leaves)
+/// \return None
+static void push_channel(uint8_t ch, int32_t value, bool full)
+{
+    if (full) {
+        s_sum[ch] -= s_ring[s_next][ch];
+        // The leaving sample is the oldest one, so it can only be at the front of a deque
+        if (s_min_dq[ch].len > 0 && s_min_dq[ch].pos[s_min_dq[ch].head] == s_next) {
+            s_min_dq[ch].head = (uint8_t)((s_min_dq[ch].head + 1u) % s_window);
+            s_min_dq[ch].len--;
+        }
+        if (s_max_dq[ch].len > 0 && s_max_dq[ch].pos[s_max_dq[ch].head] == s_next) {
+            s_max_dq[ch].head = (uint8_t)((s_max_dq[ch].head + 1u) % s_window);
+            s_max_dq[ch].len--;
+        }
+    }
+
+    s_ring[s_next][ch] = value;
+    s_sum[ch] += value;
+    deque_push(&s_min_dq[ch], ch, value, false);
+    deque_push(&s_max_dq[ch], ch, value, true);
+
+    return;
+}
+
+/// This function appends the newest sample (at ring position ::s_next) to a monotonic deque. Candidates at the back
+/// which the new value dominates can never become the extreme again and are removed first.
+///
+/// \param[in,out] dq     Deque
+/// \param[in]     ch     Channel index
+/// \param[in]     value  Quantized value of the newest sample
+/// \param[in]     is_max True for a maximum deque, false for a minimum deque
+/// \return None
+static void deque_push(mono_deque_t *dq, uint8_t ch, int32_t value, bool is_max)
+{
+    while (dq->len > 0) {
+        uint8_t back = dq->pos[(dq->head + dq->len - 1u) % s_window];
+        int32_t back_value = s_ring[back][ch];
+        bool dominated = is_max ? (back_value <= value) : (back_value >= value);
+        if (!dominated) {
+            break;
+        }
+        dq->len--;
+    }
+
+    dq->pos[(dq->head + dq->len) % s_window] = (uint8_t)s_next;
+    dq->len++;
+
+    return;
+}
+
+/// This function converts the running sum and deque fronts of a channel to average, minimum and maximum.
+///
+/// \param[in]  ch    Channel index
+/// \param[in]  scale Fixed-point scale of the channel
+/// \param[out] out   Statistics of the channel
+/// \return None
+static void fill_value(uint8_t ch, float scale, bms_rolling_value_t *out)
+{
+    float inv = 1.0f / scale;
+
+    out->avg = ((float)s_sum[ch] / (float)s_count) * inv;
+    out->min = (float)s_ring[s_min_dq[ch].pos[s_min_dq[ch].head]][ch] * inv;
+    out->max = (float)s_ring[s_max_dq[ch].pos[s_max_dq[ch].head]][ch] * inv;
+
+    return;
+}
+
+/// This function converts a value to fixed point with rounding and saturation to +-2^24 (keeps window sums of
+/// ::BMS_ROLLING_MAX_WINDOW samples within int32).
+///
+/// \param[in] value Value in physical units
+/// \param[in] scale Fixed-point scale
+/// \return Quantized value
+static int32_t quantize(float value, float scale)
+{
+    const float limit = 16777216.0f;
+    float q = value * scale;
+
+    if (!(q > -limit)) {
+        return -(int32_t)limit;
+    }
+    if (q > limit) {
+        return (int32_t)limit;
+    }
+
+    return (int32_t)lroundf(q);
+}
@@ -0,0 +1,79 @@
+/// Header file for `rolling_stats.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "bms_data.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Enables sliding-window statistics updated by the Fast Core and served at /bms/rolling
+#ifndef CONFIG_BMS_ROLLING
+#define CONFIG_BMS_ROLLING          0
+#endif
+
+/// Maximum length of the sliding window in samples (5 s at 20 Hz, range of CONFIG_BMS_ROLLING_WINDOW)
+#define BMS_ROLLING_MAX_WINDOW      100
+
+/// Length of the sliding window in samples (20 = 1 s at 20 Hz)
+#ifndef CONFIG_BMS_ROLLING_WINDOW
+#define CONFIG_BMS_ROLLING_WINDOW   20
+#endif
+
+/// Number of samples the ring and deques are sized for, bms_rolling_init() clamps the window to it. The window is
+/// fixed at build time, so storage follows it; host benchmarks raise it to compare window lengths in one build.
+#ifndef BMS_ROLLING_CAPACITY
+#define BMS_ROLLING_CAPACITY        CONFIG_BMS_ROLLING_WINDOW
+#endif
+
+#if BMS_ROLLING_CAPACITY < 1 || BMS_ROLLING_CAPACITY > BMS_ROLLING_MAX_WINDOW
+#error "BMS_ROLLING_CAPACITY must be 1 .. BMS_ROLLING_MAX_WINDOW"
+#endif
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Structure of average, minimum and maximum of one measured value over the sliding window
+typedef struct {
+    float avg;                              ///< Average
+    float min;                              ///< Minimum
+    float max;                              ///< Maximum
+} bms_rolling_value_t;
+
+/// Structure of sliding-window statistics after the newest sample
+typedef struct {
+    TickType_t timestamp;                   ///< Timestamp of the newest sample
+    uint32_t   seq;                         ///< Number of samples pushed since bms_rolling_init()
+    uint16_t   window;                      ///< Window length in samples
+    uint16_t   sample_count;                ///< Number of samples in the window (less than window after init)
+    uint8_t    num_cells;                   ///< Number of valid entries of cell_v
+    bms_rolling_value_t cell_v[BMS_MAX_CELLS];  ///< Per-cell voltages
+    bms_rolling_value_t pack_v;             ///< Pack voltage
+    bms_rolling_value_t pack_i;             ///< Pack current
+    bms_rolling_value_t temperature;        ///< Temperature (deg C)
+} bms_rolling_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void bms_rolling_init(uint16_t window);
+void bms_rolling_push(const bms_sample_t *sample);
+bool bms_rolling_get(bms_rolling_t *out);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
@@ -0,0 +1,599 @@
+/// This module implements the throughput stress sweep used to find the saturation point of the acquisition and
+/// processing pipeline. A producer task on the Fast Core pushes synthetic samples (deterministic pack simulator)
+/// into the inter-core queue at a fixed rate per step, a consumer task on the Slow Core drains the queue exactly
+/// like the Slow Core processing state (100 sample ring buffer, 1 s cycle, statistics, JSON, publish, statistics
+/// history) and a probe task reads the statistics history like the /bms/stats/data handler. Each step measures
+/// queue occupancy, drops, producer overruns, consumer cycle and publish times and history read latency. Rates
+/// increase until a step is not sustained.
+///
+/// Only FreeRTOS API and pipeline modules are used, so the same sweep runs on target (before Fast Core tasks are
+/// created, enabled by CONFIG_BMS_STRESS, results over UART and at /bms/stress) and on host, where the FreeRTOS
+/// shim maps tasks onto pthreads (bms_stress).
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "stress.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "logging.h"
+#include "esp_log.h"
+#include "process.h"
+#include "json_formatter.h"
+#include "intercore_comm.h"
+#include "stage_timing.h"
+#include "bms_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Log module tag used by logging module
+#define LOG_MODULE_TAG "STRESS"
+
+/// Capacity of consumer ring buffer (same as Slow Core)
+#define STRESS_SC_CAPACITY      100
+
+/// Consumer cycle period in milliseconds (same as Slow Core)
+#define STRESS_SC_PERIOD_MS     1000
+
+/// Statistics history read period of probe task in milliseconds
+#define STRESS_PROBE_PERIOD_MS  20
+
+/// Stack size of producer and probe tasks in bytes
+#define STRESS_TASK_STACK       4096
+
+/// Stack size of consumer task in bytes (holds one statistics JSON buffer)
+#define STRESS_SC_TASK_STACK    (8192 + BMS_STATS_STACK_CELLS_LEN)
+
+/// Maximum time to wait for tasks to pause, drain or exit in milliseconds
+#define STRESS_SYNC_TIMEOUT_MS  3000
+
+/// Maximum length of results JSON
+#define STRESS_JSON_MAXLEN      3072
+
+/// MQTT topic of published statistics (same as Slow Core)
+#define STRESS_TOPIC            "bms/esp32/stats"
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of counters accumulated during one step
+typedef struct {
+    uint32_t produced;          ///< Pushed samples
+    uint32_t dropped;           ///< Samples dropped on full queue
+    uint32_t overruns;          ///< Producer ticks longer than one tick
+    uint32_t queue_peak;        ///< Peak queue occupancy
+    uint32_t sc_left_max;       ///< Most samples left in queue after consumer fill
+    uint32_t sc_left_last;      ///< Samples left in queue after last consumer fill
+    uint32_t windows;           ///< Published statistics windows
+    uint32_t sc_cycle_max_us;   ///< Longest consumer cycle
+    uint64_t publish_sum_us;    ///< Sum of publish durations
+    uint32_t publish_count;     ///< Number of publish calls
+    uint32_t publish_max_us;    ///< Longest publish call
+    uint32_t publish_errors;    ///< Failed publish calls
+    uint64_t http_sum_us;       ///< Sum of history read durations
+    uint32_t http_count;        ///< Number of history reads
+    uint32_t http_max_us;       ///< Longest history read
+} stress_counters_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void producer_task(void *arg);
+static void consumer_task(void *arg);
+static void probe_task(void *arg);
+static bool wait_flag(volatile bool *flag, bool value);
+static void run_step(uint32_t rate_hz, uint32_t step_ms, stress_step_t *out);
+static void format_results(uint32_t step_ms);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Producer rates of the sweep in Hz (nominal Fast Core rate first)
+static const uint32_t s_rates_hz[] = { 20, 50, 100, 150, 200, 500, 1000, 2000, 5000, 10000 };
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Publish function (NULL = statistics are not published)
+static stress_publish_fn_t s_publish = NULL;
+/// Statistics history store function (NULL = messages are not stored)
+static stress_hist_push_fn_t s_hist_push = NULL;
+/// Statistics history read function (NULL = history reads are not measured)
+static stress_hist_read_fn_t s_hist_read = NULL;
+/// Producer rate in Hz (0 = paused)
+static volatile uint32_t s_rate_hz = 0;
+/// Producer is paused (acknowledges s_rate_hz == 0)
+static volatile bool s_producer_idle = true;
+/// Consumer should discard its ring buffer (set by controller, cleared by consumer)
+static volatile bool s_consumer_reset = false;
+/// Tasks should exit
+static volatile bool s_stop = false;
+/// Number of running tasks
+static volatile uint32_t s_running = 0;
+/// Counters of current step
+static stress_counters_t s_cnt;
+/// Spinlock protecting counters and task count
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+/// Consumer ring buffer storage
+static bms_sample_t s_sc_samples[STRESS_SC_CAPACITY];
+/// Results of finished steps
+static stress_step_t s_steps[STRESS_MAX_STEPS];
+/// Number of finished steps
+static size_t s_step_count = 0;
+/// Results JSON, empty until the sweep has run
+static char s_json[STRESS_JSON_MAXLEN];
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function sets the statistics history used by the consumer and probe tasks. The history belongs to the
+/// HTTP server, which registers it when it starts; without it the sweep skips history stores and reads.
+///
+/// \param[in] push Function storing one statistics message, NULL to skip stores
+/// \param[in] read Function copying the latest statistics message, NULL to skip reads
+/// \return None
+void stress_set_history(stress_hist_push_fn_t push, stress_hist_read_fn_t read)
+{
+    s_hist_push = push;
+    s_hist_read = read;
+
+    return;
+}
+
+/// This function runs the stress sweep and blocks until it finishes. Rates increase until a step is not
+/// sustained. Must be called after inter-core queue initialization and before Fast Core tasks are created, so no
+/// other task uses the queue. The queue is empty when the function returns and the pack simulator is back in its
+/// default configuration (as used by the simulator adapter).
+///
+/// \param[in] publish Function publishing statistics messages, NULL to skip publishing
+/// \param[in] step_ms Duration of one step in milliseconds (at least two consumer cycles)
+/// \return ESP_OK on success, ESP_ERR_INVALID_ARG on too short step, ESP_ERR_NO_MEM if tasks cannot be created,
+///         ESP_ERR_TIMEOUT if tasks do not respond
+esp_err_t stress_run(stress_publish_fn_t publish, uint32_t step_ms)
+{
+    if (step_ms < 2u * STRESS_SC_PERIOD_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bms_sim_config_t sim_cfg;
+    bms_sim_default_config(&sim_cfg);
+    sim_cfg.deterministic = true;
+    esp_err_t err = bms_sim_init(&sim_cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_publish        = publish;
+    s_rate_hz        = 0;
+    s_producer_idle  = true;
+    s_consumer_reset = false;
+    s_stop           = false;
+    s_running        = 3;
+    s_step_count     = 0;
+    s_json[0]        = '\0';
+
+    // Producer with Fast Core priority on Core 1, consumer with Slow Core priority and probe below it on Core 0
+    if (xTaskCreatePinnedToCore(producer_task, "stress_fc", STRESS_TASK_STACK, NULL, 7, NULL, 1) != pdPASS) {
+        BMS_LOGE("Failed to create stress producer task");
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(consumer_task, "stress_sc", STRESS_SC_TASK_STACK, NULL, 4, NULL, 0) != pdPASS) {
+        BMS_LOGE("Failed to create stress consumer task");
+        s_running = 1;
+        s_stop = true;
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(probe_task, "stress_probe", STRESS_TASK_STACK, NULL, 3, NULL, 0) != pdPASS) {
+        BMS_LOGE("Failed to create stress probe task");
+        s_running = 2;
+        s_stop = true;
+        return ESP_ERR_NO_MEM;
+    }
+
+    BMS_LOGI("Running stress sweep (%lu ms per step, publish %s)", (unsigned long)step_ms,
+             publish ? "on" : "off");
+    BMS_LOGI("%s", STRESS_TABLE_HEADER);
+
+    err = ESP_OK;
+    for (size_t i = 0; i < sizeof(s_rates_hz) / sizeof(s_rates_hz[0]) && i < STRESS_MAX_STEPS; ++i) {
+        stress_step_t *step = &s_steps[s_step_count];
+        run_step(s_rates_hz[i], step_ms, step);
+        s_step_count++;
+
+        char row[176];
+        stress_format_row(step, row, sizeof(row));
+        BMS_LOGI("%s", row);
+
+        // Stop at saturation, or if a task does not respond
+        if (!step->sustained || !s_producer_idle || s_consumer_reset) {
+            break;
+        }
+    }
+
+    // Stop tasks and leave the queue empty for normal operation
+    s_stop = true;
+    TickType_t start = xTaskGetTickCount();
+    while (s_running > 0 && (xTaskGetTickCount() - start) < pdMS_TO_TICKS(STRESS_SYNC_TIMEOUT_MS)) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (s_running > 0) {
+        BMS_LOGE("Stress tasks did not exit");
+        err = ESP_ERR_TIMEOUT;
+    }
+    bms_sample_t sample;
+    while (bms_queue_pop(&sample)) {
+    }
+    bms_sim_init(NULL);
+
+    format_results(step_ms);
+    BMS_LOGI("Maximum sustained rate %lu Hz", (unsigned long)stress_max_sustained_hz());
+    BMS_LOGI("STRESS %s", s_json);
+
+    return err;
+}
+
+/// This function returns results of finished stress steps.
+///
+/// \param[out] steps Pointer set to array of step results
+/// \return Number of finished steps
+size_t stress_get_steps(const stress_step_t **steps)
+{
+    if (steps) {
+        *steps = s_steps;
+    }
+
+    return s_step_count;
+}
+
+/// This function returns the highest sustained producer rate of the last sweep.
+///
+/// \param None
+/// \return Rate in Hz, 0 if no step was sustained
+uint32_t stress_max_sustained_hz(void)
+{
+    uint32_t max_hz = 0;
+    for (size_t i = 0; i < s_step_count; ++i) {
+        if (s_steps[i].sustained && s_steps[i].rate_hz > max_hz) {
+            max_hz = s_steps[i].rate_hz;
+        }
+    }
+
+    return max_hz;
+}
+
+/// This function returns results of the stress sweep as JSON object, or NULL if the sweep has not run.
+///
+/// \param None
+/// \return Pointer to JSON string, or NULL
+const char *stress_get_json(void)
+{
+    return s_json[0] ? s_json : NULL;
+}
+
+/// This function formats one step as a row of the result table (columns of ::STRESS_TABLE_HEADER).
+///
+/// \param[in] step Step results
+/// \param[out] buf Output buffer
+/// \param[in] size Size of output buffer
+/// \return Number of characters written (as snprintf)
+int stress_format_row(const stress_step_t *step, char *buf, size_t size)
+{
+    return snprintf(buf, size, "%9lu %9lu %8lu %8lu %7lu %8lu %8lu %8lu %10lu %11lu %11lu %12lu %12lu  %s",
+                    (unsigned long)step->rate_hz, (unsigned long)step->produced, (unsigned long)step->dropped,
+                    (unsigned long)step->overruns, (unsigned long)step->queue_peak, (unsigned long)step->backlog,
+                    (unsigned long)step->sc_left_max, (unsigned long)step->windows, (unsigned long)step->sc_cycle_max_us,
+                    (unsigned long)step->publish_mean_us, (unsigned long)step->publish_max_us,
+                    (unsigned long)step->http_mean_us, (unsigned long)step->http_max_us,
+                    step->sustained ? "yes" : "no");
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// Producer task. Every tick reads the samples due at the current rate from the simulator and pushes them into
+/// the inter-core queue, like the Fast Core does once per period.
+///
+/// \param[in] arg Unused
+/// \return None
+static void producer_task(void *arg)
+{
+    (void)arg;
+    const uint32_t tick_us = 1000000u / configTICK_RATE_HZ;
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t acc = 0;
+
+    while (!s_stop) {
+        uint32_t rate = s_rate_hz;
+        if (rate == 0) {
+            acc = 0;
+            s_producer_idle = true;
+            vTaskDelayUntil(&last_wake, 1);
+            continue;
+        }
+        s_producer_idle = false;
+
+        // Samples due in this tick (fractional part carried over)
+        acc += rate;
+        uint32_t n = acc / configTICK_RATE_HZ;
+        acc %= configTICK_RATE_HZ;
+
+        uint32_t start = stage_timing_now_us();
+        uint32_t pushed = 0;
+        uint32_t dropped = 0;
+        uint32_t peak = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            bms_sample_t sample;
+            bms_sim_read_sample(&sample);
+            if (bms_queue_push(&sample)) {
+                pushed++;
+            } else {
+                dropped++;
+            }
+            uint32_t used = BMS_QUEUE_LEN - (uint32_t)bms_queue_free_slots();
+            peak = (used > peak) ? used : peak;
+        }
+        bool overrun = (stage_timing_now_us() - start) > tick_us;
+
+        taskENTER_CRITICAL(&s_lock);
+        s_cnt.produced += pushed;
+        s_cnt.dropped  += dropped;
+        s_cnt.overruns += overrun ? 1u : 0u;
+        if (peak > s_cnt.queue_peak) {
+            s_cnt.queue_peak = peak;
+        }
+        taskEXIT_CRITICAL(&s_lock);
+
+        vTaskDelayUntil(&last_wake, 1);
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_running--;
+    taskEXIT_CRITICAL(&s_lock);
+    vTaskDelete(NULL);
+
+    return;
+}
+
+/// Consumer task. Runs the Slow Core processing cycle: fills the ring buffer from the queue up to its capacity,
+/// computes all complete statistics windows, serializes and publishes them and stores them in the history.
+///
+/// \param[in] arg Unused
+/// \return None
+static void consumer_task(void *arg)
+{
+    (void)arg;
+    bms_sample_buffer_t buf = { .samples = s_sc_samples, .head = 0, .count = 0, .capacity = STRESS_SC_CAPACITY };
+    bms_stats_buffer_t stats;
+    char json[BMS_STATS_JSON_MAXLEN];
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (!s_stop) {
+        if (s_consumer_reset) {
+            buf.head  = 0;
+            buf.count = 0;
+            s_consumer_reset = false;
+        }
+
+        uint32_t start = stage_timing_now_us();
+        bms_sample_t sample;
+        while (buf.count < buf.capacity && bms_queue_pop(&sample)) {
+            buf.samples[bms_buf_index(&buf, buf.count)] = sample;
+            buf.count++;
+        }
+        // Samples the ring buffer had no room for wait for the next cycle
+        uint32_t left = BMS_QUEUE_LEN - (uint32_t)bms_queue_free_slots();
+
+        while (buf.count > 0) {
+            if (bms_compute_stats(&buf, &stats) == 0) {
+                break;
+            }
+            for (size_t w = 0; w < stats.stats_count; ++w) {
+                int len = bms_stats_to_json(&stats.stats_array[w], json, sizeof(json));
+                if (len < 0) {
+                    continue;
+                }
+
+                uint32_t t_pub = stage_timing_now_us();
+                esp_err_t perr = s_publish ? s_publish(STRESS_TOPIC, json, len) : ESP_OK;
+                uint32_t pub_us = stage_timing_now_us() - t_pub;
+                if (s_hist_push) {
+                    s_hist_push(json, (size_t)len);
+                }
+
+                taskENTER_CRITICAL(&s_lock);
+                s_cnt.windows++;
+                if (s_publish) {
+                    s_cnt.publish_sum_us += pub_us;
+                    s_cnt.publish_count++;
+                    s_cnt.publish_max_us = (pub_us > s_cnt.publish_max_us) ? pub_us : s_cnt.publish_max_us;
+                    s_cnt.publish_errors += (perr != ESP_OK) ? 1u : 0u;
+                }
+                taskEXIT_CRITICAL(&s_lock);
+            }
+        }
+
+        uint32_t cycle_us = stage_timing_now_us() - start;
+        taskENTER_CRITICAL(&s_lock);
+        if (cycle_us > s_cnt.sc_cycle_max_us) {
+            s_cnt.sc_cycle_max_us = cycle_us;
+        }
+        if (left > s_cnt.sc_left_max) {
+            s_cnt.sc_left_max = left;
+        }
+        s_cnt.sc_left_last = left;
+        taskEXIT_CRITICAL(&s_lock);
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(STRESS_SC_PERIOD_MS));
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_running--;
+    taskEXIT_CRITICAL(&s_lock);
+    vTaskDelete(NULL);
+
+    return;
+}
+
+/// Probe task. Periodically reads the latest statistics message from the history, the work done by the
+/// /bms/stats/data handler for every browser poll, and records its latency under load.
+///
+/// \param[in] arg Unused
+/// \return None
+static void probe_task(void *arg)
+{
+    (void)arg;
+    char json[BMS_STATS_JSON_MAXLEN];
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (!s_stop) {
+        uint32_t start = stage_timing_now_us();
+        size_t len = s_hist_read ? s_hist_read(json, sizeof(json)) : 0;
+        uint32_t us = stage_timing_now_us() - start;
+
+        if (len > 0 && s_rate_hz != 0) {
+            taskENTER_CRITICAL(&s_lock);
+            s_cnt.http_sum_us += us;
+            s_cnt.http_count++;
+            if (us > s_cnt.http_max_us) {
+                s_cnt.http_max_us = us;
+            }
+            taskEXIT_CRITICAL(&s_lock);
+        }
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(STRESS_PROBE_PERIOD_MS));
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_running--;
+    taskEXIT_CRITICAL(&s_lock);
+    vTaskDelete(NULL);
+
+    return;
+}
+
+/// This function waits until a flag set by a stress task reaches the given value.
+///
+/// \param[in] flag Flag to wait for
+/// \param[in] value Expected value
+/// \return True if the flag reached the value, false on timeout
+static bool wait_flag(volatile bool *flag, bool value)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (*flag != value) {
+        if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(STRESS_SYNC_TIMEOUT_MS)) {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+
+    return true;
+}
+
+/// This function runs one stress step. Starts from an empty queue and ring buffer, lets the producer run at the
+/// given rate for the step duration and evaluates counters. A step is sustained when no sample was dropped, the
+/// producer never overran a tick, produced at least 95 % of the nominal samples, no publish failed and the last
+/// consumer cycle left at most 100 ms worth of samples in the queue after filling its ring buffer. Samples left
+/// behind in every cycle mean the backlog grows without bound, which a short step would not show as drops, while
+/// samples left once by a late consumer cycle are taken by the next one.
+///
+/// \param[in] rate_hz Producer rate in Hz
+/// \param[in] step_ms Step duration in milliseconds
+/// \param[out] out Step results
+/// \return None
+static void run_step(uint32_t rate_hz, uint32_t step_ms, stress_step_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->rate_hz = rate_hz;
+
+    // Start from empty queue and ring buffer
+    bms_sample_t sample;
+    while (bms_queue_pop(&sample)) {
+    }
+    s_consumer_reset = true;
+    if (!wait_flag(&s_consumer_reset, false)) {
+        BMS_LOGE("Stress consumer does not respond");
+        return;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    memset(&s_cnt, 0, sizeof(s_cnt));
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_rate_hz = rate_hz;
+    vTaskDelay(pdMS_TO_TICKS(step_ms));
+    s_rate_hz = 0;
+    if (!wait_flag(&s_producer_idle, true)) {
+        BMS_LOGE("Stress producer does not respond");
+        return;
+    }
+
+    stress_counters_t c;
+    taskENTER_CRITICAL(&s_lock);
+    c = s_cnt;
+    taskEXIT_CRITICAL(&s_lock);
+
+    out->produced        = c.produced;
+    out->dropped         = c.dropped;
+    out->overruns        = c.overruns;
+    out->queue_peak      = c.queue_peak;
+    out->backlog         = BMS_QUEUE_LEN - (uint32_t)bms_queue_free_slots();
+    out->sc_left_max     = c.sc_left_max;
+    out->windows         = c.windows;
+    out->sc_cycle_max_us = c.sc_cycle_max_us;
+    out->publish_mean_us = c.publish_count ? (uint32_t)(c.publish_sum_us / c.publish_count) : 0;
+    out->publish_max_us  = c.publish_max_us;
+    out->publish_errors  = c.publish_errors;
+    out->http_mean_us    = c.http_count ? (uint32_t)(c.http_sum_us / c.http_count) : 0;
+    out->http_max_us     = c.http_max_us;
+
+    uint64_t nominal = (uint64_t)rate_hz * step_ms / 1000u;
+    uint32_t left_limit = (rate_hz / 10u > 1u) ? rate_hz / 10u : 1u;
+    out->sustained = (c.dropped == 0) && (c.overruns == 0) && (c.publish_errors == 0) &&
+                     ((uint64_t)(c.produced + c.dropped) * 100u >= nominal * 95u) &&
+                     (c.sc_left_last <= left_limit);
+
+    return;
+}
+
+/// This function formats results of all finished steps as JSON object.
+///
+/// \param[in] step_ms Step duration in milliseconds
+/// \return None
+static void format_results(uint32_t step_ms)
+{
+    int pos = snprintf(s_json, sizeof(s_json),
+                       "{\"tick_hz\":%u,\"queue_len\":%u,\"sc_capacity\":%u,\"sc_period_ms\":%u,\"step_ms\":%lu,"
+                       "\"max_sustained_hz\":%lu,\"steps\":[",
+                       (unsigned)configTICK_RATE_HZ, (unsigned)BMS_QUEUE_LEN, (unsigned)STRESS_SC_CAPACITY,
+                       (unsigned)STRESS_SC_PERIOD_MS, (unsigned long)step_ms,
+                       (unsigned long)stress_max_sustained_hz());
+
+    for (size_t i = 0; i < s_step_count && pos > 0 && pos < (int)sizeof(s_json); ++i) {
+        const stress_step_t *s = &s_steps[i];
+        pos += snprintf(&s_json[pos], sizeof(s_json) - (size_t)pos,
+                        "%s{\"rate_hz\":%lu,\"produced\":%lu,\"dropped\":%lu,\"overruns\":%lu,\"queue_peak\":%lu,"
+                        "\"backlog\":%lu,\"sc_left_max\":%lu,\"windows\":%lu,\"sc_cycle_max_us\":%lu,\"publish_mean_us\":%lu,"
+                        "\"publish_max_us\":%lu,\"publish_errors\":%lu,\"http_mean_us\":%lu,\"http_max_us\":%lu,"
+                        "\"sustained\":%s}",
+                        (i > 0) ? "," : "", (unsigned long)s->rate_hz, (unsigned long)s->produced,
+                        (unsigned long)s->dropped, (unsigned long)s->overruns, (unsigned long)s->queue_peak,
+                        (unsigned long)s->backlog, (unsigned long)s->sc_left_max, (unsigned long)s->windows, (unsigned long)s->sc_cycle_max_us,
+                        (unsigned long)s->publish_mean_us, (unsigned long)s->publish_max_us,
+                        (unsigned long)s->publish_errors, (unsigned long)s->http_mean_us,
+                        (unsigned long)s->http_max_us, s->sustained ? "true" : "false");
+    }
+    if (pos > 0 && pos < (int)sizeof(s_json) - 2) {
+        snprintf(&s_json[pos], sizeof(s_json) - (size_t)pos, "]}");
+    } else {
+        BMS_LOGE("Stress results JSON truncated");
+        s_json[0] = '\0';
+    }
+
+    return;
+}
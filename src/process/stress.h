@@ -0,0 +1,81 @@
+/// Header file for `stress.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Duration of one stress step (one producer rate) in milliseconds
+#ifndef CONFIG_BMS_STRESS_STEP_MS
+#define CONFIG_BMS_STRESS_STEP_MS  5000
+#endif
+
+/// Maximum number of stress steps (producer rates)
+#define STRESS_MAX_STEPS           10
+
+/// Header of the stress result table, matches rows formatted by stress_format_row()
+#define STRESS_TABLE_HEADER \
+    "  rate_hz  produced  dropped  overrun  q_peak  backlog  sc_left  windows  sc_max_us  pub_avg_us  pub_max_us  " \
+    "http_avg_us  http_max_us  ok"
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Function publishing one statistics message (MQTT QoS 0 on target, stand-in broker on host)
+typedef esp_err_t (*stress_publish_fn_t)(const char *topic, const char *data, int len);
+
+/// Function storing one statistics message in the statistics history (registered by the HTTP server)
+typedef void (*stress_hist_push_fn_t)(const char *json, size_t len);
+
+/// Function copying the latest statistics message from the history, returns its length (0 if empty)
+typedef size_t (*stress_hist_read_fn_t)(char *buf, size_t size);
+
+/// Structure of results of one stress step
+typedef struct {
+    uint32_t rate_hz;           ///< Producer sample rate
+    uint32_t produced;          ///< Number of samples pushed into inter-core queue
+    uint32_t dropped;           ///< Number of samples dropped because the queue was full
+    uint32_t overruns;          ///< Number of producer ticks which took longer than one tick
+    uint32_t queue_peak;        ///< Peak inter-core queue occupancy in samples
+    uint32_t backlog;           ///< Inter-core queue occupancy at the end of the step
+    uint32_t sc_left_max;       ///< Most samples left in the queue after a consumer cycle filled its ring buffer
+    uint32_t windows;           ///< Number of statistics windows computed, serialized and published
+    uint32_t sc_cycle_max_us;   ///< Longest consumer (Slow Core) cycle in microseconds
+    uint32_t publish_mean_us;   ///< Mean publish call duration in microseconds
+    uint32_t publish_max_us;    ///< Longest publish call in microseconds
+    uint32_t publish_errors;    ///< Number of failed publish calls
+    uint32_t http_mean_us;      ///< Mean latency of statistics history reads (HTTP stats handler path)
+    uint32_t http_max_us;       ///< Longest statistics history read in microseconds
+    bool     sustained;         ///< Rate sustained without loss, overrun or samples left behind by consumer
+} stress_step_t;
+
+/*==============================================================================================================*/
+/*                                             Public Constants                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                             Public Variables                                                 */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void stress_set_history(stress_hist_push_fn_t push, stress_hist_read_fn_t read);
+esp_err_t stress_run(stress_publish_fn_t publish, uint32_t step_ms);
+size_t stress_get_steps(const stress_step_t **steps);
+uint32_t stress_max_sustained_hz(void);
+const char *stress_get_json(void);
+int stress_format_row(const stress_step_t *step, char *buf, size_t size);
+
+/*==============================================================================================================*/
+/*                                          Public Inline Functions                                             */
+/*==============================================================================================================*/
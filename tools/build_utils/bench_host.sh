@@ -0,0 +1,12 @@
+#!/bin/bash
+set -e
+
+# Go to host build project dir
+cd "../host"
+
+# Configure and build host pipeline benchmark
+cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
+cmake --build build -j"$(nproc)"
+
+# Run benchmark, results as JSON Lines (pass e.g. -s 0.1 for a quick run)
+./build/bms_bench "$@" | tee build/bench.jsonl
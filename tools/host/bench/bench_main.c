@@ -0,0 +1,885 @@
+/// Host benchmark of the acquisition and processing pipeline. Every benchmark runs a fixed number of iterations
+/// several times and reports the median and minimum cost per unit of work. Results are printed to stdout as
+/// JSON Lines (one object per benchmark), diagnostics go to stderr.
+///
+/// Usage: bms_bench [-r repeats] [-s scale] [-f filter]
+///   -r  number of repeats per benchmark (default 5), median and minimum are reported
+///   -s  iteration count multiplier (default 1.0), e.g. 0.01 for a quick smoke run
+///   -f  run only benchmarks whose name contains the given substring
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "process.h"
+#include "json_formatter.h"
+#include "intercore_comm.h"
+#include "stats_history.h"
+#include "ltc6804.h"
+#include "ltc6804_codec.h"
+#include "ltc6804_emu.h"
+#include "rolling_stats.h"
+#include "percentile.h"
+#include "anomaly.h"
+#include "goertzel.h"
+#include "pt1000.h"
+#include "bms_sim.h"
+#include "bms_trace.h"
+#include "configuration.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Maximum number of repeats per benchmark
+#define BENCH_MAX_REPEATS      32
+
+/// Capacity of the sample ring buffer used by statistics benchmarks
+#define BENCH_SAMPLE_CAPACITY  64
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Result of one benchmark run
+typedef struct {
+    uint64_t units;             ///< Number of processed units of work (windows, messages, bytes, ...)
+    uint64_t bytes;             ///< Number of produced bytes (0 if not applicable)
+    uint64_t max_bytes;         ///< Largest single output in bytes (0 if not applicable)
+} bench_run_t;
+
+/// Benchmark function. Runs given number of iterations and fills the result.
+typedef void (*bench_fn_t)(uint64_t iterations, bench_run_t *run);
+
+/// Benchmark descriptor
+typedef struct {
+    const char *name;           ///< Benchmark name
+    const char *unit;           ///< Name of unit of work
+    uint64_t    iterations;     ///< Iterations per repeat at scale 1.0
+    bench_fn_t  fn;             ///< Benchmark function
+} bench_t;
+
+/// Layout of emulated LTC6804 chains
+typedef struct {
+    uint8_t chains;             ///< Number of chains (one emulated bus each)
+    uint8_t ics;                ///< Number of devices per chain
+    uint8_t cells_per_ic;       ///< Number of cells per device
+} bench_ltc_layout_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static uint64_t now_ns(void);
+static int cmp_double(const void *a, const void *b);
+static void fill_samples(bms_sample_t *samples, size_t count, bool violation);
+static void run_compute_stats(uint64_t iterations, bench_run_t *run, bool violation);
+static void bench_compute_stats_nominal(uint64_t iterations, bench_run_t *run);
+static void bench_compute_stats_violation(uint64_t iterations, bench_run_t *run);
+static void bench_stats_to_json(uint64_t iterations, bench_run_t *run);
+static void run_pec15(uint64_t iterations, bench_run_t *run, uint8_t len);
+static void bench_pec15_cmd(uint64_t iterations, bench_run_t *run);
+static void bench_pec15_reg(uint64_t iterations, bench_run_t *run);
+static void bench_pec15_max(uint64_t iterations, bench_run_t *run);
+static void fill_cell_regs(uint8_t regs[4][LTC6804_REG_RX_BYTES]);
+static void bench_parse_cell_regs(uint64_t iterations, bench_run_t *run);
+static void bench_decode_cell_regs(uint64_t iterations, bench_run_t *run);
+static void bench_queue_push_pop(uint64_t iterations, bench_run_t *run);
+static void bench_stats_hist_push(uint64_t iterations, bench_run_t *run);
+static void bench_pt1000(uint64_t iterations, bench_run_t *run);
+static void bench_sim_read_sample(uint64_t iterations, bench_run_t *run);
+static void bench_trace_record(uint64_t iterations, bench_run_t *run);
+static void run_rolling_push(uint64_t iterations, bench_run_t *run, uint16_t window);
+static void bench_rolling_push(uint64_t iterations, bench_run_t *run);
+static void bench_rolling_push_w100(uint64_t iterations, bench_run_t *run);
+static void bench_rolling_rescan_w100(uint64_t iterations, bench_run_t *run);
+static void run_pct_window(uint64_t iterations, bench_run_t *run, int channels);
+static void bench_pct_window_12(uint64_t iterations, bench_run_t *run);
+static void bench_pct_window_96(uint64_t iterations, bench_run_t *run);
+static void bench_pct_p2_stream(uint64_t iterations, bench_run_t *run);
+static void bench_anomaly_update(uint64_t iterations, bench_run_t *run);
+static void run_goertzel(uint64_t iterations, bench_run_t *run, uint8_t bins);
+static void bench_goertzel_4(uint64_t iterations, bench_run_t *run);
+static void bench_goertzel_8(uint64_t iterations, bench_run_t *run);
+static void run_ltc6804_read(uint64_t iterations, bench_run_t *run, const bench_ltc_layout_t *layout,
+                             uint32_t bit_error_ppm, bool read_flags);
+static void bench_ltc6804_read(uint64_t iterations, bench_run_t *run);
+static void bench_ltc6804_read_faults(uint64_t iterations, bench_run_t *run);
+static void bench_ltc6804_read_flags(uint64_t iterations, bench_run_t *run);
+static void bench_ltc6804_read_1x2(uint64_t iterations, bench_run_t *run);
+static void bench_ltc6804_read_2x2(uint64_t iterations, bench_run_t *run);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Table of benchmarks
+static const bench_t s_benches[] = {
+    { "bms_compute_stats/nominal",   "window",  200000,   bench_compute_stats_nominal   },
+    { "bms_compute_stats/violation", "window",  200000,   bench_compute_stats_violation },
+    { "bms_stats_to_json",           "message", 200000,   bench_stats_to_json           },
+    { "pec15_calc/cmd2",             "byte",    20000000, bench_pec15_cmd               },
+    { "pec15_calc/reg6",             "byte",    10000000, bench_pec15_reg               },
+    { "pec15_calc/len255",           "byte",    200000,   bench_pec15_max               },
+    { "ltc6804_parse_cell_regs",     "sample",  5000000,  bench_parse_cell_regs         },
+    { "ltc6804_decode_reg/fused",    "sample",  5000000,  bench_decode_cell_regs        },
+    { "bms_queue_push_pop",          "sample",  2000000,  bench_queue_push_pop          },
+    { "bms_stats_hist_push",         "message", 1000000,  bench_stats_hist_push         },
+    { "pt1000_raw_to_celsius",       "sample",  2000000,  bench_pt1000                  },
+    { "bms_sim_read_sample",         "sample",  2000000,  bench_sim_read_sample         },
+    { "bms_trace_rec/push_flush",    "sample",  2000000,  bench_trace_record            },
+    { "bms_rolling_push",            "sample",  2000000,  bench_rolling_push            },
+    { "bms_rolling_push/w100",       "sample",  2000000,  bench_rolling_push_w100       },
+    { "bms_rolling/rescan_w100",     "sample",  200000,   bench_rolling_rescan_w100     },
+    { "bms_pct_window/12ch",         "window",  200000,   bench_pct_window_12           },
+    { "bms_pct_window/96ch",         "window",  20000,    bench_pct_window_96           },
+    { "bms_pct_add/p2",              "sample",  5000000,  bench_pct_p2_stream           },
+    { "bms_anomaly_update",          "window",  1000000,  bench_anomaly_update          },
+    { "bms_goertzel_push/4f",        "sample",  10000000, bench_goertzel_4              },
+    { "bms_goertzel_push/8f",        "sample",  10000000, bench_goertzel_8              },
+    { "ltc6804_read_cells/emu",      "sample",  200,      bench_ltc6804_read            },
+    { "ltc6804_read_cells/emu_bitf", "sample",  200,      bench_ltc6804_read_faults     },
+    { "ltc6804_read_cells/emu_flags","sample",  200,      bench_ltc6804_read_flags      },
+    { "ltc6804_read_cells/emu_1x2",  "sample",  200,      bench_ltc6804_read_1x2        },
+    { "ltc6804_read_cells/emu_2x2",  "sample",  200,      bench_ltc6804_read_2x2        },
+};
+
+/// Emulated LTC6804 layouts: one device with 12 cells, and 2 devices with 3 cells each on one or two chains
+static const bench_ltc_layout_t s_ltc_single = { .chains = 1, .ics = 1, .cells_per_ic = 12 };
+static const bench_ltc_layout_t s_ltc_1x2 = { .chains = 1, .ics = 2, .cells_per_ic = 3 };
+static const bench_ltc_layout_t s_ltc_2x2 = { .chains = 2, .ics = 2, .cells_per_ic = 3 };
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Sink preventing the compiler from removing benchmarked work
+static volatile uint32_t s_sink;
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+int main(int argc, char **argv)
+{
+    int repeats = 5;
+    double scale = 1.0;
+    const char *filter = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:s:f:")) != -1) {
+        switch (opt) {
+            case 'r': repeats = atoi(optarg); break;
+            case 's': scale = atof(optarg);   break;
+            case 'f': filter = optarg;        break;
+            default:
+                fprintf(stderr, "usage: %s [-r repeats] [-s scale] [-f filter]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (repeats < 1 || repeats > BENCH_MAX_REPEATS || scale <= 0.0) {
+        fprintf(stderr, "invalid arguments (1 <= repeats <= %d, scale > 0)\n", BENCH_MAX_REPEATS);
+        return 2;
+    }
+
+    bms_queue_init();
+
+    for (size_t b = 0; b < sizeof(s_benches) / sizeof(s_benches[0]); ++b) {
+        const bench_t *bench = &s_benches[b];
+        if (filter && !strstr(bench->name, filter)) {
+            continue;
+        }
+
+        uint64_t iterations = (uint64_t)((double)bench->iterations * scale);
+        if (iterations == 0) {
+            iterations = 1;
+        }
+
+        // Warm-up run (caches, branch predictors, lazily initialized module state)
+        bench_run_t run = {0};
+        bench->fn(iterations / 10 + 1, &run);
+
+        double ns_per_unit[BENCH_MAX_REPEATS];
+        for (int r = 0; r < repeats; ++r) {
+            memset(&run, 0, sizeof(run));
+            uint64_t start = now_ns();
+            bench->fn(iterations, &run);
+            uint64_t elapsed = now_ns() - start;
+            ns_per_unit[r] = run.units ? (double)elapsed / (double)run.units : 0.0;
+        }
+        qsort(ns_per_unit, (size_t)repeats, sizeof(double), cmp_double);
+
+        printf("{\"bench\":\"%s\",\"unit\":\"%s\",\"iterations\":%llu,\"repeats\":%d,"
+               "\"ns_per_unit\":%.3f,\"ns_per_unit_min\":%.3f",
+               bench->name, bench->unit, (unsigned long long)iterations, repeats,
+               ns_per_unit[repeats / 2], ns_per_unit[0]);
+        if (run.bytes) {
+            printf(",\"bytes_per_unit\":%.1f,\"bytes_max\":%llu",
+                   (double)run.bytes / (double)run.units, (unsigned long long)run.max_bytes);
+        }
+        printf("}\n");
+        fflush(stdout);
+    }
+
+    return 0;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function returns monotonic time in nanoseconds.
+///
+/// \param None
+/// \return Time in nanoseconds
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/// qsort() comparator of doubles.
+static int cmp_double(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+
+    return (da > db) - (da < db);
+}
+
+/// This function fills samples with cell voltages around 1.2 V. With violation, every 7th sample has one
+/// overvoltage cell, which makes bms_compute_stats() split the second into 0.2 s windows.
+///
+/// \param[out] samples Array of samples
+/// \param[in] count Number of samples
+/// \param[in] violation True to inject overvoltage
+/// \return None
+static void fill_samples(bms_sample_t *samples, size_t count, bool violation)
+{
+    for (size_t i = 0; i < count; ++i) {
+        bms_sample_t *s = &samples[i];
+        s->pack_v = 0.0f;
+        for (int c = 0; c < BMS_MAX_CELLS; ++c) {
+            s->cell_v[c] = 1.2f + 0.001f * (float)((i * 7 + (size_t)c * 3) % 50);
+            s->pack_v += s->cell_v[c];
+        }
+        if (violation && (i % 7) == 3) {
+            s->cell_v[i % BMS_MAX_CELLS] = g_cfg.battery.cell_v_max + 0.1f;
+        }
+        s->pack_i      = 2.5f + 0.01f * (float)(i % 10);
+        s->temperature = 25.0f + 0.1f * (float)(i % 5);
+        s->timestamp   = (TickType_t)(i * 50);
+    }
+
+    return;
+}
+
+/// This function runs bms_compute_stats() over 1 s of samples per iteration. Samples are generated once,
+/// each iteration only rewinds the ring buffer.
+///
+/// \param[in] iterations Number of iterations
+/// \param[out] run Result (units = computed windows)
+/// \param[in] violation True to use samples with limit violations
+/// \return None
+static void run_compute_stats(uint64_t iterations, bench_run_t *run, bool violation)
+{
+    static bms_sample_t samples[BENCH_SAMPLE_CAPACITY];
+    fill_samples(samples, BENCH_SAMPLE_CAPACITY, violation);
+
+    bms_sample_buffer_t buf = { .samples = samples, .capacity = BENCH_SAMPLE_CAPACITY };
+    bms_stats_buffer_t stats;
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        buf.head  = (size_t)(i % BENCH_SAMPLE_CAPACITY);
+        buf.count = 20;
+        bms_compute_stats(&buf, &stats);
+        run->units += stats.stats_count;
+        s_sink += stats.stats_array[0].cell_errors;
+    }
+
+    return;
+}
+
+static void bench_compute_stats_nominal(uint64_t iterations, bench_run_t *run)
+{
+    run_compute_stats(iterations, run, false);
+
+    return;
+}
+
+static void bench_compute_stats_violation(uint64_t iterations, bench_run_t *run)
+{
+    run_compute_stats(iterations, run, true);
+
+    return;
+}
+
+/// This function serializes stats windows to JSON. Every 10th message contains telemetry, as on target.
+///
+/// \param[in] iterations Number of messages
+/// \param[out] run Result (units = messages, bytes = JSON bytes)
+/// \return None
+static void bench_stats_to_json(uint64_t iterations, bench_run_t *run)
+{
+    static bms_sample_t samples[BENCH_SAMPLE_CAPACITY];
+    fill_samples(samples, BENCH_SAMPLE_CAPACITY, false);
+
+    bms_sample_buffer_t buf = { .samples = samples, .capacity = BENCH_SAMPLE_CAPACITY, .count = 20 };
+    bms_stats_buffer_t stats;
+    bms_compute_stats(&buf, &stats);
+
+    char json[BMS_STATS_JSON_MAXLEN];
+    for (uint64_t i = 0; i < iterations; ++i) {
+        int len = bms_stats_to_json(&stats.stats_array[0], json, sizeof(json));
+        if (len < 0) {
+            fprintf(stderr, "bms_stats_to_json failed\n");
+            exit(1);
+        }
+        run->units++;
+        run->bytes += (uint64_t)len;
+        if ((uint64_t)len > run->max_bytes) {
+            run->max_bytes = (uint64_t)len;
+        }
+    }
+
+    return;
+}
+
+/// This function runs ltc6804_pec15_calc() over buffers of given length.
+///
+/// \param[in] iterations Number of PEC calculations
+/// \param[out] run Result (units = processed bytes)
+/// \param[in] len Buffer length in bytes
+/// \return None
+static void run_pec15(uint64_t iterations, bench_run_t *run, uint8_t len)
+{
+    uint8_t data[255];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    uint32_t acc = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        data[0] = (uint8_t)i;
+        acc += ltc6804_pec15_calc(len, data);
+    }
+    s_sink += acc;
+    run->units += iterations * len;
+
+    return;
+}
+
+static void bench_pec15_cmd(uint64_t iterations, bench_run_t *run)
+{
+    run_pec15(iterations, run, 2);
+
+    return;
+}
+
+static void bench_pec15_reg(uint64_t iterations, bench_run_t *run)
+{
+    run_pec15(iterations, run, LTC6804_REG_DATA_BYTES);
+
+    return;
+}
+
+static void bench_pec15_max(uint64_t iterations, bench_run_t *run)
+{
+    run_pec15(iterations, run, 255);
+
+    return;
+}
+
+/// This function fills four cell voltage register groups with fixed data and valid PEC.
+///
+/// \param[out] regs Register groups
+/// \return None
+static void fill_cell_regs(uint8_t regs[4][LTC6804_REG_RX_BYTES])
+{
+    for (int r = 0; r < 4; ++r) {
+        for (int b = 0; b < LTC6804_REG_DATA_BYTES; ++b) {
+            regs[r][b] = (uint8_t)(r * 17 + b * 5 + 3);
+        }
+        uint16_t pec = ltc6804_pec15_calc(LTC6804_REG_DATA_BYTES, regs[r]);
+        regs[r][6] = (uint8_t)(pec >> 8);
+        regs[r][7] = (uint8_t)pec;
+    }
+
+    return;
+}
+
+/// This function verifies PEC (byte-wise) and parses cell codes of all four cell voltage register groups in separate
+/// passes, the reference for bench_decode_cell_regs().
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_parse_cell_regs(uint64_t iterations, bench_run_t *run)
+{
+    uint8_t regs[4][LTC6804_REG_RX_BYTES];
+    fill_cell_regs(regs);
+
+    uint16_t codes[12];
+    for (uint64_t i = 0; i < iterations; ++i) {
+        int pec_errors = 0;
+        for (int r = 0; r < 4; ++r) {
+            ltc6804_parse_cell_codes(regs[r], &codes[r * 3]);
+            pec_errors += !ltc6804_reg_pec_ok(regs[r]);
+        }
+        s_sink += codes[(size_t)(i % 12)] + (uint32_t)pec_errors;
+    }
+    run->units += iterations;
+
+    return;
+}
+
+/// This function decodes all four cell voltage register groups with ltc6804_decode_reg() (cell codes and PEC
+/// in one pass), as the driver does.
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_decode_cell_regs(uint64_t iterations, bench_run_t *run)
+{
+    uint8_t regs[4][LTC6804_REG_RX_BYTES];
+    fill_cell_regs(regs);
+
+    uint16_t codes[12];
+    for (uint64_t i = 0; i < iterations; ++i) {
+        int pec_errors = 0;
+        for (int r = 0; r < 4; ++r) {
+            pec_errors += !ltc6804_decode_reg(regs[r], &codes[r * 3]);
+        }
+        s_sink += codes[(size_t)(i % 12)] + (uint32_t)pec_errors;
+    }
+    run->units += iterations;
+
+    return;
+}
+
+/// This function pushes and pops one sample through the inter-core queue per iteration.
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_queue_push_pop(uint64_t iterations, bench_run_t *run)
+{
+    bms_sample_t in;
+    bms_sample_t out;
+    fill_samples(&in, 1, false);
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        in.timestamp = (TickType_t)i;
+        if (!bms_queue_push(&in) || !bms_queue_pop(&out)) {
+            fprintf(stderr, "bms_queue push/pop failed\n");
+            exit(1);
+        }
+        s_sink += out.timestamp;
+    }
+    run->units += iterations;
+
+    return;
+}
+
+/// This function stores a telemetry sized JSON message into statistics history per iteration.
+///
+/// \param[in] iterations Number of messages
+/// \param[out] run Result (units = messages)
+/// \return None
+static void bench_stats_hist_push(uint64_t iterations, bench_run_t *run)
+{
+    char json[BMS_STATS_JSON_MAXLEN];
+    memset(json, 'x', sizeof(json));
+    const size_t len = 1200;
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        json[0] = (char)('0' + (i % 10));
+        bms_stats_hist_push(json, len);
+    }
+    run->units += iterations;
+
+    return;
+}
+
+/// This function converts raw ADC values to temperature, half of them below 0 deg C (Newton-Raphson path).
+///
+/// \param[in] iterations Number of conversions
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_pt1000(uint64_t iterations, bench_run_t *run)
+{
+    float acc = 0.0f;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        int raw = 1760 + (int)(i % 256) * 2;
+        acc += pt1000_raw_to_celsius(raw);
+    }
+    s_sink += (uint32_t)(int32_t)acc;
+    run->units += iterations;
+
+    return;
+}
+
+/// This function produces samples with the deterministic pack simulator (default profile, seed 1).
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_sim_read_sample(uint64_t iterations, bench_run_t *run)
+{
+    bms_sim_config_t cfg;
+    bms_sim_default_config(&cfg);
+    cfg.deterministic = true;
+    bms_sim_init(&cfg);
+
+    bms_sample_t sample;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bms_sim_read_sample(&sample);
+        s_sink += (uint32_t)(sample.pack_v * 1000.0f);
+    }
+    run->units += iterations;
+
+    return;
+}
+
+/// This function records samples with the trace recorder into /dev/null: record encoding and copy into the RAM
+/// buffer (Fast Core part) plus buffer writes to the file every 64 samples (Slow Core part).
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples, bytes = bytes written to file)
+/// \return None
+static void bench_trace_record(uint64_t iterations, bench_run_t *run)
+{
+    bms_sample_t samples[64];
+    fill_samples(samples, 64, false);
+    if (bms_trace_rec_start("/dev/null", g_cfg.battery.num_cells, UINT32_MAX) != ESP_OK) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        samples[i % 64].timestamp = (TickType_t)(i * 50u);
+        bms_trace_rec_push(&samples[i % 64]);
+        if ((i % 64) == 63) {
+            bms_trace_rec_flush();
+        }
+    }
+    bms_trace_rec_stop();
+
+    bms_trace_rec_stats_t st;
+    bms_trace_rec_get_stats(&st);
+    run->units += st.records;
+    run->bytes += st.bytes_written;
+
+    return;
+}
+
+/// This function pushes samples into the sliding-window statistics and reads the snapshot back, as the Fast Core
+/// and a reader (HTTP endpoint) do every cycle.
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \param[in] window Window length in samples
+/// \return None
+static void run_rolling_push(uint64_t iterations, bench_run_t *run, uint16_t window)
+{
+    bms_sample_t samples[64];
+    fill_samples(samples, 64, false);
+    bms_rolling_init(window);
+
+    bms_rolling_t r;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bms_rolling_push(&samples[i % 64]);
+        if (bms_rolling_get(&r)) {
+            s_sink += (uint32_t)(r.cell_v[i % g_cfg.battery.num_cells].min * 10000.0f);
+        }
+        run->units++;
+    }
+
+    return;
+}
+
+static void bench_rolling_push(uint64_t iterations, bench_run_t *run)
+{
+    run_rolling_push(iterations, run, CONFIG_BMS_ROLLING_WINDOW);
+
+    return;
+}
+
+static void bench_rolling_push_w100(uint64_t iterations, bench_run_t *run)
+{
+    run_rolling_push(iterations, run, BMS_ROLLING_MAX_WINDOW);
+
+    return;
+}
+
+/// This function computes the same per-cell average, minimum and maximum by re-scanning a window of 100 samples
+/// after every sample. Reference for the running sums and monotonic deques of bms_rolling_push().
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_rolling_rescan_w100(uint64_t iterations, bench_run_t *run)
+{
+    bms_sample_t samples[64];
+    fill_samples(samples, 64, false);
+    static bms_sample_t s_window[BMS_ROLLING_MAX_WINDOW];
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        s_window[i % BMS_ROLLING_MAX_WINDOW] = samples[i % 64];
+        size_t n = (i < BMS_ROLLING_MAX_WINDOW) ? (size_t)(i + 1) : BMS_ROLLING_MAX_WINDOW;
+        for (int c = 0; c < g_cfg.battery.num_cells; ++c) {
+            float sum = 0.0f;
+            float min = s_window[0].cell_v[c];
+            float max = min;
+            for (size_t k = 0; k < n; ++k) {
+                float v = s_window[k].cell_v[c];
+                sum += v;
+                min = (v < min) ? v : min;
+                max = (v > max) ? v : max;
+            }
+            s_sink += (uint32_t)((sum / (float)n + min + max) * 10000.0f);
+        }
+        run->units++;
+    }
+
+    return;
+}
+
+/// This function runs percentile estimation of 1 s statistics windows (20 samples) over given number of cell
+/// channels plus pack current, as the stats pass does with CONFIG_BMS_PERCENTILES. Channel count is independent of
+/// BMS_MAX_CELLS, so the cost at 96 cells can be compared with bms_compute_stats/nominal.
+///
+/// \param[in] iterations Number of windows
+/// \param[out] run Result (units = windows)
+/// \param[in] channels Number of cell channels
+/// \return None
+static void run_pct_window(uint64_t iterations, bench_run_t *run, int channels)
+{
+    static bms_pct_t s_est[96 + 1];
+    bms_sample_t samples[64];
+    fill_samples(samples, 64, false);
+
+    float out[BMS_PCT_COUNT];
+    for (uint64_t i = 0; i < iterations; ++i) {
+        for (int ch = 0; ch <= channels; ++ch) {
+            bms_pct_init(&s_est[ch]);
+        }
+        for (int k = 0; k < 20; ++k) {
+            const bms_sample_t *s = &samples[(i * 20u + (uint64_t)k) % 64];
+            for (int ch = 0; ch < channels; ++ch) {
+                bms_pct_add(&s_est[ch], s->cell_v[ch % BMS_MAX_CELLS]);
+            }
+            bms_pct_add(&s_est[channels], s->pack_i);
+        }
+        for (int ch = 0; ch <= channels; ++ch) {
+            bms_pct_get(&s_est[ch], out);
+            s_sink += (uint32_t)(out[1] * 10000.0f);
+        }
+        run->units++;
+    }
+
+    return;
+}
+
+static void bench_pct_window_12(uint64_t iterations, bench_run_t *run)
+{
+    run_pct_window(iterations, run, 12);
+
+    return;
+}
+
+static void bench_pct_window_96(uint64_t iterations, bench_run_t *run)
+{
+    run_pct_window(iterations, run, 96);
+
+    return;
+}
+
+/// This function adds samples of a long stream to one estimator, which runs the P² marker update after the exact
+/// phase.
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \return None
+static void bench_pct_p2_stream(uint64_t iterations, bench_run_t *run)
+{
+    bms_sample_t samples[64];
+    fill_samples(samples, 64, false);
+    bms_pct_t est;
+    bms_pct_init(&est);
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bms_pct_add(&est, samples[i % 64].cell_v[i % BMS_MAX_CELLS]);
+        run->units++;
+    }
+    float out[BMS_PCT_COUNT];
+    bms_pct_get(&est, out);
+    s_sink += (uint32_t)(out[2] * 10000.0f);
+
+    return;
+}
+
+/// This function runs the anomaly detector over consecutive 1 s windows of all configured cells, as the Slow Core
+/// does with CONFIG_BMS_ANOMALY.
+///
+/// \param[in] iterations Number of windows
+/// \param[out] run Result (units = windows)
+/// \return None
+static void bench_anomaly_update(uint64_t iterations, bench_run_t *run)
+{
+    bms_sample_t samples[64];
+    fill_samples(samples, 64, false);
+    bms_anomaly_t out;
+    bms_anomaly_init();
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bms_anomaly_update((TickType_t)(i * pdMS_TO_TICKS(1000)), samples[i % 64].cell_v,
+                           g_cfg.battery.num_cells, &out);
+        s_sink += out.alarm.w[0] + (uint32_t)out.score[i % g_cfg.battery.num_cells];
+        run->units++;
+    }
+
+    return;
+}
+
+/// This function feeds pack current samples of a 100 Hz ripple to a Goertzel filter bank at 1 kHz with 1 s
+/// blocks, as the ripple sampler does with CONFIG_BMS_RIPPLE. The cost per sample includes the amplitude
+/// computation of every 1000th sample.
+///
+/// \param[in] iterations Number of samples
+/// \param[out] run Result (units = samples)
+/// \param[in] bins Number of frequencies
+/// \return None
+static void run_goertzel(uint64_t iterations, bench_run_t *run, uint8_t bins)
+{
+    static const float s_freqs[BMS_GOERTZEL_MAX_BINS] = { 50.0f, 100.0f, 120.0f, 300.0f, 150.0f, 200.0f, 250.0f,
+                                                          350.0f };
+    float signal[100];
+    for (int k = 0; k < 100; ++k) {
+        signal[k] = 2048.0f + 300.0f * sinf(2.0f * 3.14159265f * (float)k / 10.0f);
+    }
+    bms_goertzel_t bank;
+    bms_goertzel_init(&bank, 1000.0f, s_freqs, bins, 1000);
+
+    float amp[BMS_GOERTZEL_MAX_BINS];
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (bms_goertzel_push(&bank, signal[i % 100], amp)) {
+            s_sink += (uint32_t)amp[1];
+        }
+        run->units++;
+    }
+
+    return;
+}
+
+static void bench_goertzel_4(uint64_t iterations, bench_run_t *run)
+{
+    run_goertzel(iterations, run, 4);
+
+    return;
+}
+
+static void bench_goertzel_8(uint64_t iterations, bench_run_t *run)
+{
+    run_goertzel(iterations, run, 8);
+
+    return;
+}
+
+/// This function reads cell voltages with the LTC6804 driver from the software LTC6804 model in fast ADC mode,
+/// which covers command encoding, isoSPI wakeups, SPI bus time at the configured clock, conversion wait and PEC
+/// checks. The emulated chains are set up whenever the requested layout differs from the previous run.
+///
+/// \param[in] iterations Number of reads
+/// \param[out] run Result (units = successful reads, failed reads only add time)
+/// \param[in] layout Chain layout (one emulated bus per chain, all chains have the same devices and cells)
+/// \param[in] bit_error_ppm Probability of a bit flip per byte sent by the device (forces driver retries)
+/// \param[in] read_flags Flag to read cell UV/OV flags after every cell voltage read
+/// \return None
+static void run_ltc6804_read(uint64_t iterations, bench_run_t *run, const bench_ltc_layout_t *layout,
+                             uint32_t bit_error_ppm, bool read_flags)
+{
+    static bench_ltc_layout_t s_layout;
+    if (memcmp(&s_layout, layout, sizeof(s_layout)) != 0) {
+        float cells[LTC6804_EMU_CELLS];
+        for (int c = 0; c < LTC6804_EMU_CELLS; ++c) {
+            cells[c] = 1.2f + 0.01f * (float)c;
+        }
+        ltc6804_chain_cfg_t chains[LTC6804_MAX_CHAINS];
+        ltc6804_emu_init(layout->chains, layout->ics, 1);
+        for (uint8_t b = 0; b < layout->chains; ++b) {
+            for (uint8_t a = 0; a < layout->ics; ++a) {
+                ltc6804_emu_set_cell_voltages(b, a, cells, LTC6804_EMU_CELLS);
+            }
+            chains[b].transport = ltc6804_emu_transport(b);
+            chains[b].num_ics = layout->ics;
+            chains[b].cells_per_ic = layout->cells_per_ic;
+        }
+        ltc6804_emu_set_noise(0.0005f);
+        if (ltc6804_set_chains(chains, layout->chains) != ESP_OK ||
+            ltc6804_init(g_cfg.battery.cell_v_min, g_cfg.battery.cell_v_max) != ESP_OK) {
+            fprintf(stderr, "ltc6804_init with emulator failed\n");
+            exit(1);
+        }
+        ltc6804_set_adc_mode(LTC6804_MD_FAST);
+        s_layout = *layout;
+    }
+
+    ltc6804_emu_faults_t faults = { .bit_error_ppm = bit_error_ppm };
+    ltc6804_emu_set_faults(&faults);
+
+    uint8_t num_cells = ltc6804_num_cells();
+    if (num_cells > g_cfg.battery.num_cells) {
+        num_cells = g_cfg.battery.num_cells;
+    }
+    float voltages[LTC6804_MAX_CELLS];
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (ltc6804_read_cell_voltages(voltages, num_cells) == ESP_OK) {
+            run->units++;
+            s_sink += (uint32_t)(voltages[i % num_cells] * 10000.0f);
+            // Per-cycle comparator flag read and cross-check of CONFIG_BMS_LTC_HW_FLAGS
+            bms_cell_mask_t uv, ov, mismatch;
+            if (read_flags && ltc6804_read_cell_flags(&uv, &ov) == ESP_OK) {
+                s_sink += ltc6804_flags_mismatch(uv.w, ov.w, voltages, num_cells, g_cfg.battery.cell_v_min,
+                                                 g_cfg.battery.cell_v_max, mismatch.w);
+            }
+        }
+    }
+    ltc6804_emu_set_faults(NULL);
+
+    return;
+}
+
+static void bench_ltc6804_read(uint64_t iterations, bench_run_t *run)
+{
+    run_ltc6804_read(iterations, run, &s_ltc_single, 0, false);
+
+    return;
+}
+
+static void bench_ltc6804_read_faults(uint64_t iterations, bench_run_t *run)
+{
+    run_ltc6804_read(iterations, run, &s_ltc_single, 1000, false);
+
+    return;
+}
+
+static void bench_ltc6804_read_flags(uint64_t iterations, bench_run_t *run)
+{
+    run_ltc6804_read(iterations, run, &s_ltc_single, 0, true);
+
+    return;
+}
+
+static void bench_ltc6804_read_1x2(uint64_t iterations, bench_run_t *run)
+{
+    run_ltc6804_read(iterations, run, &s_ltc_1x2, 0, false);
+
+    return;
+}
+
+static void bench_ltc6804_read_2x2(uint64_t iterations, bench_run_t *run)
+{
+    run_ltc6804_read(iterations, run, &s_ltc_2x2, 0, false);
+
+    return;
+}
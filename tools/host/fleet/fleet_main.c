@@ -0,0 +1,806 @@
+/// Fleet load generator. Emulates many BMS devices against a real MQTT broker (e.g. the Mosquitto container of
+/// tools/data-visualization/docker) to find where broker and ingestion (Telegraf or influx-bridge into InfluxDB)
+/// stop keeping up as the fleet grows.
+///
+/// Every device has its own device ID, deterministic pack simulator instance (own seed, initial state of charge and
+/// phase of the current profile), Slow Core ring buffer, telemetry cadence and MQTT connection. Once per second, at
+/// a per-device phase, a device takes one second of samples and runs them through the firmware bms_compute_stats()
+/// and bms_stats_to_json(), so it publishes what a real device publishes: one 1 s window, or five 0.2 s windows
+/// while limits are violated, with telemetry in every 10th message. Messages are MQTT 3.1.1 QoS 0 PUBLISH packets
+/// like on target.
+///
+/// A separate subscriber connection receives the statistics topic back; broker latency is the time from the
+/// device publish to reception by the subscriber (same host clock). With -I, the number of points written to
+/// InfluxDB for the devices of this run is queried every report interval and ingestion lag is estimated from the
+/// backlog (published but not yet written) and the publish rate. After the run, the time until InfluxDB has all
+/// messages received by the subscriber is reported as drain time.
+///
+/// Device IDs are FE:<run>:00:00:<index>, <run> is random per run so runs can be told apart in InfluxDB.
+///
+/// Usage: bms_fleet [-n devices] [-d seconds] [-r step:interval_s] [-h host] [-p port] [-t topic] [-i report_s]
+///                  [-S seed] [-I influx_url] [-W drain_s]
+///   -n  number of devices (default 100, at most FLEET_MAX_DEVICES)
+///   -d  duration of publishing in seconds (default 60)
+///   -r  ramp: start with step devices and add step devices every interval_s seconds until -n is reached
+///   -h  broker host (default localhost), -p broker port (default 1883)
+///   -t  statistics topic (default bms/esp32/stats)
+///   -i  report interval in seconds (default 5)
+///   -S  base seed of pack simulators (default 1)
+///   -I  InfluxDB URL, e.g. http://localhost:8086 (token from INFLUX_TOKEN, org and bucket from INFLUX_ORG and
+///       INFLUX_BUCKET, default "bms")
+///   -W  maximum wait for InfluxDB to drain after the run in seconds (default 60)
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "bms_sim.h"
+#include "process.h"
+#include "json_formatter.h"
+#include "stats_history.h"
+#include "host_stubs.h"
+#include "mqtt_frame.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Maximum number of emulated devices
+#define FLEET_MAX_DEVICES       4096
+
+/// Samples per device tick (one second at the nominal 50 ms period)
+#define FLEET_SAMPLES_PER_TICK  20
+
+/// Capacity of a device ring buffer (one tick plus samples left over from the previous tick)
+#define FLEET_BUFFER_CAPACITY   (2 * FLEET_SAMPLES_PER_TICK)
+
+/// Number of remembered publish times per device (for matching messages received by the subscriber)
+#define FLEET_SENT_SLOTS        64
+
+/// Maximum number of latency samples per report interval
+#define FLEET_MAX_LATENCIES     65536
+
+/// Device tick later than this is counted as late (generator cannot keep up)
+#define FLEET_LATE_NS           100000000LL
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Publish time of one message, identified by its statistics timestamp
+typedef struct {
+    uint32_t timestamp;         ///< Statistics timestamp (ticks)
+    int64_t  sent_ns;           ///< Publish time (monotonic)
+} fleet_sent_t;
+
+/// Structure of one emulated device
+typedef struct {
+    char                id[18];                             ///< Device ID (MAC address format)
+    bms_sim_t           sim;                                ///< Pack simulator
+    bms_sample_t        samples[FLEET_BUFFER_CAPACITY];     ///< Ring buffer storage
+    bms_sample_buffer_t buf;                                ///< Ring buffer
+    uint32_t            json_counter;                       ///< Message counter of JSON formatter
+    int64_t             phase_ns;                           ///< Tick phase within the second
+    uint32_t            start_s;                            ///< Second of activation (ramp)
+    int                 fd;                                 ///< Broker connection (-1 = not connected)
+    fleet_sent_t        sent[FLEET_SENT_SLOTS];             ///< Publish times of recent messages
+    uint32_t            sent_next;                          ///< Next slot of sent[]
+} fleet_device_t;
+
+/// Counters of one report interval and the whole run
+typedef struct {
+    uint64_t published;         ///< Published messages
+    uint64_t bytes;             ///< Published payload bytes
+    uint64_t received;          ///< Messages received by the subscriber
+    uint64_t matched;           ///< Received messages with known publish time
+    uint64_t errors;            ///< Failed publishes (connection lost)
+    uint64_t late;              ///< Device ticks later than FLEET_LATE_NS
+    int64_t  max_late_ns;       ///< Maximum tick lateness
+} fleet_counters_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static int device_init(fleet_device_t *dev, uint32_t index, uint32_t seed);
+static void device_tick(fleet_device_t *dev);
+static void *subscriber_thread(void *arg);
+static void *reporter_thread(void *arg);
+static void report(double t_s, const fleet_counters_t *c, uint32_t active, double interval_s);
+static int influx_count(uint64_t *count);
+static int tcp_connect(const char *host, uint16_t port);
+static int mqtt_connect(const char *client_id);
+static int mqtt_subscribe(int fd, const char *topic);
+static int mqtt_read_packet(int fd, uint8_t *type, uint8_t *buf, size_t size, size_t *len);
+static int cmp_i64(const void *a, const void *b);
+static int64_t now_ns(void);
+static void sleep_until_ns(int64_t t_ns);
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Emulated devices
+static fleet_device_t *s_devices = NULL;
+/// Number of emulated devices and currently active devices
+static uint32_t s_device_count = 100;
+static volatile uint32_t s_active = 0;
+/// Random run ID (second byte of device IDs)
+static uint8_t s_run_id = 0;
+/// Broker address and statistics topic
+static const char *s_host = "localhost";
+static uint16_t s_port = 1883;
+static const char *s_topic = "bms/esp32/stats";
+/// InfluxDB URL (NULL = ingestion not measured)
+static const char *s_influx_url = NULL;
+/// Unix time of run start (InfluxDB query range)
+static time_t s_start_unix = 0;
+/// Monotonic time of run start
+static int64_t s_start_ns = 0;
+/// Publishing finished, run finished
+static volatile bool s_publish_done = false;
+static volatile bool s_stop = false;
+/// Report interval in seconds
+static uint32_t s_report_s = 5;
+
+/// Counters of current report interval and totals, latencies of current interval (protected by s_lock)
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static fleet_counters_t s_interval;
+static fleet_counters_t s_total;
+static int64_t s_latencies[FLEET_MAX_LATENCIES];
+static size_t s_latency_count = 0;
+static int64_t s_max_latency_ns = 0;
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+int main(int argc, char **argv)
+{
+    uint32_t duration_s = 60;
+    uint32_t ramp_step = 0;
+    uint32_t ramp_interval_s = 0;
+    uint32_t seed = 1;
+    uint32_t drain_s = 60;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:r:h:p:t:i:S:I:W:")) != -1) {
+        switch (opt) {
+            case 'n': s_device_count = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'd': duration_s = (uint32_t)strtoul(optarg, NULL, 0);     break;
+            case 'r':
+                if (sscanf(optarg, "%u:%u", &ramp_step, &ramp_interval_s) != 2) {
+                    ramp_step = 0;
+                }
+                break;
+            case 'h': s_host = optarg;                                     break;
+            case 'p': s_port = (uint16_t)strtoul(optarg, NULL, 0);         break;
+            case 't': s_topic = optarg;                                    break;
+            case 'i': s_report_s = (uint32_t)strtoul(optarg, NULL, 0);     break;
+            case 'S': seed = (uint32_t)strtoul(optarg, NULL, 0);           break;
+            case 'I': s_influx_url = optarg;                               break;
+            case 'W': drain_s = (uint32_t)strtoul(optarg, NULL, 0);        break;
+            default:
+                fprintf(stderr, "usage: %s [-n devices] [-d seconds] [-r step:interval_s] [-h host] [-p port] "
+                        "[-t topic] [-i report_s] [-S seed] [-I influx_url] [-W drain_s]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (s_device_count < 1 || s_device_count > FLEET_MAX_DEVICES || duration_s < 1 || s_report_s < 1 ||
+        seed == 0 || (ramp_step > 0 && ramp_interval_s < 1)) {
+        fprintf(stderr, "invalid arguments (1 <= devices <= %d, duration, report interval, seed and ramp "
+                "interval > 0)\n", FLEET_MAX_DEVICES);
+        return 2;
+    }
+
+    // One connection per device plus subscriber and InfluxDB queries
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < (rlim_t)s_device_count + 64u) {
+        lim.rlim_cur = (lim.rlim_max < (rlim_t)s_device_count + 64u) ? lim.rlim_max : (rlim_t)s_device_count + 64u;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    s_devices = calloc(s_device_count, sizeof(fleet_device_t));
+    if (s_devices == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    srand((unsigned)time(NULL) ^ (unsigned)getpid());
+    s_run_id = (uint8_t)(rand() & 0xFF);
+    for (uint32_t i = 0; i < s_device_count; ++i) {
+        if (device_init(&s_devices[i], i, seed) != 0) {
+            fprintf(stderr, "device %u: simulator init failed\n", (unsigned)i);
+            return 1;
+        }
+        s_devices[i].start_s = (ramp_step > 0) ? (i / ramp_step) * ramp_interval_s : 0;
+    }
+
+    int sub_fd = mqtt_connect("bms-fleet-sub");
+    if (sub_fd < 0 || mqtt_subscribe(sub_fd, s_topic) != 0) {
+        fprintf(stderr, "cannot subscribe to %s at %s:%u\n", s_topic, s_host, (unsigned)s_port);
+        return 1;
+    }
+    printf("run FE:%02X, %u devices, %u s, broker %s:%u, topic %s%s%s\n", (unsigned)s_run_id,
+           (unsigned)s_device_count, (unsigned)duration_s, s_host, (unsigned)s_port, s_topic,
+           s_influx_url ? ", influx " : "", s_influx_url ? s_influx_url : "");
+    printf("%8s %7s %9s %9s %9s %8s %8s %8s %6s %9s %9s %8s\n", "t_s", "devices", "pub_msg/s", "pub_kB/s",
+           "rcv_msg/s", "lat_p50", "lat_p99", "lat_max", "late", "ingested", "backlog", "lag_s");
+
+    s_start_unix = time(NULL);
+    s_start_ns = now_ns();
+    pthread_t sub;
+    pthread_t rep;
+    pthread_create(&sub, NULL, subscriber_thread, &sub_fd);
+    pthread_create(&rep, NULL, reporter_thread, NULL);
+
+    // Generator: device ticks in phase order, every device once per second once active
+    for (uint32_t sec = 0; sec < duration_s; ++sec) {
+        for (uint32_t i = 0; i < s_device_count; ++i) {
+            fleet_device_t *dev = &s_devices[i];
+            if (sec < dev->start_s) {
+                continue;
+            }
+            if (sec == dev->start_s) {
+                char client_id[32];
+                snprintf(client_id, sizeof(client_id), "bms-fleet-%02X-%u", (unsigned)s_run_id, (unsigned)i);
+                dev->fd = mqtt_connect(client_id);
+                if (dev->fd < 0) {
+                    fprintf(stderr, "device %u: cannot connect to broker: %s\n", (unsigned)i, strerror(errno));
+                }
+                s_active = i + 1u;
+            }
+            int64_t due = s_start_ns + (int64_t)sec * 1000000000LL + dev->phase_ns;
+            int64_t now = now_ns();
+            if (now < due) {
+                sleep_until_ns(due);
+            } else if (now - due > FLEET_LATE_NS) {
+                pthread_mutex_lock(&s_lock);
+                s_interval.late++;
+                if (now - due > s_interval.max_late_ns) {
+                    s_interval.max_late_ns = now - due;
+                }
+                pthread_mutex_unlock(&s_lock);
+            }
+            device_tick(dev);
+        }
+    }
+    s_publish_done = true;
+
+    // Let the subscriber catch up with the broker, then InfluxDB with the subscriber
+    int64_t end_ns = now_ns();
+    uint64_t last_received = UINT64_MAX;
+    while (now_ns() - end_ns < 5000000000LL) {
+        pthread_mutex_lock(&s_lock);
+        uint64_t received = s_total.received + s_interval.received;
+        pthread_mutex_unlock(&s_lock);
+        if (received == last_received) {
+            break;
+        }
+        last_received = received;
+        usleep(500000);
+    }
+    double drain = -1.0;
+    uint64_t ingested = 0;
+    if (s_influx_url) {
+        while (now_ns() - end_ns < (int64_t)drain_s * 1000000000LL) {
+            if (influx_count(&ingested) == 0 && ingested >= last_received) {
+                drain = (double)(now_ns() - end_ns) * 1e-9;
+                break;
+            }
+            sleep(1);
+        }
+    }
+    s_stop = true;
+    pthread_join(rep, NULL);
+    shutdown(sub_fd, SHUT_RDWR);
+    pthread_join(sub, NULL);
+
+    double run_s = (double)(end_ns - s_start_ns) * 1e-9;
+    printf("total: %llu published (%.1f msg/s, %.1f kB/s), %llu received (%llu matched), max latency %.1f ms, "
+           "%llu publish errors, %llu late ticks (max %.1f ms)\n",
+           (unsigned long long)s_total.published, (double)s_total.published / run_s,
+           (double)s_total.bytes / run_s / 1024.0, (unsigned long long)s_total.received,
+           (unsigned long long)s_total.matched, (double)s_max_latency_ns * 1e-6, (unsigned long long)s_total.errors,
+           (unsigned long long)s_total.late, (double)s_total.max_late_ns * 1e-6);
+    if (s_influx_url) {
+        if (drain >= 0.0) {
+            printf("influx: %llu points, drained %.1f s after publishing stopped\n", (unsigned long long)ingested,
+                   drain);
+        } else {
+            printf("influx: %llu of %llu points after %u s, not drained\n", (unsigned long long)ingested,
+                   (unsigned long long)last_received, (unsigned)drain_s);
+        }
+    }
+
+    for (uint32_t i = 0; i < s_device_count; ++i) {
+        if (s_devices[i].fd >= 0) {
+            close(s_devices[i].fd);
+        }
+    }
+    close(sub_fd);
+    free(s_devices);
+
+    return (s_total.errors == 0 && s_total.received >= s_total.published) ? 0 : 1;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function initializes one emulated device: ID, simulator with own seed, state of charge and profile phase,
+/// ring buffer and tick phase.
+///
+/// \param[out] dev Device
+/// \param[in] index Device index
+/// \param[in] seed Base seed
+/// \return 0 on success, -1 on error
+static int device_init(fleet_device_t *dev, uint32_t index, uint32_t seed)
+{
+    snprintf(dev->id, sizeof(dev->id), "FE:%02X:00:00:%02X:%02X", (unsigned)s_run_id, (unsigned)((index >> 8) & 0xFFu),
+             (unsigned)(index & 0xFFu));
+    dev->fd = -1;
+    dev->buf.samples = dev->samples;
+    dev->buf.capacity = FLEET_BUFFER_CAPACITY;
+    dev->phase_ns = (int64_t)((uint64_t)index * 1000000000ULL / s_device_count);
+
+    bms_sim_config_t cfg;
+    bms_sim_default_config(&cfg);
+    cfg.deterministic = true;
+    cfg.seed = seed + index * 7919u;
+    cfg.initial_soc = 0.4f + 0.5f * (float)((index * 37u) % 100u) / 100.0f;
+    // Rotate the current profile so devices are in different load phases
+    uint8_t shift = (uint8_t)(index % cfg.profile_len);
+    bms_sim_step_t rotated[BMS_SIM_MAX_STEPS];
+    for (uint8_t k = 0; k < cfg.profile_len; ++k) {
+        rotated[k] = cfg.profile[(k + shift) % cfg.profile_len];
+    }
+    memcpy(cfg.profile, rotated, sizeof(rotated[0]) * cfg.profile_len);
+
+    return (bms_sim_inst_init(&dev->sim, &cfg) == ESP_OK) ? 0 : -1;
+}
+
+/// This function runs one tick of a device: one second of samples through statistics and JSON serialization,
+/// every produced message is published.
+///
+/// \param[in, out] dev Device
+/// \return None
+static void device_tick(fleet_device_t *dev)
+{
+    bms_stats_buffer_t stats;
+    char json[BMS_STATS_JSON_MAXLEN];
+
+    for (int i = 0; i < FLEET_SAMPLES_PER_TICK && dev->buf.count < dev->buf.capacity; ++i) {
+        bms_sim_inst_read_sample(&dev->sim, &dev->buf.samples[bms_buf_index(&dev->buf, dev->buf.count)]);
+        dev->buf.count++;
+    }
+
+    host_set_device_id(dev->id);
+    bms_stats_json_set_counter(dev->json_counter);
+    while (dev->buf.count > 0 && bms_compute_stats(&dev->buf, &stats) > 0) {
+        for (size_t w = 0; w < stats.stats_count; ++w) {
+            int len = bms_stats_to_json(&stats.stats_array[w], json, sizeof(json));
+            if (len < 0) {
+                continue;
+            }
+            // Publish time is recorded before publishing, the subscriber may receive the message before send returns
+            fleet_sent_t *slot = &dev->sent[dev->sent_next];
+            dev->sent_next = (dev->sent_next + 1u) % FLEET_SENT_SLOTS;
+            pthread_mutex_lock(&s_lock);
+            slot->timestamp = (uint32_t)stats.stats_array[w].timestamp;
+            slot->sent_ns = now_ns();
+            pthread_mutex_unlock(&s_lock);
+
+            int err = (dev->fd >= 0) ? mqtt_publish(dev->fd, s_topic, json, (size_t)len) : -1;
+
+            pthread_mutex_lock(&s_lock);
+            if (err == 0) {
+                s_interval.published++;
+                s_interval.bytes += (uint64_t)len;
+            } else {
+                slot->sent_ns = 0;
+                s_interval.errors++;
+            }
+            pthread_mutex_unlock(&s_lock);
+        }
+    }
+    dev->json_counter = bms_stats_json_get_counter();
+
+    return;
+}
+
+/// Subscriber thread. Receives the statistics topic back from the broker and matches messages of this run to
+/// their publish time by device ID and statistics timestamp.
+///
+/// \param[in] arg Pointer to subscriber socket
+/// \return NULL
+static void *subscriber_thread(void *arg)
+{
+    int fd = *(int *)arg;
+    static uint8_t buf[BMS_STATS_JSON_MAXLEN + 256];
+    uint8_t type;
+    size_t len;
+
+    while (mqtt_read_packet(fd, &type, buf, sizeof(buf) - 1, &len) == 0) {
+        int64_t t = now_ns();
+        if ((type & 0xF0u) != MQTT_PUBLISH || len < 2) {
+            continue;
+        }
+        size_t topic_len = ((size_t)buf[0] << 8) | buf[1];
+        if (2 + topic_len > len) {
+            continue;
+        }
+        buf[len] = '\0';
+        const char *payload = (const char *)&buf[2 + topic_len];
+
+        unsigned run;
+        unsigned hi;
+        unsigned lo;
+        unsigned timestamp;
+        if (sscanf(payload, "{\"device_id\":\"FE:%2X:00:00:%2X:%2X\",\"timestamp\":%u", &run, &hi, &lo,
+                   &timestamp) != 4 || run != s_run_id) {
+            continue;
+        }
+        uint32_t index = (hi << 8) | lo;
+
+        pthread_mutex_lock(&s_lock);
+        s_interval.received++;
+        if (index < s_device_count) {
+            const fleet_device_t *dev = &s_devices[index];
+            for (uint32_t k = 0; k < FLEET_SENT_SLOTS; ++k) {
+                if (dev->sent[k].sent_ns != 0 && dev->sent[k].timestamp == timestamp) {
+                    int64_t lat = t - dev->sent[k].sent_ns;
+                    s_interval.matched++;
+                    if (s_latency_count < FLEET_MAX_LATENCIES) {
+                        s_latencies[s_latency_count++] = lat;
+                    }
+                    if (lat > s_max_latency_ns) {
+                        s_max_latency_ns = lat;
+                    }
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&s_lock);
+    }
+
+    return NULL;
+}
+
+/// Reporter thread. Prints one line per report interval until the run finishes.
+///
+/// \param[in] arg Unused
+/// \return NULL
+static void *reporter_thread(void *arg)
+{
+    (void)arg;
+    int64_t next = s_start_ns;
+
+    while (!s_stop) {
+        next += (int64_t)s_report_s * 1000000000LL;
+        while (!s_stop && now_ns() < next) {
+            usleep(50000);
+        }
+
+        pthread_mutex_lock(&s_lock);
+        fleet_counters_t c = s_interval;
+        memset(&s_interval, 0, sizeof(s_interval));
+        s_total.published += c.published;
+        s_total.bytes += c.bytes;
+        s_total.received += c.received;
+        s_total.matched += c.matched;
+        s_total.errors += c.errors;
+        s_total.late += c.late;
+        if (c.max_late_ns > s_total.max_late_ns) {
+            s_total.max_late_ns = c.max_late_ns;
+        }
+        pthread_mutex_unlock(&s_lock);
+
+        // Last interval ends with the run, its length is not a full interval
+        double interval_s = (double)s_report_s;
+        if (s_stop) {
+            interval_s -= (double)(next - now_ns()) * 1e-9;
+        }
+        report((double)(now_ns() - s_start_ns) * 1e-9, &c, s_active, interval_s);
+    }
+
+    return NULL;
+}
+
+/// This function prints one report line. Latencies of the interval are consumed.
+///
+/// \param[in] t_s Time since run start in seconds
+/// \param[in] c Counters of the interval
+/// \param[in] active Number of active devices
+/// \param[in] interval_s Length of the interval in seconds
+/// \return None
+static void report(double t_s, const fleet_counters_t *c, uint32_t active, double interval_s)
+{
+    static int64_t s_lat[FLEET_MAX_LATENCIES];
+
+    pthread_mutex_lock(&s_lock);
+    size_t n = s_latency_count;
+    memcpy(s_lat, s_latencies, n * sizeof(s_lat[0]));
+    s_latency_count = 0;
+    uint64_t published = s_total.published;
+    pthread_mutex_unlock(&s_lock);
+
+    if (interval_s < 0.001) {
+        interval_s = 0.001;
+    }
+    qsort(s_lat, n, sizeof(s_lat[0]), cmp_i64);
+    double p50 = (n > 0) ? (double)s_lat[(n - 1) / 2] * 1e-6 : 0.0;
+    double p99 = (n > 0) ? (double)s_lat[(n * 99 - 1) / 100] * 1e-6 : 0.0;
+    double max = (n > 0) ? (double)s_lat[n - 1] * 1e-6 : 0.0;
+
+    char ingest[64];
+    snprintf(ingest, sizeof(ingest), "%9s %9s %8s", "-", "-", "-");
+    uint64_t ingested;
+    if (s_influx_url && influx_count(&ingested) == 0) {
+        // Backlog is published but not yet written, lag is the time to write it at the current publish rate
+        uint64_t backlog = (published > ingested) ? published - ingested : 0;
+        double rate = (double)published / ((t_s > 0.0) ? t_s : 1.0);
+        snprintf(ingest, sizeof(ingest), "%9llu %9llu %8.1f", (unsigned long long)ingested,
+                 (unsigned long long)backlog, (rate > 0.0) ? (double)backlog / rate : 0.0);
+    }
+    printf("%8.1f %7u %9.1f %9.1f %9.1f %8.1f %8.1f %8.1f %6llu %s\n", t_s, (unsigned)active,
+           (double)c->published / interval_s, (double)c->bytes / interval_s / 1024.0,
+           (double)c->received / interval_s, p50, p99, max, (unsigned long long)c->late, ingest);
+    fflush(stdout);
+
+    return;
+}
+
+/// This function queries InfluxDB for the number of points written for the devices of this run (one point per
+/// message, counted by the sample_count field). Plain HTTP/1.0 request to the query API, CSV response.
+///
+/// \param[out] count Number of points
+/// \return 0 on success, -1 on error
+static int influx_count(uint64_t *count)
+{
+    char host[256];
+    unsigned port = 8086;
+    if (sscanf(s_influx_url, "http://%255[^:/]:%u", host, &port) < 1) {
+        return -1;
+    }
+    const char *token = getenv("INFLUX_TOKEN");
+    const char *org = getenv("INFLUX_ORG");
+    const char *bucket = getenv("INFLUX_BUCKET");
+
+    char flux[512];
+    int flux_len = snprintf(flux, sizeof(flux),
+        "from(bucket: \"%s\") |> range(start: %lld) "
+        "|> filter(fn: (r) => r._measurement == \"mqtt_consumer\" and r._field == \"sample_count\" "
+        "and r.device_id =~ /^FE:%02X:/) |> group() |> count()",
+        bucket ? bucket : "bms", (long long)s_start_unix - 60, (unsigned)s_run_id);
+    char req[2048];
+    int req_len = snprintf(req, sizeof(req),
+        "POST /api/v2/query?org=%s HTTP/1.0\r\nHost: %s:%u\r\nAuthorization: Token %s\r\n"
+        "Content-Type: application/vnd.flux\r\nAccept: application/csv\r\nContent-Length: %d\r\n\r\n%s",
+        org ? org : "bms", host, port, token ? token : "", flux_len, flux);
+
+    if (flux_len < 0 || (size_t)flux_len >= sizeof(flux) || req_len < 0 || (size_t)req_len >= sizeof(req)) {
+        return -1;
+    }
+
+    int fd = tcp_connect(host, (uint16_t)port);
+    if (fd < 0) {
+        return -1;
+    }
+    char resp[4096];
+    size_t resp_len = 0;
+    if (mqtt_send_all(fd, (const uint8_t *)req, (size_t)req_len) == 0) {
+        ssize_t n;
+        while (resp_len < sizeof(resp) - 1 && (n = recv(fd, resp + resp_len, sizeof(resp) - 1 - resp_len, 0)) > 0) {
+            resp_len += (size_t)n;
+        }
+    }
+    close(fd);
+    resp[resp_len] = '\0';
+
+    if (strncmp(resp, "HTTP/1.", 7) != 0 || strncmp(resp + 8, " 200", 4) != 0) {
+        return -1;
+    }
+    // No table at all when no point exists yet
+    *count = 0;
+    const char *row = strstr(resp, ",_result,");
+    if (row) {
+        const char *end = strpbrk(row, "\r\n");
+        const char *last = NULL;
+        for (const char *p = row; *p && p != end; ++p) {
+            if (*p == ',') {
+                last = p;
+            }
+        }
+        if (last) {
+            *count = strtoull(last + 1, NULL, 10);
+        }
+    }
+
+    return 0;
+}
+
+/// This function opens a TCP connection.
+///
+/// \param[in] host Host name or address
+/// \param[in] port Port
+/// \return Socket, -1 on error
+static int tcp_connect(const char *host, uint16_t port)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)port);
+    if (getaddrinfo(host, service, &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    return fd;
+}
+
+/// This function connects to the broker and completes the MQTT CONNECT handshake (clean session, keep alive
+/// disabled, so no PINGREQ is needed while the connection only publishes).
+///
+/// \param[in] client_id Client ID
+/// \return Socket, -1 on error
+static int mqtt_connect(const char *client_id)
+{
+    int fd = tcp_connect(s_host, s_port);
+    if (fd < 0) {
+        return -1;
+    }
+
+    uint8_t pkt[5 + 10 + 2 + 64];
+    size_t id_len = strlen(client_id);
+    if (id_len > 64) {
+        close(fd);
+        return -1;
+    }
+    size_t pos = 0;
+    pkt[pos++] = MQTT_CONNECT;
+    pos += mqtt_encode_remaining_length(&pkt[pos], (uint32_t)(10u + 2u + id_len));
+    static const uint8_t var_hdr[10] = { 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 0 };
+    memcpy(&pkt[pos], var_hdr, sizeof(var_hdr));
+    pos += sizeof(var_hdr);
+    pkt[pos++] = (uint8_t)(id_len >> 8);
+    pkt[pos++] = (uint8_t)id_len;
+    memcpy(&pkt[pos], client_id, id_len);
+    pos += id_len;
+
+    uint8_t type;
+    uint8_t ack[2];
+    size_t len;
+    if (mqtt_send_all(fd, pkt, pos) != 0 || mqtt_read_packet(fd, &type, ack, sizeof(ack), &len) != 0 ||
+        type != MQTT_CONNACK || len != 2 || ack[1] != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/// This function subscribes to a topic with QoS 0 and waits for SUBACK.
+///
+/// \param[in] fd Broker connection
+/// \param[in] topic Topic filter
+/// \return 0 on success, -1 on error
+static int mqtt_subscribe(int fd, const char *topic)
+{
+    uint8_t pkt[5 + 2 + 2 + 128 + 1];
+    size_t topic_len = strlen(topic);
+    if (topic_len > 128) {
+        return -1;
+    }
+    size_t pos = 0;
+    pkt[pos++] = MQTT_SUBSCRIBE;
+    pos += mqtt_encode_remaining_length(&pkt[pos], (uint32_t)(2u + 2u + topic_len + 1u));
+    pkt[pos++] = 0;
+    pkt[pos++] = 1;
+    pkt[pos++] = (uint8_t)(topic_len >> 8);
+    pkt[pos++] = (uint8_t)topic_len;
+    memcpy(&pkt[pos], topic, topic_len);
+    pos += topic_len;
+    pkt[pos++] = 0;
+
+    uint8_t type;
+    uint8_t ack[3];
+    size_t len;
+    if (mqtt_send_all(fd, pkt, pos) != 0 || mqtt_read_packet(fd, &type, ack, sizeof(ack), &len) != 0 ||
+        type != MQTT_SUBACK || len != 3 || ack[2] > 2) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/// This function reads one MQTT packet. Body bytes beyond the buffer size are discarded.
+///
+/// \param[in] fd Broker connection
+/// \param[out] type First byte of fixed header (packet type and flags)
+/// \param[out] buf Packet body
+/// \param[in] size Buffer size in bytes
+/// \param[out] len Stored body length in bytes
+/// \return 0 on success, -1 on error or closed connection
+static int mqtt_read_packet(int fd, uint8_t *type, uint8_t *buf, size_t size, size_t *len)
+{
+    uint8_t b;
+    if (recv(fd, type, 1, MSG_WAITALL) != 1) {
+        return -1;
+    }
+    uint32_t remaining = 0;
+    uint32_t multiplier = 1;
+    do {
+        if (recv(fd, &b, 1, MSG_WAITALL) != 1 || multiplier > 128u * 128u * 128u) {
+            return -1;
+        }
+        remaining += (uint32_t)(b & 0x7Fu) * multiplier;
+        multiplier *= 128u;
+    } while (b & 0x80u);
+
+    *len = (remaining < size) ? remaining : size;
+    if (*len > 0 && recv(fd, buf, *len, MSG_WAITALL) != (ssize_t)*len) {
+        return -1;
+    }
+    for (uint32_t skip = remaining - (uint32_t)*len; skip > 0; --skip) {
+        if (recv(fd, &b, 1, MSG_WAITALL) != 1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/// Comparison of int64_t values for qsort().
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/// This function returns monotonic time in nanoseconds.
+///
+/// \param None
+/// \return Time in nanoseconds
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/// This function sleeps until given monotonic time.
+///
+/// \param[in] t_ns Wake-up time in nanoseconds
+/// \return None
+static void sleep_until_ns(int64_t t_ns)
+{
+    struct timespec ts = { .tv_sec = (time_t)(t_ns / 1000000000LL), .tv_nsec = (long)(t_ns % 1000000000LL) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+
+    return;
+}
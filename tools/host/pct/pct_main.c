@@ -0,0 +1,279 @@
+/// Host accuracy check of the streaming percentile estimator (`percentile.c`) against exact sorting. Streams of
+/// known distributions are fed through bms_pct_add() and the estimated P50/P95/P99 are compared with the
+/// percentiles of the same values sorted, using the estimator's definition (linear interpolation between ranks,
+/// rank 1 + (N - 1) * p). Errors are divided by the standard deviation of the distribution, so one limit fits all.
+///
+/// Cases are every distribution with every stream length:
+///   uniform   uniform in [0, 1)
+///   normal    standard normal
+///   exp       exponential with mean 1 (skewed, long upper tail)
+///   ripple    5 A sine ripple at a random phase and frequency plus 0.2 A normal noise (inverter load)
+/// and lengths 4 and 20 (0.2 s and 1 s statistics windows at 20 Hz, exact phase), 100, 1000 and 100000 (P² phase
+/// after the first ::BMS_PCT_EXACT observations).
+///
+/// Prints one JSON object per case with the mean and largest error of each percentile. Fails (exit 1) when the
+/// mean error of a percentile exceeds the limit of its stream length.
+///
+/// Usage: bms_pct_check [-S seed]
+///   -S  seed (default 1)
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "percentile.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Longest stream length
+#define PCT_MAX_LEN             100000u
+
+/// Observations per case (sum over trials), sets the number of trials of each length
+#define PCT_CASE_OBS            400000u
+
+/// Pi
+#define PCT_PI                  3.14159265358979323846
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of a distribution
+typedef struct {
+    const char *name;                       ///< Name in the report
+    double      sd;                         ///< Standard deviation, unit of reported errors
+    void      (*fill)(float *v, uint32_t n);///< Fills a stream with n values
+} pct_dist_t;
+
+/// Structure of a stream length and its error limit
+typedef struct {
+    uint32_t len;                           ///< Observations per stream
+    double   limit;                         ///< Largest mean error per percentile (standard deviations)
+} pct_len_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void fill_uniform(float *v, uint32_t n);
+static void fill_normal(float *v, uint32_t n);
+static void fill_exp(float *v, uint32_t n);
+static void fill_ripple(float *v, uint32_t n);
+static double exact_pct(const float *sorted, uint32_t n, double p);
+static double rand_uniform(void);
+static double rand_normal(void);
+static int cmp_float(const void *a, const void *b);
+
+/*==============================================================================================================*/
+/*                                            Private Constants                                                 */
+/*==============================================================================================================*/
+/// Distributions
+static const pct_dist_t s_dists[] = {
+    { "uniform", 0.28867513, fill_uniform },
+    { "normal",  1.0,        fill_normal  },
+    { "exp",     1.0,        fill_exp     },
+    { "ripple",  3.54118624, fill_ripple  },
+};
+
+/// Stream lengths. Statistics windows stay in the exact phase and must match sorting up to float rounding. The P²
+/// phase converges with the stream length; P99 of skewed streams is the slowest (few observations above it).
+static const pct_len_t s_lens[] = {
+    { 4,      0.0001 },
+    { 20,     0.0001 },
+    { 100,    0.60   },
+    { 1000,   0.15   },
+    { 100000, 0.02   },
+};
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Stream values
+static float s_values[PCT_MAX_LEN];
+/// Stream values sorted
+static float s_sorted[PCT_MAX_LEN];
+/// Random generator state
+static uint64_t s_rng;
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+int main(int argc, char **argv)
+{
+    uint32_t seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "S:")) != -1) {
+        switch (opt) {
+            case 'S': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-S seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    s_rng = seed;
+
+    int failed = 0;
+    for (size_t d = 0; d < sizeof(s_dists) / sizeof(s_dists[0]); ++d) {
+        for (size_t l = 0; l < sizeof(s_lens) / sizeof(s_lens[0]); ++l) {
+            const pct_dist_t *dist = &s_dists[d];
+            const uint32_t len = s_lens[l].len;
+            const uint32_t trials = (PCT_CASE_OBS / len > 0) ? PCT_CASE_OBS / len : 1;
+            double sum[BMS_PCT_COUNT] = {0};
+            double max[BMS_PCT_COUNT] = {0};
+
+            for (uint32_t t = 0; t < trials; ++t) {
+                dist->fill(s_values, len);
+                bms_pct_t est;
+                bms_pct_init(&est);
+                for (uint32_t i = 0; i < len; ++i) {
+                    bms_pct_add(&est, s_values[i]);
+                }
+                float out[BMS_PCT_COUNT];
+                bms_pct_get(&est, out);
+
+                memcpy(s_sorted, s_values, len * sizeof(s_sorted[0]));
+                qsort(s_sorted, len, sizeof(s_sorted[0]), cmp_float);
+                for (int j = 0; j < BMS_PCT_COUNT; ++j) {
+                    double ref = exact_pct(s_sorted, len, (double)g_bms_pct_levels[j] / 100.0);
+                    double err = fabs((double)out[j] - ref) / dist->sd;
+                    sum[j] += err;
+                    if (err > max[j]) {
+                        max[j] = err;
+                    }
+                }
+            }
+
+            bool ok = true;
+            printf("{\"dist\":\"%s\",\"len\":%u,\"trials\":%u", dist->name, (unsigned)len, (unsigned)trials);
+            for (int j = 0; j < BMS_PCT_COUNT; ++j) {
+                double mean = sum[j] / (double)trials;
+                ok = ok && (mean <= s_lens[l].limit);
+                printf(",\"p%u\":{\"mean_err\":%.4f,\"max_err\":%.4f}", (unsigned)g_bms_pct_levels[j], mean, max[j]);
+            }
+            printf(",\"limit\":%.4f,\"ok\":%s}\n", s_lens[l].limit, ok ? "true" : "false");
+            failed += ok ? 0 : 1;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function fills a stream with uniform values in [0, 1).
+///
+/// \param[out] v Values
+/// \param[in] n Number of values
+/// \return None
+static void fill_uniform(float *v, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        v[i] = (float)rand_uniform();
+    }
+
+    return;
+}
+
+/// This function fills a stream with standard normal values.
+///
+/// \param[out] v Values
+/// \param[in] n Number of values
+/// \return None
+static void fill_normal(float *v, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        v[i] = (float)rand_normal();
+    }
+
+    return;
+}
+
+/// This function fills a stream with exponential values of mean 1.
+///
+/// \param[out] v Values
+/// \param[in] n Number of values
+/// \return None
+static void fill_exp(float *v, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        v[i] = (float)-log(rand_uniform());
+    }
+
+    return;
+}
+
+/// This function fills a stream with pack current samples (20 Hz) under a 5 A inverter ripple of random frequency
+/// and phase, plus 0.2 A normal noise.
+///
+/// \param[out] v Values
+/// \param[in] n Number of values
+/// \return None
+static void fill_ripple(float *v, uint32_t n)
+{
+    double freq = 0.3 + 7.0 * rand_uniform();
+    double phase = 2.0 * PCT_PI * rand_uniform();
+    for (uint32_t i = 0; i < n; ++i) {
+        v[i] = (float)(5.0 * sin(2.0 * PCT_PI * freq * (double)i / 20.0 + phase) + 0.2 * rand_normal());
+    }
+
+    return;
+}
+
+/// This function computes a percentile of sorted values with the estimator's definition.
+///
+/// \param[in] sorted Values in ascending order
+/// \param[in] n Number of values (> 0)
+/// \param[in] p Percentile as fraction
+/// \return Percentile by linear interpolation between closest ranks
+static double exact_pct(const float *sorted, uint32_t n, double p)
+{
+    double rank = p * (double)(n - 1u);
+    uint32_t lo = (uint32_t)rank;
+    if (lo + 1u >= n) {
+        return sorted[n - 1u];
+    }
+
+    return sorted[lo] + (rank - (double)lo) * ((double)sorted[lo + 1u] - (double)sorted[lo]);
+}
+
+/// This function returns a uniform random number (splitmix64).
+///
+/// \param None
+/// \return Number in (0, 1)
+static double rand_uniform(void)
+{
+    uint64_t z = (s_rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    return ((double)(z >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/// This function returns a standard normal random number (Box-Muller).
+///
+/// \param None
+/// \return Number
+static double rand_normal(void)
+{
+    return sqrt(-2.0 * log(rand_uniform())) * cos(2.0 * PCT_PI * rand_uniform());
+}
+
+/// This function compares two values for qsort().
+///
+/// \param[in] a First value
+/// \param[in] b Second value
+/// \return Negative, zero or positive
+static int cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,127 @@
+/// Host implementation of the ESP-IDF shim (timer, random numbers, error names, HTTP responses).
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_http_server.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Monotonic time of the first timer call in microseconds
+static int64_t s_epoch_us = -1;
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function returns monotonic time in microseconds since the first call.
+///
+/// \param None
+/// \return Time in microseconds
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t now_us = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    if (s_epoch_us < 0) {
+        s_epoch_us = now_us;
+    }
+
+    return now_us - s_epoch_us;
+}
+
+/// This function returns 32 random bits from the operating system.
+///
+/// \param None
+/// \return Random value
+uint32_t esp_random(void)
+{
+    uint32_t value = 0;
+    esp_fill_random(&value, sizeof(value));
+
+    return value;
+}
+
+/// This function fills buffer with random bytes from /dev/urandom, falling back to the monotonic clock.
+///
+/// \param[out] buf Buffer to fill
+/// \param[in] len Number of bytes
+/// \return None
+void esp_fill_random(void *buf, size_t len)
+{
+    FILE *f = fopen("/dev/urandom", "rb");
+    size_t got = f ? fread(buf, 1, len, f) : 0;
+    if (f) {
+        fclose(f);
+    }
+    for (size_t i = got; i < len; ++i) {
+        ((uint8_t *)buf)[i] = (uint8_t)(esp_timer_get_time() >> (8 * (i % 4)));
+    }
+
+    return;
+}
+
+/// This function returns name of an error code.
+///
+/// \param[in] code Error code
+/// \return Error name
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_CRC:   return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+        default:                    return "UNKNOWN ERROR";
+    }
+}
+
+/// This function ignores response content type.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \param[in] type Content type
+/// \return ESP_OK
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+    (void)req;
+    (void)type;
+
+    return ESP_OK;
+}
+
+/// This function counts response bytes and discards them.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \param[in] buf Response data
+/// \param[in] buf_len Length of response data
+/// \return ESP_OK
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+    if (req && buf) {
+        req->sent_bytes += (size_t)buf_len;
+    }
+
+    return ESP_OK;
+}
+
+/// This function counts response string bytes and discards them.
+///
+/// \param[in] req Pointer to HTTP request structure
+/// \param[in] str Response string
+/// \return ESP_OK
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str)
+{
+    return httpd_resp_send(req, str, str ? (ssize_t)strlen(str) : 0);
+}
@@ -0,0 +1,276 @@
+/// Host implementation of the FreeRTOS shim (tick count, delays, tasks and queues). Tasks are detached pthreads,
+/// pinned to the CPU of their core number when the host has it; priorities are ignored.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Start arguments of a task thread
+typedef struct {
+    TaskFunction_t fn;          ///< Task function
+    void *arg;                  ///< Task argument
+} task_start_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void *task_thread(void *arg);
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function returns ticks elapsed since the first call of any time function.
+///
+/// \param None
+/// \return Tick count
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((esp_timer_get_time() * configTICK_RATE_HZ) / 1000000);
+}
+
+/// This function sleeps the calling thread for the given number of ticks.
+///
+/// \param[in] ticks Number of ticks to sleep
+/// \return None
+void vTaskDelay(TickType_t ticks)
+{
+    uint64_t us = ((uint64_t)ticks * 1000000u) / configTICK_RATE_HZ;
+    struct timespec ts = { .tv_sec = (time_t)(us / 1000000u), .tv_nsec = (long)(us % 1000000u) * 1000 };
+    nanosleep(&ts, NULL);
+
+    return;
+}
+
+/// This function sleeps the calling thread until the previous wake time plus the increment and advances the
+/// previous wake time, like the FreeRTOS absolute delay.
+///
+/// \param[in,out] prev_wake Previous wake time in ticks
+/// \param[in] increment Period in ticks
+/// \return None
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment)
+{
+    *prev_wake += increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*prev_wake - now) > 0) {
+        vTaskDelay(*prev_wake - now);
+    }
+
+    return;
+}
+
+/// This function starts a task as a detached thread. Stack depth and priority are ignored.
+///
+/// \param[in] fn Task function
+/// \param[in] name Task name (unused)
+/// \param[in] stack_depth Stack size (unused, default thread stack is larger)
+/// \param[in] arg Task argument
+/// \param[in] priority Task priority (unused)
+/// \param[out] handle Task handle (thread id stored as handle), may be NULL
+/// \param[in] core_id Core to pin the thread to, if the host has that CPU
+/// \return pdPASS on success, pdFAIL if the thread cannot be created
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+
+    task_start_t *start = malloc(sizeof(*start));
+    if (!start) {
+        return pdFAIL;
+    }
+    start->fn  = fn;
+    start->arg = arg;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_thread, start) != 0) {
+        free(start);
+        return pdFAIL;
+    }
+    if (core_id >= 0 && core_id < sysconf(_SC_NPROCESSORS_ONLN)) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core_id, &set);
+        pthread_setaffinity_np(thread, sizeof(set), &set);
+    }
+    pthread_detach(thread);
+    if (handle) {
+        *handle = (TaskHandle_t)thread;
+    }
+
+    return pdPASS;
+}
+
+/// This function ends the calling task. Only deletion of the calling task (NULL) is supported.
+///
+/// \param[in] task Task handle, must be NULL
+/// \return None
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+
+    return;
+}
+
+/// This function creates a queue with storage allocated from heap.
+///
+/// \param[in] length Maximum number of items
+/// \param[in] item_size Size of one item in bytes
+/// \return Queue handle, or NULL on allocation failure
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    StaticQueue_t *q = calloc(1, sizeof(*q));
+    uint8_t *storage = malloc((size_t)length * item_size);
+    if (!q || !storage) {
+        free(q);
+        free(storage);
+        return NULL;
+    }
+
+    xQueueCreateStatic(length, item_size, storage, q);
+    q->dynamic = true;
+
+    return q;
+}
+
+/// This function creates a queue in caller provided storage.
+///
+/// \param[in] length Maximum number of items
+/// \param[in] item_size Size of one item in bytes
+/// \param[in] storage Item storage of length * item_size bytes
+/// \param[out] queue Queue control structure
+/// \return Queue handle
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *queue)
+{
+    pthread_mutex_init(&queue->lock, NULL);
+    queue->storage   = storage;
+    queue->length    = length;
+    queue->item_size = item_size;
+    queue->head      = 0;
+    queue->count     = 0;
+    queue->dynamic   = false;
+
+    return queue;
+}
+
+/// This function deletes a queue.
+///
+/// \param[in] queue Queue handle
+/// \return None
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (!queue) {
+        return;
+    }
+
+    pthread_mutex_destroy(&queue->lock);
+    if (queue->dynamic) {
+        free(queue->storage);
+        free(queue);
+    }
+
+    return;
+}
+
+/// This function copies an item to the back of the queue.
+///
+/// \param[in] queue Queue handle
+/// \param[in] item Pointer to item to copy
+/// \param[in] ticks_to_wait Ignored
+/// \return pdPASS on success, pdFAIL if queue is full
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    BaseType_t ret = pdFAIL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count < queue->length) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->storage + (size_t)tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return ret;
+}
+
+/// This function copies the oldest item out of the queue and removes it.
+///
+/// \param[in] queue Queue handle
+/// \param[out] item Pointer to buffer receiving the item
+/// \param[in] ticks_to_wait Ignored
+/// \return pdPASS on success, pdFAIL if queue is empty
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    BaseType_t ret = pdFAIL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0) {
+        memcpy(item, queue->storage + (size_t)queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return ret;
+}
+
+/// This function returns number of free slots of the queue.
+///
+/// \param[in] queue Queue handle
+/// \return Number of free slots
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t free_slots = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+
+    return free_slots;
+}
+
+/// This function returns number of items stored in the queue.
+///
+/// \param[in] queue Queue handle
+/// \return Number of stored items
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+
+    return count;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// Thread entry of a task. Runs the task function; a task returning without vTaskDelete() ends its thread.
+///
+/// \param[in] arg Start arguments (freed here)
+/// \return NULL
+static void *task_thread(void *arg)
+{
+    task_start_t start = *(task_start_t *)arg;
+    free(arg);
+    start.fn(start.arg);
+
+    return NULL;
+}
@@ -0,0 +1,16 @@
+/// Host shim of ESP-IDF HTTP server. Responses are counted and discarded.
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+/// HTTP request structure
+typedef struct httpd_req {
+    size_t content_len;         ///< Length of request body
+    size_t sent_bytes;          ///< Number of response bytes sent by handler
+} httpd_req_t;
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str);
@@ -0,0 +1,11 @@
+/// Host shim of ESP-IDF hardware random number generator.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// Returns 32 random bits
+uint32_t esp_random(void);
+
+/// Fills buffer with random bytes
+void esp_fill_random(void *buf, size_t len);
@@ -0,0 +1,7 @@
+/// Host shim of ESP-IDF high resolution timer.
+#pragma once
+
+#include <stdint.h>
+
+/// Returns monotonic time in microseconds since first call
+int64_t esp_timer_get_time(void);
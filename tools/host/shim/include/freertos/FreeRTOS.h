@@ -0,0 +1,39 @@
+/// Host shim of FreeRTOS base definitions. Provides only what the pipeline modules built by the host target use.
+/// Critical sections map to a process-wide recursive mutex per spinlock, ticks are derived from monotonic clock.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+#include "freertos/portmacro.h"
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// RTOS tick rate in Hz (ESP-IDF project setting)
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ      1000
+#endif
+
+/// Converts milliseconds to RTOS ticks
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+/// Tick period in milliseconds
+#define portTICK_PERIOD_MS      ((TickType_t)(1000u / configTICK_RATE_HZ))
+/// Maximum blocking time
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFFu)
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+TickType_t xTaskGetTickCount(void);
@@ -0,0 +1,33 @@
+/// Host shim of FreeRTOS port definitions. ESP-IDF spinlocks are emulated by recursive pthread mutexes, which
+/// keeps the nesting behavior of taskENTER_CRITICAL() within one thread.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// Static initializer of unlocked spinlock
+#define portMUX_INITIALIZER_UNLOCKED    PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
+
+/// Enters critical section protected by spinlock
+#define taskENTER_CRITICAL(mux)         pthread_mutex_lock(mux)
+/// Exits critical section protected by spinlock
+#define taskEXIT_CRITICAL(mux)          pthread_mutex_unlock(mux)
+#define taskENTER_CRITICAL_ISR(mux)     pthread_mutex_lock(mux)
+#define taskEXIT_CRITICAL_ISR(mux)      pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(mux)
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+typedef uint32_t        TickType_t;
+typedef int             BaseType_t;
+typedef unsigned int    UBaseType_t;
+typedef pthread_mutex_t portMUX_TYPE;
@@ -0,0 +1,36 @@
+/// Host shim of FreeRTOS queue API. Queues are copy-by-value ring buffers guarded by a mutex. Blocking time is
+/// ignored, every call behaves as with zero ticks to wait (the only mode used by the pipeline).
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+/*==============================================================================================================*/
+/*                                               Public Types                                                   */
+/*==============================================================================================================*/
+/// Queue control structure
+typedef struct QueueDefinition {
+    pthread_mutex_t lock;       ///< Lock guarding the queue
+    uint8_t        *storage;    ///< Item storage
+    UBaseType_t     length;     ///< Maximum number of items
+    UBaseType_t     item_size;  ///< Size of one item in bytes
+    UBaseType_t     head;       ///< Index of the oldest item
+    UBaseType_t     count;      ///< Number of stored items
+    bool            dynamic;    ///< Storage allocated by xQueueCreate()
+} StaticQueue_t;
+
+typedef StaticQueue_t *QueueHandle_t;
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *queue);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
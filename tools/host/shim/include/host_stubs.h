@@ -0,0 +1,11 @@
+/// Host-only controls of the stubs in `platform_stubs.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+void host_set_device_id(const char *id);
@@ -0,0 +1,29 @@
+/// Header file for `mqtt_frame.c`.
+
+/*==============================================================================================================*/
+/*                                                 Includes                                                     */
+/*==============================================================================================================*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*==============================================================================================================*/
+/*                                               Public Macros                                                  */
+/*==============================================================================================================*/
+/// MQTT control packet types (first byte of fixed header, including the fixed flags of SUBSCRIBE)
+#define MQTT_CONNECT            0x10u
+#define MQTT_CONNACK            0x20u
+#define MQTT_PUBLISH            0x30u
+#define MQTT_SUBSCRIBE          0x82u
+#define MQTT_SUBACK             0x90u
+
+/// Longest topic accepted by mqtt_publish()
+#define MQTT_FRAME_TOPIC_MAX    128u
+
+/*==============================================================================================================*/
+/*                                        Public Function Prototypes                                            */
+/*==============================================================================================================*/
+size_t mqtt_encode_remaining_length(uint8_t *p, uint32_t len);
+int mqtt_send_all(int fd, const uint8_t *buf, size_t len);
+int mqtt_publish(int fd, const char *topic, const char *data, size_t len);
@@ -0,0 +1,3 @@
+/// Host shim of generated ESP-IDF configuration. Options left undefined take module defaults (`#ifndef CONFIG_*`),
+/// boolean options are disabled.
+#pragma once
@@ -0,0 +1,80 @@
+/// MQTT 3.1.1 framing shared by the host tools which talk to a broker over a plain TCP socket (bms_stress stand-in
+/// broker, bms_fleet real broker): remaining length encoding, complete sends and QoS 0 PUBLISH packets.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "mqtt_frame.h"
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// This function encodes MQTT remaining length (variable length integer, 7 bits per byte).
+///
+/// \param[out] p Destination (at most 4 bytes)
+/// \param[in] len Remaining length
+/// \return Number of bytes written
+size_t mqtt_encode_remaining_length(uint8_t *p, uint32_t len)
+{
+    size_t n = 0;
+    do {
+        uint8_t b = (uint8_t)(len % 128u);
+        len /= 128u;
+        p[n++] = (len > 0) ? (uint8_t)(b | 0x80u) : b;
+    } while (len > 0 && n < 4);
+
+    return n;
+}
+
+/// This function sends the whole buffer.
+///
+/// \param[in] fd Socket
+/// \param[in] buf Data
+/// \param[in] len Data length in bytes
+/// \return 0 on success, -1 on error
+int mqtt_send_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/// This function publishes one message as QoS 0 PUBLISH packet.
+///
+/// \param[in] fd Broker connection
+/// \param[in] topic Topic (at most ::MQTT_FRAME_TOPIC_MAX bytes)
+/// \param[in] data Payload
+/// \param[in] len Payload length in bytes
+/// \return 0 on success, -1 on error
+int mqtt_publish(int fd, const char *topic, const char *data, size_t len)
+{
+    uint8_t hdr[5 + 2 + MQTT_FRAME_TOPIC_MAX];
+    size_t topic_len = strlen(topic);
+    if (topic_len > MQTT_FRAME_TOPIC_MAX) {
+        return -1;
+    }
+
+    size_t pos = 0;
+    hdr[pos++] = MQTT_PUBLISH;
+    pos += mqtt_encode_remaining_length(&hdr[pos], (uint32_t)(2u + topic_len + len));
+    hdr[pos++] = (uint8_t)(topic_len >> 8);
+    hdr[pos++] = (uint8_t)topic_len;
+    memcpy(&hdr[pos], topic, topic_len);
+    pos += topic_len;
+
+    if (mqtt_send_all(fd, hdr, pos) != 0 || mqtt_send_all(fd, (const uint8_t *)data, len) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/// Host replacements of firmware modules which depend on ESP32 hardware or services (telemetry, supervisor,
+/// JSON arena, RTC log storage, configuration storage, LTC6804 SPI transport, SNTP time sync status). They return
+/// fixed, representative values so that pipeline modules produce messages of realistic size.
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "configuration.h"
+#include "bms_data.h"
+#include "telemetry.h"
+#include "supervisor.h"
+#include "json_arena.h"
+#include "logging.h"
+#include "ltc6804_transport.h"
+#include "host_stubs.h"
+#include "timesync.h"
+#include <stdio.h>
+#include <string.h>
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Device ID reported by telemetry_get_device_id(), per thread
+static _Thread_local char s_device_id[18] = "AA:BB:CC:DD:EE:FF";
+
+/*==============================================================================================================*/
+/*                                      Public Variables and Constants                                          */
+/*==============================================================================================================*/
+/// Global configuration instance (12 Li-ion cells with 2.5 to 4.2 V limits, current and temperature enabled)
+configuration_t g_cfg = {
+    .battery = {
+        .adapter_mode         = BMS_ADAPTER_DEMO,
+        .num_cells            = BMS_MAX_CELLS,
+        .current_enable       = true,
+        .temperature_enable   = true,
+        .cell_v_min           = 2.5f,
+        .cell_v_max           = 4.2f,
+        .pack_v_min           = 2.5f * BMS_MAX_CELLS,
+        .pack_v_max           = 4.2f * BMS_MAX_CELLS,
+        .series_pack_i_min    = 1.0f,
+        .series_pack_i_max    = 5.0f
+    }
+};
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+/// Host stub of telemetry_get_device_id(), returns the MAC address set by host_set_device_id() in the calling
+/// thread or a fixed one.
+void telemetry_get_device_id(char *id_buf, size_t buf_size)
+{
+    snprintf(id_buf, buf_size, "%s", s_device_id);
+
+    return;
+}
+
+/// This function sets the device ID returned by telemetry_get_device_id() in the calling thread (fleet emulation).
+void host_set_device_id(const char *id)
+{
+    snprintf(s_device_id, sizeof(s_device_id), "%s", id);
+
+    return;
+}
+
+/// Host stub of telemetry_get_sw_version().
+void telemetry_get_sw_version(char *ver_buf, size_t buf_size)
+{
+    snprintf(ver_buf, buf_size, "%s", "host-0000000");
+
+    return;
+}
+
+/// Host stub of telemetry_get_esp32_telemetry(), returns values of a device running for one day.
+void telemetry_get_esp32_telemetry(esp32_telemetry_t *telem)
+{
+    memset(telem, 0, sizeof(*telem));
+    telemetry_get_device_id(telem->device_id, sizeof(telem->device_id));
+    telemetry_get_sw_version(telem->sw_version, sizeof(telem->sw_version));
+    telem->cpu_load           = 42;
+    telem->free_heap          = 181234;
+    telem->min_free_heap      = 170112;
+    telem->largest_free_block = 110592;
+    telem->heap_baseline      = 170400;
+    telem->heap_drift         = 288;
+    telem->uptime_s           = 86400;
+    telem->reset_reason       = 1;
+
+    return;
+}
+
+/// Host stub of telemetry_get_ltc6804_status(), returns valid status without cell flags.
+void telemetry_get_ltc6804_status(ltc6804_status_t *status)
+{
+    memset(status, 0, sizeof(*status));
+    status->soc        = 0x1F40;
+    status->itmp       = 0x5DC0;
+    status->va         = 0xC350;
+    status->vd         = 0x7530;
+    status->cell_flags = 0;
+    status->diag       = 0x10;
+    status->valid      = true;
+
+    return;
+}
+
+#if CONFIG_BMS_TIMESYNC
+/// Host stub of bms_timesync_get_status(), reports a device synchronized for one day.
+void bms_timesync_get_status(bms_timesync_status_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->synced      = true;
+    out->syncs       = 1440;
+    out->drift_ppb   = -12345;
+    out->offset_us   = -412;
+    out->age_s       = 17;
+    out->wake_max_us = 85;
+
+    return;
+}
+#endif
+
+/// Host stub of supervisor_get_status(), reports Fast Core and Slow Core heartbeats.
+size_t supervisor_get_status(supervisor_status_t *out, size_t max_count)
+{
+    static const supervisor_status_t s_status[] = {
+        { .name = "fast_core", .age_ms = 12,  .deadline_ms = 500,   .worst_late_ms = 3 },
+        { .name = "slow_core", .age_ms = 640, .deadline_ms = 30000, .worst_late_ms = 41 },
+    };
+
+    size_t n = sizeof(s_status) / sizeof(s_status[0]);
+    if (n > max_count) {
+        n = max_count;
+    }
+    memcpy(out, s_status, n * sizeof(*out));
+
+    return n;
+}
+
+/// Host stub of json_arena_get_stats(), arena is not used on host.
+void json_arena_get_stats(json_arena_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->size = CONFIG_BMS_JSON_ARENA_SIZE;
+
+    return;
+}
+
+/// Host stub of bms_log_rtc_store(), there is no RTC memory on host. Errors are still printed by ESP_LOGE.
+void bms_log_rtc_store(const char *tag, const char *fmt, ...)
+{
+    (void)tag;
+    (void)fmt;
+
+    return;
+}
+
+/// Host stub of ltc6804_spi_transport(), there is no SPI master on host. LTC6804 driver has to be given the
+/// emulator transports by ltc6804_set_chains().
+const ltc6804_transport_t *ltc6804_spi_transport(uint8_t chain)
+{
+    (void)chain;
+
+    return NULL;
+}
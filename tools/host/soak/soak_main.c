@@ -0,0 +1,313 @@
+/// Host soak test of the acquisition and processing pipeline driven by the deterministic pack simulator. Samples
+/// of simulated time are produced as fast as possible and go the same way as on target: inter-core queue, Slow
+/// Core ring buffer, statistics windows, JSON serialization and statistics history. One JSON object with totals,
+/// a digest of all produced JSON messages and the achieved speed-up over real time is printed to stdout. The
+/// digest depends only on the seed, cell count, faults and simulated duration, so runs can be compared across
+/// commits and machines.
+///
+/// A fault-free run must not produce any limit violation window, otherwise the run fails with exit code 1.
+///
+/// The per-cell anomaly detector runs on every window as on target. The times of the first anomaly alarm and of the
+/// first cell voltage limit violation (-1 if none) show how much earlier the detector flags a faulty cell than the
+/// hard limits.
+///
+/// The raw sample stream can be recorded to a trace file (-W) and a recorded trace can be fed through the
+/// pipeline instead of the simulator (-R, until the end of the trace). Replaying a trace recorded from the
+/// simulator reproduces the digest of the recording run.
+///
+/// Usage: bms_soak [-S seed] [-H hours] [-n cells] [-F kind:cell:start_s]... [-W trace] [-R trace]
+///   -S  simulator seed (default 1)
+///   -H  simulated duration in hours (default 24)
+///   -n  number of cells (default from host configuration)
+///   -F  inject cell fault, kind is one of hr, cap, leak, open, stuck, cell is 1-based, start in seconds
+///       (up to 4 faults)
+///   -W  record raw samples to trace file
+///   -R  replay trace file instead of running the simulator
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "bms_sim.h"
+#include "bms_trace.h"
+#include "process.h"
+#include "json_formatter.h"
+#include "intercore_comm.h"
+#include "stats_history.h"
+#include "configuration.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Capacity of the Slow Core ring buffer (same as on target)
+#define SOAK_BUFFER_CAPACITY   100
+
+/// Samples per simulated second at the nominal 50 ms period
+#define SOAK_SAMPLES_PER_S     20
+
+/// Cell undervoltage / overvoltage bits of cell_errors (bits 1-24, bit 27 for cells beyond 11)
+#define SOAK_CELL_LIMIT_BITS   0x09FFFFFEu
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static int parse_fault(const char *spec, bms_sim_fault_t *fault);
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t len);
+static double now_s(void);
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Slow Core ring buffer storage
+static bms_sample_t s_samples[SOAK_BUFFER_CAPACITY];
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+int main(int argc, char **argv)
+{
+    bms_sim_config_t sim_cfg;
+    bms_sim_default_config(&sim_cfg);
+    sim_cfg.deterministic = true;
+    double hours = 24.0;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "S:H:n:F:W:R:")) != -1) {
+        switch (opt) {
+            case 'S': sim_cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'H': hours = atof(optarg);                              break;
+            case 'n': g_cfg.battery.num_cells = (uint8_t)atoi(optarg);   break;
+            case 'F':
+                if (sim_cfg.fault_count >= BMS_SIM_MAX_FAULTS ||
+                    parse_fault(optarg, &sim_cfg.faults[sim_cfg.fault_count]) != 0) {
+                    fprintf(stderr, "invalid fault '%s' (kind:cell:start_s, at most %d)\n", optarg,
+                            BMS_SIM_MAX_FAULTS);
+                    return 2;
+                }
+                sim_cfg.fault_count++;
+                break;
+            case 'W': record_path = optarg; break;
+            case 'R': replay_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-S seed] [-H hours] [-n cells] [-F kind:cell:start_s]... [-W trace] "
+                        "[-R trace]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (hours <= 0.0 || g_cfg.battery.num_cells < 1 || g_cfg.battery.num_cells > BMS_MAX_CELLS ||
+        sim_cfg.seed == 0) {
+        fprintf(stderr, "invalid arguments (hours > 0, 1 <= cells <= %d, seed != 0)\n", BMS_MAX_CELLS);
+        return 2;
+    }
+    // Sample source: simulator, or trace replayed once (cell count taken from the trace)
+    esp_err_t (*read_sample)(bms_sample_t *out) = bms_sim_read_sample;
+    if (replay_path) {
+        if (bms_trace_replay_open(replay_path, BMS_TRACE_PACE_NONE, false) != ESP_OK) {
+            fprintf(stderr, "cannot replay trace '%s'\n", replay_path);
+            return 1;
+        }
+        g_cfg.battery.num_cells = bms_trace_replay_cells();
+        read_sample = bms_trace_replay_read;
+    } else if (bms_sim_init(&sim_cfg) != ESP_OK) {
+        fprintf(stderr, "bms_sim_init failed\n");
+        return 1;
+    }
+    if (record_path && bms_trace_rec_start(record_path, g_cfg.battery.num_cells, UINT32_MAX) != ESP_OK) {
+        fprintf(stderr, "cannot record trace '%s'\n", record_path);
+        return 1;
+    }
+    bms_queue_init();
+
+    bms_sample_buffer_t buf = { .samples = s_samples, .capacity = SOAK_BUFFER_CAPACITY };
+    bms_stats_buffer_t stats;
+    char json[BMS_STATS_JSON_MAXLEN];
+
+    uint64_t total_s = (uint64_t)(hours * 3600.0);
+    uint64_t samples = 0;
+    uint64_t windows = 0;
+    uint64_t violation_windows = 0;
+    uint64_t json_bytes = 0;
+    uint64_t json_max = 0;
+    double limit_s = -1.0;
+    double anomaly_s = -1.0;
+    bms_cell_mask_t anomaly_cells = { 0 };
+    uint32_t digest = 2166136261u;
+    bool end_of_trace = false;
+    double start = now_s();
+
+    for (uint64_t sec = 0; sec < total_s && !end_of_trace; ++sec) {
+        // Fast Core: one simulated second of samples into inter-core queue
+        for (int i = 0; i < SOAK_SAMPLES_PER_S; ++i) {
+            bms_sample_t sample;
+            if (read_sample(&sample) != ESP_OK) {
+                end_of_trace = true;
+                break;
+            }
+            bms_trace_rec_push(&sample);
+            if (!bms_queue_push(&sample)) {
+                fprintf(stderr, "inter-core queue full at %llu s\n", (unsigned long long)sec);
+                return 1;
+            }
+            samples++;
+        }
+
+        // Slow Core: write recorded samples, drain queue into ring buffer, compute and serialize statistics windows
+        if (bms_trace_rec_flush() != ESP_OK) {
+            fprintf(stderr, "trace write failed at %llu s\n", (unsigned long long)sec);
+            return 1;
+        }
+        bms_sample_t sample;
+        while (buf.count < buf.capacity && bms_queue_pop(&sample)) {
+            buf.samples[bms_buf_index(&buf, buf.count)] = sample;
+            buf.count++;
+        }
+        while (buf.count > 0) {
+            if (bms_compute_stats(&buf, &stats) == 0) {
+                break;
+            }
+            for (size_t w = 0; w < stats.stats_count; ++w) {
+                bms_stats_t *st = &stats.stats_array[w];
+                bms_anomaly_t anomaly;
+                bms_anomaly_update(st->timestamp, st->cell_v_avg, g_cfg.battery.num_cells, &anomaly);
+#if CONFIG_BMS_ANOMALY
+                st->anomaly = anomaly;
+#endif
+                double window_s = (double)st->timestamp / configTICK_RATE_HZ;
+                if (bms_cell_mask_any(&anomaly.alarm) && anomaly_s < 0.0) {
+                    anomaly_s = window_s;
+                    anomaly_cells = anomaly.alarm;
+                }
+                int len = bms_stats_to_json(st, json, sizeof(json));
+                if (len < 0) {
+                    fprintf(stderr, "bms_stats_to_json failed at %llu s\n", (unsigned long long)sec);
+                    return 1;
+                }
+                bms_stats_hist_push(json, (size_t)len);
+                digest = fnv1a(digest, json, (size_t)len);
+                windows++;
+                // Bit 0 is the inspection bit, set in every window
+                violation_windows += ((st->cell_errors & ~0x1u) != 0);
+                if ((st->cell_errors & SOAK_CELL_LIMIT_BITS) != 0 && limit_s < 0.0) {
+                    limit_s = window_s;
+                }
+                json_bytes += (uint64_t)len;
+                if ((uint64_t)len > json_max) {
+                    json_max = (uint64_t)len;
+                }
+            }
+        }
+    }
+
+    double wall = now_s() - start;
+    if (record_path && bms_trace_rec_stop() != ESP_OK) {
+        fprintf(stderr, "trace write failed\n");
+        return 1;
+    }
+    bms_trace_replay_close();
+
+    // Cells of the first alarm as in the JSON messages: one number up to 32 cells, an array of 32-bit words beyond
+    char cells_txt[16 + 11 * BMS_CELL_MASK_WORDS];
+    int cells_len = 0;
+    if (g_cfg.battery.num_cells <= 32) {
+        snprintf(cells_txt, sizeof(cells_txt), "%lu", (unsigned long)anomaly_cells.w[0]);
+    } else {
+        for (int i = 0; i < (g_cfg.battery.num_cells + 31) / 32; ++i) {
+            cells_len += snprintf(cells_txt + cells_len, sizeof(cells_txt) - (size_t)cells_len, "%s%lu",
+                                  i ? "," : "[", (unsigned long)anomaly_cells.w[i]);
+        }
+        snprintf(cells_txt + cells_len, sizeof(cells_txt) - (size_t)cells_len, "]");
+    }
+
+    // Simulated (or replayed) time at the nominal sample period
+    double sim_s = (double)samples / SOAK_SAMPLES_PER_S;
+    printf("{\"seed\":%lu,\"cells\":%u,\"faults\":%u,\"sim_hours\":%.3f,\"samples\":%llu,\"windows\":%llu,"
+           "\"violation_windows\":%llu,\"limit_s\":%.1f,\"anomaly_s\":%.1f,\"anomaly_cells\":%s,"
+           "\"json_bytes\":%llu,\"json_max\":%llu,\"digest\":\"%08x\",\"wall_s\":%.3f,\"speedup\":%.0f}\n",
+           (unsigned long)sim_cfg.seed, (unsigned)g_cfg.battery.num_cells, (unsigned)sim_cfg.fault_count,
+           sim_s / 3600.0, (unsigned long long)samples, (unsigned long long)windows,
+           (unsigned long long)violation_windows, limit_s, anomaly_s, cells_txt,
+           (unsigned long long)json_bytes, (unsigned long long)json_max, digest, wall,
+           (wall > 0.0) ? sim_s / wall : 0.0);
+
+    // Without injected faults the simulated pack stays inside the host limits, any violation is a pipeline error
+    if (!replay_path && sim_cfg.fault_count == 0 && violation_windows != 0) {
+        fprintf(stderr, "%llu violation windows in a fault-free run\n", (unsigned long long)violation_windows);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function parses fault specification kind:cell:start_s.
+///
+/// \param[in] spec Fault specification
+/// \param[out] fault Parsed fault
+/// \return 0 on success, -1 on invalid specification
+static int parse_fault(const char *spec, bms_sim_fault_t *fault)
+{
+    static const struct {
+        const char *name;
+        bms_sim_fault_kind_t kind;
+    } s_kinds[] = {
+        { "hr",    BMS_SIM_FAULT_HIGH_RESISTANCE },
+        { "cap",   BMS_SIM_FAULT_LOW_CAPACITY    },
+        { "leak",  BMS_SIM_FAULT_SELF_DISCHARGE  },
+        { "open",  BMS_SIM_FAULT_OPEN_WIRE       },
+        { "stuck", BMS_SIM_FAULT_STUCK           },
+    };
+
+    char name[8];
+    unsigned cell;
+    float start_s;
+    if (sscanf(spec, "%7[a-z]:%u:%f", name, &cell, &start_s) != 3 || cell < 1 || cell > BMS_MAX_CELLS ||
+        start_s < 0.0f) {
+        return -1;
+    }
+    for (size_t k = 0; k < sizeof(s_kinds) / sizeof(s_kinds[0]); ++k) {
+        if (strcmp(name, s_kinds[k].name) == 0) {
+            fault->kind    = s_kinds[k].kind;
+            fault->cell    = (uint8_t)(cell - 1u);
+            fault->start_s = start_s;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/// This function updates FNV-1a hash with given data.
+///
+/// \param[in] hash Current hash value
+/// \param[in] data Data
+/// \param[in] len Data length in bytes
+/// \return Updated hash value
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/// This function returns monotonic time in seconds.
+///
+/// \param None
+/// \return Time in seconds
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,270 @@
+/// Host run of the throughput stress sweep (stress.c). Producer, consumer and probe are FreeRTOS tasks mapped onto
+/// pthreads by the shim. Statistics are published as MQTT 3.1.1 QoS 0 PUBLISH packets over a loopback TCP
+/// connection to a stand-in broker thread, which parses the packet stream and counts received messages. The
+/// result table (same columns as the UART output on target) or the results JSON is printed to stdout.
+///
+/// Usage: bms_stress [-t step_ms] [-j] [-P]
+///   -t  duration of one rate step in milliseconds (default CONFIG_BMS_STRESS_STEP_MS)
+///   -j  print results JSON instead of the table
+///   -P  do not publish (no broker)
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "stress.h"
+#include "intercore_comm.h"
+#include "stats_history.h"
+#include "mqtt_frame.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of stand-in broker state
+typedef struct {
+    int listen_fd;              ///< Listening socket
+    uint64_t bytes;             ///< Received bytes
+    uint32_t publishes;         ///< Received PUBLISH packets
+    uint32_t other;             ///< Received packets of other types
+} broker_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static int broker_start(uint16_t *port);
+static void *broker_thread(void *arg);
+static int client_connect(uint16_t port);
+static esp_err_t publish(const char *topic, const char *data, int len);
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Stand-in broker
+static broker_t s_broker = { .listen_fd = -1 };
+/// Client connection to stand-in broker
+static int s_client_fd = -1;
+/// Number of published messages
+static uint32_t s_published = 0;
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+int main(int argc, char **argv)
+{
+    uint32_t step_ms = CONFIG_BMS_STRESS_STEP_MS;
+    bool json = false;
+    bool use_broker = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:jP")) != -1) {
+        switch (opt) {
+            case 't': step_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'j': json = true;                                   break;
+            case 'P': use_broker = false;                            break;
+            default:
+                fprintf(stderr, "usage: %s [-t step_ms] [-j] [-P]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    pthread_t broker;
+    if (use_broker) {
+        uint16_t port;
+        if (broker_start(&port) != 0 || pthread_create(&broker, NULL, broker_thread, NULL) != 0 ||
+            client_connect(port) != 0) {
+            fprintf(stderr, "stand-in broker setup failed\n");
+            return 1;
+        }
+    }
+
+    bms_queue_init();
+    stress_set_history(bms_stats_hist_push, bms_stats_hist_copy_latest);
+    esp_err_t err = stress_run(use_broker ? publish : NULL, step_ms);
+    if (err != ESP_OK) {
+        fprintf(stderr, "stress_run failed: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+
+    // Close connection and let the broker read everything that was sent
+    if (use_broker) {
+        shutdown(s_client_fd, SHUT_WR);
+        pthread_join(broker, NULL);
+        close(s_client_fd);
+        close(s_broker.listen_fd);
+    }
+
+    if (json) {
+        const char *results = stress_get_json();
+        printf("%s\n", results ? results : "null");
+    } else {
+        const stress_step_t *steps;
+        size_t n = stress_get_steps(&steps);
+        char row[176];
+        printf("%s\n", STRESS_TABLE_HEADER);
+        for (size_t i = 0; i < n; ++i) {
+            stress_format_row(&steps[i], row, sizeof(row));
+            printf("%s\n", row);
+        }
+        printf("max sustained rate: %lu Hz (queue %u samples, step %lu ms)\n",
+               (unsigned long)stress_max_sustained_hz(), (unsigned)BMS_QUEUE_LEN, (unsigned long)step_ms);
+        if (use_broker) {
+            printf("broker: %lu PUBLISH received of %lu sent, %llu bytes\n", (unsigned long)s_broker.publishes,
+                   (unsigned long)s_published, (unsigned long long)s_broker.bytes);
+        }
+    }
+
+    if (use_broker && s_broker.publishes != s_published) {
+        fprintf(stderr, "broker received %lu of %lu messages\n", (unsigned long)s_broker.publishes,
+                (unsigned long)s_published);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function opens the listening socket of the stand-in broker on a free loopback port.
+///
+/// \param[out] port Port number
+/// \return 0 on success, -1 on error
+static int broker_start(uint16_t *port)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+
+    s_broker.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (s_broker.listen_fd < 0 || bind(s_broker.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(s_broker.listen_fd, 1) != 0 ||
+        getsockname(s_broker.listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+
+    return 0;
+}
+
+/// Stand-in broker thread. Accepts one client, answers CONNECT with CONNACK and counts packets until the client
+/// closes the connection. Packets are framed by the fixed header (type and remaining length).
+///
+/// \param[in] arg Unused
+/// \return NULL
+static void *broker_thread(void *arg)
+{
+    (void)arg;
+    int fd = accept(s_broker.listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    uint8_t buf[8192];
+    uint8_t type = 0;
+    uint32_t remaining = 0;
+    uint32_t multiplier = 1;
+    enum { ST_TYPE, ST_LENGTH, ST_BODY } state = ST_TYPE;
+
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        s_broker.bytes += (uint64_t)n;
+        for (ssize_t i = 0; i < n; ++i) {
+            uint8_t b = buf[i];
+            if (state == ST_TYPE) {
+                type = b & 0xF0u;
+                remaining = 0;
+                multiplier = 1;
+                state = ST_LENGTH;
+            } else if (state == ST_LENGTH) {
+                remaining += (uint32_t)(b & 0x7Fu) * multiplier;
+                multiplier *= 128u;
+                if ((b & 0x80u) == 0) {
+                    state = ST_BODY;
+                }
+            } else if (remaining > 0) {
+                // Skip body bytes in bulk
+                uint32_t skip = ((uint32_t)(n - i) < remaining) ? (uint32_t)(n - i) : remaining;
+                remaining -= skip;
+                i += (ssize_t)skip - 1;
+            }
+
+            if (state == ST_BODY && remaining == 0) {
+                if (type == MQTT_PUBLISH) {
+                    s_broker.publishes++;
+                } else {
+                    s_broker.other++;
+                    if (type == MQTT_CONNECT) {
+                        const uint8_t connack[4] = { MQTT_CONNACK, 2, 0, 0 };
+                        mqtt_send_all(fd, connack, sizeof(connack));
+                    }
+                }
+                state = ST_TYPE;
+            }
+        }
+    }
+    close(fd);
+
+    return NULL;
+}
+
+/// This function connects the publishing client to the stand-in broker and completes the MQTT CONNECT handshake.
+///
+/// \param[in] port Broker port
+/// \return 0 on success, -1 on error
+static int client_connect(uint16_t port)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port),
+                                .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    s_client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (s_client_fd < 0 || connect(s_client_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(s_client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // CONNECT: protocol "MQTT" level 4, clean session, keep alive 60 s, client id "bms-stress"
+    static const uint8_t connect_pkt[] = {
+        MQTT_CONNECT, 22, 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 60,
+        0, 10, 'b', 'm', 's', '-', 's', 't', 'r', 'e', 's', 's',
+    };
+    uint8_t connack[4];
+    if (mqtt_send_all(s_client_fd, connect_pkt, sizeof(connect_pkt)) != 0 ||
+        recv(s_client_fd, connack, sizeof(connack), MSG_WAITALL) != (ssize_t)sizeof(connack) ||
+        connack[0] != MQTT_CONNACK || connack[3] != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/// This function publishes one message to the stand-in broker as QoS 0 PUBLISH packet.
+///
+/// \param[in] topic Topic
+/// \param[in] data Payload
+/// \param[in] len Payload length in bytes
+/// \return ESP_OK on success, ESP_FAIL on send error
+static esp_err_t publish(const char *topic, const char *data, int len)
+{
+    if (strlen(topic) > MQTT_FRAME_TOPIC_MAX || len < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (mqtt_publish(s_client_fd, topic, data, (size_t)len) != 0) {
+        return ESP_FAIL;
+    }
+    s_published++;
+
+    return ESP_OK;
+}
+
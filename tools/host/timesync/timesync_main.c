@@ -0,0 +1,564 @@
+/// Host test of wall-clock time synchronization and aligned statistics windows (CONFIG_BMS_TIMESYNC). Devices run
+/// in simulated time against a local NTP stand-in, which answers with true UTC over a network with random delay in
+/// each direction and packet loss. Every device has its own crystal error (constant part plus slow wander), boot
+/// time and pack simulator. Per device, the firmware clock mapping (`clock_map.c`) is fed with SNTP samples as on
+/// target (server time plus half the round trip), the Fast Core waits for wall-clock edges of its 50 ms period like
+/// `tasksFC.c` (esp_timer wake with random dispatch latency) and stamps samples with the edge, and the firmware
+/// bms_compute_stats() and bms_stats_to_json() form and serialize the windows.
+///
+/// Measured after the warm-up, against true time:
+///   align_us     start of the first sample of a window minus the window start it is published with (|us|)
+///   map_err_us   mapped time minus true time at every cycle (|us|)
+///   sync_err_us  mapped time minus true time when an SNTP sample arrives (|us|)
+///   join         per UTC second with a 1 s window from every device: spread of true window starts (us)
+/// plus windows without UTC, 1 s windows without 20 samples, discontinuities between consecutive windows of a
+/// device (skipped or repeated time), messages without matching "ts_ms" and the largest drift estimate error.
+///
+/// Usage: bms_timesync [-n devices] [-d seconds] [-i interval_s] [-b delay_us] [-j jitter_us] [-l loss_pct]
+///                     [-p skew_ppm] [-w wander_ppm] [-L latency_us] [-W warmup_s] [-S seed]
+///   -n  number of devices (default 8)
+///   -d  simulated duration in seconds (default 3600)
+///   -i  SNTP request interval in seconds (default 60, CONFIG_BMS_TIMESYNC_INTERVAL_S)
+///   -b  minimum one-way network delay in microseconds (default 2000)
+///   -j  mean random one-way delay on top of it in microseconds, exponential (default 1000)
+///   -l  SNTP packet loss in percent (default 2)
+///   -p  largest constant crystal error in ppm, uniform per device (default 40)
+///   -w  amplitude of crystal error wander in ppm, 30 min period (default 2)
+///   -L  mean esp_timer wake latency in microseconds, exponential (default 50)
+///   -W  warm-up in seconds excluded from measurements (default 300)
+///   -S  seed (default 1)
+
+/*==============================================================================================================*/
+/*                                                Includes                                                      */
+/*==============================================================================================================*/
+#include "bms_sim.h"
+#include "clock_map.h"
+#include "process.h"
+#include "json_formatter.h"
+#include "stats_history.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*==============================================================================================================*/
+/*                                             Private Macros                                                   */
+/*==============================================================================================================*/
+/// Capacity of the Slow Core ring buffer (same as on target)
+#define TS_BUFFER_CAPACITY      100
+
+/// Fast Core period (us)
+#define TS_PERIOD_US            50000
+
+/// Fast Core work per cycle before waiting for the next edge (us)
+#define TS_CYCLE_WORK_US        3000.0
+
+/// Local time of the first SNTP request after boot (Wi-Fi connected, us)
+#define TS_FIRST_REQUEST_US     2000000.0
+
+/// Local time after a lost SNTP request until it is repeated (lwIP SNTP_RETRY_TIMEOUT, us)
+#define TS_RETRY_US             15000000.0
+
+/// Period of crystal error wander (s)
+#define TS_WANDER_PERIOD_S      1800.0
+
+/// UTC at the start of the simulation (ms since the Unix epoch), the run adds a random fraction of a second
+#define TS_EPOCH0_MS            1760000000000LL
+
+/// Marker of samples not started on a wall-clock edge
+#define TS_NO_EDGE              INT32_MIN
+
+/// Pi
+#define TS_PI                   3.14159265358979323846
+
+/*==============================================================================================================*/
+/*                                              Private Types                                                   */
+/*==============================================================================================================*/
+/// Structure of run parameters
+typedef struct {
+    int      devices;           ///< Number of devices
+    double   duration_s;        ///< Simulated duration
+    double   interval_s;        ///< SNTP request interval
+    double   delay_us;          ///< Minimum one-way delay
+    double   jitter_us;         ///< Mean random one-way delay
+    double   loss_pct;          ///< Packet loss
+    double   skew_ppm;          ///< Largest constant crystal error
+    double   wander_ppm;        ///< Crystal error wander amplitude
+    double   latency_us;        ///< Mean wake latency
+    double   warmup_s;          ///< Warm-up excluded from measurements
+    uint32_t seed;              ///< Seed
+} ts_args_t;
+
+/// Structure of the local clock of one device: local time (us since boot) advances by 1 + error per true us
+typedef struct {
+    double boot_us;             ///< True time of boot (us since simulation start)
+    double skew;                ///< Constant crystal error
+    double wander;              ///< Crystal error wander amplitude
+    double phase;               ///< Wander phase (rad)
+} dev_clock_t;
+
+/// Structure of a growing set of values for percentiles
+typedef struct {
+    uint32_t *v;                ///< Values
+    size_t    n;                ///< Number of values
+    size_t    cap;              ///< Allocated values
+} value_set_t;
+
+/// Structure of window starts of all devices in one UTC second
+typedef struct {
+    int32_t  min_us;            ///< Earliest true start relative to the second
+    int32_t  max_us;            ///< Latest true start relative to the second
+    uint16_t devices;           ///< Number of devices with a window in this second
+} join_slot_t;
+
+/// Structure of run totals
+typedef struct {
+    uint64_t    requests;       ///< SNTP requests
+    uint64_t    lost;           ///< Lost requests or replies
+    uint64_t    steps;          ///< Mapping steps after the first sync
+    uint64_t    windows;        ///< Windows
+    uint64_t    unsynced;       ///< Windows without UTC
+    uint64_t    short_windows;  ///< 1 s windows after warm-up without 20 samples
+    uint64_t    discontinuities;///< Consecutive windows not adjacent in UTC
+    uint64_t    json_errors;    ///< Messages without the expected "ts_ms"
+    double      drift_err_ppb;  ///< Largest final drift estimate error
+    value_set_t align;          ///< Window alignment errors
+    value_set_t map_err;        ///< Mapping errors at cycles
+    value_set_t sync_err;       ///< Mapping errors at SNTP samples
+    join_slot_t *join;          ///< Window starts per UTC second
+    size_t      join_len;       ///< Number of seconds in join
+} ts_totals_t;
+
+/*==============================================================================================================*/
+/*                                       Private Function Prototypes                                            */
+/*==============================================================================================================*/
+static void run_device(int index, const ts_args_t *args, ts_totals_t *tot);
+static void drain_windows(bms_sample_buffer_t *buf, bool measure, int64_t *next_ms, ts_totals_t *tot);
+static double dev_mono(const dev_clock_t *clk, double t);
+static double dev_true(const dev_clock_t *clk, double mono);
+static double dev_error(const dev_clock_t *clk, double t);
+static double rand_uniform(void);
+static double rand_exp(double mean);
+static void set_add(value_set_t *set, int64_t value);
+static uint32_t set_pct(value_set_t *set, double p);
+static int cmp_u32(const void *a, const void *b);
+static double now_s(void);
+
+/*==============================================================================================================*/
+/*                                            Private Variables                                                 */
+/*==============================================================================================================*/
+/// Slow Core ring buffer storage
+static bms_sample_t s_samples[TS_BUFFER_CAPACITY];
+/// True start of each buffered sample minus its edge (us), TS_NO_EDGE if not started on an edge
+static int32_t s_edge_err[TS_BUFFER_CAPACITY];
+/// UTC at simulation start (us since the Unix epoch)
+static int64_t s_epoch0_us;
+/// Random generator state
+static uint64_t s_rng;
+
+/*==============================================================================================================*/
+/*                                       Public Function Definitions                                            */
+/*==============================================================================================================*/
+int main(int argc, char **argv)
+{
+    ts_args_t args = {
+        .devices = 8, .duration_s = 3600.0, .interval_s = 60.0, .delay_us = 2000.0, .jitter_us = 1000.0,
+        .loss_pct = 2.0, .skew_ppm = 40.0, .wander_ppm = 2.0, .latency_us = 50.0, .warmup_s = 300.0, .seed = 1,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:i:b:j:l:p:w:L:W:S:")) != -1) {
+        switch (opt) {
+            case 'n': args.devices    = atoi(optarg);                       break;
+            case 'd': args.duration_s = atof(optarg);                       break;
+            case 'i': args.interval_s = atof(optarg);                       break;
+            case 'b': args.delay_us   = atof(optarg);                       break;
+            case 'j': args.jitter_us  = atof(optarg);                       break;
+            case 'l': args.loss_pct   = atof(optarg);                       break;
+            case 'p': args.skew_ppm   = atof(optarg);                       break;
+            case 'w': args.wander_ppm = atof(optarg);                       break;
+            case 'L': args.latency_us = atof(optarg);                       break;
+            case 'W': args.warmup_s   = atof(optarg);                       break;
+            case 'S': args.seed       = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n devices] [-d seconds] [-i interval_s] [-b delay_us] [-j jitter_us] "
+                        "[-l loss_pct] [-p skew_ppm] [-w wander_ppm] [-L latency_us] [-W warmup_s] [-S seed]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (args.devices < 1 || args.devices > 1000 || args.duration_s <= args.warmup_s || args.interval_s < 1.0 ||
+        args.seed == 0) {
+        fprintf(stderr, "invalid arguments (1 <= devices <= 1000, duration > warm-up, interval >= 1 s, "
+                "seed != 0)\n");
+        return 2;
+    }
+
+    s_rng = args.seed;
+    s_epoch0_us = TS_EPOCH0_MS * 1000LL + (int64_t)(rand_uniform() * 1e6);
+    ts_totals_t tot = {0};
+    tot.join_len = (size_t)args.duration_s + 2u;
+    tot.join = calloc(tot.join_len, sizeof(*tot.join));
+    if (!tot.join) {
+        return 1;
+    }
+
+    double start = now_s();
+    for (int d = 0; d < args.devices; ++d) {
+        run_device(d, &args, &tot);
+    }
+    double wall = now_s() - start;
+
+    // Seconds with a window from every device
+    value_set_t spread = {0};
+    size_t joined = 0;
+    size_t seconds = 0;
+    for (size_t k = 0; k < tot.join_len; ++k) {
+        if (tot.join[k].devices == 0) {
+            continue;
+        }
+        seconds++;
+        if (tot.join[k].devices == args.devices) {
+            joined++;
+            set_add(&spread, (int64_t)tot.join[k].max_us - tot.join[k].min_us);
+        }
+    }
+
+    printf("{\"devices\":%d,\"duration_s\":%.0f,\"interval_s\":%.0f,\"requests\":%llu,\"lost\":%llu,\"steps\":%llu,"
+           "\"windows\":%llu,\"unsynced_windows\":%llu,\"short_windows\":%llu,\"discontinuities\":%llu,"
+           "\"json_errors\":%llu,\"align_us\":[%u,%u,%u],\"map_err_us\":[%u,%u,%u],\"sync_err_us\":[%u,%u,%u],"
+           "\"drift_err_ppb\":%.0f,\"join\":{\"seconds\":%zu,\"all_devices\":%zu,\"spread_us\":[%u,%u,%u]},"
+           "\"wall_s\":%.3f}\n",
+           args.devices, args.duration_s, args.interval_s, (unsigned long long)tot.requests,
+           (unsigned long long)tot.lost, (unsigned long long)tot.steps, (unsigned long long)tot.windows,
+           (unsigned long long)tot.unsynced, (unsigned long long)tot.short_windows,
+           (unsigned long long)tot.discontinuities, (unsigned long long)tot.json_errors,
+           set_pct(&tot.align, 0.5), set_pct(&tot.align, 0.99), set_pct(&tot.align, 1.0),
+           set_pct(&tot.map_err, 0.5), set_pct(&tot.map_err, 0.99), set_pct(&tot.map_err, 1.0),
+           set_pct(&tot.sync_err, 0.5), set_pct(&tot.sync_err, 0.99), set_pct(&tot.sync_err, 1.0),
+           tot.drift_err_ppb, seconds, joined,
+           set_pct(&spread, 0.5), set_pct(&spread, 0.99), set_pct(&spread, 1.0), wall);
+
+    return 0;
+}
+
+/*==============================================================================================================*/
+/*                                       Private Function Definitions                                           */
+/*==============================================================================================================*/
+/// This function simulates one device for the whole duration: SNTP exchanges with the stand-in server, Fast Core
+/// cycles on wall-clock edges and Slow Core windows.
+///
+/// \param[in] index Device index
+/// \param[in] args Run parameters
+/// \param[in,out] tot Run totals
+/// \return None
+static void run_device(int index, const ts_args_t *args, ts_totals_t *tot)
+{
+    dev_clock_t clk = {
+        .boot_us = rand_uniform() * 1e6,
+        .skew    = (2.0 * rand_uniform() - 1.0) * args->skew_ppm * 1e-6,
+        .wander  = args->wander_ppm * 1e-6,
+        .phase   = 2.0 * TS_PI * rand_uniform(),
+    };
+
+    bms_sim_config_t cfg;
+    bms_sim_default_config(&cfg);
+    cfg.deterministic = true;
+    cfg.seed = args->seed + (uint32_t)index * 7919u;
+    static bms_sim_t sim;
+    if (bms_sim_inst_init(&sim, &cfg) != ESP_OK) {
+        fprintf(stderr, "bms_sim_inst_init failed\n");
+        exit(1);
+    }
+
+    bms_clock_t map;
+    bms_clock_init(&map);
+    bms_sample_buffer_t buf = { .samples = s_samples, .capacity = TS_BUFFER_CAPACITY };
+    const double end_us = args->duration_s * 1e6;
+    const double warmup_us = args->warmup_s * 1e6;
+
+    double t = clk.boot_us;             // true time of the cycle start
+    double tick_wake = 0.0;             // local time of the last tick-based wake
+    bool on_edge = false;               // cycle started on a wall-clock edge
+    int64_t edge_epoch = 0;             // UTC of that edge
+    double next_request = TS_FIRST_REQUEST_US;
+    bool reply_pending = false;
+    double reply_t = 0.0;
+    int64_t reply_mono = 0;
+    int64_t reply_epoch = 0;
+    int64_t next_ms = 0;
+
+    while (t < end_us) {
+        double mono = dev_mono(&clk, t);
+        bool measure = (t >= warmup_us);
+
+        // SNTP exchange with the stand-in: server time at reception of the request, plus half the round trip
+        // measured with the local clock when the reply arrives
+        if (!reply_pending && mono >= next_request) {
+            double t1 = dev_true(&clk, next_request);
+            tot->requests++;
+            if (rand_uniform() * 100.0 >= args->loss_pct) {
+                next_request += args->interval_s * 1e6;
+                double up = args->delay_us + rand_exp(args->jitter_us);
+                double down = args->delay_us + rand_exp(args->jitter_us);
+                double server_us = (double)s_epoch0_us + t1 + up;
+                reply_t = t1 + up + down;
+                double rtt = dev_mono(&clk, reply_t) - dev_mono(&clk, t1);
+                reply_mono = llround(dev_mono(&clk, reply_t));
+                reply_epoch = llround(server_us + 0.5 * rtt);
+                reply_pending = true;
+            } else {
+                next_request += TS_RETRY_US;
+                tot->lost++;
+            }
+        }
+        if (reply_pending && reply_t <= t) {
+            int64_t mapped;
+            if (measure && bms_clock_to_epoch(&map, reply_mono, &mapped)) {
+                set_add(&tot->sync_err, mapped - llround((double)s_epoch0_us + reply_t));
+            }
+            bms_clock_sync(&map, reply_mono, reply_epoch);
+            reply_pending = false;
+        }
+
+        // Sample of the cycle, stamped with its edge or with the current mapped time
+        int64_t now_epoch;
+        bool synced = bms_clock_to_epoch(&map, llround(mono), &now_epoch);
+        size_t idx = bms_buf_index(&buf, buf.count);
+        bms_sample_t *s = &buf.samples[idx];
+        bms_sim_inst_read_sample(&sim, s);
+        if (on_edge) {
+            s->epoch_ms = (uint64_t)(edge_epoch / 1000);
+            s_edge_err[idx] = (int32_t)llround((double)s_epoch0_us + t - (double)edge_epoch);
+        } else {
+            s->epoch_ms = synced ? (uint64_t)(now_epoch / 1000) : 0;
+            s_edge_err[idx] = TS_NO_EDGE;
+        }
+        buf.count++;
+        if (measure && synced) {
+            set_add(&tot->map_err, now_epoch - llround((double)s_epoch0_us + t));
+        }
+
+        // Slow Core
+        drain_windows(&buf, measure, &next_ms, tot);
+
+        // Fast Core wait: next wall-clock edge via esp_timer, or the tick-based period
+        int64_t edge_mono;
+        if (bms_clock_next_edge(&map, llround(mono + TS_CYCLE_WORK_US), TS_PERIOD_US, &edge_epoch, &edge_mono)) {
+            t = dev_true(&clk, (double)edge_mono) + rand_exp(args->latency_us);
+            tick_wake = dev_mono(&clk, t);
+            on_edge = true;
+        } else {
+            tick_wake += TS_PERIOD_US;
+            t = dev_true(&clk, tick_wake);
+            on_edge = false;
+        }
+    }
+
+    // Drift estimate against the true rate of UTC over the local clock at the end of the run
+    double true_ppb = (1.0 / (1.0 + dev_error(&clk, end_us)) - 1.0) * 1e9;
+    double drift_err = fabs((double)map.drift_ppb - true_ppb);
+    if (drift_err > tot->drift_err_ppb) {
+        tot->drift_err_ppb = drift_err;
+    }
+    tot->steps += map.steps;
+
+    return;
+}
+
+/// This function runs bms_compute_stats() and bms_stats_to_json() on all complete windows of the ring buffer and
+/// records window alignment.
+///
+/// \param[in,out] buf Ring buffer
+/// \param[in] measure True after warm-up
+/// \param[in,out] next_ms Expected start of the next window of the device (0 before the first UTC window)
+/// \param[in,out] tot Run totals
+/// \return None
+static void drain_windows(bms_sample_buffer_t *buf, bool measure, int64_t *next_ms, ts_totals_t *tot)
+{
+    bms_stats_buffer_t stats;
+    char json[BMS_STATS_JSON_MAXLEN];
+    char key[40];
+
+    for (;;) {
+        size_t head = buf->head;
+        if (bms_compute_stats(buf, &stats) == 0) {
+            break;
+        }
+        size_t offset = 0;
+        for (size_t k = 0; k < stats.stats_count; ++k) {
+            const bms_stats_t *st = &stats.stats_array[k];
+            int32_t err = s_edge_err[(head + offset) % buf->capacity];
+            offset += st->sample_count;
+            tot->windows++;
+
+            int len = bms_stats_to_json(st, json, sizeof(json));
+            if (st->epoch_ms == 0) {
+                tot->unsynced++;
+                continue;
+            }
+            snprintf(key, sizeof(key), "\"ts_ms\":%llu,", (unsigned long long)st->epoch_ms);
+            if (len < 0 || !strstr(json, key)) {
+                tot->json_errors++;
+            }
+
+            // 0.2 s windows while limits are violated (several per second, or one starting between seconds)
+            int64_t length_ms = (stats.stats_count > 1 || st->epoch_ms % 1000u != 0) ? 200 : 1000;
+            if (*next_ms != 0 && (int64_t)st->epoch_ms != *next_ms) {
+                tot->discontinuities++;
+            }
+            *next_ms = (int64_t)st->epoch_ms + length_ms;
+
+            if (!measure || err == TS_NO_EDGE) {
+                continue;
+            }
+            set_add(&tot->align, err);
+            if (length_ms == 1000 && st->sample_count != 1000000u / TS_PERIOD_US) {
+                tot->short_windows++;
+            }
+            if (st->epoch_ms % 1000u == 0) {
+                int64_t sec = ((int64_t)st->epoch_ms * 1000LL - s_epoch0_us) / 1000000LL + 1;
+                if (sec >= 0 && (size_t)sec < tot->join_len) {
+                    join_slot_t *slot = &tot->join[sec];
+                    if (slot->devices == 0 || err < slot->min_us) {
+                        slot->min_us = err;
+                    }
+                    if (slot->devices == 0 || err > slot->max_us) {
+                        slot->max_us = err;
+                    }
+                    slot->devices++;
+                }
+            }
+        }
+    }
+
+    return;
+}
+
+/// This function converts true time to local time of a device.
+///
+/// \param[in] clk Device clock
+/// \param[in] t True time (us since simulation start)
+/// \return Local time (us since boot)
+static double dev_mono(const dev_clock_t *clk, double t)
+{
+    double d = t - clk->boot_us;
+    double w = 2.0 * TS_PI / (TS_WANDER_PERIOD_S * 1e6);
+
+    return d + clk->skew * d + clk->wander / w * (cos(clk->phase) - cos(w * d + clk->phase));
+}
+
+/// This function converts local time of a device to true time (Newton iteration).
+///
+/// \param[in] clk Device clock
+/// \param[in] mono Local time (us since boot)
+/// \return True time (us since simulation start)
+static double dev_true(const dev_clock_t *clk, double mono)
+{
+    double t = clk->boot_us + mono / (1.0 + clk->skew);
+    for (int i = 0; i < 3; ++i) {
+        t -= (dev_mono(clk, t) - mono) / (1.0 + dev_error(clk, t));
+    }
+
+    return t;
+}
+
+/// This function gets the crystal error of a device.
+///
+/// \param[in] clk Device clock
+/// \param[in] t True time (us since simulation start)
+/// \return Local clock rate minus one
+static double dev_error(const dev_clock_t *clk, double t)
+{
+    double w = 2.0 * TS_PI / (TS_WANDER_PERIOD_S * 1e6);
+
+    return clk->skew + clk->wander * sin(w * (t - clk->boot_us) + clk->phase);
+}
+
+/// This function returns a uniform random number (splitmix64).
+///
+/// \param None
+/// \return Number in (0, 1)
+static double rand_uniform(void)
+{
+    uint64_t z = (s_rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    return ((double)(z >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/// This function returns an exponentially distributed random number.
+///
+/// \param[in] mean Mean
+/// \return Number >= 0
+static double rand_exp(double mean)
+{
+    return -mean * log(rand_uniform());
+}
+
+/// This function adds the magnitude of a value to a set.
+///
+/// \param[in,out] set Set
+/// \param[in] value Value
+/// \return None
+static void set_add(value_set_t *set, int64_t value)
+{
+    if (set->n == set->cap) {
+        size_t cap = set->cap ? 2 * set->cap : 4096;
+        uint32_t *v = realloc(set->v, cap * sizeof(*v));
+        if (!v) {
+            return;
+        }
+        set->v = v;
+        set->cap = cap;
+    }
+    uint64_t mag = (uint64_t)((value < 0) ? -value : value);
+    set->v[set->n++] = (mag > UINT32_MAX) ? UINT32_MAX : (uint32_t)mag;
+
+    return;
+}
+
+/// This function gets a percentile of a set (nearest rank). The set is sorted.
+///
+/// \param[in,out] set Set
+/// \param[in] p Percentile (0 .. 1)
+/// \return Value, 0 for an empty set
+static uint32_t set_pct(value_set_t *set, double p)
+{
+    if (set->n == 0) {
+        return 0;
+    }
+    qsort(set->v, set->n, sizeof(*set->v), cmp_u32);
+    size_t rank = (size_t)ceil(p * (double)set->n);
+
+    return set->v[(rank > 0) ? rank - 1 : 0];
+}
+
+/// This function compares two values for qsort().
+///
+/// \param[in] a First value
+/// \param[in] b Second value
+/// \return Negative, zero or positive
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/// This function returns monotonic time in seconds.
+///
+/// \param None
+/// \return Time in seconds
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,371 @@
+"""Bridge BMS statistics from MQTT to InfluxDB 2 line protocol.
+
+Replaces the Telegraf json_v2 pipeline for BMS topics. Messages are decoded by a schema (schema.json) instead of
+one hand-written block per field. Array fields expand to one field per element (cell_v_avg -> cell_v_avg_0 ..
+cell_v_avg_N-1), so any cell count works without configuration changes. Per-cell bit masks (cell_uv, cell_ov,
+anomaly.alarm) are a number up to 32 cells and an array of 32-bit words beyond; mask fields keep cells 0-31 in
+the field itself and expand further words to <field>_1 .. <field>_K-1. Measurement, tag and field names match
+the Telegraf configuration, so existing buckets and the Grafana dashboard keep working. Numeric fields are
+written as floats like Telegraf json_v2 does, to avoid field type conflicts with data already in the bucket.
+
+Decoded points are batched and written with gzip to /api/v2/write. A batch is written when it is full or when
+the flush interval expires. Failed writes are retried with backoff. When the buffer limit is reached, the oldest
+lines are dropped. Every report interval, the bridge prints messages per second and the lag from reception to
+acknowledged write. If messages carry the latency probe object (CONFIG_BMS_LATENCY_PROBE), it also prints the
+lag from device serialization to write. That lag needs synchronized clocks.
+
+Points are stamped with the reception time, or with the time in the message if the schema names one ("time").
+Devices with CONFIG_BMS_TIMESYNC publish the UTC start of each window as "ts_ms", so windows of different devices
+land on the same timestamps and can be joined without resampling.
+
+Usage:
+  python influx_bridge.py --mqtt-host localhost --influx-url http://localhost:8086 --org bms --bucket bms \\
+      --token $INFLUX_TOKEN
+  python influx_bridge.py --dry-run          # print line protocol instead of writing
+"""
+
+import argparse
+import gzip
+import json
+import os
+import queue
+import sys
+import threading
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+
+import paho.mqtt.client as mqtt
+
+# Wall clock stamps before 2020-01-01 mean the device clock was never set
+MIN_VALID_WALL_US = 1577836800 * 1_000_000
+
+# Nanoseconds per unit of message timestamps
+TIME_UNIT_NS = {"s": 1_000_000_000, "ms": 1_000_000, "us": 1_000, "ns": 1}
+
+
+def _escape_key(text: str) -> str:
+    """Escape measurement, tag key, tag value or field key for line protocol."""
+    return text.replace("\\", "\\\\").replace(",", "\\,").replace("=", "\\=").replace(" ", "\\ ")
+
+
+def _escape_measurement(text: str) -> str:
+    return text.replace("\\", "\\\\").replace(",", "\\,").replace(" ", "\\ ")
+
+
+def _format_field(value, kind: str):
+    """Format field value for line protocol, None if value does not match the field type."""
+    if kind == "string":
+        if not isinstance(value, str):
+            return None
+        return '"' + value.replace("\\", "\\\\").replace('"', '\\"') + '"'
+    if kind == "bool":
+        return "true" if value else "false"
+    if isinstance(value, bool) or not isinstance(value, (int, float)):
+        return None
+    if kind == "int":
+        return f"{int(value)}i"
+    return repr(float(value))
+
+
+class JsonDecoder:
+    """Schema-driven decoder of JSON statistics messages into line protocol."""
+
+    def __init__(self, schema: dict):
+        self.measurement = _escape_measurement(schema.get("measurement", "mqtt_consumer"))
+        self.tags = [(spec["path"].split("."), _escape_key(self._name(spec))) for spec in schema.get("tags", [])]
+        self.fields = [
+            (spec["path"].split("."), _escape_key(self._name(spec)), spec.get("type", "float"),
+             "mask" if spec.get("mask") else "array" if spec.get("array") else None)
+            for spec in schema.get("fields", [])
+        ]
+        time_spec = schema.get("time")
+        self.time_keys = time_spec["path"].split(".") if time_spec else None
+        self.time_unit_ns = TIME_UNIT_NS[time_spec.get("unit", "ns")] if time_spec else 1
+
+    @staticmethod
+    def _name(spec: dict) -> str:
+        return spec.get("name", spec["path"].replace(".", "_"))
+
+    @staticmethod
+    def _get(msg: dict, keys: list):
+        for key in keys:
+            if not isinstance(msg, dict) or key not in msg:
+                return None
+            msg = msg[key]
+        return msg
+
+    def decode(self, topic: str, payload: bytes, time_ns: int):
+        """Return (line, message) or (None, None) if payload is not a JSON object."""
+        try:
+            msg = json.loads(payload)
+        except ValueError:
+            return None, None
+        if not isinstance(msg, dict):
+            return None, None
+
+        tags = [f"topic={_escape_key(topic)}"]
+        for keys, name in self.tags:
+            value = self._get(msg, keys)
+            if value is not None and value != "":
+                tags.append(f"{name}={_escape_key(str(value))}")
+        # Line protocol expects tags sorted by key for best write performance
+        tags.sort()
+
+        fields = []
+        for keys, name, kind, shape in self.fields:
+            value = self._get(msg, keys)
+            if value is None:
+                continue
+            if shape == "mask" and isinstance(value, list):
+                # Word 0 (cells 0-31) keeps the scalar field name, so queries work for any layout
+                for i, element in enumerate(value):
+                    text = _format_field(element, kind)
+                    if text is not None:
+                        fields.append(f"{name}={text}" if i == 0 else f"{name}_{i}={text}")
+            elif shape == "array":
+                if not isinstance(value, list):
+                    continue
+                for i, element in enumerate(value):
+                    text = _format_field(element, kind)
+                    if text is not None:
+                        fields.append(f"{name}_{i}={text}")
+            else:
+                text = _format_field(value, kind)
+                if text is not None:
+                    fields.append(f"{name}={text}")
+
+        if not fields:
+            return None, None
+        # Device time if present and set, otherwise reception time
+        if self.time_keys:
+            stamp = self._get(msg, self.time_keys)
+            if isinstance(stamp, int) and not isinstance(stamp, bool) and \
+                    stamp * self.time_unit_ns >= MIN_VALID_WALL_US * 1000:
+                time_ns = stamp * self.time_unit_ns
+        return f"{self.measurement},{','.join(tags)} {','.join(fields)} {time_ns}", msg
+
+
+def make_decoder(schema: dict):
+    """Create the decoder for the schema's payload format (only "json" so far)."""
+    fmt = schema.get("format", "json")
+    if fmt == "json":
+        return JsonDecoder(schema)
+    raise ValueError(f"unsupported payload format: {fmt}")
+
+
+class InfluxWriter:
+    """Writes batches of line protocol to InfluxDB 2, or to stdout in dry-run mode."""
+
+    def __init__(self, url: str, org: str, bucket: str, token: str, dry_run: bool):
+        query = urllib.parse.urlencode({"org": org, "bucket": bucket, "precision": "ns"})
+        self.url = url.rstrip("/") + "/api/v2/write?" + query
+        self.token = token
+        self.dry_run = dry_run
+
+    def write(self, lines: list):
+        body = ("\n".join(lines) + "\n").encode("utf-8")
+        if self.dry_run:
+            sys.stdout.write(body.decode("utf-8"))
+            sys.stdout.flush()
+            return
+        request = urllib.request.Request(self.url, data=gzip.compress(body, compresslevel=1), method="POST")
+        request.add_header("Authorization", f"Token {self.token}")
+        request.add_header("Content-Type", "text/plain; charset=utf-8")
+        request.add_header("Content-Encoding", "gzip")
+        with urllib.request.urlopen(request, timeout=10) as response:
+            response.read()
+
+
+class Stats:
+    """Counters and lag samples of one report interval."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        self.messages = 0
+        self.undecodable = 0
+        self.lines = 0
+        self.batches = 0
+        self.write_errors = 0
+        self.dropped = 0
+        self.lag_ms = []
+        self.device_lag_ms = []
+
+    def report(self, interval_s: float, pending: int):
+        with self.lock:
+            lag = sorted(self.lag_ms)
+            device_lag = sorted(self.device_lag_ms)
+
+            def pct(values, p):
+                return values[min(len(values) - 1, int(p / 100.0 * len(values)))] if values else float("nan")
+
+            line = (f"{self.messages / interval_s:7.1f} msg/s  lines {self.lines}  batches {self.batches}  "
+                    f"pending {pending}  errors {self.write_errors}  dropped {self.dropped}  "
+                    f"undecodable {self.undecodable}  lag ms p50 {pct(lag, 50):.1f} max {pct(lag, 100):.1f}")
+            if device_lag:
+                line += f"  device lag ms p50 {pct(device_lag, 50):.1f} max {pct(device_lag, 100):.1f}"
+            self.reset()
+        print(line, file=sys.stderr, flush=True)
+
+
+class Bridge:
+    """Decodes received messages and writes them in batches from one worker thread."""
+
+    def __init__(self, decoder, writer: InfluxWriter, args):
+        self.decoder = decoder
+        self.writer = writer
+        self.batch_size = args.batch_size
+        self.flush_interval = args.flush_interval
+        self.max_buffer = args.max_buffer
+        self.received = queue.Queue()
+        self.stats = Stats()
+        self.stop = threading.Event()
+        # Pending lines with reception time (ns) and device serialization wall time (us, 0 if unknown)
+        self.pending = []
+
+    def on_message(self, topic: str, payload: bytes):
+        # Reception stamp in the MQTT thread, decoding happens in the worker
+        self.received.put((time.time_ns(), topic, payload))
+
+    def run(self):
+        last_flush = time.monotonic()
+        retry_at = 0.0
+        backoff = 0.0
+        while True:
+            stopping = self.stop.is_set()
+            # On stop, drain received messages and pending lines, but give up if writes are failing
+            if stopping and self.received.empty() and (not self.pending or backoff):
+                break
+            try:
+                wait = self.flush_interval - (time.monotonic() - last_flush)
+                recv_ns, topic, payload = self.received.get(timeout=min(max(wait, 0.0), 0.1))
+                self._decode(recv_ns, topic, payload)
+                # Drain what is already queued before considering a write
+                while len(self.pending) < self.batch_size:
+                    recv_ns, topic, payload = self.received.get_nowait()
+                    self._decode(recv_ns, topic, payload)
+            except queue.Empty:
+                pass
+
+            now = time.monotonic()
+            due = len(self.pending) >= self.batch_size or now - last_flush >= self.flush_interval or stopping
+            if self.pending and due and now >= retry_at:
+                if self._flush():
+                    backoff = 0.0
+                else:
+                    backoff = min(max(2.0 * backoff, 0.5), 30.0)
+                    retry_at = now + backoff
+                last_flush = now
+            elif now - last_flush >= self.flush_interval:
+                last_flush = now
+
+    def _decode(self, recv_ns: int, topic: str, payload: bytes):
+        line, msg = self.decoder.decode(topic, payload, recv_ns)
+        with self.stats.lock:
+            self.stats.messages += 1
+            if line is None:
+                self.stats.undecodable += 1
+                return
+        wall_us = 0
+        lat = msg.get("lat")
+        if isinstance(lat, dict) and isinstance(lat.get("wall"), int) and lat["wall"] >= MIN_VALID_WALL_US:
+            wall_us = lat["wall"]
+        self.pending.append((line, recv_ns, wall_us))
+        if len(self.pending) > self.max_buffer:
+            drop = len(self.pending) - self.max_buffer
+            del self.pending[:drop]
+            with self.stats.lock:
+                self.stats.dropped += drop
+
+    def _flush(self) -> bool:
+        batch = self.pending[:self.batch_size]
+        try:
+            self.writer.write([line for line, _, _ in batch])
+        except (urllib.error.URLError, OSError) as e:
+            with self.stats.lock:
+                self.stats.write_errors += 1
+            print(f"write failed ({len(batch)} lines kept): {e}", file=sys.stderr, flush=True)
+            return False
+        done_ns = time.time_ns()
+        del self.pending[:len(batch)]
+        with self.stats.lock:
+            self.stats.lines += len(batch)
+            self.stats.batches += 1
+            for _, recv_ns, wall_us in batch:
+                self.stats.lag_ms.append((done_ns - recv_ns) / 1e6)
+                if wall_us:
+                    self.stats.device_lag_ms.append((done_ns / 1e3 - wall_us) / 1e3)
+        return True
+
+
+def make_client(client_id: str) -> mqtt.Client:
+    # paho-mqtt 2.x requires the callback API version, 1.x does not know it
+    if hasattr(mqtt, "CallbackAPIVersion"):
+        return mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id=client_id)
+    return mqtt.Client(client_id=client_id)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="BMS MQTT to InfluxDB bridge")
+    parser.add_argument("--mqtt-host", default="localhost")
+    parser.add_argument("--mqtt-port", type=int, default=1883)
+    parser.add_argument("--topic", action="append", help="topic to subscribe (default: topics from schema)")
+    parser.add_argument("--schema", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "schema.json"))
+    parser.add_argument("--influx-url", default="http://localhost:8086")
+    parser.add_argument("--org", default="bms")
+    parser.add_argument("--bucket", default="bms")
+    parser.add_argument("--token", default=os.environ.get("INFLUX_TOKEN", ""), help="default: $INFLUX_TOKEN")
+    parser.add_argument("--batch-size", type=int, default=5000, help="lines per write request")
+    parser.add_argument("--flush-interval", type=float, default=1.0, help="max. seconds between writes")
+    parser.add_argument("--max-buffer", type=int, default=200000, help="max. pending lines before dropping")
+    parser.add_argument("--report-interval", type=float, default=10.0, help="seconds between statistics lines")
+    parser.add_argument("--duration", type=float, default=0.0, help="stop after this many seconds (0: no limit)")
+    parser.add_argument("--dry-run", action="store_true", help="print line protocol to stdout, do not write")
+    args = parser.parse_args()
+
+    with open(args.schema, encoding="utf-8") as f:
+        schema = json.load(f)
+    topics = args.topic or schema.get("topics", ["bms/esp32/stats"])
+
+    bridge = Bridge(make_decoder(schema), InfluxWriter(args.influx_url, args.org, args.bucket, args.token,
+                                                       args.dry_run), args)
+
+    client = make_client(f"bms-influx-bridge-{os.getpid()}")
+
+    def on_connect(c, userdata, flags, reason_code, properties=None):
+        for topic in topics:
+            c.subscribe(topic, qos=0)
+
+    client.on_connect = on_connect
+    client.on_message = lambda c, userdata, message: bridge.on_message(message.topic, message.payload)
+    client.connect(args.mqtt_host, args.mqtt_port, keepalive=60)
+    client.loop_start()
+
+    worker = threading.Thread(target=bridge.run, daemon=True)
+    worker.start()
+
+    start = time.monotonic()
+    last_report = start
+    try:
+        while not args.duration or time.monotonic() - start < args.duration:
+            time.sleep(min(0.2, args.report_interval))
+            now = time.monotonic()
+            if now - last_report >= args.report_interval:
+                bridge.stats.report(now - last_report, len(bridge.pending))
+                last_report = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.loop_stop()
+        client.disconnect()
+        bridge.stop.set()
+        worker.join(timeout=15)
+        bridge.stats.report(max(time.monotonic() - last_report, 1e-3), len(bridge.pending))
+
+
+if __name__ == "__main__":
+    main()
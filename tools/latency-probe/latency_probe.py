@@ -0,0 +1,204 @@
+"""Measure acquisition to delivery latency of BMS statistics messages.
+
+Requires firmware built with CONFIG_BMS_LATENCY_PROBE, which adds a "lat" object to every message published on
+bms/esp32/stats. Device stamps are microseconds since boot (32-bit, wrapping); stages measured on the device are
+differences of these stamps. Delivery (publish to this subscriber) is measured in one of two modes:
+
+  sync  Device wall clock at serialization ("wall") is compared with reception time on this host. Needs both
+        clocks synchronized (SNTP/NTP); messages from a device without a valid wall clock are skipped.
+  echo  Every received "lat" object is published back to bms/esp32/latency/echo. The device measures the round
+        trip with its own clock and reports it in a later message; delivery is estimated as half of it. All devices
+        share the echo topic, so echoes carry the device ID ("dev") and devices ignore echoes of others.
+
+Usage:
+  python latency_probe.py --host localhost --mode echo --count 300
+  python latency_probe.py --mode sync --duration 600 --csv latency.csv
+"""
+
+import argparse
+import csv
+import json
+import math
+import sys
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+
+STATS_TOPIC = "bms/esp32/stats"
+ECHO_TOPIC = "bms/esp32/latency/echo"
+
+# Wall clock stamps before 2020-01-01 mean the device clock was never set
+MIN_VALID_WALL_US = 1577836800 * 1_000_000
+
+# Stages in pipeline order: (name, description)
+STAGES = [
+    ("window", "first to last sample acquisition"),
+    ("enqueue", "last sample acquisition to enqueue"),
+    ("queue", "enqueue to statistics done (queue and ring buffer wait)"),
+    ("serialize", "statistics done to JSON serialization"),
+    ("publish", "publish call duration"),
+    ("device", "last sample acquisition to serialization"),
+    ("delivery", "serialization to reception by subscriber"),
+    ("end_to_end", "last sample acquisition to reception by subscriber"),
+]
+
+
+def wrap_diff(later: int, earlier: int) -> int:
+    """Difference of two 32-bit microsecond stamps, correct across wrap."""
+    return (later - earlier) & 0xFFFFFFFF
+
+
+def percentile(sorted_values: list, p: float) -> float:
+    """Nearest-rank percentile of an already sorted list."""
+    if not sorted_values:
+        return math.nan
+    rank = max(1, math.ceil(p / 100.0 * len(sorted_values)))
+    return sorted_values[rank - 1]
+
+
+class LatencyProbe:
+    """Collects per-stage latencies from received messages."""
+
+    def __init__(self, mode: str, client: mqtt.Client):
+        self.mode = mode
+        self.client = client
+        self.samples = {name: [] for name, _ in STAGES}
+        self.rows = []
+        self.received = 0
+        self.skipped = 0
+        self.last_echoes = {}  # dev -> echo counter of the last message
+        self.device_us = {}  # (dev, seq) -> last sample acquisition to serialization, for echo mode end-to-end
+        self.lock = threading.Lock()
+
+    def on_message(self, recv_wall_us: int, payload: bytes):
+        try:
+            msg = json.loads(payload)
+        except ValueError:
+            return
+        lat = msg.get("lat")
+        if not isinstance(lat, dict):
+            with self.lock:
+                self.skipped += 1
+            return
+
+        if self.mode == "echo":
+            # Echo immediately, device measures round trip from its serialization stamp
+            echo = json.dumps({"dev": lat["dev"], "seq": lat["seq"], "ser": lat["ser"]}, separators=(",", ":"))
+            self.client.publish(ECHO_TOPIC, echo, qos=0)
+
+        dev = lat["dev"]
+        row = {
+            "dev": dev,
+            "seq": lat["seq"],
+            "window": wrap_diff(lat["acq1"], lat["acq0"]),
+            "enqueue": wrap_diff(lat["enq1"], lat["acq1"]),
+            "queue": wrap_diff(lat["stats"], lat["enq1"]),
+            "serialize": wrap_diff(lat["ser"], lat["stats"]),
+            "device": wrap_diff(lat["ser"], lat["acq1"]),
+        }
+        # Previous publish call belongs to the previous message, first message has none
+        if lat["pub_prev"] > 0:
+            row["publish"] = lat["pub_prev"]
+
+        with self.lock:
+            self.received += 1
+            if self.mode == "sync":
+                if lat["wall"] >= MIN_VALID_WALL_US:
+                    row["delivery"] = recv_wall_us - lat["wall"]
+                    row["end_to_end"] = row["device"] + row["delivery"]
+                else:
+                    self.skipped += 1
+            else:
+                self.device_us[(dev, lat["seq"])] = row["device"]
+                # New echo reported: round trip of an earlier message of the same device
+                if lat["echoes"] != self.last_echoes.get(dev, 0):
+                    self.last_echoes[dev] = lat["echoes"]
+                    delivery = lat["rtt"] // 2
+                    device = self.device_us.pop((dev, lat["echo_seq"]), None)
+                    if device is not None:
+                        row["delivery"] = delivery
+                        row["end_to_end"] = device + delivery
+                # Keep map bounded if echoes are lost
+                while len(self.device_us) > 1000 * len(self.last_echoes) + 1000:
+                    self.device_us.pop(next(iter(self.device_us)))
+
+            for name, _ in STAGES:
+                if name in row:
+                    self.samples[name].append(row[name])
+            self.rows.append(row)
+
+    def report(self, out=sys.stdout):
+        with self.lock:
+            print(f"messages: {self.received} received, {self.skipped} without usable stamps "
+                  f"(mode {self.mode})", file=out)
+            print(f"{'stage':<11} {'n':>6} {'min':>9} {'p50':>9} {'p90':>9} {'p99':>9} {'max':>9}  [ms]", file=out)
+            for name, desc in STAGES:
+                values = sorted(self.samples[name])
+                if not values:
+                    print(f"{name:<11} {0:>6}  ({desc}: no data)", file=out)
+                    continue
+                cols = [values[0], percentile(values, 50), percentile(values, 90), percentile(values, 99),
+                        values[-1]]
+                print(f"{name:<11} {len(values):>6} " + " ".join(f"{v / 1000.0:>9.3f}" for v in cols), file=out)
+
+    def write_csv(self, path: str):
+        with self.lock, open(path, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=["dev", "seq"] + [name for name, _ in STAGES])
+            writer.writeheader()
+            writer.writerows(self.rows)
+
+
+def make_client() -> mqtt.Client:
+    # paho-mqtt 2.x requires the callback API version, 1.x does not know it
+    if hasattr(mqtt, "CallbackAPIVersion"):
+        return mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id="bms-latency-probe")
+    return mqtt.Client(client_id="bms-latency-probe")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="BMS acquisition to delivery latency probe")
+    parser.add_argument("--host", default="localhost", help="MQTT broker host")
+    parser.add_argument("--port", type=int, default=1883, help="MQTT broker port")
+    parser.add_argument("--topic", default=STATS_TOPIC, help="statistics topic")
+    parser.add_argument("--mode", choices=["sync", "echo"], default="sync",
+                        help="delivery measurement: synchronized clocks or device round trip")
+    parser.add_argument("--count", type=int, default=0, help="stop after this many messages (0: no limit)")
+    parser.add_argument("--duration", type=float, default=0.0, help="stop after this many seconds (0: no limit)")
+    parser.add_argument("--csv", help="write per-message stage latencies (us) to this file")
+    args = parser.parse_args()
+
+    client = make_client()
+    probe = LatencyProbe(args.mode, client)
+    done = threading.Event()
+
+    def on_connect(c, userdata, flags, reason_code, properties=None):
+        c.subscribe(args.topic, qos=0)
+
+    def on_message(c, userdata, message):
+        # Reception stamp first, before any parsing
+        recv_wall_us = time.time_ns() // 1000
+        probe.on_message(recv_wall_us, message.payload)
+        if args.count and probe.received >= args.count:
+            done.set()
+
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.host, args.port, keepalive=60)
+    client.loop_start()
+
+    try:
+        done.wait(timeout=args.duration if args.duration > 0 else None)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.loop_stop()
+        client.disconnect()
+
+    probe.report()
+    if args.csv:
+        probe.write_csv(args.csv)
+
+
+if __name__ == "__main__":
+    main()
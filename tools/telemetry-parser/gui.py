@@ -1,14 +1,23 @@
 """Tkinter GUI for the LTC6804 telemetry parser."""
 
+import multiprocessing
 import os
+import queue
+import threading
 import tkinter as tk
 from tkinter import filedialog, messagebox, ttk
 
 from tkinterdnd2 import DND_FILES, TkinterDnD
 
-from parse_telemetry import parse_file
+from parse_telemetry import FORMATS, convert_files, iter_blocks
 from version import APP_NAME, VERSION
 
+# Number of records shown in the preview (conversion always processes whole files)
+PREVIEW_RECORDS = 200
+
+# Interval of polling background work from the Tk main loop in milliseconds
+POLL_MS = 100
+
 
 class TelemetryParserGUI:
     def __init__(self, root: TkinterDnD.Tk):
@@ -17,7 +26,15 @@ class TelemetryParserGUI:
         self.root.geometry("1200x800")
         self.root.minsize(600, 400)
 
-        self.parsed_output = ""
+        self.paths = []
+        # Messages from worker threads: ("preview", text), ("progress", path, done, total),
+        # ("file_done", in_path, out_path, result), ("finished", None)
+        self.events = queue.Queue()
+        self.busy = False
+        # Bytes read per input file, total bytes of all files and per-file results of running conversion
+        self.progress = {}
+        self.progress_total = 1
+        self.results = []
 
         self._build_ui()
         self._setup_dnd()
@@ -33,10 +50,16 @@ class TelemetryParserGUI:
         self.browse_btn.pack(side=tk.LEFT)
 
         self.save_btn = ttk.Button(
-            top_frame, text="Save As...", command=self._save_as, state=tk.DISABLED
+            top_frame, text="Convert To...", command=self._save_as, state=tk.DISABLED
         )
         self.save_btn.pack(side=tk.LEFT, padx=(10, 0))
 
+        self.format_var = tk.StringVar(value="text")
+        format_box = ttk.Combobox(
+            top_frame, textvariable=self.format_var, values=list(FORMATS), state="readonly", width=8
+        )
+        format_box.pack(side=tk.LEFT, padx=(10, 0))
+
         self.file_var = tk.StringVar(value="No file loaded")
         file_entry = ttk.Entry(top_frame, textvariable=self.file_var, state="readonly")
         file_entry.pack(side=tk.LEFT, padx=(15, 0), fill=tk.X, expand=True)
@@ -44,11 +67,19 @@ class TelemetryParserGUI:
         # Drop hint label
         self.drop_hint = ttk.Label(
             self.root,
-            text="Drop a CSV file here or use Browse",
+            text="Drop CSV files here or use Browse",
             foreground="gray",
         )
         self.drop_hint.pack(pady=(0, 5))
 
+        # Progress bar and status line of background conversion
+        status_frame = ttk.Frame(self.root)
+        status_frame.pack(fill=tk.X, padx=10, pady=(0, 5))
+        self.progress_bar = ttk.Progressbar(status_frame, mode="determinate", maximum=1000)
+        self.progress_bar.pack(side=tk.LEFT, fill=tk.X, expand=True)
+        self.status_var = tk.StringVar(value="")
+        ttk.Label(status_frame, textvariable=self.status_var, width=50).pack(side=tk.LEFT, padx=(10, 0))
+
         # Text area with ttk scrollbar
         text_frame = ttk.Frame(self.root)
         text_frame.pack(fill=tk.BOTH, expand=True, padx=10, pady=(0, 10))
@@ -67,50 +98,158 @@ class TelemetryParserGUI:
         self.text_area.dnd_bind("<<Drop>>", self._on_drop)
 
     def _on_drop(self, event):
-        path = event.data.strip()
-        # tkinterdnd2 may wrap path in braces on some platforms
-        if path.startswith("{") and path.endswith("}"):
-            path = path[1:-1]
-        self._load_file(path)
+        # tkinterdnd2 passes a Tcl list, paths with spaces are wrapped in braces
+        paths = list(self.root.tk.splitlist(event.data))
+        if paths:
+            self._load_files(paths)
 
     def _browse_file(self):
-        path = filedialog.askopenfilename(
+        paths = filedialog.askopenfilenames(
             parent=self.root,
             title="Select telemetry CSV",
             filetypes=[("CSV files", "*.csv"), ("All files", "*.*")],
         )
-        if path:
-            self._load_file(path)
-
-    def _load_file(self, path: str):
-        try:
-            self.parsed_output = parse_file(path)
-        except Exception as e:
-            messagebox.showerror("Error", f"Failed to parse file:\n{e}")
-            return
+        if paths:
+            self._load_files(list(paths))
 
-        self.file_var.set(path)
+    def _load_files(self, paths: list):
+        if self.busy:
+            return
+        self.paths = paths
+        if len(paths) == 1:
+            self.file_var.set(paths[0])
+        else:
+            self.file_var.set(f"{len(paths)} files: {', '.join(map(os.path.basename, paths))}")
         self.drop_hint.pack_forget()
+        self._set_text("")
+        self.status_var.set("Loading preview...")
 
-        self.text_area.config(state=tk.NORMAL)
-        self.text_area.delete("1.0", tk.END)
-        self.text_area.insert(tk.END, self.parsed_output)
-        self.text_area.config(state=tk.DISABLED)
+        # Preview of the first file is read in background, only the first records are formatted
+        def worker():
+            try:
+                separator = "-" * 60 + "\n"
+                text = separator.join(iter_blocks(paths[0], PREVIEW_RECORDS))
+                self.events.put(("preview", text))
+            except Exception as e:
+                self.events.put(("error", f"Failed to parse file:\n{e}"))
 
-        self.save_btn.config(state=tk.NORMAL)
+        self._start(worker)
 
     def _save_as(self):
-        path = filedialog.asksaveasfilename(
-            parent=self.root,
-            title="Save parsed output",
-            defaultextension=".txt",
-            filetypes=[("Text files", "*.txt"), ("All files", "*.*")],
-        )
-        if not path:
-            return
-        try:
-            with open(path, "w", encoding="utf-8") as f:
-                f.write(self.parsed_output)
-            messagebox.showinfo("Saved", f"Output saved to:\n{path}")
-        except Exception as e:
-            messagebox.showerror("Error", f"Failed to save file:\n{e}")
+        fmt = self.format_var.get()
+        if len(self.paths) == 1:
+            ext = FORMATS[fmt]
+            out = filedialog.asksaveasfilename(
+                parent=self.root,
+                title="Save parsed output",
+                defaultextension=ext,
+                filetypes=[(f"{fmt} files", f"*{ext}"), ("All files", "*.*")],
+            )
+            if not out:
+                return
+            out_dir = os.path.dirname(out)
+            rename = (self.paths[0], out)
+        else:
+            out_dir = filedialog.askdirectory(parent=self.root, title="Output directory")
+            if not out_dir:
+                return
+            rename = None
+
+        paths = list(self.paths)
+        total = {p: max(os.path.getsize(p), 1) for p in paths}
+        self.progress = {p: 0 for p in paths}
+        self.progress_total = sum(total.values())
+        self.results = []
+
+        # Files are converted in worker processes, this thread only forwards their results and progress
+        def worker():
+            try:
+                convert(paths)
+            except Exception as e:
+                self.events.put(("file_done", paths[0], "", e))
+            self.events.put(("finished", None))
+
+        def convert(paths):
+            with multiprocessing.Manager() as manager:
+                progress_queue = manager.Queue()
+                stop = threading.Event()
+
+                def forward_progress():
+                    while not stop.is_set() or not progress_queue.empty():
+                        try:
+                            path, done, size = progress_queue.get(timeout=0.1)
+                        except queue.Empty:
+                            continue
+                        self.events.put(("progress", path, done, size))
+
+                forwarder = threading.Thread(target=forward_progress, daemon=True)
+                forwarder.start()
+                for in_path, out_path, result in convert_files(paths, out_dir, fmt, queue=progress_queue):
+                    if rename and not isinstance(result, Exception) and out_path != rename[1]:
+                        os.replace(out_path, rename[1])
+                        out_path = rename[1]
+                    self.events.put(("file_done", in_path, out_path, result))
+                stop.set()
+                forwarder.join()
+
+        self.status_var.set(f"Converting {len(paths)} file(s) to {fmt}...")
+        self._start(worker)
+
+    def _start(self, worker):
+        self.busy = True
+        self.browse_btn.config(state=tk.DISABLED)
+        self.save_btn.config(state=tk.DISABLED)
+        threading.Thread(target=worker, daemon=True).start()
+        self.root.after(POLL_MS, self._poll)
+
+    def _finish(self):
+        self.busy = False
+        self.browse_btn.config(state=tk.NORMAL)
+        self.save_btn.config(state=tk.NORMAL if self.paths else tk.DISABLED)
+
+    def _poll(self):
+        done = False
+        while True:
+            try:
+                event = self.events.get_nowait()
+            except queue.Empty:
+                break
+            kind = event[0]
+            if kind == "preview":
+                self._set_text(event[1] or "(no rows with LTC6804 telemetry)")
+                name = os.path.basename(self.paths[0])
+                self.status_var.set(f"Preview: first {PREVIEW_RECORDS} records of {name}")
+                done = True
+            elif kind == "error":
+                messagebox.showerror("Error", event[1])
+                self.status_var.set("")
+                self.paths = []
+                done = True
+            elif kind == "progress":
+                _, path, value, _ = event
+                self.progress[path] = value
+                self.progress_bar["value"] = 1000 * sum(self.progress.values()) / self.progress_total
+            elif kind == "file_done":
+                self.results.append(event[1:])
+            elif kind == "finished":
+                self.progress_bar["value"] = 1000
+                lines = []
+                for in_path, out_path, result in self.results:
+                    if isinstance(result, Exception):
+                        lines.append(f"{os.path.basename(in_path)}: FAILED ({result})")
+                    else:
+                        lines.append(f"{os.path.basename(in_path)} -> {out_path}: {result} records")
+                self.status_var.set("Conversion finished")
+                messagebox.showinfo("Converted", "\n".join(lines))
+                done = True
+
+        if done:
+            self._finish()
+        else:
+            self.root.after(POLL_MS, self._poll)
+
+    def _set_text(self, text: str):
+        self.text_area.config(state=tk.NORMAL)
+        self.text_area.delete("1.0", tk.END)
+        self.text_area.insert(tk.END, text)
+        self.text_area.config(state=tk.DISABLED)
@@ -1,11 +1,15 @@
 """Entry point for the LTC6804 Telemetry Parser GUI."""
 
+import multiprocessing
+
 from tkinterdnd2 import TkinterDnD
 
 from gui import TelemetryParserGUI
 
 
 def main():
+    # Conversion runs in worker processes, needed when packaged as a frozen executable
+    multiprocessing.freeze_support()
     root = TkinterDnD.Tk()
     TelemetryParserGUI(root)
     root.mainloop()
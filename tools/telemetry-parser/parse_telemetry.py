@@ -1,6 +1,19 @@
-"""Parse LTC6804 telemetry CSV data into a human-readable log file."""
+"""Parse LTC6804 telemetry CSV data into a human-readable log file or columnar output.
 
+Rows are read and written incrementally, so memory use does not depend on the input size. Column names are
+matched leniently: `telemetry_ltc_soc`, `telemetry.ltc_soc` and `ltc_soc` are the same column, and InfluxDB
+annotated CSV (`#group`/`#datatype`/`#default` rows) is accepted. Rows without LTC6804 telemetry (only every 10th
+message carries it) are skipped.
+
+Command line:
+  python parse_telemetry.py export1.csv export2.csv --format parquet --out-dir out --jobs 4
+"""
+
+import argparse
 import csv
+import os
+import sys
+from concurrent.futures import ProcessPoolExecutor, as_completed
 
 # ESP32 reset reason mapping (from esp_reset_reason_t)
 RESET_REASONS = {
@@ -17,28 +30,81 @@ RESET_REASONS = {
     10: "SDIO",
 }
 
+# Output formats and file extensions
+FORMATS = {
+    "text": ".txt",
+    "csv": ".csv",
+    "parquet": ".parquet",
+}
+
+# Canonical input columns (without "telemetry_" prefix); ltc_* and reset_reason are required
+REQUIRED_COLUMNS = ["ltc_soc", "ltc_itmp", "ltc_va", "ltc_vd", "ltc_cell_flags", "ltc_diag", "reset_reason"]
+
+# Decoded output columns in order, with Parquet types
+RECORD_COLUMNS = [
+    ("time", "string"),
+    ("soc_v", "float"),
+    ("itmp_c", "float"),
+    ("va_v", "float"),
+    ("vd_v", "float"),
+    ("cell_flags", "int"),
+    ("uv_mask", "int"),
+    ("ov_mask", "int"),
+    ("thsd", "bool"),
+    ("muxfail", "bool"),
+    ("rev", "int"),
+    ("reset_reason", "int"),
+    ("reset_reason_name", "string"),
+    ("reset_msg", "string"),
+]
+
+# Rows per Parquet row group and per progress report
+BATCH_ROWS = 8192
+
+# Interval of progress reports in bytes of input
+PROGRESS_BYTES = 1 << 20
+
+
+def soc_volts(raw: int) -> float:
+    return raw * 0.0001 * 20
+
+
+def itmp_celsius(raw: int) -> float:
+    return raw * 0.0001 / 0.0075 - 273
+
+
+def analog_volts(raw: int) -> float:
+    return raw * 0.0001
+
+
+def cell_flag_masks(raw: int) -> tuple:
+    """Split LTC6804 cell flags into undervoltage and overvoltage masks (bit n = cell n+1)."""
+    uv = 0
+    ov = 0
+    for cell in range(12):
+        uv |= ((raw >> (cell * 2)) & 1) << cell
+        ov |= ((raw >> (cell * 2 + 1)) & 1) << cell
+    return uv, ov
+
 
 def parse_soc(raw: int) -> str:
-    voltage = raw * 0.0001 * 20
-    return f"{voltage:.4f} V"
+    return f"{soc_volts(raw):.4f} V"
 
 
 def parse_itmp(raw: int) -> str:
-    temp_c = raw * 0.0001 / 0.0075 - 273
-    return f"{temp_c:.2f} °C"
+    return f"{itmp_celsius(raw):.2f} °C"
 
 
 def parse_analog_voltage(raw: int) -> str:
-    voltage = raw * 0.0001
-    return f"{voltage:.4f} V"
+    return f"{analog_volts(raw):.4f} V"
 
 
 def parse_cell_flags(raw: int) -> str:
     lines = []
+    uv_mask, ov_mask = cell_flag_masks(raw)
     for cell in range(1, 13):
-        bit_offset = (cell - 1) * 2
-        uv = (raw >> bit_offset) & 1
-        ov = (raw >> (bit_offset + 1)) & 1
+        uv = (uv_mask >> (cell - 1)) & 1
+        ov = (ov_mask >> (cell - 1)) & 1
         flags = []
         if uv:
             flags.append("UV")
@@ -65,19 +131,116 @@ def parse_reset_reason(raw: int) -> str:
     return RESET_REASONS.get(raw, f"UNKNOWN ({raw})")
 
 
-def parse_row(row: dict) -> str:
-    time_str = row["_time"]
-    soc = int(row["telemetry_ltc_soc"])
-    itmp = int(row["telemetry_ltc_itmp"])
-    va = int(row["telemetry_ltc_va"])
-    vd = int(row["telemetry_ltc_vd"])
-    cell_flags = int(row["telemetry_ltc_cell_flags"])
-    diag = int(row["telemetry_ltc_diag"])
-    reset_reason = int(row["telemetry_reset_reason"])
-    reset_message = row.get("telemetry_reset_msg", "")
+def canonical_column(name: str) -> str:
+    """Map header variants to one name: strip, lower case, "." to "_" and drop "telemetry_" prefix."""
+    name = name.strip().lower().replace(".", "_")
+    if name.startswith("telemetry_"):
+        name = name[len("telemetry_"):]
+    return name
+
+
+def _to_int(value: str):
+    """Parse integer cell, Influx exports may write integers as floats ("123.0"). Empty cell gives None."""
+    value = value.strip()
+    if not value:
+        return None
+    try:
+        return int(value)
+    except ValueError:
+        return int(float(value))
+
+
+def iter_rows(path: str, progress=None):
+    """Yield raw rows of a CSV file as dicts with canonical column names.
+
+    Annotation rows of Influx annotated CSV are skipped, and a blank line starts a new table with its own header.
+    Tables without telemetry columns are skipped. If no table has them, ValueError is raised. If given,
+    `progress(bytes_read)` is called about every PROGRESS_BYTES of input.
+    """
+    with open(path, newline="", encoding="utf-8") as f:
+        counter = {"bytes": 0, "next": PROGRESS_BYTES}
+
+        def lines():
+            for line in f:
+                counter["bytes"] += len(line)
+                yield line
+
+        header = None
+        header_ok = False
+        any_header_ok = False
+        missing = []
+        for fields in csv.reader(lines()):
+            if progress and counter["bytes"] >= counter["next"]:
+                counter["next"] = counter["bytes"] + PROGRESS_BYTES
+                progress(counter["bytes"])
+            if not fields or all(not v for v in fields):
+                # Blank line between Influx tables
+                header = None
+                continue
+            if fields[0].startswith("#"):
+                # Influx annotation row
+                continue
+            if header is None:
+                header = [canonical_column(name) for name in fields]
+                missing = [c for c in REQUIRED_COLUMNS if c not in header]
+                header_ok = not missing
+                any_header_ok = any_header_ok or header_ok
+                continue
+            if header_ok:
+                yield dict(zip(header, fields))
+        if progress:
+            progress(counter["bytes"])
+        if not any_header_ok:
+            raise ValueError(f"{os.path.basename(path)}: missing columns {', '.join(missing or REQUIRED_COLUMNS)}")
+
+
+def decode_row(row: dict):
+    """Decode one raw row into engineering units. Returns None if the row carries no LTC6804 telemetry."""
+    raw = {c: _to_int(row.get(c, "")) for c in REQUIRED_COLUMNS}
+    if any(v is None for v in raw.values()):
+        return None
+    uv_mask, ov_mask = cell_flag_masks(raw["ltc_cell_flags"])
+    diag = raw["ltc_diag"]
+    return {
+        "time": row.get("_time", row.get("time", "")),
+        "soc_v": round(soc_volts(raw["ltc_soc"]), 4),
+        "itmp_c": round(itmp_celsius(raw["ltc_itmp"]), 2),
+        "va_v": round(analog_volts(raw["ltc_va"]), 4),
+        "vd_v": round(analog_volts(raw["ltc_vd"]), 4),
+        "cell_flags": raw["ltc_cell_flags"],
+        "uv_mask": uv_mask,
+        "ov_mask": ov_mask,
+        "thsd": bool(diag & 0x01),
+        "muxfail": bool(diag & 0x02),
+        "rev": (diag >> 4) & 0x0F,
+        "reset_reason": raw["reset_reason"],
+        "reset_reason_name": parse_reset_reason(raw["reset_reason"]),
+        "reset_msg": row.get("reset_msg", ""),
+        "_raw": raw,
+    }
+
+
+def iter_records(path: str, progress=None):
+    """Yield decoded records of a CSV file, skipping rows without telemetry."""
+    for row in iter_rows(path, progress):
+        record = decode_row(row)
+        if record is not None:
+            yield record
+
+
+def format_record(record: dict) -> str:
+    """Format one decoded record as human-readable text block."""
+    raw = record["_raw"]
+    soc = raw["ltc_soc"]
+    itmp = raw["ltc_itmp"]
+    va = raw["ltc_va"]
+    vd = raw["ltc_vd"]
+    cell_flags = raw["ltc_cell_flags"]
+    diag = raw["ltc_diag"]
+    reset_reason = raw["reset_reason"]
 
     block = (
-        f"Time: {time_str}\n"
+        f"Time: {record['time']}\n"
         f"\n"
         f"  [LTC6804 Status Registers]\n"
         f"  SOC (Sum of Cells):  {soc} -> {parse_soc(soc)}\n"
@@ -91,15 +254,166 @@ def parse_row(row: dict) -> str:
         f"\n"
         f"  [ESP32 Telemetry]\n"
         f"  Reset Reason: {reset_reason} -> {parse_reset_reason(reset_reason)}\n"
-        f"  Reset Message: {reset_message}\n"
+        f"  Reset Message: {record['reset_msg']}\n"
     )
     return block
 
 
+def parse_row(row: dict) -> str:
+    record = decode_row({canonical_column(k): v for k, v in row.items()})
+    if record is None:
+        raise ValueError("row carries no LTC6804 telemetry")
+    return format_record(record)
+
+
+def iter_blocks(path: str, limit: int = 0):
+    """Yield formatted text blocks of a CSV file, at most `limit` blocks if non-zero."""
+    for count, record in enumerate(iter_records(path), start=1):
+        yield format_record(record)
+        if limit and count >= limit:
+            return
+
+
 def parse_file(path: str) -> str:
-    """Parse a CSV file and return the formatted output as a string."""
-    with open(path, newline="", encoding="utf-8") as csvfile:
-        reader = csv.DictReader(csvfile)
-        blocks = [parse_row(row) for row in reader]
+    """Parse a CSV file and return the formatted output as a string (small files only, see convert_file)."""
     separator = "-" * 60 + "\n"
-    return separator.join(blocks)
+    return separator.join(iter_blocks(path))
+
+
+class _TextWriter:
+    def __init__(self, path: str):
+        self.f = open(path, "w", encoding="utf-8")
+        self.first = True
+
+    def write(self, records: list):
+        for record in records:
+            if not self.first:
+                self.f.write("-" * 60 + "\n")
+            self.f.write(format_record(record))
+            self.first = False
+
+    def close(self):
+        self.f.close()
+
+
+class _CsvWriter:
+    def __init__(self, path: str):
+        self.f = open(path, "w", newline="", encoding="utf-8")
+        self.writer = csv.writer(self.f)
+        self.writer.writerow([name for name, _ in RECORD_COLUMNS])
+
+    def write(self, records: list):
+        for record in records:
+            self.writer.writerow([
+                int(record[name]) if kind == "bool" else record[name] for name, kind in RECORD_COLUMNS
+            ])
+
+    def close(self):
+        self.f.close()
+
+
+class _ParquetWriter:
+    def __init__(self, path: str):
+        try:
+            import pyarrow as pa
+            import pyarrow.parquet as pq
+        except ImportError as e:
+            raise RuntimeError("Parquet output requires pyarrow (pip install pyarrow)") from e
+        types = {"string": pa.string(), "float": pa.float32(), "int": pa.int32(), "bool": pa.bool_()}
+        self.pa = pa
+        self.schema = pa.schema([(name, types[kind]) for name, kind in RECORD_COLUMNS])
+        self.writer = pq.ParquetWriter(path, self.schema, compression="zstd")
+
+    def write(self, records: list):
+        if records:
+            columns = {name: [r[name] for r in records] for name, _ in RECORD_COLUMNS}
+            self.writer.write_table(self.pa.Table.from_pydict(columns, schema=self.schema))
+
+    def close(self):
+        self.writer.close()
+
+
+_WRITERS = {"text": _TextWriter, "csv": _CsvWriter, "parquet": _ParquetWriter}
+
+
+def output_path(in_path: str, out_dir: str, fmt: str) -> str:
+    base = os.path.splitext(os.path.basename(in_path))[0]
+    suffix = "_decoded" if fmt == "csv" else ""
+    return os.path.join(out_dir or os.path.dirname(os.path.abspath(in_path)), base + suffix + FORMATS[fmt])
+
+
+def convert_file(in_path: str, out_path: str, fmt: str, progress=None) -> int:
+    """Stream one CSV file into text, compact CSV or Parquet output. Returns number of records written.
+
+    If given, `progress(bytes_read, total_bytes)` is called periodically.
+    """
+    total = os.path.getsize(in_path)
+    writer = _WRITERS[fmt](out_path)
+    count = 0
+    batch = []
+    try:
+        for record in iter_records(in_path, (lambda n: progress(n, total)) if progress else None):
+            batch.append(record)
+            if len(batch) >= BATCH_ROWS:
+                writer.write(batch)
+                count += len(batch)
+                batch = []
+        writer.write(batch)
+        count += len(batch)
+    except BaseException:
+        # Do not leave partial output behind
+        writer.close()
+        os.remove(out_path)
+        raise
+    writer.close()
+    return count
+
+
+def _convert_worker(in_path: str, out_path: str, fmt: str, queue):
+    def progress(done, total):
+        if queue is not None:
+            queue.put((in_path, done, total))
+
+    return in_path, out_path, convert_file(in_path, out_path, fmt, progress)
+
+
+def convert_files(paths: list, out_dir: str, fmt: str, jobs: int = 0, queue=None):
+    """Convert several files in parallel worker processes. Yields (in_path, out_path, records or exception) as
+    files complete. Progress tuples (in_path, bytes_read, total_bytes) are put into `queue` (a
+    multiprocessing.Manager().Queue()) if given.
+    """
+    jobs = jobs or min(len(paths), os.cpu_count() or 1)
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+    with ProcessPoolExecutor(max_workers=max(1, jobs)) as pool:
+        futures = {
+            pool.submit(_convert_worker, p, output_path(p, out_dir, fmt), fmt, queue): p for p in paths
+        }
+        for future in as_completed(futures):
+            in_path = futures[future]
+            try:
+                yield future.result()
+            except Exception as e:  # reported per file, other files continue
+                yield in_path, output_path(in_path, out_dir, fmt), e
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode LTC6804 telemetry CSV exports")
+    parser.add_argument("files", nargs="+", help="input CSV files (Influx export or telegraf CSV)")
+    parser.add_argument("--format", choices=sorted(FORMATS), default="csv", help="output format")
+    parser.add_argument("--out-dir", default="", help="output directory (default: next to input)")
+    parser.add_argument("--jobs", type=int, default=0, help="worker processes (default: one per file, max CPUs)")
+    args = parser.parse_args()
+
+    failed = 0
+    for in_path, out_path, result in convert_files(args.files, args.out_dir, args.format, args.jobs):
+        if isinstance(result, Exception):
+            failed += 1
+            print(f"{in_path}: {result}", file=sys.stderr)
+        else:
+            print(f"{in_path} -> {out_path}: {result} records")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,2 +1,2 @@
 APP_NAME = "LTC Telemetry Parser"
-VERSION = "1.0.0"
+VERSION = "1.1.0"